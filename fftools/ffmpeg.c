@@ -99,6 +99,7 @@
 
 #include "cmdutils.h"
 #include "ffmpeg.h"
+#include "mem_budget.h"
 #include "sync_queue.h"
 
 const char program_name[] = "ffmpeg";
@@ -354,6 +355,9 @@ static void ffmpeg_cleanup(int ret)
         av_log(NULL, AV_LOG_INFO, "bench: maxrss=%ikB\n", maxrss);
     }
 
+    if (atomic_load(&transcode_init_done))
+        mem_budget_log(NULL, do_benchmark ? AV_LOG_INFO : AV_LOG_VERBOSE);
+
     for (i = 0; i < nb_filtergraphs; i++)
         fg_free(&filtergraphs[i]);
     av_freep(&filtergraphs);
@@ -390,6 +394,7 @@ static void ffmpeg_cleanup(int ret)
     } else if (ret && atomic_load(&transcode_init_done)) {
         av_log(NULL, AV_LOG_INFO, "Conversion failed!\n");
     }
+    av_log_set_async(0);
     term_exit();
     ffmpeg_exited = 1;
 }
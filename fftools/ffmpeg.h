@@ -242,6 +242,12 @@ typedef struct OptionsContext {
     int        nb_fix_sub_duration;
     SpecifierOpt *fix_sub_duration_heartbeat;
     int        nb_fix_sub_duration_heartbeat;
+    SpecifierOpt *enc_chunks;
+    int        nb_enc_chunks;
+    SpecifierOpt *enc_chunk_frames;
+    int        nb_enc_chunk_frames;
+    SpecifierOpt *enc_chunk_queue_size;
+    int        nb_enc_chunk_queue_size;
     SpecifierOpt *canvas_sizes;
     int        nb_canvas_sizes;
     SpecifierOpt *pass;
@@ -610,6 +616,13 @@ typedef struct OutputStream {
      * subtitles utilizing fix_sub_duration at random access points.
      */
     unsigned int fix_sub_duration_heartbeat;
+
+    /* number of chunks encoded in parallel by separate encoder instances,
+     * their length in frames and the maximum size of the raw frames queued
+     * for one chunk; see -enc_chunks */
+    int enc_chunks;
+    int enc_chunk_frames;
+    int enc_chunk_queue_size;
 } OutputStream;
 
 typedef struct OutputFile {
@@ -30,6 +30,7 @@
 #include "libavfilter/buffersrc.h"
 
 #include "ffmpeg.h"
+#include "mem_budget.h"
 #include "thread_queue.h"
 
 struct Decoder {
@@ -857,6 +858,7 @@ static int dec_thread_start(InputStream *ist)
         objpool_free(&op);
         return AVERROR(ENOMEM);
     }
+    tq_set_mem_budget(d->queue_in, MEM_STAGE_DEC, mem_budget_packet_size, 0);
 
     op = objpool_alloc_frames();
     if (!op)
@@ -867,6 +869,7 @@ static int dec_thread_start(InputStream *ist)
         objpool_free(&op);
         goto fail;
     }
+    tq_set_mem_budget(d->queue_out, MEM_STAGE_DEC, mem_budget_frame_size, 0);
 
     ret = pthread_create(&d->thread, NULL, decoder_thread, ist);
     if (ret) {
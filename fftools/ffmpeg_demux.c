@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include "ffmpeg.h"
+#include "mem_budget.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
@@ -542,6 +543,13 @@ static void thread_set_name(InputFile *f)
     ff_thread_setname(name);
 }
 
+static int demux_queue_busy(void *opaque)
+{
+    Demuxer *d = opaque;
+
+    return av_thread_message_queue_nb_elems(d->in_thread_queue) > 0;
+}
+
 static void *input_thread(void *arg)
 {
     Demuxer   *d = arg;
@@ -564,6 +572,7 @@ static void *input_thread(void *arg)
 
     while (1) {
         DemuxMsg msg = { NULL };
+        size_t msg_size;
 
         ret = av_read_frame(f->ctx, pkt);
 
@@ -625,6 +634,13 @@ static void *input_thread(void *arg)
         if (f->readrate)
             readrate_sleep(d);
 
+        /* while over the memory budget, wait until the consumer has caught
+         * up; an empty queue can always take one more packet */
+        mem_budget_wait(demux_queue_busy, d);
+
+        msg_size = mem_budget_packet_size(msg.pkt);
+        mem_budget_update(MEM_STAGE_DEMUX, msg_size);
+
         ret = av_thread_message_queue_send(d->in_thread_queue, &msg, flags);
         if (flags && ret == AVERROR(EAGAIN)) {
             flags = 0;
@@ -639,6 +655,7 @@ static void *input_thread(void *arg)
                 av_log(f, AV_LOG_ERROR,
                        "Unable to send packet to main thread: %s\n",
                        av_err2str(ret));
+            mem_budget_update(MEM_STAGE_DEMUX, -(int64_t)msg_size);
             av_packet_free(&msg.pkt);
             break;
         }
@@ -663,8 +680,11 @@ static void thread_stop(Demuxer *d)
     if (!d->in_thread_queue)
         return;
     av_thread_message_queue_set_err_send(d->in_thread_queue, AVERROR_EOF);
-    while (av_thread_message_queue_recv(d->in_thread_queue, &msg, 0) >= 0)
+    while (av_thread_message_queue_recv(d->in_thread_queue, &msg, 0) >= 0) {
+        if (msg.pkt)
+            mem_budget_update(MEM_STAGE_DEMUX, -(int64_t)mem_budget_packet_size(msg.pkt));
         av_packet_free(&msg.pkt);
+    }
 
     pthread_join(d->thread, NULL);
     av_thread_message_queue_free(&d->in_thread_queue);
@@ -740,6 +760,8 @@ int ifile_get_packet(InputFile *f, AVPacket **pkt)
     if (msg.looping)
         return 1;
 
+    mem_budget_update(MEM_STAGE_DEMUX, -(int64_t)mem_budget_packet_size(msg.pkt));
+
     *pkt = msg.pkt;
     return 0;
 }
@@ -20,6 +20,9 @@
 #include <stdint.h>
 
 #include "ffmpeg.h"
+#include "mem_budget.h"
+#include "objpool.h"
+#include "thread_queue.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
@@ -27,9 +30,11 @@
 #include "libavutil/dict.h"
 #include "libavutil/display.h"
 #include "libavutil/eval.h"
+#include "libavutil/fifo.h"
 #include "libavutil/frame.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
+#include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
 #include "libavutil/timestamp.h"
@@ -38,6 +43,25 @@
 
 #include "libavformat/avformat.h"
 
+// a range of frames encoded by its own encoder instance in its own thread
+typedef struct EncChunk {
+    OutputStream   *ost;
+    AVCodecContext *enc_ctx;
+
+    pthread_t       thread;
+    // frames sent from the main thread to the chunk thread
+    ThreadQueue    *queue_in;
+    // packets sent from the chunk thread back to the main thread
+    ThreadQueue    *queue_out;
+
+    int             nb_frames;
+
+    /* audio: packets outside of [start_pts, end_pts) are produced from the
+     * pre-roll or the encoder delay and duplicate the neighbouring chunks */
+    int64_t         start_pts;
+    int64_t         end_pts;
+} EncChunk;
+
 struct Encoder {
     AVFrame *sq_frame;
 
@@ -50,9 +74,66 @@ struct Encoder {
     // number of packets received from the encoder
     uint64_t packets_encoded;
 
+    /* sizes of the frames held inside the encoder, accounted to the memory
+     * budget until a packet is received for each of them */
+    AVFifo  *frame_sizes;
+
     int opened;
+
+    /* chunked encoding (-enc_chunks); the encoder options are kept in
+     * an unopened context, from which every chunk encoder is set up */
+    AVCodecContext *chunk_tmpl;
+    AVDictionary   *chunk_opts;
+    AVFrame        *chunk_frame;
+    int             chunk_frames;
+    // chunks in flight in output order, the last one receives new frames
+    EncChunk      **chunks;
+    int             nb_chunks;
+    /* audio: number of frames around a boundary that are encoded by the
+     * chunks on both sides of it; the last ones sent are kept to be encoded
+     * again at the start of the next chunk */
+    int             overlap;
+    AVFrame       **preroll;
+    int             nb_preroll;
 };
 
+static int enc_chunk_stop(EncChunk *c)
+{
+    void *ret;
+
+    tq_send_finish(c->queue_in, 0);
+    tq_receive_finish(c->queue_out, 0);
+
+    pthread_join(c->thread, &ret);
+
+    return (intptr_t)ret;
+}
+
+static void enc_chunk_free(EncChunk **pc)
+{
+    EncChunk *c = *pc;
+
+    if (!c)
+        return;
+
+    tq_free(&c->queue_in);
+    tq_free(&c->queue_out);
+    avcodec_free_context(&c->enc_ctx);
+
+    av_freep(pc);
+}
+
+static void enc_release_frames(Encoder *e, int all)
+{
+    size_t size;
+
+    while (av_fifo_read(e->frame_sizes, &size, 1) >= 0) {
+        mem_budget_update(MEM_STAGE_ENC, -(int64_t)size);
+        if (!all)
+            break;
+    }
+}
+
 void enc_free(Encoder **penc)
 {
     Encoder *enc = *penc;
@@ -60,6 +141,22 @@ void enc_free(Encoder **penc)
     if (!enc)
         return;
 
+    if (enc->frame_sizes)
+        enc_release_frames(enc, 1);
+    av_fifo_freep2(&enc->frame_sizes);
+
+    for (int i = 0; i < enc->nb_chunks; i++) {
+        enc_chunk_stop(enc->chunks[i]);
+        enc_chunk_free(&enc->chunks[i]);
+    }
+    av_freep(&enc->chunks);
+    for (int i = 0; i < enc->nb_preroll; i++)
+        av_frame_free(&enc->preroll[i]);
+    av_freep(&enc->preroll);
+    av_frame_free(&enc->chunk_frame);
+    av_dict_free(&enc->chunk_opts);
+    avcodec_free_context(&enc->chunk_tmpl);
+
     av_frame_free(&enc->sq_frame);
 
     av_packet_free(&enc->pkt);
@@ -81,6 +178,10 @@ int enc_alloc(Encoder **penc, const AVCodec *codec)
     if (!enc->pkt)
         goto fail;
 
+    enc->frame_sizes = av_fifo_alloc2(8, sizeof(size_t), AV_FIFO_FLAG_AUTO_GROW);
+    if (!enc->frame_sizes)
+        goto fail;
+
     *penc = enc;
 
     return 0;
@@ -140,6 +241,91 @@ static int hw_device_setup_for_encode(OutputStream *ost, AVBufferRef *frames_ref
     return 0;
 }
 
+/* Copy the encoder settings that are not reachable through the
+ * encoder options dictionary. */
+static int enc_chunk_copy_settings(AVCodecContext *dst, const AVCodecContext *src)
+{
+    int ret;
+
+    ret = av_opt_copy(dst, src);
+    if (ret < 0)
+        return ret;
+    if (src->codec->priv_class) {
+        ret = av_opt_copy(dst->priv_data, src->priv_data);
+        if (ret < 0)
+            return ret;
+    }
+
+    dst->framerate  = src->framerate;
+    dst->sample_fmt = src->sample_fmt;
+
+#define COPY_MATRIX(m)                                                          \
+    if (src->m && !(dst->m = av_memdup(src->m, 64 * sizeof(*src->m))))         \
+        return AVERROR(ENOMEM);
+    COPY_MATRIX(intra_matrix);
+    COPY_MATRIX(inter_matrix);
+    COPY_MATRIX(chroma_intra_matrix);
+#undef COPY_MATRIX
+
+    if (src->hw_device_ctx &&
+        !(dst->hw_device_ctx = av_buffer_ref(src->hw_device_ctx)))
+        return AVERROR(ENOMEM);
+    if (src->hw_frames_ctx &&
+        !(dst->hw_frames_ctx = av_buffer_ref(src->hw_frames_ctx)))
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int enc_chunk_start(OutputStream *ost, const AVFrame *frame);
+
+static int enc_chunks_init(OutputStream *ost, const AVFrame *frame)
+{
+    Encoder *e = ost->enc;
+    const AVCodecContext *enc;
+    int ret;
+
+    e->chunk_tmpl  = avcodec_alloc_context3(ost->enc_ctx->codec);
+    e->chunk_frame = av_frame_alloc();
+    e->chunks      = av_calloc(ost->enc_chunks, sizeof(*e->chunks));
+    if (!e->chunk_tmpl || !e->chunk_frame || !e->chunks)
+        return AVERROR(ENOMEM);
+
+    ret = enc_chunk_copy_settings(e->chunk_tmpl, ost->enc_ctx);
+    if (ret < 0)
+        return ret;
+
+    ret = av_dict_copy(&e->chunk_opts, ost->encoder_opts, 0);
+    if (ret < 0)
+        return ret;
+
+    /* The main encoder context is never opened; the first chunk encoder
+     * provides the parameters that are only known after opening. */
+    ret = enc_chunk_start(ost, frame);
+    if (ret < 0)
+        return ret;
+    enc = e->chunks[0]->enc_ctx;
+
+    ost->enc_ctx->frame_size      = enc->frame_size;
+    ost->enc_ctx->initial_padding = enc->initial_padding;
+
+    /* Twice the encoder delay, so that the window shape decisions of both
+     * encoders have settled at the boundary as well. */
+    if (enc->codec_type == AVMEDIA_TYPE_AUDIO && enc->initial_padding) {
+        e->overlap = enc->frame_size ?
+                     2 * ((enc->initial_padding + enc->frame_size - 1) / enc->frame_size) : 2;
+        e->preroll = av_calloc(e->overlap, sizeof(*e->preroll));
+        if (!e->preroll)
+            return AVERROR(ENOMEM);
+        e->chunk_frames = FFMAX(e->chunk_frames, e->overlap);
+    }
+
+    av_log(ost, AV_LOG_VERBOSE, "Encoding up to %d chunks of %d frames "
+           "in parallel\n", ost->enc_chunks, e->chunk_frames);
+
+    return 0;
+}
+
 static int set_encoder_id(OutputFile *of, OutputStream *ost)
 {
     const char *cname = ost->enc_ctx->codec->name;
@@ -290,8 +476,10 @@ int enc_open(OutputStream *ost, const AVFrame *frame)
     if (ost->bitexact)
         enc_ctx->flags |= AV_CODEC_FLAG_BITEXACT;
 
+    // with chunked encoding the chunks provide the parallelism
     if (!av_dict_get(ost->encoder_opts, "threads", NULL, 0))
-        av_dict_set(&ost->encoder_opts, "threads", "auto", 0);
+        av_dict_set(&ost->encoder_opts, "threads",
+                    ost->enc_chunks > 1 ? "1" : "auto", 0);
 
     if (enc->capabilities & AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE) {
         ret = av_dict_set(&ost->encoder_opts, "flags", "+copy_opaque", AV_DICT_MULTIKEY);
@@ -308,7 +496,11 @@ int enc_open(OutputStream *ost, const AVFrame *frame)
         return ret;
     }
 
-    if ((ret = avcodec_open2(ost->enc_ctx, enc, &ost->encoder_opts)) < 0) {
+    if (ost->enc_chunks > 1) {
+        ret = enc_chunks_init(ost, frame);
+        if (ret < 0)
+            return ret;
+    } else if ((ret = avcodec_open2(ost->enc_ctx, enc, &ost->encoder_opts)) < 0) {
         if (ret != AVERROR_EXPERIMENTAL)
             av_log(ost, AV_LOG_ERROR, "Error while opening encoder - maybe "
                    "incorrect parameters such as bit_rate, rate, width or height.\n");
@@ -338,7 +530,8 @@ int enc_open(OutputStream *ost, const AVFrame *frame)
         av_log(ost, AV_LOG_WARNING, "The bitrate parameter is set too low."
                                     " It takes bits/s as argument, not kbits/s\n");
 
-    ret = avcodec_parameters_from_context(ost->par_in, ost->enc_ctx);
+    ret = avcodec_parameters_from_context(ost->par_in, e->nb_chunks ?
+                                          e->chunks[0]->enc_ctx : ost->enc_ctx);
     if (ret < 0) {
         av_log(ost, AV_LOG_FATAL,
                "Error initializing the output stream codec context.\n");
@@ -610,6 +803,350 @@ static int update_video_stats(OutputStream *ost, const AVPacket *pkt, int write_
     return 0;
 }
 
+static int output_packet(OutputFile *of, OutputStream *ost, AVPacket *pkt)
+{
+    Encoder            *e = ost->enc;
+    AVCodecContext   *enc = ost->enc_ctx;
+    const char *type_desc = av_get_media_type_string(enc->codec_type);
+    int ret;
+
+    if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
+        ret = update_video_stats(ost, pkt, !!vstats_filename);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (ost->enc_stats_post.io)
+        enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
+                        e->packets_encoded);
+
+    if (debug_ts) {
+        av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
+               "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
+               "duration:%s duration_time:%s\n",
+               type_desc,
+               av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
+               av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
+               av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
+    }
+
+    if ((ret = trigger_fix_sub_duration_heartbeat(ost, pkt)) < 0) {
+        av_log(NULL, AV_LOG_ERROR,
+               "Subtitle heartbeat logic failed in %s! (%s)\n",
+               __func__, av_err2str(ret));
+        return ret;
+    }
+
+    e->data_size += pkt->size;
+
+    e->packets_encoded++;
+
+    return of_output_packet(of, ost, pkt);
+}
+
+static void *enc_chunk_thread(void *arg)
+{
+    EncChunk       *c = arg;
+    AVCodecContext *enc = c->enc_ctx;
+    AVFrame    *frame = av_frame_alloc();
+    AVPacket     *pkt = av_packet_alloc();
+    char name[16];
+    int ret = 0;
+
+    if (!frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    snprintf(name, sizeof(name), "enc%d:%d:chunk",
+             c->ost->file_index, c->ost->index);
+    ff_thread_setname(name);
+
+    while (1) {
+        int dummy, eof;
+
+        eof = tq_receive(c->queue_in, &dummy, frame) < 0;
+
+        ret = avcodec_send_frame(enc, eof ? NULL : frame);
+        av_frame_unref(frame);
+        if (ret < 0)
+            break;
+
+        while ((ret = avcodec_receive_packet(enc, pkt)) >= 0) {
+            pkt->time_base = enc->time_base;
+            ret = tq_send(c->queue_out, 0, pkt);
+            if (ret < 0) {
+                av_packet_unref(pkt);
+                goto finish;
+            }
+        }
+        if (ret == AVERROR_EOF) {
+            ret = 0;
+            break;
+        } else if (ret != AVERROR(EAGAIN))
+            break;
+    }
+
+finish:
+    tq_receive_finish(c->queue_in,  0);
+    tq_send_finish   (c->queue_out, 0);
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+
+    return (void*)(intptr_t)ret;
+}
+
+static int enc_chunk_send(Encoder *e, EncChunk *c, const AVFrame *frame)
+{
+    int ret;
+
+    ret = av_frame_ref(e->chunk_frame, frame);
+    if (ret < 0)
+        return ret;
+
+    ret = tq_send(c->queue_in, 0, e->chunk_frame);
+    if (ret < 0) {
+        av_frame_unref(e->chunk_frame);
+        return ret;
+    }
+
+    return 0;
+}
+
+static int enc_chunk_start(OutputStream *ost, const AVFrame *frame)
+{
+    Encoder *e = ost->enc;
+    AVDictionary *opts = NULL;
+    size_t frame_size, queue_size;
+    EncChunk *c;
+    ObjPool *op;
+    int ret;
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    c->ost       = ost;
+    c->start_pts = e->nb_preroll ? frame->pts : INT64_MIN;
+    c->end_pts   = INT64_MAX;
+
+    c->enc_ctx = avcodec_alloc_context3(e->chunk_tmpl->codec);
+    if (!c->enc_ctx) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    ret = enc_chunk_copy_settings(c->enc_ctx, e->chunk_tmpl);
+    if (ret < 0)
+        goto fail;
+
+    ret = av_dict_copy(&opts, e->chunk_opts, 0);
+    if (ret >= 0)
+        ret = avcodec_open2(c->enc_ctx, NULL, &opts);
+    // the unused options are checked for the first chunk
+    if (!e->nb_chunks) {
+        av_dict_free(&ost->encoder_opts);
+        ost->encoder_opts = opts;
+        opts = NULL;
+    }
+    av_dict_free(&opts);
+    if (ret < 0) {
+        av_log(ost, AV_LOG_ERROR, "Error opening the encoder of a chunk: %s\n",
+               av_err2str(ret));
+        goto fail;
+    }
+
+    // by default every video chunk is one GOP, every audio chunk about 10s
+    if (!e->chunk_frames) {
+        const AVCodecContext *enc = c->enc_ctx;
+
+        if (ost->enc_chunk_frames)
+            e->chunk_frames = ost->enc_chunk_frames;
+        else if (enc->codec_type == AVMEDIA_TYPE_AUDIO)
+            e->chunk_frames = FFMAX(10 * enc->sample_rate /
+                                    (enc->frame_size ? enc->frame_size : 1024), 1);
+        else
+            e->chunk_frames = enc->gop_size > 0 ? enc->gop_size : 25;
+    }
+
+    /* Room for a whole chunk, so the main thread can move on to the next one,
+     * as long as its frames stay within -enc_chunk_queue_size. Otherwise the
+     * main thread waits for the chunk encoder. */
+    frame_size = FFMAX(mem_budget_frame_size(frame), 1);
+    queue_size = FFMAX(ost->enc_chunk_queue_size / frame_size, 1);
+    queue_size = FFMIN(queue_size, e->chunk_frames + 2 * e->overlap);
+    op = objpool_alloc_frames();
+    if (!op ||
+        !(c->queue_in = tq_alloc(1, queue_size, op, frame_move))) {
+        objpool_free(&op);
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    tq_set_mem_budget(c->queue_in, MEM_STAGE_ENC, mem_budget_frame_size, 1);
+
+    op = objpool_alloc_packets();
+    if (!op ||
+        !(c->queue_out = tq_alloc(1, e->chunk_frames + 2 * e->overlap + 8,
+                                  op, pkt_move))) {
+        objpool_free(&op);
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    ret = pthread_create(&c->thread, NULL, enc_chunk_thread, c);
+    if (ret) {
+        ret = AVERROR(ret);
+        av_log(ost, AV_LOG_ERROR, "pthread_create() failed: %s\n",
+               av_err2str(ret));
+        goto fail;
+    }
+
+    e->chunks[e->nb_chunks++] = c;
+
+    for (int i = 0; i < e->nb_preroll; i++) {
+        ret = enc_chunk_send(e, c, e->preroll[i]);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+fail:
+    enc_chunk_free(&c);
+    return ret;
+}
+
+// send all packets of the oldest chunk to the muxer and free it
+static int enc_chunk_drain(OutputFile *of, OutputStream *ost)
+{
+    Encoder   *e = ost->enc;
+    EncChunk  *c = e->chunks[0];
+    int ret, thread_ret;
+
+    tq_send_finish(c->queue_in, 0);
+
+    while (1) {
+        int dummy;
+
+        ret = tq_receive(c->queue_out, &dummy, e->pkt);
+        if (ret < 0) {
+            ret = 0;
+            break;
+        }
+
+        if (e->pkt->pts != AV_NOPTS_VALUE &&
+            (e->pkt->pts < c->start_pts || e->pkt->pts >= c->end_pts)) {
+            av_packet_unref(e->pkt);
+            continue;
+        }
+
+        ret = output_packet(of, ost, e->pkt);
+        av_packet_unref(e->pkt);
+        if (ret < 0)
+            break;
+    }
+
+    thread_ret = enc_chunk_stop(c);
+    if (thread_ret < 0) {
+        av_log(ost, AV_LOG_ERROR, "Encoding a chunk failed: %s\n",
+               av_err2str(thread_ret));
+        ret = err_merge(ret, thread_ret);
+    }
+
+    enc_chunk_free(&e->chunks[0]);
+    memmove(e->chunks, e->chunks + 1, --e->nb_chunks * sizeof(*e->chunks));
+
+    return ret;
+}
+
+/*
+ * Chunked encoding: consecutive runs of chunk_frames frames are encoded
+ * concurrently by fresh encoder instances, so every chunk starts with a
+ * keyframe and does not reference the previous one. The packets are passed
+ * on chunk by chunk in order; as every encoder sees the original frame
+ * timestamps, no adjustment is needed for constant frame rate content.
+ *
+ * For audio encoders with a delay (e.g. AAC), the frames covering the delay
+ * on either side of a chunk boundary are encoded by both chunks, so that the
+ * transform windows around the boundary are computed from real data in both
+ * encoders. Only the packets of a chunk between its first and last frame are
+ * passed on, so the stream has no gaps or overlaps at chunk boundaries.
+ */
+static int encode_frame_chunked(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+    Encoder *e = ost->enc;
+    EncChunk *c = e->nb_chunks ? e->chunks[e->nb_chunks - 1] : NULL;
+    int ret;
+
+    if (!frame) {
+        for (int i = 0; i < e->nb_chunks; i++)
+            tq_send_finish(e->chunks[i]->queue_in, 0);
+        while (e->nb_chunks) {
+            ret = enc_chunk_drain(of, ost);
+            if (ret < 0)
+                return ret;
+        }
+
+        ret = of_output_packet(of, ost, NULL);
+        return ret < 0 ? ret : AVERROR_EOF;
+    }
+
+    if (!c || c->nb_frames == e->chunk_frames) {
+        if (c) {
+            if (e->overlap)
+                c->end_pts = frame->pts;
+            else
+                tq_send_finish(c->queue_in, 0);
+        }
+        if (e->nb_chunks == ost->enc_chunks) {
+            ret = enc_chunk_drain(of, ost);
+            if (ret < 0)
+                return ret;
+        }
+
+        ret = enc_chunk_start(ost, frame);
+        if (ret < 0)
+            goto fail;
+        c = e->chunks[e->nb_chunks - 1];
+    }
+
+    ret = enc_chunk_send(e, c, frame);
+    if (ret < 0)
+        goto fail;
+    c->nb_frames++;
+
+    if (e->overlap) {
+        // the previous chunk goes on until its delay is covered
+        if (e->nb_chunks > 1 && c->nb_frames <= e->overlap) {
+            EncChunk *prev = e->chunks[e->nb_chunks - 2];
+
+            ret = enc_chunk_send(e, prev, frame);
+            if (ret < 0)
+                goto fail;
+            if (c->nb_frames == e->overlap)
+                tq_send_finish(prev->queue_in, 0);
+        }
+
+        if (e->nb_preroll == e->overlap) {
+            av_frame_free(&e->preroll[0]);
+            memmove(e->preroll, e->preroll + 1,
+                    --e->nb_preroll * sizeof(*e->preroll));
+        }
+        e->preroll[e->nb_preroll] = av_frame_clone(frame);
+        if (!e->preroll[e->nb_preroll])
+            return AVERROR(ENOMEM);
+        e->nb_preroll++;
+    }
+
+    return 0;
+fail:
+    // a chunk thread terminated early, collect its error
+    while (e->nb_chunks) {
+        int err = enc_chunk_drain(of, ost);
+        if (err < 0)
+            return err;
+    }
+    return ret;
+}
+
 static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
 {
     Encoder            *e = ost->enc;
@@ -639,6 +1176,9 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
             enc->sample_aspect_ratio = frame->sample_aspect_ratio;
     }
 
+    if (e->chunk_tmpl)
+        return encode_frame_chunked(of, ost, frame);
+
     update_benchmark(NULL);
 
     ret = avcodec_send_frame(enc, frame);
@@ -647,6 +1187,14 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
                type_desc);
         return ret;
     }
+    if (frame) {
+        size_t size = mem_budget_frame_size(frame);
+
+        ret = av_fifo_write(e->frame_sizes, &size, 1);
+        if (ret < 0)
+            return ret;
+        mem_budget_update(MEM_STAGE_ENC, size);
+    }
 
     while (1) {
         av_packet_unref(pkt);
@@ -665,6 +1213,7 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
             av_assert0(frame); // should never happen during flushing
             return 0;
         } else if (ret == AVERROR_EOF) {
+            enc_release_frames(e, 1);
             ret = of_output_packet(of, ost, NULL);
             return ret < 0 ? ret : AVERROR_EOF;
         } else if (ret < 0) {
@@ -672,38 +1221,9 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
             return ret;
         }
 
-        if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
-            ret = update_video_stats(ost, pkt, !!vstats_filename);
-            if (ret < 0)
-                return ret;
-        }
-
-        if (ost->enc_stats_post.io)
-            enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
-                            e->packets_encoded);
+        enc_release_frames(e, 0);
 
-        if (debug_ts) {
-            av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
-                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
-                   "duration:%s duration_time:%s\n",
-                   type_desc,
-                   av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
-                   av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
-                   av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
-        }
-
-        if ((ret = trigger_fix_sub_duration_heartbeat(ost, pkt)) < 0) {
-            av_log(NULL, AV_LOG_ERROR,
-                   "Subtitle heartbeat logic failed in %s! (%s)\n",
-                   __func__, av_err2str(ret));
-            return ret;
-        }
-
-        e->data_size += pkt->size;
-
-        e->packets_encoded++;
-
-        ret = of_output_packet(of, ost, pkt);
+        ret = output_packet(of, ost, pkt);
         if (ret < 0)
             return ret;
     }
@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include "ffmpeg.h"
+#include "mem_budget.h"
 
 #include "libavfilter/avfilter.h"
 #include "libavfilter/buffersink.h"
@@ -813,8 +814,10 @@ void fg_free(FilterGraph **pfg)
 
         if (ifp->frame_queue) {
             AVFrame *frame;
-            while (av_fifo_read(ifp->frame_queue, &frame, 1) >= 0)
+            while (av_fifo_read(ifp->frame_queue, &frame, 1) >= 0) {
+                mem_budget_update_held(MEM_STAGE_FILTER, -(int64_t)mem_budget_frame_size(frame));
                 av_frame_free(&frame);
+            }
             av_fifo_freep2(&ifp->frame_queue);
         }
         av_frame_free(&ifp->sub2video.frame);
@@ -1718,6 +1721,7 @@ static int configure_filtergraph(FilterGraph *fg)
         InputFilterPriv *ifp = ifp_from_ifilter(fg->inputs[i]);
         AVFrame *tmp;
         while (av_fifo_read(ifp->frame_queue, &tmp, 1) >= 0) {
+            mem_budget_update_held(MEM_STAGE_FILTER, -(int64_t)mem_budget_frame_size(tmp));
             if (ifp->type_src == AVMEDIA_TYPE_SUBTITLE) {
                 sub2video_update(ifp, INT64_MIN, (const AVSubtitle*)tmp->buf[0]->data);
             } else {
@@ -2299,6 +2303,7 @@ int ifilter_sub2video(InputFilter *ifilter, const AVFrame *frame)
             av_frame_free(&tmp);
             return ret;
         }
+        mem_budget_update_held(MEM_STAGE_FILTER, mem_budget_frame_size(tmp));
     }
 
     return 0;
@@ -2396,13 +2401,26 @@ int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
     /* (re)init the graph if possible, otherwise buffer the frame and return */
     if (need_reinit || !fg->graph) {
         if (!ifilter_has_all_input_formats(fg)) {
-            AVFrame *tmp = av_frame_clone(frame);
+            AVFrame *tmp;
+
+            /* the other inputs are needed to make progress, so only wait
+             * for the data queued for other threads to drain */
+            ret = mem_budget_wait(NULL, NULL);
+            if (ret < 0) {
+                av_log(fg, AV_LOG_ERROR, "Queued data over the memory budget "
+                       "while waiting for all filtergraph inputs.\n");
+                return ret;
+            }
+
+            tmp = av_frame_clone(frame);
             if (!tmp)
                 return AVERROR(ENOMEM);
 
             ret = av_fifo_write(ifp->frame_queue, &tmp, 1);
             if (ret < 0)
                 av_frame_free(&tmp);
+            else
+                mem_budget_update_held(MEM_STAGE_FILTER, mem_budget_frame_size(tmp));
 
             return ret;
         }
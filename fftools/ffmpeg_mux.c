@@ -22,6 +22,7 @@
 
 #include "ffmpeg.h"
 #include "ffmpeg_mux.h"
+#include "mem_budget.h"
 #include "objpool.h"
 #include "sync_queue.h"
 #include "thread_queue.h"
@@ -291,6 +292,16 @@ static int queue_packet(OutputStream *ost, AVPacket *pkt)
     AVPacket *tmp_pkt = NULL;
     int ret;
 
+    /* only this thread can flush this queue, so wait for the data queued
+     * for other threads, and fail if the data buffered this way alone is
+     * over the budget */
+    if (pkt && (ret = mem_budget_wait(NULL, NULL)) < 0) {
+        av_log(ost, AV_LOG_ERROR,
+               "Queued data over the memory budget while buffering packets "
+               "for output stream %d:%d.\n", ost->file_index, ost->st->index);
+        return ret;
+    }
+
     if (!av_fifo_can_write(ms->muxing_queue)) {
         size_t cur_size = av_fifo_can_read(ms->muxing_queue);
         size_t pkt_size = pkt ? pkt->size : 0;
@@ -321,6 +332,7 @@ static int queue_packet(OutputStream *ost, AVPacket *pkt)
 
         av_packet_move_ref(tmp_pkt, pkt);
         ms->muxing_queue_data_size += tmp_pkt->size;
+        mem_budget_update_held(MEM_STAGE_MUX, mem_budget_packet_size(tmp_pkt));
     }
     av_fifo_write(ms->muxing_queue, &tmp_pkt, 1);
 
@@ -504,6 +516,7 @@ static int thread_start(Muxer *mux)
         objpool_free(&op);
         return AVERROR(ENOMEM);
     }
+    tq_set_mem_budget(mux->tq, MEM_STAGE_MUX, mem_budget_packet_size, 1);
 
     ret = pthread_create(&mux->thread, NULL, muxer_thread, (void*)mux);
     if (ret) {
@@ -518,6 +531,8 @@ static int thread_start(Muxer *mux)
         AVPacket *pkt;
 
         while (av_fifo_read(ms->muxing_queue, &pkt, 1) >= 0) {
+            if (pkt)
+                mem_budget_update_held(MEM_STAGE_MUX, -(int64_t)mem_budget_packet_size(pkt));
             ret = thread_submit_packet(mux, ost, pkt);
             if (pkt) {
                 ms->muxing_queue_data_size -= pkt->size;
@@ -857,8 +872,11 @@ static void ost_free(OutputStream **post)
 
     if (ms->muxing_queue) {
         AVPacket *pkt;
-        while (av_fifo_read(ms->muxing_queue, &pkt, 1) >= 0)
+        while (av_fifo_read(ms->muxing_queue, &pkt, 1) >= 0) {
+            if (pkt)
+                mem_budget_update_held(MEM_STAGE_MUX, -(int64_t)mem_budget_packet_size(pkt));
             av_packet_free(&pkt);
+        }
         av_fifo_freep2(&ms->muxing_queue);
     }
 
@@ -55,6 +55,9 @@ static const char *const opt_name_bitstream_filters[]         = {"bsf", "absf",
 static const char *const opt_name_copy_initial_nonkeyframes[] = {"copyinkf", NULL};
 static const char *const opt_name_copy_prior_start[]          = {"copypriorss", NULL};
 static const char *const opt_name_disposition[]               = {"disposition", NULL};
+static const char *const opt_name_enc_chunks[]                = {"enc_chunks", NULL};
+static const char *const opt_name_enc_chunk_frames[]          = {"enc_chunk_frames", NULL};
+static const char *const opt_name_enc_chunk_queue_size[]      = {"enc_chunk_queue_size", NULL};
 static const char *const opt_name_enc_time_bases[]            = {"enc_time_base", NULL};
 static const char *const opt_name_enc_stats_pre[]             = {"enc_stats_pre", NULL};
 static const char *const opt_name_enc_stats_post[]            = {"enc_stats_post", NULL};
@@ -1415,6 +1418,26 @@ static int ost_add(Muxer *mux, const OptionsContext *o, enum AVMediaType type,
     if (ret < 0)
         return ret;
 
+    if (ost->enc_ctx &&
+        (type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_AUDIO)) {
+        MATCH_PER_STREAM_OPT(enc_chunks, i, ost->enc_chunks, oc, st);
+        MATCH_PER_STREAM_OPT(enc_chunk_frames, i, ost->enc_chunk_frames, oc, st);
+        ost->enc_chunk_queue_size = 256 * 1024 * 1024;
+        MATCH_PER_STREAM_OPT(enc_chunk_queue_size, i, ost->enc_chunk_queue_size, oc, st);
+        if (ost->enc_chunks > 1) {
+            if (ost->enc_ctx->flags & (AV_CODEC_FLAG_PASS1 | AV_CODEC_FLAG_PASS2) ||
+                ost->enc_ctx->rc_override_count) {
+                av_log(ost, AV_LOG_FATAL, "-enc_chunks cannot be combined with "
+                       "two-pass encoding or -rc_override\n");
+                return AVERROR(EINVAL);
+            }
+            if (ost->enc_chunk_frames < 0 || ost->enc_chunk_queue_size < 0) {
+                av_log(ost, AV_LOG_FATAL, "Invalid chunk length or queue size\n");
+                return AVERROR(EINVAL);
+            }
+        }
+    }
+
     if (type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_AUDIO) {
         ret = ost_get_filters(o, oc, ost, &filters);
         if (ret < 0)
@@ -29,6 +29,7 @@
 
 #include "ffmpeg.h"
 #include "cmdutils.h"
+#include "mem_budget.h"
 #include "opt_common.h"
 #include "sync_queue.h"
 
@@ -326,6 +327,35 @@ static int opt_abort_on(void *optctx, const char *opt, const char *arg)
     return av_opt_eval_flags(&pclass, &opts[0], arg, &abort_on_flags);
 }
 
+static int opt_max_queue_mem(void *optctx, const char *opt, const char *arg)
+{
+    double lim;
+    int ret;
+
+    ret = parse_number(opt, arg, OPT_INT64, 0, INT64_MAX, &lim);
+    if (ret < 0)
+        return ret;
+
+    mem_budget_set_limit(lim);
+    return 0;
+}
+
+static int opt_log_async(void *optctx, const char *opt, const char *arg)
+{
+    double size;
+    int ret;
+
+    ret = parse_number(opt, arg, OPT_INT64, 0, INT_MAX, &size);
+    if (ret < 0)
+        return ret;
+
+    ret = av_log_set_async(size);
+    if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Cannot set up asynchronous logging: %s\n",
+               av_err2str(ret));
+    return ret;
+}
+
 static int opt_stats_period(void *optctx, const char *opt, const char *arg)
 {
     int64_t user_stats_period;
@@ -1593,6 +1623,10 @@ const OptionDef options[] = {
         "print progress report during encoding", },
     { "stats_period",    HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_stats_period },
         "set the period at which ffmpeg updates stats and -progress output", "time" },
+    { "max_queue_mem",   HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_max_queue_mem },
+        "set the limit for the data queued between the processing stages", "bytes" },
+    { "log_async",       HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_log_async },
+        "write log messages from a background thread, with per-thread buffers of the given size", "bytes" },
     { "attach",         HAS_ARG | OPT_PERFILE | OPT_EXPERT |
                         OPT_OUTPUT,                                  { .func_arg = opt_attach },
         "add an attachment to the output file", "filename" },
@@ -1829,6 +1863,12 @@ const OptionDef options[] = {
         "maximum number of packets that can be buffered while waiting for all streams to initialize", "packets" },
     { "muxing_queue_data_threshold", HAS_ARG | OPT_INT | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT, { .off = OFFSET(muxing_queue_data_threshold) },
         "set the threshold after which max_muxing_queue_size is taken into account", "bytes" },
+    { "enc_chunks", HAS_ARG | OPT_INT | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT, { .off = OFFSET(enc_chunks) },
+        "encode this number of independent chunks in parallel with separate encoder instances (experimental)", "number" },
+    { "enc_chunk_frames", HAS_ARG | OPT_INT | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT, { .off = OFFSET(enc_chunk_frames) },
+        "set the length of the chunks encoded in parallel", "frames" },
+    { "enc_chunk_queue_size", HAS_ARG | OPT_INT | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT, { .off = OFFSET(enc_chunk_queue_size) },
+        "set the maximum size of the raw frames queued for one chunk", "bytes" },
 
     /* data codec support */
     { "dcodec", HAS_ARG | OPT_DATA | OPT_PERFILE | OPT_EXPERT | OPT_INPUT | OPT_OUTPUT, { .func_arg = opt_data_codec },
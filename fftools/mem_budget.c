@@ -0,0 +1,171 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/log.h"
+#include "libavutil/macros.h"
+#include "libavutil/thread.h"
+
+#include "libavcodec/packet.h"
+
+#include "mem_budget.h"
+
+static const char *const stage_names[MEM_STAGE_NB] = {
+    [MEM_STAGE_DEMUX]  = "demux",
+    [MEM_STAGE_DEC]    = "decode",
+    [MEM_STAGE_FILTER] = "filter",
+    [MEM_STAGE_ENC]    = "encode",
+    [MEM_STAGE_MUX]    = "mux",
+};
+
+static int64_t              budget_limit;
+
+static atomic_int_least64_t total_used;
+static atomic_int_least64_t total_peak;
+static atomic_int_least64_t stage_used[MEM_STAGE_NB];
+static atomic_int_least64_t stage_peak[MEM_STAGE_NB];
+// data that is released without help from the waiting threads
+static atomic_int_least64_t async_used;
+// data that only the thread that queued it can release
+static atomic_int_least64_t held_used;
+
+// signalled on every release while a thread waits in mem_budget_wait()
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  wait_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int      nb_waiting;
+
+static void update_peak(atomic_int_least64_t *peak, int64_t val)
+{
+    int_least64_t cur = atomic_load(peak);
+
+    while (val > cur && !atomic_compare_exchange_weak(peak, &cur, val))
+        ;
+}
+
+void mem_budget_set_limit(int64_t limit)
+{
+    budget_limit = limit;
+}
+
+void mem_budget_update(enum MemBudgetStage stage, int64_t size)
+{
+    int64_t used;
+
+    used = atomic_fetch_add(&stage_used[stage], size) + size;
+    update_peak(&stage_peak[stage], used);
+
+    used = atomic_fetch_add(&total_used, size) + size;
+    update_peak(&total_peak, used);
+
+    /* a waiter that did not see this release yet holds the lock
+     * until it is waiting on the condition */
+    if (size < 0 && atomic_load(&nb_waiting)) {
+        pthread_mutex_lock(&wait_lock);
+        pthread_cond_broadcast(&wait_cond);
+        pthread_mutex_unlock(&wait_lock);
+    }
+}
+
+void mem_budget_update_async(enum MemBudgetStage stage, int64_t size)
+{
+    atomic_fetch_add(&async_used, size);
+    mem_budget_update(stage, size);
+}
+
+void mem_budget_update_held(enum MemBudgetStage stage, int64_t size)
+{
+    atomic_fetch_add(&held_used, size);
+    mem_budget_update(stage, size);
+}
+
+int mem_budget_exceeded(void)
+{
+    return budget_limit > 0 && atomic_load(&total_used) > budget_limit;
+}
+
+int mem_budget_wait(int (*progress)(void *opaque), void *opaque)
+{
+    int ret = 0;
+
+    if (!mem_budget_exceeded())
+        return 0;
+
+    pthread_mutex_lock(&wait_lock);
+    atomic_fetch_add(&nb_waiting, 1);
+
+    while (mem_budget_exceeded()) {
+        if (progress) {
+            if (!progress(opaque)) {
+                ret = AVERROR(ENOSPC);
+                break;
+            }
+        } else {
+            if (atomic_load(&held_used) > budget_limit) {
+                ret = AVERROR(ENOSPC);
+                break;
+            }
+            /* the other producers are waiting for this thread */
+            if (atomic_load(&async_used) <= 0)
+                break;
+        }
+        pthread_cond_wait(&wait_cond, &wait_lock);
+    }
+
+    atomic_fetch_sub(&nb_waiting, 1);
+    pthread_mutex_unlock(&wait_lock);
+
+    return ret;
+}
+
+void mem_budget_log(void *logctx, int level)
+{
+    av_log(logctx, level, "Peak queued data:");
+    for (int i = 0; i < MEM_STAGE_NB; i++)
+        av_log(logctx, level, " %s %"PRId64"kB", stage_names[i],
+               (int64_t)atomic_load(&stage_peak[i]) >> 10);
+    av_log(logctx, level, " total %"PRId64"kB", (int64_t)atomic_load(&total_peak) >> 10);
+    if (budget_limit > 0)
+        av_log(logctx, level, " (limit %"PRId64"kB)", budget_limit >> 10);
+    av_log(logctx, level, "\n");
+}
+
+size_t mem_budget_packet_size(const void *obj)
+{
+    const AVPacket *pkt = obj;
+
+    return pkt->buf ? pkt->buf->size : pkt->size;
+}
+
+size_t mem_budget_frame_size(const void *obj)
+{
+    const AVFrame *frame = obj;
+    size_t size = 0;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        size += frame->buf[i]->size;
+    for (int i = 0; i < frame->nb_extended_buf; i++)
+        size += frame->extended_buf[i]->size;
+
+    return size;
+}
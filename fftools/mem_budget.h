@@ -0,0 +1,103 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef FFTOOLS_MEM_BUDGET_H
+#define FFTOOLS_MEM_BUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Process-wide accounting of the data held in the queues between the
+ * processing stages. All functions except mem_budget_set_limit() may be
+ * called from any thread.
+ */
+
+enum MemBudgetStage {
+    MEM_STAGE_DEMUX,
+    MEM_STAGE_DEC,
+    MEM_STAGE_FILTER,
+    MEM_STAGE_ENC,
+    MEM_STAGE_MUX,
+
+    MEM_STAGE_NB,
+};
+
+/**
+ * Set the limit for the total queued data in bytes, 0 disables the limit.
+ */
+void mem_budget_set_limit(int64_t limit);
+
+/**
+ * Add size bytes (negative when data leaves a queue) to the usage of the
+ * given stage.
+ */
+void mem_budget_update(enum MemBudgetStage stage, int64_t size);
+
+/**
+ * Same as mem_budget_update(), for data in a queue whose consumer never waits
+ * for the memory budget itself (a muxer or chunk encoder thread). Such data
+ * is released without help from any waiting thread, see mem_budget_wait().
+ */
+void mem_budget_update_async(enum MemBudgetStage stage, int64_t size);
+
+/**
+ * Same as mem_budget_update(), for data in a buffer that only the thread
+ * filling it can drain (a muxing queue before the header is written, frames
+ * kept while a filtergraph waits for its other inputs), see
+ * mem_budget_wait().
+ */
+void mem_budget_update_held(enum MemBudgetStage stage, int64_t size);
+
+/**
+ * @return nonzero when the total queued data is over the limit
+ */
+int mem_budget_exceeded(void);
+
+/**
+ * Wait until the total queued data is within the limit. The waiting thread
+ * is woken up whenever data is released.
+ *
+ * @param progress callback returning nonzero as long as other threads can be
+ *                 expected to release data; called with an internal lock
+ *                 held. If NULL, the data queued with
+ *                 mem_budget_update_async() is waited for, but not the data
+ *                 of other producers, which wait for the calling thread.
+ * @return 0 when the queued data is within the limit or nothing more can be
+ *         waited for, AVERROR(ENOSPC) when progress returns zero or, without
+ *         progress, when the data queued with mem_budget_update_held() alone
+ *         is over the limit
+ */
+int mem_budget_wait(int (*progress)(void *opaque), void *opaque);
+
+/**
+ * Log the peak usage of every stage and of the total.
+ */
+void mem_budget_log(void *logctx, int level);
+
+/**
+ * @return the size of the data referenced by an AVPacket
+ */
+size_t mem_budget_packet_size(const void *pkt);
+
+/**
+ * @return the size of the data referenced by an AVFrame
+ */
+size_t mem_budget_frame_size(const void *frame);
+
+#endif // FFTOOLS_MEM_BUDGET_H
@@ -37,6 +37,7 @@ enum {
 typedef struct FifoElem {
     void        *obj;
     unsigned int stream_idx;
+    size_t       size;
 } FifoElem;
 
 struct ThreadQueue {
@@ -48,10 +49,22 @@ struct ThreadQueue {
     ObjPool *obj_pool;
     void   (*obj_move)(void *dst, void *src);
 
+    enum MemBudgetStage mem_stage;
+    size_t (*obj_size)(const void *obj);
+    int      mem_async;
+
     pthread_mutex_t lock;
     pthread_cond_t  cond;
 };
 
+static void mem_update(ThreadQueue *tq, int64_t size)
+{
+    if (tq->mem_async)
+        mem_budget_update_async(tq->mem_stage, size);
+    else
+        mem_budget_update(tq->mem_stage, size);
+}
+
 void tq_free(ThreadQueue **ptq)
 {
     ThreadQueue *tq = *ptq;
@@ -61,8 +74,11 @@ void tq_free(ThreadQueue **ptq)
 
     if (tq->fifo) {
         FifoElem elem;
-        while (av_fifo_read(tq->fifo, &elem, 1) >= 0)
+        while (av_fifo_read(tq->fifo, &elem, 1) >= 0) {
+            if (elem.size)
+                mem_update(tq, -(int64_t)elem.size);
             objpool_release(tq->obj_pool, &elem.obj);
+        }
     }
     av_fifo_freep2(&tq->fifo);
 
@@ -117,6 +133,23 @@ fail:
     return NULL;
 }
 
+void tq_set_mem_budget(ThreadQueue *tq, enum MemBudgetStage stage,
+                       size_t (*obj_size)(const void *obj), int async)
+{
+    tq->mem_stage = stage;
+    tq->obj_size  = obj_size;
+    tq->mem_async = async;
+}
+
+/* Queue is full, or the memory budget is exceeded and our consumer still has
+ * data to process. Every queue can always hold at least one item, so this
+ * can only make the queue behave like a shorter one and never deadlocks. */
+static int send_blocked(ThreadQueue *tq)
+{
+    return !av_fifo_can_write(tq->fifo) ||
+           (tq->obj_size && av_fifo_can_read(tq->fifo) && mem_budget_exceeded());
+}
+
 int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
 {
     int *finished;
@@ -132,7 +165,7 @@ int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
         goto finish;
     }
 
-    while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo))
+    while (!(*finished & FINISHED_RECV) && send_blocked(tq))
         pthread_cond_wait(&tq->cond, &tq->lock);
 
     if (*finished & FINISHED_RECV) {
@@ -145,6 +178,11 @@ int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
         if (ret < 0)
             goto finish;
 
+        if (tq->obj_size) {
+            elem.size = tq->obj_size(data);
+            mem_update(tq, elem.size);
+        }
+
         tq->obj_move(elem.obj, data);
 
         ret = av_fifo_write(tq->fifo, &elem, 1);
@@ -165,6 +203,8 @@ static int receive_locked(ThreadQueue *tq, int *stream_idx,
     unsigned int nb_finished = 0;
 
     if (av_fifo_read(tq->fifo, &elem, 1) >= 0) {
+        if (elem.size)
+            mem_update(tq, -(int64_t)elem.size);
         tq->obj_move(data, elem.obj);
         objpool_release(tq->obj_pool, &elem.obj);
         *stream_idx = elem.stream_idx;
@@ -21,6 +21,7 @@
 
 #include <string.h>
 
+#include "mem_budget.h"
 #include "objpool.h"
 
 typedef struct ThreadQueue ThreadQueue;
@@ -40,6 +41,20 @@ ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
                       ObjPool *obj_pool, void (*obj_move)(void *dst, void *src));
 void         tq_free(ThreadQueue **tq);
 
+/**
+ * Account the items stored in the queue to the given stage of the process-wide
+ * memory budget. While the budget is exceeded, tq_send() additionally blocks
+ * until the queue is empty.
+ *
+ * Must be called before the queue is used.
+ *
+ * @param obj_size callback that returns the size of the data in an item
+ * @param async    nonzero if the consumer never waits for the memory budget
+ *                 itself, see mem_budget_update_async()
+ */
+void tq_set_mem_budget(ThreadQueue *tq, enum MemBudgetStage stage,
+                       size_t (*obj_size)(const void *obj), int async);
+
 /**
  * Send an item for the given stream to the queue.
  *
@@ -2116,6 +2116,17 @@ typedef struct AVCodecContext {
      *   an error.
      */
     int64_t frame_num;
+
+    /**
+     * Maximum number of frames of output delay that frame threading may add
+     * when decoding. The number of frame threads is limited to one more than
+     * this value; with 0, frame threading is not used and slice threading is
+     * used instead if the decoder supports it. Negative values mean no limit.
+     *
+     * - encoding: unused
+     * - decoding: Set by user.
+     */
+    int thread_max_delay;
 } AVCodecContext;
 
 /**
@@ -41,7 +41,8 @@
  *
  * Threading requires more than one thread.
  * Frame threading requires entire frames to be passed to the codec,
- * and introduces extra decoding delay, so is incompatible with low_delay.
+ * and introduces extra decoding delay, so is incompatible with low_delay
+ * and with a zero thread_max_delay.
  *
  * @param avctx The context.
  */
@@ -49,6 +50,7 @@ static void validate_thread_parameters(AVCodecContext *avctx)
 {
     int frame_threading_supported = (avctx->codec->capabilities & AV_CODEC_CAP_FRAME_THREADS)
                                 && !(avctx->flags  & AV_CODEC_FLAG_LOW_DELAY)
+                                && avctx->thread_max_delay != 0
                                 && !(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS);
     if (avctx->thread_count == 1) {
         avctx->active_thread_type = 0;
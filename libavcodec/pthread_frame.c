@@ -865,6 +865,14 @@ int ff_frame_thread_init(AVCodecContext *avctx)
             thread_count = avctx->thread_count = 1;
     }
 
+    /* every frame thread adds one frame of output delay */
+    if (avctx->thread_max_delay > 0 && thread_count > avctx->thread_max_delay + 1) {
+        av_log(avctx, AV_LOG_VERBOSE,
+               "Limiting frame threads from %d to %d for a maximum delay of %d frames.\n",
+               thread_count, avctx->thread_max_delay + 1, avctx->thread_max_delay);
+        thread_count = avctx->thread_count = avctx->thread_max_delay + 1;
+    }
+
     if (thread_count <= 1) {
         avctx->active_thread_type = 0;
         return 0;
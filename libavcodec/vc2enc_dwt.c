@@ -20,6 +20,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <string.h>
+
+#include "config.h"
 #include "libavutil/attributes.h"
 #include "libavutil/mem.h"
 #include "vc2enc_dwt.h"
@@ -52,7 +55,9 @@ static av_always_inline void deinterleave(dwtcoef *linell, ptrdiff_t stride,
     }
 }
 
-static void vc2_subband_dwt_97(VC2TransformContext *t, dwtcoef *data,
+/* The original interleaved versions, still used for bands that are too
+ * narrow or short for the edge handling of the row based ones below. */
+static void dwt_97_interleaved(VC2TransformContext *t, dwtcoef *data,
                                ptrdiff_t stride, int width, int height)
 {
     int x, y;
@@ -137,7 +142,7 @@ static void vc2_subband_dwt_97(VC2TransformContext *t, dwtcoef *data,
     deinterleave(data, stride, width, height, synth);
 }
 
-static void vc2_subband_dwt_53(VC2TransformContext *t, dwtcoef *data,
+static void dwt_53_interleaved(VC2TransformContext *t, dwtcoef *data,
                                ptrdiff_t stride, int width, int height)
 {
     int x, y;
@@ -211,35 +216,134 @@ static void vc2_subband_dwt_53(VC2TransformContext *t, dwtcoef *data,
     deinterleave(data, stride, width, height, synth);
 }
 
+/*
+ * The row based transforms below compute exactly the same as the interleaved
+ * ones. The horizontal pass splits every row into its low and high halves
+ * right away, so each lifting step becomes an operation on whole rows (or
+ * row halves) that maps directly to SIMD, and the final deinterleave only
+ * needs to reorder rows.
+ */
+#define ROW(y) (synth + (y) * synth_width)
+
+static void reorder_rows(dwtcoef *data, ptrdiff_t stride, int width, int height,
+                         const dwtcoef *synth)
+{
+    const ptrdiff_t synth_width = width << 1;
+
+    for (int y = 0; y < height; y++) {
+        memcpy(data + y * stride,            ROW(2 * y),     synth_width * sizeof(*data));
+        memcpy(data + (height + y) * stride, ROW(2 * y + 1), synth_width * sizeof(*data));
+    }
+}
+
+static void vc2_subband_dwt_97(VC2TransformContext *t, dwtcoef *data,
+                               ptrdiff_t stride, int width, int height)
+{
+    const VC2TransformDSPContext *dsp = &t->dsp;
+    dwtcoef *synth = t->buffer;
+    const ptrdiff_t synth_width  = width  << 1;
+    const int       synth_height = height << 1;
+
+    if (width < 3 || height < 3) {
+        dwt_97_interleaved(t, data, stride, width, height);
+        return;
+    }
+
+    /* Horizontal synthesis. The split shifts in the extra precision bit. */
+    for (int y = 0; y < synth_height; y++) {
+        dwtcoef *l = ROW(y), *h = l + width;
+
+        dsp->split_row(l, h, data + y * stride, width);
+
+        /* Lifting stage 2. */
+        h[0] -= (8*l[0] + 9*l[1] - l[2] + 8) >> 4;
+        dsp->predict_97(h + 1, l, l + 1, l + 2, l + 3, width - 3);
+        h[width - 1] -= (17*l[width - 1] - l[width - 2] + 8) >> 4;
+        h[width - 2] -= (8*l[width - 1] + 9*l[width - 2] - l[width - 3] + 8) >> 4;
+
+        /* Lifting stage 1. */
+        l[0] += (h[0] + h[0] + 2) >> 2;
+        dsp->update(l + 1, h, h + 1, width - 1);
+    }
+
+    /* Vertical synthesis: Lifting stage 2. */
+    dsp->predict_97(ROW(1), ROW(0), ROW(0), ROW(2), ROW(4), synth_width);
+    for (int y = 1; y < height - 2; y++)
+        dsp->predict_97(ROW(2*y + 1), ROW(2*y - 2), ROW(2*y), ROW(2*y + 2),
+                        ROW(2*y + 4), synth_width);
+    dsp->predict_97(ROW(synth_height - 1), ROW(synth_height - 2), ROW(synth_height - 2),
+                    ROW(synth_height - 2), ROW(synth_height - 4), synth_width);
+    dsp->predict_97(ROW(synth_height - 3), ROW(synth_height - 6), ROW(synth_height - 4),
+                    ROW(synth_height - 2), ROW(synth_height - 2), synth_width);
+
+    /* Vertical synthesis: Lifting stage 1. */
+    dsp->update(ROW(0), ROW(1), ROW(1), synth_width);
+    for (int y = 1; y < height; y++)
+        dsp->update(ROW(2*y), ROW(2*y - 1), ROW(2*y + 1), synth_width);
+
+    reorder_rows(data, stride, width, height, synth);
+}
+
+static void vc2_subband_dwt_53(VC2TransformContext *t, dwtcoef *data,
+                               ptrdiff_t stride, int width, int height)
+{
+    const VC2TransformDSPContext *dsp = &t->dsp;
+    dwtcoef *synth = t->buffer;
+    const ptrdiff_t synth_width  = width  << 1;
+    const int       synth_height = height << 1;
+
+    if (width < 2 || height < 2) {
+        dwt_53_interleaved(t, data, stride, width, height);
+        return;
+    }
+
+    /* Horizontal synthesis. The split shifts in the extra precision bit. */
+    for (int y = 0; y < synth_height; y++) {
+        dwtcoef *l = ROW(y), *h = l + width;
+
+        dsp->split_row(l, h, data + y * stride, width);
+
+        /* Lifting stage 2. */
+        dsp->predict_53(h, l, l + 1, width - 1);
+        h[width - 1] -= (2*l[width - 1] + 1) >> 1;
+
+        /* Lifting stage 1. */
+        l[0] += (2*h[0] + 2) >> 2;
+        dsp->update(l + 1, h, h + 1, width - 1);
+    }
+
+    /* Vertical synthesis: Lifting stage 2. */
+    for (int y = 0; y < height - 1; y++)
+        dsp->predict_53(ROW(2*y + 1), ROW(2*y), ROW(2*y + 2), synth_width);
+    dsp->predict_53(ROW(synth_height - 1), ROW(synth_height - 2),
+                    ROW(synth_height - 2), synth_width);
+
+    /* Vertical synthesis: Lifting stage 1. */
+    dsp->update(ROW(0), ROW(1), ROW(1), synth_width);
+    for (int y = 1; y < height; y++)
+        dsp->update(ROW(2*y), ROW(2*y - 1), ROW(2*y + 1), synth_width);
+
+    reorder_rows(data, stride, width, height, synth);
+}
+
 static av_always_inline void dwt_haar(VC2TransformContext *t, dwtcoef *data,
                                       ptrdiff_t stride, int width, int height,
                                       const int s)
 {
-    int x, y;
-    dwtcoef *synth = t->buffer, *synthl = synth, *datal = data;
+    const VC2TransformDSPContext *dsp = &t->dsp;
+    dwtcoef *synth = t->buffer;
     const ptrdiff_t synth_width  = width  << 1;
-    const ptrdiff_t synth_height = height << 1;
+    const int       synth_height = height << 1;
 
     /* Horizontal synthesis. */
-    for (y = 0; y < synth_height; y++) {
-        for (x = 0; x < synth_width; x += 2) {
-            synthl[y*synth_width + x + 1] = (datal[y*stride + x + 1] - datal[y*stride + x]) * (1 << s);
-            synthl[y*synth_width + x] = datal[y*stride + x + 0] * (1 << s) +
-                                        ((synthl[y*synth_width + x + 1] + 1) >> 1);
-        }
-    }
+    for (int y = 0; y < synth_height; y++)
+        dsp->haar_row(ROW(y), ROW(y) + width, data + y * stride, width, s);
 
     /* Vertical synthesis. */
-    for (x = 0; x < synth_width; x++) {
-        for (y = 0; y < synth_height; y += 2) {
-            synthl[(y + 1)*synth_width + x] = synthl[(y + 1)*synth_width + x] -
-                                              synthl[y*synth_width + x];
-            synthl[y*synth_width + x] = synthl[y*synth_width + x] +
-                                        ((synthl[(y + 1)*synth_width + x] + 1) >> 1);
-        }
-    }
+    for (int y = 0; y < synth_height; y += 2)
+        dsp->haar_col(ROW(y), ROW(y + 1), synth_width);
 
-    deinterleave(data, stride, width, height, synth);
+    reorder_rows(data, stride, width, height, synth);
 }
 
 static void vc2_subband_dwt_haar(VC2TransformContext *t, dwtcoef *data,
@@ -254,6 +358,66 @@ static void vc2_subband_dwt_haar_shift(VC2TransformContext *t, dwtcoef *data,
     dwt_haar(t, data, stride, width, height, 1);
 }
 
+static void split_row_c(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n)
+{
+    for (int i = 0; i < n; i++) {
+        lo[i] = src[2*i]     * 2;
+        hi[i] = src[2*i + 1] * 2;
+    }
+}
+
+static void haar_row_c(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n,
+                       int shift)
+{
+    for (int i = 0; i < n; i++) {
+        hi[i] = (src[2*i + 1] - src[2*i]) * (1 << shift);
+        lo[i] = src[2*i] * (1 << shift) + ((hi[i] + 1) >> 1);
+    }
+}
+
+static void haar_col_c(dwtcoef *lo, dwtcoef *hi, int n)
+{
+    for (int i = 0; i < n; i++) {
+        hi[i] -= lo[i];
+        lo[i] += (hi[i] + 1) >> 1;
+    }
+}
+
+static void predict_53_c(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] -= (a[i] + b[i] + 1) >> 1;
+}
+
+static void predict_97_c(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,
+                         const dwtcoef *c, const dwtcoef *d, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] -= (9*(b[i] + c[i]) - a[i] - d[i] + 8) >> 4;
+}
+
+static void update_c(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] += (a[i] + b[i] + 2) >> 2;
+}
+
+av_cold void ff_vc2enc_init_transform_dsp(VC2TransformDSPContext *c)
+{
+    c->split_row  = split_row_c;
+    c->haar_row   = haar_row_c;
+    c->haar_col   = haar_col_c;
+    c->predict_53 = predict_53_c;
+    c->predict_97 = predict_97_c;
+    c->update     = update_c;
+
+#if ARCH_AARCH64
+    ff_vc2enc_init_transform_dsp_aarch64(c);
+#elif ARCH_X86
+    ff_vc2enc_init_transform_dsp_x86(c);
+#endif
+}
+
 av_cold int ff_vc2enc_init_transforms(VC2TransformContext *s, int p_stride,
                                       int p_height, int slice_w, int slice_h)
 {
@@ -262,6 +426,8 @@ av_cold int ff_vc2enc_init_transforms(VC2TransformContext *s, int p_stride,
     s->vc2_subband_dwt[VC2_TRANSFORM_HAAR]   = vc2_subband_dwt_haar;
     s->vc2_subband_dwt[VC2_TRANSFORM_HAAR_S] = vc2_subband_dwt_haar_shift;
 
+    ff_vc2enc_init_transform_dsp(&s->dsp);
+
     /* Pad by the slice size, only matters for non-Haar wavelets */
     s->buffer = av_calloc((p_stride + slice_w)*(p_height + slice_h), sizeof(dwtcoef));
     if (!s->buffer)
@@ -39,9 +39,31 @@ enum VC2TransformType {
     VC2_TRANSFORMS_NB
 };
 
+/* Row kernels the transforms are built from. They process exactly n
+ * elements (n >= 0); the pointers need no particular alignment and dst
+ * never overlaps the inputs. */
+typedef struct VC2TransformDSPContext {
+    /* lo[i] = src[2*i] * 2, hi[i] = src[2*i + 1] * 2 */
+    void (*split_row)(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n);
+    /* hi[i] = (src[2*i + 1] - src[2*i]) << shift,
+     * lo[i] = (src[2*i] << shift) + ((hi[i] + 1) >> 1) */
+    void (*haar_row)(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n,
+                     int shift);
+    /* hi[i] -= lo[i], lo[i] += (hi[i] + 1) >> 1 */
+    void (*haar_col)(dwtcoef *lo, dwtcoef *hi, int n);
+    /* dst[i] -= (a[i] + b[i] + 1) >> 1 */
+    void (*predict_53)(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b, int n);
+    /* dst[i] -= (9 * (b[i] + c[i]) - a[i] - d[i] + 8) >> 4 */
+    void (*predict_97)(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,
+                       const dwtcoef *c, const dwtcoef *d, int n);
+    /* dst[i] += (a[i] + b[i] + 2) >> 2 */
+    void (*update)(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b, int n);
+} VC2TransformDSPContext;
+
 typedef struct VC2TransformContext {
     dwtcoef *buffer;
     int padding;
+    VC2TransformDSPContext dsp;
     void (*vc2_subband_dwt[VC2_TRANSFORMS_NB])(struct VC2TransformContext *t,
                                                dwtcoef *data, ptrdiff_t stride,
                                                int width, int height);
@@ -51,4 +73,8 @@ int  ff_vc2enc_init_transforms(VC2TransformContext *t, int p_stride, int p_heigh
                                int slice_w, int slice_h);
 void ff_vc2enc_free_transforms(VC2TransformContext *t);
 
+void ff_vc2enc_init_transform_dsp(VC2TransformDSPContext *c);
+void ff_vc2enc_init_transform_dsp_aarch64(VC2TransformDSPContext *c);
+void ff_vc2enc_init_transform_dsp_x86(VC2TransformDSPContext *c);
+
 #endif /* AVCODEC_VC2ENC_DWT_H */
@@ -0,0 +1,203 @@
+;******************************************************************************
+;* VC-2 encoder wavelet transform row kernels
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; Run the operation %1 over n elements, with iq as the byte offset into the
+; rows: mmsize/4 elements per iteration, then one at a time. The operation is
+; given the load/store instruction and the register prefix to use.
+%macro DWT_LOOP 1
+    movsxdifnidn  nq, nd
+    shl           nq, 2
+    xor           iq, iq
+    sub           nq, mmsize
+    jl .tail
+.loop:
+    %1          movu, m
+    add           iq, mmsize
+    cmp           iq, nq
+    jle .loop
+.tail:
+    add           nq, mmsize
+    cmp           iq, nq
+    jge .end
+.loop1:
+    %1          movd, xm
+    add           iq, 4
+    cmp           iq, nq
+    jl .loop1
+.end:
+    RET
+%endmacro
+
+; even source samples in %2 %+ 2, odd ones in %2 %+ 0
+%macro LOAD_SPLIT 2
+%ifidn %2, m
+    movu          m0, [srcq + 2*iq]
+    movu          m1, [srcq + 2*iq + mmsize]
+    shufps        m2, m0, m1, q2020
+    shufps        m0, m0, m1, q3131
+%if cpuflag(avx2)
+    vpermq        m2, m2, q3120
+    vpermq        m0, m0, q3120
+%endif
+%else
+    movd         xm2, [srcq + 2*iq]
+    movd         xm0, [srcq + 2*iq + 4]
+%endif
+%endmacro
+
+%macro SPLIT_ROW_OP 2
+    LOAD_SPLIT    %1, %2
+    paddd         %2 %+ 2, %2 %+ 2
+    paddd         %2 %+ 0, %2 %+ 0
+    %1            [loq + iq], %2 %+ 2
+    %1            [hiq + iq], %2 %+ 0
+%endmacro
+
+; m4 = -1, xm5 = shift
+%macro HAAR_ROW_OP 2
+    LOAD_SPLIT    %1, %2
+    pslld         %2 %+ 2, xm5
+    pslld         %2 %+ 0, xm5
+    psubd         %2 %+ 0, %2 %+ 2
+    mova          %2 %+ 1, %2 %+ 0
+    psubd         %2 %+ 1, %2 %+ 4
+    psrad         %2 %+ 1, 1
+    paddd         %2 %+ 2, %2 %+ 1
+    %1            [loq + iq], %2 %+ 2
+    %1            [hiq + iq], %2 %+ 0
+%endmacro
+
+; m3 = -1
+%macro HAAR_COL_OP 2
+    %1            %2 %+ 0, [loq + iq]
+    %1            %2 %+ 1, [hiq + iq]
+    psubd         %2 %+ 1, %2 %+ 0
+    mova          %2 %+ 2, %2 %+ 1
+    psubd         %2 %+ 2, %2 %+ 3
+    psrad         %2 %+ 2, 1
+    paddd         %2 %+ 0, %2 %+ 2
+    %1            [loq + iq], %2 %+ 0
+    %1            [hiq + iq], %2 %+ 1
+%endmacro
+
+; m3 = -1
+%macro PREDICT_53_OP 2
+    %1            %2 %+ 0, [src0q + iq]
+    %1            %2 %+ 1, [src1q + iq]
+    paddd         %2 %+ 0, %2 %+ 1
+    psubd         %2 %+ 0, %2 %+ 3
+    psrad         %2 %+ 0, 1
+    %1            %2 %+ 1, [dstq + iq]
+    psubd         %2 %+ 1, %2 %+ 0
+    %1            [dstq + iq], %2 %+ 1
+%endmacro
+
+; m3 = 8
+%macro PREDICT_97_OP 2
+    %1            %2 %+ 0, [src1q + iq]
+    %1            %2 %+ 1, [src2q + iq]
+    paddd         %2 %+ 0, %2 %+ 1
+    pslld         %2 %+ 1, %2 %+ 0, 3
+    paddd         %2 %+ 0, %2 %+ 1
+    %1            %2 %+ 1, [src0q + iq]
+    psubd         %2 %+ 0, %2 %+ 1
+    %1            %2 %+ 1, [src3q + iq]
+    psubd         %2 %+ 0, %2 %+ 1
+    paddd         %2 %+ 0, %2 %+ 3
+    psrad         %2 %+ 0, 4
+    %1            %2 %+ 1, [dstq + iq]
+    psubd         %2 %+ 1, %2 %+ 0
+    %1            [dstq + iq], %2 %+ 1
+%endmacro
+
+; m3 = 2
+%macro UPDATE_OP 2
+    %1            %2 %+ 0, [src0q + iq]
+    %1            %2 %+ 1, [src1q + iq]
+    paddd         %2 %+ 0, %2 %+ 1
+    paddd         %2 %+ 0, %2 %+ 3
+    psrad         %2 %+ 0, 2
+    %1            %2 %+ 1, [dstq + iq]
+    paddd         %2 %+ 1, %2 %+ 0
+    %1            [dstq + iq], %2 %+ 1
+%endmacro
+
+%macro VC2ENC_DWT_FUNCS 0
+;-----------------------------------------------------------------------------
+; void ff_vc2enc_split_row(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n)
+;-----------------------------------------------------------------------------
+cglobal vc2enc_split_row, 4, 5, 3, lo, hi, src, n, i
+    DWT_LOOP      SPLIT_ROW_OP
+
+;-----------------------------------------------------------------------------
+; void ff_vc2enc_haar_row(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n,
+;                         int shift)
+;-----------------------------------------------------------------------------
+cglobal vc2enc_haar_row, 5, 6, 6, lo, hi, src, n, shift, i
+    movd         xm5, shiftd
+    pcmpeqd       m4, m4
+    DWT_LOOP      HAAR_ROW_OP
+
+;-----------------------------------------------------------------------------
+; void ff_vc2enc_haar_col(dwtcoef *lo, dwtcoef *hi, int n)
+;-----------------------------------------------------------------------------
+cglobal vc2enc_haar_col, 3, 4, 4, lo, hi, n, i
+    pcmpeqd       m3, m3
+    DWT_LOOP      HAAR_COL_OP
+
+;-----------------------------------------------------------------------------
+; void ff_vc2enc_predict_53(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,
+;                           int n)
+;-----------------------------------------------------------------------------
+cglobal vc2enc_predict_53, 4, 5, 4, dst, src0, src1, n, i
+    pcmpeqd       m3, m3
+    DWT_LOOP      PREDICT_53_OP
+
+;-----------------------------------------------------------------------------
+; void ff_vc2enc_predict_97(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,
+;                           const dwtcoef *c, const dwtcoef *d, int n)
+;-----------------------------------------------------------------------------
+cglobal vc2enc_predict_97, 6, 7, 4, dst, src0, src1, src2, src3, n, i
+    pcmpeqd       m3, m3
+    psrld         m3, 31
+    pslld         m3, 3
+    DWT_LOOP      PREDICT_97_OP
+
+;-----------------------------------------------------------------------------
+; void ff_vc2enc_update(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b, int n)
+;-----------------------------------------------------------------------------
+cglobal vc2enc_update, 4, 5, 4, dst, src0, src1, n, i
+    pcmpeqd       m3, m3
+    psrld         m3, 31
+    pslld         m3, 1
+    DWT_LOOP      UPDATE_OP
+%endmacro
+
+INIT_XMM sse2
+VC2ENC_DWT_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+VC2ENC_DWT_FUNCS
+%endif
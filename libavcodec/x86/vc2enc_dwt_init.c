@@ -0,0 +1,60 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/vc2enc_dwt.h"
+
+#define DECL_FUNCS(opt)                                                           \
+void ff_vc2enc_split_row_##opt(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src,     \
+                               int n);                                           \
+void ff_vc2enc_haar_row_##opt(dwtcoef *lo, dwtcoef *hi, const dwtcoef *src,      \
+                              int n, int shift);                                 \
+void ff_vc2enc_haar_col_##opt(dwtcoef *lo, dwtcoef *hi, int n);                  \
+void ff_vc2enc_predict_53_##opt(dwtcoef *dst, const dwtcoef *a,                  \
+                                const dwtcoef *b, int n);                        \
+void ff_vc2enc_predict_97_##opt(dwtcoef *dst, const dwtcoef *a,                  \
+                                const dwtcoef *b, const dwtcoef *c,              \
+                                const dwtcoef *d, int n);                        \
+void ff_vc2enc_update_##opt(dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,    \
+                            int n);
+
+DECL_FUNCS(sse2)
+DECL_FUNCS(avx2)
+
+#define SET_FUNCS(opt)                                  \
+    do {                                                \
+        c->split_row  = ff_vc2enc_split_row_##opt;      \
+        c->haar_row   = ff_vc2enc_haar_row_##opt;       \
+        c->haar_col   = ff_vc2enc_haar_col_##opt;       \
+        c->predict_53 = ff_vc2enc_predict_53_##opt;     \
+        c->predict_97 = ff_vc2enc_predict_97_##opt;     \
+        c->update     = ff_vc2enc_update_##opt;         \
+    } while (0)
+
+av_cold void ff_vc2enc_init_transform_dsp_x86(VC2TransformDSPContext *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        SET_FUNCS(sse2);
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        SET_FUNCS(avx2);
+}
@@ -65,6 +65,10 @@
 
 #define MAX_NEURONS 128
 
+/* Number of channels pushed through each network layer at once, so the
+ * weights are read once per batch instead of once per channel. */
+#define MAX_BATCH 8
+
 #define ACTIVATION_TANH    0
 #define ACTIVATION_SIGMOID 1
 #define ACTIVATION_RELU    2
@@ -128,6 +132,19 @@ typedef struct DenoiseState {
     float lastg[NB_BANDS];
     float history[FRAME_SIZE];
     RNNState rnn[2];
+
+    /* Per-frame data kept between the analysis, the batched network
+     * evaluation and the synthesis. */
+    AVComplexFloat X[FREQ_SIZE];
+    AVComplexFloat P[WINDOW_SIZE];
+    float Ex[NB_BANDS], Ep[NB_BANDS];
+    DECLARE_ALIGNED(32, float, Exp)[FFALIGN(NB_BANDS, 4)];
+    DECLARE_ALIGNED(32, float, features)[MAX_NEURONS];
+    DECLARE_ALIGNED(32, float, dense_out)[MAX_NEURONS];
+    DECLARE_ALIGNED(32, float, noise_input)[MAX_NEURONS * 3];
+    DECLARE_ALIGNED(32, float, denoise_input)[MAX_NEURONS * 3];
+    float g[NB_BANDS];
+    float vad_prob;
     AVTXContext *tx, *txi;
     av_tx_fn tx_fn, txi_fn;
 } DenoiseState;
@@ -289,7 +306,7 @@ static int rnnoise_model_from_file(FILE *f, RNNModel **rnn)
     ret->name ## _size = name->nb_neurons; \
     INPUT_ACTIVATION(name->activation); \
     NEW_LINE(); \
-    INPUT_ARRAY(name->input_weights, name->nb_inputs * name->nb_neurons); \
+    INPUT_ARRAY3(name->input_weights, name->nb_inputs, name->nb_neurons, 1); \
     NEW_LINE(); \
     INPUT_ARRAY(name->bias, name->nb_neurons); \
     NEW_LINE(); \
@@ -1024,7 +1041,7 @@ static int compute_frame_features(AudioRNNContext *s, DenoiseState *st, AVComple
     float E = 0;
     float *ceps_0, *ceps_1, *ceps_2;
     float spec_variability = 0;
-    LOCAL_ALIGNED_32(float, Ly, [NB_BANDS]);
+    LOCAL_ALIGNED_32(float, Ly, [FFALIGN(NB_BANDS, 4)]);
     LOCAL_ALIGNED_32(float, p, [WINDOW_SIZE]);
     float pitch_buf[PITCH_BUF_SIZE>>1];
     int pitch_index;
@@ -1068,6 +1085,8 @@ static int compute_frame_features(AudioRNNContext *s, DenoiseState *st, AVComple
     features[NB_BANDS+3*NB_DELTA_CEPS] = .01*(pitch_index-300);
     logMax = -2;
     follow = -2;
+    /* dct() reads the padding */
+    RNN_CLEAR(Ly + NB_BANDS, FFALIGN(NB_BANDS, 4) - NB_BANDS);
 
     for (int i = 0; i < NB_BANDS; i++) {
         Ly[i] = log10f(1e-2f + Ex[i]);
@@ -1249,39 +1268,52 @@ static inline float sigmoid_approx(float x)
     return .5f + .5f*tansig_approx(.5f*x);
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+/*
+ * The layers are evaluated for a batch of nb channels at a time: every
+ * weight row is applied to all channels while it is in cache. The dot
+ * products go through AVFloatDSPContext.scalarproduct_float, so inputs and
+ * weight rows are padded with zeros to a multiple of 4.
+ */
+static void compute_dense(AudioRNNContext *s, const DenseLayer *layer,
+                          float **output, const float **input, int nb)
 {
-    const int N = layer->nb_neurons, M = layer->nb_inputs, stride = N;
+    const int N = layer->nb_neurons, AM = FFALIGN(layer->nb_inputs, 4);
 
     for (int i = 0; i < N; i++) {
-        /* Compute update gate. */
-        float sum = layer->bias[i];
+        const float *weights = layer->input_weights + i * AM;
 
-        for (int j = 0; j < M; j++)
-            sum += layer->input_weights[j * stride + i] * input[j];
+        for (int c = 0; c < nb; c++) {
+            float sum = layer->bias[i];
 
-        output[i] = WEIGHTS_SCALE * sum;
+            sum += s->fdsp->scalarproduct_float(weights, input[c], AM);
+            output[c][i] = WEIGHTS_SCALE * sum;
+        }
     }
 
-    if (layer->activation == ACTIVATION_SIGMOID) {
-        for (int i = 0; i < N; i++)
-            output[i] = sigmoid_approx(output[i]);
-    } else if (layer->activation == ACTIVATION_TANH) {
-        for (int i = 0; i < N; i++)
-            output[i] = tansig_approx(output[i]);
-    } else if (layer->activation == ACTIVATION_RELU) {
-        for (int i = 0; i < N; i++)
-            output[i] = FFMAX(0, output[i]);
-    } else {
-        av_assert0(0);
+    for (int c = 0; c < nb; c++) {
+        float *out = output[c];
+
+        if (layer->activation == ACTIVATION_SIGMOID) {
+            for (int i = 0; i < N; i++)
+                out[i] = sigmoid_approx(out[i]);
+        } else if (layer->activation == ACTIVATION_TANH) {
+            for (int i = 0; i < N; i++)
+                out[i] = tansig_approx(out[i]);
+        } else if (layer->activation == ACTIVATION_RELU) {
+            for (int i = 0; i < N; i++)
+                out[i] = FFMAX(0, out[i]);
+        } else {
+            av_assert0(0);
+        }
     }
 }
 
-static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, const float *input)
+static void compute_gru(AudioRNNContext *s, const GRULayer *gru,
+                        float **state, const float **input, int nb)
 {
-    LOCAL_ALIGNED_32(float, z, [MAX_NEURONS]);
-    LOCAL_ALIGNED_32(float, r, [MAX_NEURONS]);
-    LOCAL_ALIGNED_32(float, h, [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, z,  [MAX_BATCH], [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, rs, [MAX_BATCH], [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, h,  [MAX_BATCH], [MAX_NEURONS]);
     const int M = gru->nb_inputs;
     const int N = gru->nb_neurons;
     const int AN = FFALIGN(N, 4);
@@ -1290,97 +1322,143 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
 
     for (int i = 0; i < N; i++) {
         /* Compute update gate. */
-        float sum = gru->bias[i];
+        const float *iw = gru->input_weights + i * istride;
+        const float *rw = gru->recurrent_weights + i * stride;
 
-        sum += s->fdsp->scalarproduct_float(gru->input_weights + i * istride, input, AM);
-        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + i * stride, state, AN);
-        z[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
+        for (int c = 0; c < nb; c++) {
+            float sum = gru->bias[i];
+
+            sum += s->fdsp->scalarproduct_float(iw, input[c], AM);
+            sum += s->fdsp->scalarproduct_float(rw, state[c], AN);
+            z[c][i] = sigmoid_approx(WEIGHTS_SCALE * sum);
+        }
     }
 
     for (int i = 0; i < N; i++) {
-        /* Compute reset gate. */
-        float sum = gru->bias[N + i];
+        /* Compute reset gate, applied to the state right away. */
+        const float *iw = gru->input_weights + AM + i * istride;
+        const float *rw = gru->recurrent_weights + AN + i * stride;
 
-        sum += s->fdsp->scalarproduct_float(gru->input_weights + AM + i * istride, input, AM);
-        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + AN + i * stride, state, AN);
-        r[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
+        for (int c = 0; c < nb; c++) {
+            float sum = gru->bias[N + i];
+
+            sum += s->fdsp->scalarproduct_float(iw, input[c], AM);
+            sum += s->fdsp->scalarproduct_float(rw, state[c], AN);
+            rs[c][i] = sigmoid_approx(WEIGHTS_SCALE * sum) * state[c][i];
+        }
     }
 
+    for (int c = 0; c < nb; c++)
+        for (int i = N; i < AN; i++)
+            rs[c][i] = 0.f;
+
     for (int i = 0; i < N; i++) {
         /* Compute output. */
-        float sum = gru->bias[2 * N + i];
-
-        sum += s->fdsp->scalarproduct_float(gru->input_weights + 2 * AM + i * istride, input, AM);
-        for (int j = 0; j < N; j++)
-            sum += gru->recurrent_weights[2 * AN + i * stride + j] * state[j] * r[j];
-
-        if (gru->activation == ACTIVATION_SIGMOID)
-            sum = sigmoid_approx(WEIGHTS_SCALE * sum);
-        else if (gru->activation == ACTIVATION_TANH)
-            sum = tansig_approx(WEIGHTS_SCALE * sum);
-        else if (gru->activation == ACTIVATION_RELU)
-            sum = FFMAX(0, WEIGHTS_SCALE * sum);
-        else
-            av_assert0(0);
-        h[i] = z[i] * state[i] + (1.f - z[i]) * sum;
+        const float *iw = gru->input_weights + 2 * AM + i * istride;
+        const float *rw = gru->recurrent_weights + 2 * AN + i * stride;
+
+        for (int c = 0; c < nb; c++) {
+            float sum = gru->bias[2 * N + i];
+
+            sum += s->fdsp->scalarproduct_float(iw, input[c], AM);
+            sum += s->fdsp->scalarproduct_float(rw, rs[c], AN);
+
+            if (gru->activation == ACTIVATION_SIGMOID)
+                sum = sigmoid_approx(WEIGHTS_SCALE * sum);
+            else if (gru->activation == ACTIVATION_TANH)
+                sum = tansig_approx(WEIGHTS_SCALE * sum);
+            else if (gru->activation == ACTIVATION_RELU)
+                sum = FFMAX(0, WEIGHTS_SCALE * sum);
+            else
+                av_assert0(0);
+            h[c][i] = z[c][i] * state[c][i] + (1.f - z[c][i]) * sum;
+        }
     }
 
-    RNN_COPY(state, h, N);
+    for (int c = 0; c < nb; c++)
+        RNN_COPY(state[c], h[c], N);
 }
 
 #define INPUT_SIZE 42
 
-static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *vad, const float *input)
+static void compute_rnn(AudioRNNContext *s, DenoiseState **st, int nb)
 {
-    LOCAL_ALIGNED_32(float, dense_out,     [MAX_NEURONS]);
-    LOCAL_ALIGNED_32(float, noise_input,   [MAX_NEURONS * 3]);
-    LOCAL_ALIGNED_32(float, denoise_input, [MAX_NEURONS * 3]);
-
-    compute_dense(rnn->model->input_dense, dense_out, input);
-    compute_gru(s, rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-    compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
-
-    memcpy(noise_input, dense_out, rnn->model->input_dense_size * sizeof(float));
-    memcpy(noise_input + rnn->model->input_dense_size,
-           rnn->vad_gru_state, rnn->model->vad_gru_size * sizeof(float));
-    memcpy(noise_input + rnn->model->input_dense_size + rnn->model->vad_gru_size,
-           input, INPUT_SIZE * sizeof(float));
-
-    compute_gru(s, rnn->model->noise_gru, rnn->noise_gru_state, noise_input);
-
-    memcpy(denoise_input, rnn->vad_gru_state, rnn->model->vad_gru_size * sizeof(float));
-    memcpy(denoise_input + rnn->model->vad_gru_size,
-           rnn->noise_gru_state, rnn->model->noise_gru_size * sizeof(float));
-    memcpy(denoise_input + rnn->model->vad_gru_size + rnn->model->noise_gru_size,
-           input, INPUT_SIZE * sizeof(float));
-
-    compute_gru(s, rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-    compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+    const RNNModel *model = st[0]->rnn[0].model;
+    const float *input[MAX_BATCH], *dense_in[MAX_BATCH];
+    float *output[MAX_BATCH], *vad[MAX_BATCH];
+    float *vad_state[MAX_BATCH], *noise_state[MAX_BATCH], *denoise_state[MAX_BATCH];
+
+    for (int c = 0; c < nb; c++) {
+        RNNState *rnn = &st[c]->rnn[0];
+
+        vad_state[c]     = rnn->vad_gru_state;
+        noise_state[c]   = rnn->noise_gru_state;
+        denoise_state[c] = rnn->denoise_gru_state;
+        input[c]         = st[c]->features;
+        output[c]        = st[c]->dense_out;
+        vad[c]           = &st[c]->vad_prob;
+    }
+
+    compute_dense(s, model->input_dense, output, input, nb);
+    for (int c = 0; c < nb; c++)
+        dense_in[c] = st[c]->dense_out;
+    compute_gru(s, model->vad_gru, vad_state, dense_in, nb);
+    for (int c = 0; c < nb; c++)
+        dense_in[c] = vad_state[c];
+    compute_dense(s, model->vad_output, vad, dense_in, nb);
+
+    for (int c = 0; c < nb; c++) {
+        float *noise_input = st[c]->noise_input;
+
+        memcpy(noise_input, st[c]->dense_out, model->input_dense_size * sizeof(float));
+        memcpy(noise_input + model->input_dense_size,
+               vad_state[c], model->vad_gru_size * sizeof(float));
+        memcpy(noise_input + model->input_dense_size + model->vad_gru_size,
+               input[c], INPUT_SIZE * sizeof(float));
+        dense_in[c] = noise_input;
+    }
+
+    compute_gru(s, model->noise_gru, noise_state, dense_in, nb);
+
+    for (int c = 0; c < nb; c++) {
+        float *denoise_input = st[c]->denoise_input;
+
+        memcpy(denoise_input, vad_state[c], model->vad_gru_size * sizeof(float));
+        memcpy(denoise_input + model->vad_gru_size,
+               noise_state[c], model->noise_gru_size * sizeof(float));
+        memcpy(denoise_input + model->vad_gru_size + model->noise_gru_size,
+               input[c], INPUT_SIZE * sizeof(float));
+        dense_in[c] = denoise_input;
+    }
+
+    compute_gru(s, model->denoise_gru, denoise_state, dense_in, nb);
+    for (int c = 0; c < nb; c++) {
+        dense_in[c] = denoise_state[c];
+        output[c]   = st[c]->g;
+    }
+    compute_dense(s, model->denoise_output, output, dense_in, nb);
 }
 
-static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
-                             int disabled)
+static int rnnoise_channel_analysis(AudioRNNContext *s, DenoiseState *st, const float *in)
 {
-    AVComplexFloat X[FREQ_SIZE];
-    AVComplexFloat P[WINDOW_SIZE];
     float x[FRAME_SIZE];
-    float Ex[NB_BANDS], Ep[NB_BANDS];
-    LOCAL_ALIGNED_32(float, Exp, [NB_BANDS]);
-    float features[NB_FEATURES];
-    float g[NB_BANDS];
-    float gf[FREQ_SIZE];
-    float vad_prob = 0;
-    float *history = st->history;
     static const float a_hp[2] = {-1.99599, 0.99600};
     static const float b_hp[2] = {-2, 1};
-    int silence;
 
     biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
-    silence = compute_frame_features(s, st, X, P, Ex, Ep, Exp, features, x);
+    return compute_frame_features(s, st, st->X, st->P, st->Ex, st->Ep, st->Exp, st->features, x);
+}
+
+static void rnnoise_channel_synthesis(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
+                                      int denoise)
+{
+    AVComplexFloat *X = st->X;
+    float *g = st->g;
+    float gf[FREQ_SIZE];
+    float *history = st->history;
 
-    if (!silence && !disabled) {
-        compute_rnn(s, &st->rnn[0], g, &vad_prob, features);
-        pitch_filter(X, P, Ex, Ep, Exp, g);
+    if (denoise) {
+        pitch_filter(X, st->P, st->Ex, st->Ep, st->Exp, g);
         for (int i = 0; i < NB_BANDS; i++) {
             float alpha = .6f;
 
@@ -1398,8 +1476,6 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
 
     frame_synthesis(s, st, out, X);
     memcpy(history, in, FRAME_SIZE * sizeof(*history));
-
-    return vad_prob;
 }
 
 typedef struct ThreadData {
@@ -1415,11 +1491,29 @@ static int rnnoise_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int start = (out->ch_layout.nb_channels * jobnr) / nb_jobs;
     const int end = (out->ch_layout.nb_channels * (jobnr+1)) / nb_jobs;
 
-    for (int ch = start; ch < end; ch++) {
-        rnnoise_channel(s, &s->st[ch],
-                        (float *)out->extended_data[ch],
-                        (const float *)in->extended_data[ch],
-                        ctx->is_disabled);
+    for (int ch = start; ch < end; ch += MAX_BATCH) {
+        const int nb = FFMIN(end - ch, MAX_BATCH);
+        DenoiseState *active[MAX_BATCH];
+        int denoise[MAX_BATCH];
+        int nb_active = 0;
+
+        for (int c = 0; c < nb; c++) {
+            DenoiseState *st = &s->st[ch + c];
+            int silence = rnnoise_channel_analysis(s, st, (const float *)in->extended_data[ch + c]);
+
+            denoise[c] = !silence && !ctx->is_disabled;
+            if (denoise[c])
+                active[nb_active++] = st;
+        }
+
+        if (nb_active)
+            compute_rnn(s, active, nb_active);
+
+        for (int c = 0; c < nb; c++)
+            rnnoise_channel_synthesis(s, &s->st[ch + c],
+                                      (float *)out->extended_data[ch + c],
+                                      (const float *)in->extended_data[ch + c],
+                                      denoise[c]);
     }
 
     return 0;
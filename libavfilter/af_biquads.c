@@ -67,7 +67,9 @@
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/ffmath.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
+#include "af_biquadsdsp.h"
 #include "audio.h"
 #include "avfilter.h"
 #include "filters.h"
@@ -110,6 +112,18 @@ enum TransformType {
     NB_TTYPE,
 };
 
+/* Size of the per-channel state of one stage, in samples of the cache frames,
+ * so that it holds four values of any of the filtering types. */
+#define STAGE_CACHE_SIZE (4 * sizeof(double))
+
+/* Number of frames transposed at once for the lane functions. */
+#define LANE_BLOCK 256
+
+/* Fewest filtered channels for which the lane functions are used. */
+#define MIN_LANE_CHANNELS 3
+
+#define MAX_STAGES 16
+
 typedef struct BiquadsContext {
     const AVClass *class;
 
@@ -131,6 +145,7 @@ typedef struct BiquadsContext {
     AVChannelLayout ch_layout;
     int normalize;
     int order;
+    int nb_stages;
 
     double a_double[3];
     double b_double[3];
@@ -138,6 +153,10 @@ typedef struct BiquadsContext {
     float a_float[3];
     float b_float[3];
 
+    float lane_coeffs[7];
+    int *lane_channels;
+    int nb_lane_channels;
+
     double oa[3];
     double ob[3];
 
@@ -152,6 +171,9 @@ typedef struct BiquadsContext {
 
     void (*filter)(struct BiquadsContext *s, const void *ibuf, void *obuf, int len,
                    void *cache, int *clip, int disabled);
+    void (*filter_lanes)(float *buf, const float *coeffs, float *state,
+                         ptrdiff_t len);
+    BiquadsDSPContext dsp;
 } BiquadsContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -250,7 +272,7 @@ static void biquad_## name (BiquadsContext *s,                                \
         }                                                                     \
     }                                                                         \
     if (i < len) {                                                            \
-        ftype o0 = ibuf[i] * b0 + i1 * b1 + i2 * b2 + o1 * a1 + o2 * a2;      \
+        ftype o0 = i2 * b2 + i1 * b1 + ibuf[i] * b0 + o2 * a2 + o1 * a1;      \
         i2 = i1;                                                              \
         i1 = ibuf[i];                                                         \
         o2 = o1;                                                              \
@@ -1020,10 +1042,12 @@ static int config_filter(AVFilterLink *outlink, int reset)
     }
 
     if (!s->cache[0])
-        s->cache[0] = ff_get_audio_buffer(outlink, 4 * sizeof(double));
+        s->cache[0] = ff_get_audio_buffer(outlink, STAGE_CACHE_SIZE * s->nb_stages);
     if (!s->clip)
         s->clip = av_calloc(outlink->ch_layout.nb_channels, sizeof(*s->clip));
-    if (!s->cache[0] || !s->clip)
+    if (!s->lane_channels)
+        s->lane_channels = av_calloc(outlink->ch_layout.nb_channels, sizeof(*s->lane_channels));
+    if (!s->cache[0] || !s->clip || !s->lane_channels)
         return AVERROR(ENOMEM);
     if (reset) {
         av_samples_set_silence(s->cache[0]->extended_data, 0, s->cache[0]->nb_samples,
@@ -1032,7 +1056,7 @@ static int config_filter(AVFilterLink *outlink, int reset)
 
     if (reset && s->block_samples > 0) {
         if (!s->cache[1])
-            s->cache[1] = ff_get_audio_buffer(outlink, 4 * sizeof(double));
+            s->cache[1] = ff_get_audio_buffer(outlink, STAGE_CACHE_SIZE * s->nb_stages);
         if (!s->cache[1])
             return AVERROR(ENOMEM);
         av_samples_set_silence(s->cache[1]->extended_data, 0, s->cache[1]->nb_samples,
@@ -1187,6 +1211,24 @@ static int config_filter(AVFilterLink *outlink, int reset)
     s->b_float[1] = s->b_double[1];
     s->b_float[2] = s->b_double[2];
 
+    /* The C lane functions are slower than filtering each channel in turn,
+     * so only the SIMD ones are used. */
+    s->filter_lanes = NULL;
+    if (inlink->format == AV_SAMPLE_FMT_FLTP) {
+        if (s->transform_type == DI && s->dsp.filter_di_flt != filter_di_flt_c)
+            s->filter_lanes = s->dsp.filter_di_flt;
+        else if (s->transform_type == TDII && s->dsp.filter_tdii_flt != filter_tdii_flt_c)
+            s->filter_lanes = s->dsp.filter_tdii_flt;
+    }
+
+    s->lane_coeffs[0] =  s->b_float[0];
+    s->lane_coeffs[1] =  s->b_float[1];
+    s->lane_coeffs[2] =  s->b_float[2];
+    s->lane_coeffs[3] = -s->a_float[1];
+    s->lane_coeffs[4] = -s->a_float[2];
+    s->lane_coeffs[5] =  s->mix;
+    s->lane_coeffs[6] =  1. - s->lane_coeffs[5];
+
     return 0;
 }
 
@@ -1235,6 +1277,14 @@ static void reverse_samples(AVFrame *out, AVFrame *in, int p,
     }
 }
 
+static void filter_stages(BiquadsContext *s, const void *ibuf, void *obuf, int len,
+                          uint8_t *cache, int *clip, int disabled)
+{
+    for (int i = 0; i < s->nb_stages; i++)
+        s->filter(s, i ? obuf : ibuf, obuf, len, cache + i * STAGE_CACHE_SIZE,
+                  clip, disabled);
+}
+
 static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     AVFilterLink *inlink = ctx->inputs[0];
@@ -1257,8 +1307,8 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
         }
 
         if (!s->block_samples) {
-            s->filter(s, buf->extended_data[ch], out_buf->extended_data[ch], buf->nb_samples,
-                      s->cache[0]->extended_data[ch], s->clip+ch, ctx->is_disabled);
+            filter_stages(s, buf->extended_data[ch], out_buf->extended_data[ch], buf->nb_samples,
+                          s->cache[0]->extended_data[ch], s->clip+ch, ctx->is_disabled);
         } else if (td->eof) {
             memcpy(out_buf->extended_data[ch], s->block[1]->extended_data[ch] + s->block_align * s->block_samples,
                    s->nb_samples * s->block_align);
@@ -1267,20 +1317,20 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
                    buf->nb_samples * s->block_align);
             memset(s->block[0]->extended_data[ch] + s->block_align * (s->block_samples + buf->nb_samples),
                    0, (s->block_samples - buf->nb_samples) * s->block_align);
-            s->filter(s, s->block[0]->extended_data[ch], s->block[1]->extended_data[ch], s->block_samples,
-                      s->cache[0]->extended_data[ch], s->clip+ch, ctx->is_disabled);
+            filter_stages(s, s->block[0]->extended_data[ch], s->block[1]->extended_data[ch], s->block_samples,
+                          s->cache[0]->extended_data[ch], s->clip+ch, ctx->is_disabled);
             av_samples_copy(s->cache[1]->extended_data, s->cache[0]->extended_data, 0, 0,
                             s->cache[0]->nb_samples, s->cache[0]->ch_layout.nb_channels,
                             s->cache[0]->format);
-            s->filter(s, s->block[0]->extended_data[ch] + s->block_samples * s->block_align,
-                      s->block[1]->extended_data[ch] + s->block_samples * s->block_align,
-                      s->block_samples, s->cache[1]->extended_data[ch], s->clip+ch,
-                      ctx->is_disabled);
+            filter_stages(s, s->block[0]->extended_data[ch] + s->block_samples * s->block_align,
+                          s->block[1]->extended_data[ch] + s->block_samples * s->block_align,
+                          s->block_samples, s->cache[1]->extended_data[ch], s->clip+ch,
+                          ctx->is_disabled);
             reverse_samples(s->block[2], s->block[1], ch, 0, 0, 2 * s->block_samples);
             av_samples_set_silence(s->cache[1]->extended_data, 0, s->cache[1]->nb_samples,
                                    s->cache[1]->ch_layout.nb_channels, s->cache[1]->format);
-            s->filter(s, s->block[2]->extended_data[ch], s->block[2]->extended_data[ch], 2 * s->block_samples,
-                      s->cache[1]->extended_data[ch], s->clip+ch, ctx->is_disabled);
+            filter_stages(s, s->block[2]->extended_data[ch], s->block[2]->extended_data[ch], 2 * s->block_samples,
+                          s->cache[1]->extended_data[ch], s->clip+ch, ctx->is_disabled);
             reverse_samples(s->block[1], s->block[2], ch, 0, 0, 2 * s->block_samples);
             memcpy(out_buf->extended_data[ch], s->block[1]->extended_data[ch],
                    s->block_samples * s->block_align);
@@ -1292,6 +1342,87 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
     return 0;
 }
 
+/* Filters the selected channels BIQUADS_LANES at a time: each group is
+ * transposed into a small interleaved block, which all stages then process
+ * while it stays in cache. */
+static int filter_channel_lanes(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    ThreadData *td = arg;
+    AVFrame *buf = td->in;
+    AVFrame *out_buf = td->out;
+    BiquadsContext *s = ctx->priv;
+    const int nb_channels = buf->ch_layout.nb_channels;
+    const int nb_groups = (s->nb_lane_channels + BIQUADS_LANES - 1) / BIQUADS_LANES;
+    const int start = (nb_groups * jobnr) / nb_jobs;
+    const int end = (nb_groups * (jobnr+1)) / nb_jobs;
+    LOCAL_ALIGNED_32(float, block, [LANE_BLOCK * BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(float, state, [MAX_STAGES * 4 * BIQUADS_LANES]);
+
+    if (buf != out_buf) {
+        for (int ch = (nb_channels * jobnr) / nb_jobs; ch < (nb_channels * (jobnr+1)) / nb_jobs; ch++) {
+            enum AVChannel channel = av_channel_layout_channel_from_index(&inlink->ch_layout, ch);
+
+            if (av_channel_layout_index_from_channel(&s->ch_layout, channel) < 0)
+                memcpy(out_buf->extended_data[ch], buf->extended_data[ch],
+                       buf->nb_samples * s->block_align);
+        }
+    }
+
+    for (int g = start; g < end; g++) {
+        const int *channels = s->lane_channels + g * BIQUADS_LANES;
+        const int nb_lanes = FFMIN(s->nb_lane_channels - g * BIQUADS_LANES, BIQUADS_LANES);
+
+        memset(state, 0, s->nb_stages * 4 * BIQUADS_LANES * sizeof(*state));
+        for (int c = 0; c < nb_lanes; c++) {
+            const uint8_t *cache = s->cache[0]->extended_data[channels[c]];
+
+            for (int i = 0; i < s->nb_stages; i++) {
+                const float *fcache = (const float *)(cache + i * STAGE_CACHE_SIZE);
+
+                for (int k = 0; k < 4; k++)
+                    state[(i * 4 + k) * BIQUADS_LANES + c] = fcache[k];
+            }
+        }
+
+        for (int n = 0; n < buf->nb_samples; n += LANE_BLOCK) {
+            const int len = FFMIN(buf->nb_samples - n, LANE_BLOCK);
+
+            if (nb_lanes < BIQUADS_LANES)
+                memset(block, 0, len * BIQUADS_LANES * sizeof(*block));
+            for (int c = 0; c < nb_lanes; c++) {
+                const float *src = (const float *)buf->extended_data[channels[c]] + n;
+
+                for (int i = 0; i < len; i++)
+                    block[i * BIQUADS_LANES + c] = src[i];
+            }
+
+            for (int i = 0; i < s->nb_stages; i++)
+                s->filter_lanes(block, s->lane_coeffs, state + i * 4 * BIQUADS_LANES, len);
+
+            for (int c = 0; c < nb_lanes; c++) {
+                float *dst = (float *)out_buf->extended_data[channels[c]] + n;
+
+                for (int i = 0; i < len; i++)
+                    dst[i] = block[i * BIQUADS_LANES + c];
+            }
+        }
+
+        for (int c = 0; c < nb_lanes; c++) {
+            uint8_t *cache = s->cache[0]->extended_data[channels[c]];
+
+            for (int i = 0; i < s->nb_stages; i++) {
+                float *fcache = (float *)(cache + i * STAGE_CACHE_SIZE);
+
+                for (int k = 0; k < 4; k++)
+                    fcache[k] = state[(i * 4 + k) * BIQUADS_LANES + c];
+            }
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *buf, int eof)
 {
     AVFilterContext  *ctx = inlink->dst;
@@ -1329,8 +1460,18 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf, int eof)
     td.in = buf;
     td.out = out_buf;
     td.eof = eof;
-    ff_filter_execute(ctx, filter_channel, &td, NULL,
-                      FFMIN(outlink->ch_layout.nb_channels, ff_filter_get_nb_threads(ctx)));
+    s->nb_lane_channels = 0;
+    if (s->filter_lanes && !s->block_samples && !ctx->is_disabled) {
+        for (ch = 0; ch < inlink->ch_layout.nb_channels; ch++) {
+            enum AVChannel channel = av_channel_layout_channel_from_index(&inlink->ch_layout, ch);
+
+            if (av_channel_layout_index_from_channel(&s->ch_layout, channel) >= 0)
+                s->lane_channels[s->nb_lane_channels++] = ch;
+        }
+    }
+    /* With fewer channels most of the lanes would be wasted. */
+    ff_filter_execute(ctx, s->nb_lane_channels >= MIN_LANE_CHANNELS ? filter_channel_lanes : filter_channel,
+                      &td, NULL, FFMIN(outlink->ch_layout.nb_channels, ff_filter_get_nb_threads(ctx)));
 
     for (ch = 0; ch < outlink->ch_layout.nb_channels; ch++) {
         if (s->clip[ch] > 0)
@@ -1429,6 +1570,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&s->cache[0]);
     av_frame_free(&s->cache[1]);
     av_freep(&s->clip);
+    av_freep(&s->lane_channels);
     av_channel_layout_uninit(&s->ch_layout);
 }
 
@@ -1450,6 +1592,7 @@ static av_cold int name_##_init(AVFilterContext *ctx)                   \
     BiquadsContext *s = ctx->priv;                                      \
     s->filter_type = name_;                                             \
     s->pts = AV_NOPTS_VALUE;                                            \
+    ff_biquads_init(&s->dsp);                                           \
     return 0;                                                           \
 }                                                                       \
                                                          \
@@ -1513,6 +1656,9 @@ const AVFilter ff_af_##name_ = {                         \
     {"f32", "floating-point single", 0, AV_OPT_TYPE_CONST, {.i64=2},  0, 0, AF, "precision"},                         \
     {"f64", "floating-point double", 0, AV_OPT_TYPE_CONST, {.i64=3},  0, 0, AF, "precision"}
 
+#define STAGES_OPTION(x)                                                                                      \
+    {"stages", "set number of cascaded stages", OFFSET(nb_stages), AV_OPT_TYPE_INT, {.i64=x}, 1, MAX_STAGES, AF}
+
 #define BLOCKSIZE_OPTION(x)                                                                              \
     {"blocksize", "set the block size", OFFSET(block_samples), AV_OPT_TYPE_INT, {.i64=x}, 0, 32768, AF}, \
     {"b",         "set the block size", OFFSET(block_samples), AV_OPT_TYPE_INT, {.i64=x}, 0, 32768, AF}
@@ -1528,6 +1674,7 @@ static const AVOption equalizer_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1547,6 +1694,7 @@ static const AVOption bass_lowshelf_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1573,6 +1721,7 @@ static const AVOption treble_highshelf_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1603,6 +1752,7 @@ static const AVOption bandpass_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1618,6 +1768,7 @@ static const AVOption bandreject_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1635,6 +1786,7 @@ static const AVOption lowpass_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1652,6 +1804,7 @@ static const AVOption highpass_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
@@ -1669,6 +1822,7 @@ static const AVOption allpass_options[] = {
     {"o",     "set filter order", OFFSET(order), AV_OPT_TYPE_INT, {.i64=2}, 1, 2, FLAGS},
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     {NULL}
 };
 
@@ -1685,6 +1839,7 @@ static const AVOption biquad_options[] = {
     MIX_CHANNELS_NORMALIZE_OPTION(1, "all", 0),
     TRANSFORM_OPTION(DI),
     PRECISION_OPTION(-1),
+    STAGES_OPTION(1),
     BLOCKSIZE_OPTION(0),
     {NULL}
 };
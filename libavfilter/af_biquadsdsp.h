@@ -0,0 +1,134 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_BIQUADSDSP_H
+#define AVFILTER_BIQUADSDSP_H
+
+#include <stddef.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+
+/* Number of channels filtered together by the lane functions. */
+#define BIQUADS_LANES 8
+
+/*
+ * The lane functions run one biquad section in place over len frames of
+ * BIQUADS_LANES interleaved channels, buf[n * BIQUADS_LANES + lane].
+ * buf and state must be 32-byte aligned. The float and double versions take
+ * coeffs and state of their own sample type.
+ *
+ * coeffs holds b0, b1, b2, -a1, -a2, wet and dry.
+ * state holds four rows of BIQUADS_LANES values: i1, i2, o1, o2 for direct
+ * form I and w1, w2 for transposed direct form II.
+ */
+typedef struct BiquadsDSPContext {
+    void (*filter_di_flt)(float *buf, const float *coeffs, float *state,
+                          ptrdiff_t len);
+    void (*filter_tdii_flt)(float *buf, const float *coeffs, float *state,
+                            ptrdiff_t len);
+    void (*filter_di_dbl)(double *buf, const double *coeffs, double *state,
+                          ptrdiff_t len);
+} BiquadsDSPContext;
+
+void ff_biquads_init_x86(BiquadsDSPContext *s);
+
+static void filter_di_flt_c(float *buf, const float *coeffs, float *state,
+                            ptrdiff_t len)
+{
+    const float b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2];
+    const float a1 = coeffs[3], a2 = coeffs[4];
+    const float wet = coeffs[5], dry = coeffs[6];
+    float *i1 = state;
+    float *i2 = state + BIQUADS_LANES;
+    float *o1 = state + BIQUADS_LANES * 2;
+    float *o2 = state + BIQUADS_LANES * 3;
+
+    for (ptrdiff_t n = 0; n < len; n++, buf += BIQUADS_LANES) {
+        for (int c = 0; c < BIQUADS_LANES; c++) {
+            const float in = buf[c];
+            const float o0 = i2[c] * b2 + i1[c] * b1 + in * b0 + o2[c] * a2 + o1[c] * a1;
+
+            i2[c] = i1[c];
+            i1[c] = in;
+            o2[c] = o1[c];
+            o1[c] = o0;
+            buf[c] = o0 * wet + in * dry;
+        }
+    }
+}
+
+static void filter_tdii_flt_c(float *buf, const float *coeffs, float *state,
+                              ptrdiff_t len)
+{
+    const float b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2];
+    const float a1 = coeffs[3], a2 = coeffs[4];
+    const float wet = coeffs[5], dry = coeffs[6];
+    float *w1 = state;
+    float *w2 = state + BIQUADS_LANES;
+
+    for (ptrdiff_t n = 0; n < len; n++, buf += BIQUADS_LANES) {
+        for (int c = 0; c < BIQUADS_LANES; c++) {
+            const float in = buf[c];
+            const float out = b0 * in + w1[c];
+
+            w1[c] = b1 * in + w2[c] + a1 * out;
+            w2[c] = b2 * in + a2 * out;
+            buf[c] = out * wet + in * dry;
+        }
+    }
+}
+
+static void filter_di_dbl_c(double *buf, const double *coeffs, double *state,
+                            ptrdiff_t len)
+{
+    const double b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2];
+    const double a1 = coeffs[3], a2 = coeffs[4];
+    const double wet = coeffs[5], dry = coeffs[6];
+
+    double *i1 = state;
+    double *i2 = state + BIQUADS_LANES;
+    double *o1 = state + BIQUADS_LANES * 2;
+    double *o2 = state + BIQUADS_LANES * 3;
+
+    for (ptrdiff_t n = 0; n < len; n++, buf += BIQUADS_LANES) {
+        for (int c = 0; c < BIQUADS_LANES; c++) {
+            const double in = buf[c];
+            const double o0 = i2[c] * b2 + i1[c] * b1 + in * b0 + o2[c] * a2 + o1[c] * a1;
+
+            i2[c] = i1[c];
+            i1[c] = in;
+            o2[c] = o1[c];
+            o1[c] = o0;
+            buf[c] = o0 * wet + in * dry;
+        }
+    }
+}
+
+static av_unused void ff_biquads_init(BiquadsDSPContext *dsp)
+{
+    dsp->filter_di_flt   = filter_di_flt_c;
+    dsp->filter_tdii_flt = filter_tdii_flt_c;
+    dsp->filter_di_dbl   = filter_di_dbl_c;
+
+#if ARCH_X86
+    ff_biquads_init_x86(dsp);
+#endif
+}
+
+#endif /* AVFILTER_BIQUADSDSP_H */
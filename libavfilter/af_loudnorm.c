@@ -20,7 +20,10 @@
 
 /* http://k.ylo.ph/2016/04/04/loudnorm.html */
 
+#include "libavutil/audio_fifo.h"
+#include "libavutil/fifo.h"
 #include "libavutil/opt.h"
+#include "libswresample/swresample.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "formats.h"
@@ -64,6 +67,8 @@ typedef struct LoudNormContext {
     int linear;
     int dual_mono;
     enum PrintFormat print_format;
+    int lookahead;
+    int64_t lookahead_max;
 
     double *buf;
     int buf_size;
@@ -92,9 +97,28 @@ typedef struct LoudNormContext {
     int above_threshold;
     int prev_nb_samples;
     int channels;
+    int sample_rate;                ///< rate the normalization runs at
 
     FFEBUR128State *r128_in;
     FFEBUR128State *r128_out;
+
+    /* lookahead measurement */
+    FFEBUR128State *r128_la;
+    AVFifo *la_fifo;                ///< whole input, queued while measuring
+    int64_t la_samples;             ///< number of queued samples
+    int la_offset;                  ///< samples already consumed from the first queued frame
+    int la_status;
+    int64_t la_status_pts;
+
+#if CONFIG_SWRESAMPLE
+    /* dynamic normalization of input that is not 192 kHz */
+    SwrContext *swr_up;             ///< input rate to 192 kHz
+    SwrContext *swr_down;           ///< 192 kHz back to the input rate
+    AVAudioFifo *swr_fifo;          ///< upsampled input not normalized yet
+    int swr_flushed;
+    int64_t swr_pts;                ///< pts of the first resampled output sample
+    int64_t swr_nb_samples;         ///< number of resampled output samples
+#endif
 } LoudNormContext;
 
 #define OFFSET(x) offsetof(LoudNormContext, x)
@@ -121,6 +145,8 @@ static const AVOption loudnorm_options[] = {
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, "print_format" },
     {     "summary",      0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  SUMMARY},  0,         0,  FLAGS, "print_format" },
+    { "lookahead",        "measure the whole input before normalizing", OFFSET(lookahead), AV_OPT_TYPE_BOOL,   {.i64 =  0},        0,         1,  FLAGS },
+    { "lookahead_max",    "set the maximum duration measured by lookahead", OFFSET(lookahead_max), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, INT64_MAX, FLAGS },
     { NULL }
 };
 
@@ -408,6 +434,50 @@ static void true_peak_limiter(LoudNormContext *s, double *out, int nb_samples, i
     }
 }
 
+/**
+ * Send a normalized frame, downsampled back to the input rate if the
+ * normalization runs at 192 kHz for it. A NULL frame flushes the resampler.
+ */
+static int output_frame(AVFilterContext *ctx, AVFrame *in)
+{
+    AVFilterLink *outlink = ctx->outputs[0];
+#if CONFIG_SWRESAMPLE
+    LoudNormContext *s = ctx->priv;
+
+    if (s->swr_down) {
+        const int nb_in = in ? in->nb_samples : 0;
+        const int nb_samples = swr_get_out_samples(s->swr_down, nb_in);
+        AVFrame *out;
+        int ret;
+
+        if (nb_samples <= 0) {
+            av_frame_free(&in);
+            return nb_samples;
+        }
+        out = ff_get_audio_buffer(outlink, nb_samples);
+        if (!out) {
+            av_frame_free(&in);
+            return AVERROR(ENOMEM);
+        }
+        if (in)
+            av_frame_copy_props(out, in);
+        ret = swr_convert(s->swr_down, out->extended_data, nb_samples,
+                          in ? (const uint8_t **)in->extended_data : NULL, nb_in);
+        av_frame_free(&in);
+        if (ret <= 0) {
+            av_frame_free(&out);
+            return ret;
+        }
+        out->nb_samples = ret;
+        out->pts = s->swr_pts + av_rescale_q(s->swr_nb_samples, (AVRational){ 1, outlink->sample_rate },
+                                             outlink->time_base);
+        s->swr_nb_samples += ret;
+        in = out;
+    }
+#endif
+    return ff_filter_frame(outlink, in);
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -443,7 +513,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     ff_ebur128_add_frames_double(s->r128_in, src, in->nb_samples);
 
-    if (s->frame_type == FIRST_FRAME && in->nb_samples < frame_size(inlink->sample_rate, 3000)) {
+    if (s->frame_type == FIRST_FRAME && in->nb_samples < frame_size(s->sample_rate, 3000)) {
         double offset, offset_tp, true_peak;
 
         ff_ebur128_loudness_global(s->r128_in, &global);
@@ -498,7 +568,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             s->buf_index += inlink->ch_layout.nb_channels;
         }
 
-        subframe_length = frame_size(inlink->sample_rate, 100);
+        subframe_length = frame_size(s->sample_rate, 100);
         true_peak_limiter(s, dst, subframe_length, inlink->ch_layout.nb_channels);
         ff_ebur128_add_frames_double(s->r128_out, dst, subframe_length);
 
@@ -531,7 +601,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 s->buf_index -= s->buf_size;
         }
 
-        subframe_length = (frame_size(inlink->sample_rate, 100) - in->nb_samples) * inlink->ch_layout.nb_channels;
+        subframe_length = (frame_size(s->sample_rate, 100) - in->nb_samples) * inlink->ch_layout.nb_channels;
         s->limiter_buf_index = s->limiter_buf_index + subframe_length < s->limiter_buf_size ? s->limiter_buf_index + subframe_length : s->limiter_buf_index + subframe_length - s->limiter_buf_size;
 
         true_peak_limiter(s, dst, in->nb_samples, inlink->ch_layout.nb_channels);
@@ -584,7 +654,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 s->limiter_buf_index -= s->limiter_buf_size;
         }
 
-        subframe_length = frame_size(inlink->sample_rate, 100);
+        subframe_length = frame_size(s->sample_rate, 100);
         for (i = 0; i < in->nb_samples / subframe_length; i++) {
             true_peak_limiter(s, dst, subframe_length, inlink->ch_layout.nb_channels);
 
@@ -628,7 +698,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     if (in != out)
         av_frame_free(&in);
-    return ff_filter_frame(outlink, out);
+    return output_frame(ctx, out);
 }
 
 static int flush_frame(AVFilterLink *outlink)
@@ -645,7 +715,7 @@ static int flush_frame(AVFilterLink *outlink)
         AVFrame *frame;
 
         nb_samples  = (s->buf_size / inlink->ch_layout.nb_channels) - s->prev_nb_samples;
-        nb_samples -= (frame_size(inlink->sample_rate, 100) - s->prev_nb_samples);
+        nb_samples -= (frame_size(s->sample_rate, 100) - s->prev_nb_samples);
 
         frame = ff_get_audio_buffer(outlink, nb_samples);
         if (!frame)
@@ -656,7 +726,7 @@ static int flush_frame(AVFilterLink *outlink)
         src = (double *)frame->data[0];
 
         offset  = ((s->limiter_buf_size / inlink->ch_layout.nb_channels) - s->prev_nb_samples) * inlink->ch_layout.nb_channels;
-        offset -= (frame_size(inlink->sample_rate, 100) - s->prev_nb_samples) * inlink->ch_layout.nb_channels;
+        offset -= (frame_size(s->sample_rate, 100) - s->prev_nb_samples) * inlink->ch_layout.nb_channels;
         s->buf_index = s->buf_index - offset < 0 ? s->buf_index - offset + s->buf_size : s->buf_index - offset;
 
         for (n = 0; n < nb_samples; n++) {
@@ -675,6 +745,386 @@ static int flush_frame(AVFilterLink *outlink)
     return ret;
 }
 
+static int process_frame(AVFilterLink *inlink, AVFrame *in)
+{
+    LoudNormContext *s = inlink->dst->priv;
+
+    if (s->frame_type == FIRST_FRAME) {
+        const int nb_samples = frame_size(s->sample_rate, 100);
+
+        for (int i = 0; i < FF_ARRAY_ELEMS(s->pts); i++)
+            s->pts[i] = in->pts + i * nb_samples;
+    } else if (s->frame_type == LINEAR_MODE) {
+        s->pts[0] = in->pts;
+    } else {
+        s->pts[FF_ARRAY_ELEMS(s->pts) - 1] = in->pts;
+    }
+    return filter_frame(inlink, in);
+}
+
+static int frame_nb_samples(LoudNormContext *s, AVFilterLink *inlink)
+{
+    if (s->frame_type == FIRST_FRAME)
+        return frame_size(s->sample_rate, 3000);
+    return frame_size(s->sample_rate, 100);
+}
+
+/**
+ * Allocate the state that depends on the rate the normalization runs at.
+ */
+static int init_state(AVFilterContext *ctx, int sample_rate)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    LoudNormContext *s = ctx->priv;
+
+    if (s->r128_in)
+        ff_ebur128_destroy(&s->r128_in);
+    if (s->r128_out)
+        ff_ebur128_destroy(&s->r128_out);
+    av_freep(&s->buf);
+    av_freep(&s->limiter_buf);
+
+    s->r128_in = ff_ebur128_init(inlink->ch_layout.nb_channels, sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    if (!s->r128_in)
+        return AVERROR(ENOMEM);
+
+    s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    if (!s->r128_out)
+        return AVERROR(ENOMEM);
+
+    if (inlink->ch_layout.nb_channels == 1 && s->dual_mono) {
+        ff_ebur128_set_channel(s->r128_in,  0, FF_EBUR128_DUAL_MONO);
+        ff_ebur128_set_channel(s->r128_out, 0, FF_EBUR128_DUAL_MONO);
+    }
+
+    s->buf_size = frame_size(sample_rate, 3000) * inlink->ch_layout.nb_channels;
+    s->buf = av_malloc_array(s->buf_size, sizeof(*s->buf));
+    if (!s->buf)
+        return AVERROR(ENOMEM);
+
+    s->limiter_buf_size = frame_size(sample_rate, 210) * inlink->ch_layout.nb_channels;
+    s->limiter_buf = av_malloc_array(s->buf_size, sizeof(*s->limiter_buf));
+    if (!s->limiter_buf)
+        return AVERROR(ENOMEM);
+
+    s->sample_rate = sample_rate;
+    s->attack_length = frame_size(sample_rate, 10);
+    s->release_length = frame_size(sample_rate, 100);
+
+    return 0;
+}
+
+/**
+ * The true peak limiter of the dynamic normalization only works at 192 kHz:
+ * upsample the input to it and the normalized audio back to the input rate.
+ */
+static int init_resample(AVFilterContext *ctx)
+{
+#if CONFIG_SWRESAMPLE
+    AVFilterLink *inlink = ctx->inputs[0];
+    LoudNormContext *s = ctx->priv;
+    AVFrame *head;
+    int ret;
+
+    ret = swr_alloc_set_opts2(&s->swr_up, &inlink->ch_layout, inlink->format, 192000,
+                              &inlink->ch_layout, inlink->format, inlink->sample_rate, 0, ctx);
+    if (ret < 0)
+        return ret;
+    ret = swr_alloc_set_opts2(&s->swr_down, &inlink->ch_layout, inlink->format, inlink->sample_rate,
+                              &inlink->ch_layout, inlink->format, 192000, 0, ctx);
+    if (ret < 0)
+        return ret;
+    if ((ret = swr_init(s->swr_up)) < 0 ||
+        (ret = swr_init(s->swr_down)) < 0)
+        return ret;
+
+    s->swr_fifo = av_audio_fifo_alloc(inlink->format, s->channels, frame_size(192000, 3000));
+    if (!s->swr_fifo)
+        return AVERROR(ENOMEM);
+    s->swr_pts = av_fifo_peek(s->la_fifo, &head, 1, 0) >= 0 && head->pts != AV_NOPTS_VALUE ?
+                 head->pts : 0;
+
+    av_log(ctx, AV_LOG_VERBOSE, "Resampling to 192 kHz for dynamic normalization.\n");
+    return init_state(ctx, 192000);
+#else
+    av_log(ctx, AV_LOG_ERROR, "Dynamic normalization of input that is not 192 kHz "
+           "requires libswresample, resample it to 192 kHz before this filter.\n");
+    return AVERROR(ENOSYS);
+#endif
+}
+
+/**
+ * Set the measured_* values and the normalization type from the
+ * measurement of the whole input, as a first pass would have done.
+ */
+static int lookahead_measure(AVFilterContext *ctx)
+{
+    LoudNormContext *s = ctx->priv;
+    double global, lra, thresh, tp = 0.;
+
+    ff_ebur128_loudness_global(s->r128_la, &global);
+    ff_ebur128_loudness_range(s->r128_la, &lra);
+    ff_ebur128_relative_threshold(s->r128_la, &thresh);
+    for (int c = 0; c < s->channels; c++) {
+        double tmp;
+        ff_ebur128_sample_peak(s->r128_la, c, &tmp);
+        tp = FFMAX(tp, tmp);
+    }
+    ff_ebur128_destroy(&s->r128_la);
+
+    s->measured_i      = av_clipd(global, -99., 0.);
+    s->measured_lra    = av_clipd(lra,      0., 99.);
+    s->measured_tp     = av_clipd(20. * log10(tp), -99., 99.);
+    s->measured_thresh = av_clipd(thresh, -99., 0.);
+
+    av_log(ctx, AV_LOG_VERBOSE, "Measured I:%.2f LRA:%.2f TP:%.2f thresh:%.2f\n",
+           s->measured_i, s->measured_lra, s->measured_tp, s->measured_thresh);
+
+    if (s->linear) {
+        const double offset    = s->target_i - s->measured_i;
+        const double offset_tp = s->measured_tp + offset;
+
+        if (offset_tp <= 20. * log10(s->target_tp) && s->measured_lra <= s->target_lra) {
+            s->frame_type = LINEAR_MODE;
+            s->offset = pow(10., offset / 20.);
+        } else if (ctx->inputs[0]->sample_rate != 192000) {
+            return init_resample(ctx);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Take the next nb_samples samples from the queued input.
+ */
+static int lookahead_get_samples(AVFilterLink *inlink, int nb_samples, AVFrame **frame)
+{
+    LoudNormContext *s = inlink->dst->priv;
+    AVFrame *head, *out;
+    int offset = 0;
+
+    if (av_fifo_peek(s->la_fifo, &head, 1, 0) < 0)
+        return 0;
+
+    if (s->frame_type == LINEAR_MODE && !s->la_offset) {
+        av_fifo_drain2(s->la_fifo, 1);
+        s->la_samples -= head->nb_samples;
+        *frame = head;
+        return 1;
+    }
+
+    nb_samples = FFMIN(nb_samples, s->la_samples);
+    out = ff_get_audio_buffer(inlink, nb_samples);
+    if (!out)
+        return AVERROR(ENOMEM);
+    av_frame_copy_props(out, head);
+    if (head->pts != AV_NOPTS_VALUE)
+        out->pts = head->pts + av_rescale_q(s->la_offset, (AVRational){ 1, inlink->sample_rate },
+                                            inlink->time_base);
+
+    while (offset < nb_samples) {
+        int n;
+
+        av_fifo_peek(s->la_fifo, &head, 1, 0);
+        n = FFMIN(nb_samples - offset, head->nb_samples - s->la_offset);
+        av_samples_copy(out->extended_data, head->extended_data, offset, s->la_offset,
+                        n, s->channels, inlink->format);
+        offset        += n;
+        s->la_offset  += n;
+        if (s->la_offset == head->nb_samples) {
+            av_fifo_drain2(s->la_fifo, 1);
+            av_frame_free(&head);
+            s->la_offset = 0;
+        }
+    }
+    s->la_samples -= nb_samples;
+
+    *frame = out;
+    return 1;
+}
+
+#if CONFIG_SWRESAMPLE
+/**
+ * Upsample the queued input until a whole frame to normalize is available.
+ * Return 1 if it is, 0 if all the queued input is used up.
+ */
+static int resample_input(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    LoudNormContext *s = ctx->priv;
+    const int nb_samples = frame_nb_samples(s, inlink);
+
+    while (av_audio_fifo_size(s->swr_fifo) < nb_samples) {
+        AVFrame *in, *out;
+        int ret = lookahead_get_samples(inlink, frame_size(inlink->sample_rate, 100), &in);
+
+        if (ret <= 0)
+            return ret;
+        out = ff_get_audio_buffer(inlink, swr_get_out_samples(s->swr_up, in->nb_samples));
+        if (!out) {
+            av_frame_free(&in);
+            return AVERROR(ENOMEM);
+        }
+        ret = swr_convert(s->swr_up, out->extended_data, out->nb_samples,
+                          (const uint8_t **)in->extended_data, in->nb_samples);
+        av_frame_free(&in);
+        if (ret > 0)
+            ret = av_audio_fifo_write(s->swr_fifo, (void **)out->extended_data, ret);
+        av_frame_free(&out);
+        if (ret < 0)
+            return ret;
+    }
+    return 1;
+}
+
+static int resample_flush_input(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    LoudNormContext *s = ctx->priv;
+    const int nb_samples = swr_get_out_samples(s->swr_up, 0);
+    AVFrame *out;
+    int ret;
+
+    s->swr_flushed = 1;
+    if (nb_samples <= 0)
+        return nb_samples;
+    out = ff_get_audio_buffer(inlink, nb_samples);
+    if (!out)
+        return AVERROR(ENOMEM);
+    ret = swr_convert(s->swr_up, out->extended_data, nb_samples, NULL, 0);
+    if (ret > 0)
+        ret = av_audio_fifo_write(s->swr_fifo, (void **)out->extended_data, ret);
+    av_frame_free(&out);
+    return ret;
+}
+
+static int activate_resample(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+    LoudNormContext *s = ctx->priv;
+    AVFrame *in;
+    int nb_samples, ret;
+
+    ret = resample_input(ctx);
+    if (ret < 0)
+        return ret;
+    if (!ret) {
+        if (!s->la_status) {
+            ff_filter_set_ready(ctx, 100);
+            return 0;
+        }
+        if (!s->swr_flushed) {
+            ret = resample_flush_input(ctx);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    nb_samples = FFMIN(frame_nb_samples(s, inlink), av_audio_fifo_size(s->swr_fifo));
+    if (nb_samples > 0) {
+        in = ff_get_audio_buffer(inlink, nb_samples);
+        if (!in)
+            return AVERROR(ENOMEM);
+        ret = av_audio_fifo_read(s->swr_fifo, (void **)in->extended_data, nb_samples);
+        if (ret < 0) {
+            av_frame_free(&in);
+            return ret;
+        }
+        /* the output timestamps are derived from the resampled sample count */
+        in->pts = 0;
+        ret = process_frame(inlink, in);
+        if (ret < 0)
+            return ret;
+        ff_filter_set_ready(ctx, 100);
+        return 0;
+    }
+
+    ret = flush_frame(outlink);
+    if (ret >= 0)
+        ret = output_frame(ctx, NULL);
+    ff_outlink_set_status(outlink, s->la_status, s->la_status_pts);
+    return ret;
+}
+#endif
+
+static int lookahead_ready(AVFilterContext *ctx, int64_t max_samples)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    LoudNormContext *s = ctx->priv;
+
+    if (s->la_status)
+        return 1;
+    if (s->r128_la)
+        return s->la_samples >= max_samples;
+#if CONFIG_SWRESAMPLE
+    if (s->swr_fifo)
+        return resample_input(ctx);
+#endif
+    return s->la_samples >= frame_nb_samples(s, inlink);
+}
+
+static int activate_lookahead(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+    LoudNormContext *s = ctx->priv;
+    const int64_t max_samples = s->lookahead_max ?
+        av_rescale(s->lookahead_max, inlink->sample_rate, AV_TIME_BASE) : INT64_MAX;
+    AVFrame *in = NULL;
+    int ret;
+
+    /* Queue the input until its end or lookahead_max while measuring it,
+     * then only as much as the next frame to normalize needs. */
+    while (!(ret = lookahead_ready(ctx, max_samples))) {
+        ret = ff_inlink_consume_frame(inlink, &in);
+        if (ret < 0)
+            return ret;
+        if (!ret) {
+            if (ff_inlink_acknowledge_status(inlink, &s->la_status, &s->la_status_pts))
+                break;
+            FF_FILTER_FORWARD_WANTED(outlink, inlink);
+            return FFERROR_NOT_READY;
+        }
+
+        if (s->r128_la)
+            ff_ebur128_add_frames_double(s->r128_la, (const double *)in->data[0], in->nb_samples);
+        s->la_samples += in->nb_samples;
+        ret = av_fifo_write(s->la_fifo, &in, 1);
+        if (ret < 0) {
+            av_frame_free(&in);
+            return ret;
+        }
+    }
+
+    if (ret < 0)
+        return ret;
+
+    if (s->r128_la) {
+        ret = lookahead_measure(ctx);
+        if (ret < 0)
+            return ret;
+    }
+#if CONFIG_SWRESAMPLE
+    if (s->swr_fifo)
+        return activate_resample(ctx);
+#endif
+
+    ret = lookahead_get_samples(inlink, frame_nb_samples(s, inlink), &in);
+    if (ret < 0)
+        return ret;
+    if (ret > 0) {
+        ret = process_frame(inlink, in);
+        if (ret < 0)
+            return ret;
+        ff_filter_set_ready(ctx, 100);
+        return 0;
+    }
+
+    ff_outlink_set_status(outlink, s->la_status, s->la_status_pts);
+    return flush_frame(outlink);
+}
+
 static int activate(AVFilterContext *ctx)
 {
     AVFilterLink *inlink = ctx->inputs[0];
@@ -686,14 +1136,11 @@ static int activate(AVFilterContext *ctx)
 
     FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
 
-    if (s->frame_type != LINEAR_MODE) {
-        int nb_samples;
+    if (s->lookahead)
+        return activate_lookahead(ctx);
 
-        if (s->frame_type == FIRST_FRAME) {
-            nb_samples = frame_size(inlink->sample_rate, 3000);
-        } else {
-            nb_samples = frame_size(inlink->sample_rate, 100);
-        }
+    if (s->frame_type != LINEAR_MODE) {
+        const int nb_samples = frame_nb_samples(s, inlink);
 
         ret = ff_inlink_consume_samples(inlink, nb_samples, nb_samples, &in);
     } else {
@@ -702,19 +1149,8 @@ static int activate(AVFilterContext *ctx)
 
     if (ret < 0)
         return ret;
-    if (ret > 0) {
-        if (s->frame_type == FIRST_FRAME) {
-            const int nb_samples = frame_size(inlink->sample_rate, 100);
-
-            for (int i = 0; i < FF_ARRAY_ELEMS(s->pts); i++)
-                s->pts[i] = in->pts + i * nb_samples;
-        } else if (s->frame_type == LINEAR_MODE) {
-            s->pts[0] = in->pts;
-        } else {
-            s->pts[FF_ARRAY_ELEMS(s->pts) - 1] = in->pts;
-        }
-        ret = filter_frame(inlink, in);
-    }
+    if (ret > 0)
+        ret = process_frame(inlink, in);
     if (ret < 0)
         return ret;
 
@@ -744,7 +1180,8 @@ static int query_formats(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
 
-    if (s->frame_type == LINEAR_MODE) {
+    /* with lookahead, linear mode may still be chosen once the input is measured */
+    if (s->frame_type == LINEAR_MODE || (s->lookahead && s->linear)) {
         return ff_set_common_all_samplerates(ctx);
     } else {
         return ff_set_common_samplerates_from_list(ctx, input_srate);
@@ -755,34 +1192,25 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     LoudNormContext *s = ctx->priv;
+    int ret;
 
-    s->r128_in = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
-    if (!s->r128_in)
-        return AVERROR(ENOMEM);
-
-    s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
-    if (!s->r128_out)
-        return AVERROR(ENOMEM);
-
-    if (inlink->ch_layout.nb_channels == 1 && s->dual_mono) {
-        ff_ebur128_set_channel(s->r128_in,  0, FF_EBUR128_DUAL_MONO);
-        ff_ebur128_set_channel(s->r128_out, 0, FF_EBUR128_DUAL_MONO);
-    }
-
-    s->buf_size = frame_size(inlink->sample_rate, 3000) * inlink->ch_layout.nb_channels;
-    s->buf = av_malloc_array(s->buf_size, sizeof(*s->buf));
-    if (!s->buf)
-        return AVERROR(ENOMEM);
-
-    s->limiter_buf_size = frame_size(inlink->sample_rate, 210) * inlink->ch_layout.nb_channels;
-    s->limiter_buf = av_malloc_array(s->buf_size, sizeof(*s->limiter_buf));
-    if (!s->limiter_buf)
-        return AVERROR(ENOMEM);
+    ret = init_state(ctx, inlink->sample_rate);
+    if (ret < 0)
+        return ret;
 
     s->prev_smp = av_malloc_array(inlink->ch_layout.nb_channels, sizeof(*s->prev_smp));
     if (!s->prev_smp)
         return AVERROR(ENOMEM);
 
+    if (s->lookahead) {
+        s->r128_la = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+        s->la_fifo = av_fifo_alloc2(64, sizeof(AVFrame *), AV_FIFO_FLAG_AUTO_GROW);
+        if (!s->r128_la || !s->la_fifo)
+            return AVERROR(ENOMEM);
+        if (inlink->ch_layout.nb_channels == 1 && s->dual_mono)
+            ff_ebur128_set_channel(s->r128_la, 0, FF_EBUR128_DUAL_MONO);
+    }
+
     init_gaussian_filter(s);
 
     s->buf_index =
@@ -793,8 +1221,6 @@ static int config_input(AVFilterLink *inlink)
     s->limiter_state = OUT;
     s->offset = pow(10., s->offset / 20.);
     s->target_tp = pow(10., s->target_tp / 20.);
-    s->attack_length = frame_size(inlink->sample_rate, 10);
-    s->release_length = frame_size(inlink->sample_rate, 100);
 
     return 0;
 }
@@ -817,6 +1243,10 @@ static av_cold int init(AVFilterContext *ctx)
         }
     }
 
+    /* nothing left to measure */
+    if (s->frame_type == LINEAR_MODE)
+        s->lookahead = 0;
+
     return 0;
 }
 
@@ -914,9 +1344,24 @@ end:
         ff_ebur128_destroy(&s->r128_in);
     if (s->r128_out)
         ff_ebur128_destroy(&s->r128_out);
+    if (s->r128_la)
+        ff_ebur128_destroy(&s->r128_la);
+    if (s->la_fifo) {
+        AVFrame *frame;
+
+        while (av_fifo_read(s->la_fifo, &frame, 1) >= 0)
+            av_frame_free(&frame);
+        av_fifo_freep2(&s->la_fifo);
+    }
     av_freep(&s->limiter_buf);
     av_freep(&s->prev_smp);
     av_freep(&s->buf);
+#if CONFIG_SWRESAMPLE
+    swr_free(&s->swr_up);
+    swr_free(&s->swr_down);
+    if (s->swr_fifo)
+        av_audio_fifo_free(s->swr_fifo);
+#endif
 }
 
 static const AVFilterPad avfilter_af_loudnorm_inputs[] = {
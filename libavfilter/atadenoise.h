@@ -37,6 +37,13 @@ typedef struct ATADenoiseDSPContext {
                           int thra, int thrb, const float *weight);
 } ATADenoiseDSPContext;
 
+/**
+ * Set the filter_row function of each plane.
+ *
+ * @param sigma per-plane sigma, INT16_MAX disables the weighting
+ */
+void ff_atadenoise_init(ATADenoiseDSPContext *dsp, int depth, int algorithm, const float *sigma);
 void ff_atadenoise_init_x86(ATADenoiseDSPContext *dsp, int depth, int algorithm, const float *sigma);
+void ff_atadenoise_init_aarch64(ATADenoiseDSPContext *dsp, int depth, int algorithm, const float *sigma);
 
 #endif /* AVFILTER_ATADENOISE_H */
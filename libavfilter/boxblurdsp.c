@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Row kernels of the running sum box blurs (boxblur, avgblur)
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "boxblurdsp.h"
+
+#define VBLUR_ROW(type, depth)                                                 \
+void ff_boxblur_vblur_row ## depth ## _c(uint32_t *sum, uint8_t *dst8,         \
+                                         const uint8_t *srca8,                 \
+                                         const uint8_t *srcs8,                 \
+                                         int inv, ptrdiff_t width)             \
+{                                                                              \
+    const type *srca = (const type *)srca8;                                    \
+    const type *srcs = (const type *)srcs8;                                    \
+    type *dst = (type *)dst8;                                                  \
+                                                                               \
+    for (ptrdiff_t x = 0; x < width; x++) {                                    \
+        sum[x] += (uint32_t)((srca[x] - srcs[x]) * inv);                       \
+        dst[x] = sum[x] >> 16;                                                 \
+    }                                                                          \
+}
+
+VBLUR_ROW(uint8_t,   8)
+VBLUR_ROW(uint16_t, 16)
+
+#undef VBLUR_ROW
+
+#define UPDATE_COL_SUMS(type, btype, depth)                                    \
+void ff_boxblur_update_col_sums ## depth ## _c(void *col_sum8,                 \
+                                               const uint8_t *add8,            \
+                                               const uint8_t *sub8,            \
+                                               ptrdiff_t width)                \
+{                                                                              \
+    const type *add = (const type *)add8;                                      \
+    const type *sub = (const type *)sub8;                                      \
+    btype *col_sum = col_sum8;                                                 \
+                                                                               \
+    for (ptrdiff_t x = 0; x < width; x++)                                      \
+        col_sum[x] += add[x] - sub[x];                                         \
+}
+
+UPDATE_COL_SUMS(uint8_t,  int32_t,  8)
+UPDATE_COL_SUMS(uint16_t, int64_t, 16)
+
+#undef UPDATE_COL_SUMS
+
+av_cold void ff_boxblurdsp_init(BoxBlurDSPContext *dsp, int depth)
+{
+    dsp->vblur_row       = depth > 8 ? ff_boxblur_vblur_row16_c
+                                     : ff_boxblur_vblur_row8_c;
+    dsp->update_col_sums = depth > 8 ? ff_boxblur_update_col_sums16_c
+                                     : ff_boxblur_update_col_sums8_c;
+
+#if ARCH_X86
+    ff_boxblurdsp_init_x86(dsp, depth);
+#endif
+}
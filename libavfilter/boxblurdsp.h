@@ -0,0 +1,65 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Row kernels of the running sum box blurs (boxblur, avgblur)
+ */
+
+#ifndef AVFILTER_BOXBLURDSP_H
+#define AVFILTER_BOXBLURDSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct BoxBlurDSPContext {
+    /**
+     * Advance the vertical running sums of width columns by one line:
+     * sum[x] += (srca[x] - srcs[x]) * inv, then store sum[x] >> 16 to dst[x].
+     * The sums wrap around and only the low bits of the result that fit the
+     * pixel type are stored.
+     *
+     * @param inv fixed point reciprocal of the box length, below 1 << 16
+     */
+    void (*vblur_row)(uint32_t *sum, uint8_t *dst, const uint8_t *srca,
+                      const uint8_t *srcs, int inv, ptrdiff_t width);
+
+    /**
+     * Move the per-column sums one line down: col_sum[x] += add[x] - sub[x].
+     * The sums are int32_t for 8-bit samples and int64_t for 16-bit samples.
+     */
+    void (*update_col_sums)(void *col_sum, const uint8_t *add,
+                            const uint8_t *sub, ptrdiff_t width);
+} BoxBlurDSPContext;
+
+void ff_boxblur_vblur_row8_c(uint32_t *sum, uint8_t *dst, const uint8_t *srca,
+                             const uint8_t *srcs, int inv, ptrdiff_t width);
+void ff_boxblur_vblur_row16_c(uint32_t *sum, uint8_t *dst, const uint8_t *srca,
+                              const uint8_t *srcs, int inv, ptrdiff_t width);
+void ff_boxblur_update_col_sums8_c(void *col_sum, const uint8_t *add,
+                                   const uint8_t *sub, ptrdiff_t width);
+void ff_boxblur_update_col_sums16_c(void *col_sum, const uint8_t *add,
+                                    const uint8_t *sub, ptrdiff_t width);
+
+/**
+ * @param depth 8 for 8-bit samples, 16 for samples stored in 16 bits
+ */
+void ff_boxblurdsp_init(BoxBlurDSPContext *dsp, int depth);
+void ff_boxblurdsp_init_x86(BoxBlurDSPContext *dsp, int depth);
+
+#endif /* AVFILTER_BOXBLURDSP_H */
@@ -24,6 +24,7 @@
  */
 
 #include <float.h>
+#include <stdatomic.h>
 
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
@@ -40,6 +41,22 @@
 #include "internal.h"
 #include "video.h"
 
+typedef struct QueuedFrame {
+    atomic_uintptr_t next;
+    AVFrame *frame;         ///< NULL for EOF, or if copying the frame failed
+    int flags;
+    int64_t pts;            ///< end of the frame, or EOF timestamp
+    int eof;
+    int eof_last_pts;       ///< use the end of the last frame as EOF timestamp
+    unsigned nb_frames;     ///< for EOF, number of frames accepted before it
+} QueuedFrame;
+
+/* queue_state holds the number of accepted frames shifted left by one, and
+ * in its lowest bit whether EOF was accepted */
+#define QUEUE_EOF        1
+#define QUEUE_FRAME      2
+#define QUEUE_COUNT_MASK (UINT_MAX >> 1)
+
 typedef struct BufferSourceContext {
     const AVClass    *class;
     AVRational        time_base;     ///< time_base to set in the output link
@@ -62,8 +79,72 @@ typedef struct BufferSourceContext {
 
     int eof;
     int64_t last_pts;
+
+    /**
+     * Frames submitted from any thread in threadsafe mode, in an intrusive
+     * lock-free multi-producer single-consumer queue: producers append at
+     * queue_head, the thread running the graph removes from queue_tail.
+     * queue_stub keeps the queue from ever being empty for the producers.
+     */
+    int threadsafe;
+    atomic_uintptr_t queue_head;
+    QueuedFrame *queue_tail;
+    QueuedFrame queue_stub;
+    atomic_uint queue_state;
+    unsigned nb_dequeued;           ///< frames taken from the queue
+    QueuedFrame *queue_eof;         ///< EOF waiting for frames queued behind it
+    void (*wakeup)(void *opaque);
+    void *wakeup_opaque;
 } BufferSourceContext;
 
+static void queue_push(BufferSourceContext *s, QueuedFrame *node)
+{
+    QueuedFrame *prev;
+
+    atomic_store_explicit(&node->next, 0, memory_order_relaxed);
+    prev = (QueuedFrame *)atomic_exchange_explicit(&s->queue_head, (uintptr_t)node,
+                                                   memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, (uintptr_t)node, memory_order_release);
+}
+
+/* Returns NULL when the queue is empty, or when the only queued frame is
+ * still being appended; its producer calls the wakeup callback afterwards. */
+static QueuedFrame *queue_pop(BufferSourceContext *s)
+{
+    QueuedFrame *tail = s->queue_tail;
+    QueuedFrame *next = (QueuedFrame *)atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (tail == &s->queue_stub) {
+        if (!next)
+            return NULL;
+        s->queue_tail = tail = next;
+        next = (QueuedFrame *)atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+    if (next) {
+        s->queue_tail = next;
+        return tail;
+    }
+
+    if (tail != (QueuedFrame *)atomic_load_explicit(&s->queue_head, memory_order_acquire))
+        return NULL;
+    /* tail is the last node, put the stub behind it to be able to remove it */
+    queue_push(s, &s->queue_stub);
+    next = (QueuedFrame *)atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next) {
+        s->queue_tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+static void queue_init(BufferSourceContext *s)
+{
+    atomic_init(&s->queue_stub.next, 0);
+    atomic_init(&s->queue_head, (uintptr_t)&s->queue_stub);
+    atomic_init(&s->queue_state, 0);
+    s->queue_tail = &s->queue_stub;
+}
+
 #define CHECK_VIDEO_PARAM_CHANGE(s, c, width, height, format, pts)\
     if (c->w != width || c->h != height || c->pix_fmt != format) {\
         av_log(s, AV_LOG_INFO, "filter context - w: %d h: %d fmt: %d, incoming frame - w: %d h: %d fmt: %d pts_time: %s\n",\
@@ -173,71 +254,52 @@ static int push_frame(AVFilterGraph *graph)
     return 0;
 }
 
-int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+static int check_frame(AVFilterContext *ctx, AVFrame *frame)
 {
     BufferSourceContext *s = ctx->priv;
-    AVFrame *copy;
-    int refcounted, ret;
+    int ret;
 
+    switch (ctx->outputs[0]->type) {
+    case AVMEDIA_TYPE_VIDEO:
+        CHECK_VIDEO_PARAM_CHANGE(ctx, s, frame->width, frame->height,
+                                 frame->format, frame->pts);
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        /* For layouts unknown on input but known on link after negotiation. */
 #if FF_API_OLD_CHANNEL_LAYOUT
 FF_DISABLE_DEPRECATION_WARNINGS
-    if (frame && frame->channel_layout &&
-        av_get_channel_layout_nb_channels(frame->channel_layout) != frame->channels) {
-        av_log(ctx, AV_LOG_ERROR, "Layout indicates a different number of channels than actually present\n");
-        return AVERROR(EINVAL);
-    }
+        if (!frame->channel_layout)
+            frame->channel_layout = s->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ?
+                                    s->ch_layout.u.mask : 0;
 FF_ENABLE_DEPRECATION_WARNINGS
 #endif
-
-    s->nb_failed_requests = 0;
-
-    if (!frame)
-        return av_buffersrc_close(ctx, s->last_pts, flags);
-    if (s->eof)
+        if (frame->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+            ret = av_channel_layout_copy(&frame->ch_layout, &s->ch_layout);
+            if (ret < 0)
+                return ret;
+        }
+        CHECK_AUDIO_PARAM_CHANGE(ctx, s, frame->sample_rate, frame->ch_layout,
+                                 frame->format, frame->pts);
+        break;
+    default:
         return AVERROR(EINVAL);
+    }
 
-    s->last_pts = frame->pts + frame->duration;
-
-    refcounted = !!frame->buf[0];
-
-    if (!(flags & AV_BUFFERSRC_FLAG_NO_CHECK_FORMAT)) {
-
-        switch (ctx->outputs[0]->type) {
-        case AVMEDIA_TYPE_VIDEO:
-            CHECK_VIDEO_PARAM_CHANGE(ctx, s, frame->width, frame->height,
-                                     frame->format, frame->pts);
-            break;
-        case AVMEDIA_TYPE_AUDIO:
-            /* For layouts unknown on input but known on link after negotiation. */
-#if FF_API_OLD_CHANNEL_LAYOUT
-FF_DISABLE_DEPRECATION_WARNINGS
-            if (!frame->channel_layout)
-                frame->channel_layout = s->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ?
-                                        s->ch_layout.u.mask : 0;
-FF_ENABLE_DEPRECATION_WARNINGS
-#endif
-            if (frame->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
-                ret = av_channel_layout_copy(&frame->ch_layout, &s->ch_layout);
-                if (ret < 0)
-                    return ret;
-            }
-            CHECK_AUDIO_PARAM_CHANGE(ctx, s, frame->sample_rate, frame->ch_layout,
-                                     frame->format, frame->pts);
-            break;
-        default:
-            return AVERROR(EINVAL);
-        }
+    return 0;
+}
 
-    }
+static AVFrame *copy_frame(AVFrame *frame, int flags)
+{
+    AVFrame *copy;
 
-    if (refcounted && !(flags & AV_BUFFERSRC_FLAG_KEEP_REF)) {
+    if (frame->buf[0] && !(flags & AV_BUFFERSRC_FLAG_KEEP_REF)) {
         if (!(copy = av_frame_alloc()))
-            return AVERROR(ENOMEM);
+            return NULL;
         av_frame_move_ref(copy, frame);
     } else {
         copy = av_frame_clone(frame);
         if (!copy)
-            return AVERROR(ENOMEM);
+            return NULL;
     }
 
 #if FF_API_PKT_DURATION
@@ -263,6 +325,145 @@ FF_DISABLE_DEPRECATION_WARNINGS
 FF_ENABLE_DEPRECATION_WARNINGS
 #endif
 
+    return copy;
+}
+
+/*
+ * Called from any thread in threadsafe mode, frame NULL for EOF.
+ *
+ * A frame submitted concurrently with EOF may end up behind it in the
+ * queue. Every frame is therefore counted when it is accepted, and the EOF
+ * records how many were accepted before it: it only takes effect once that
+ * many frames have been taken from the queue.
+ */
+static int queue_frame(AVFilterContext *ctx, AVFrame *frame, int flags,
+                       int64_t eof_pts, int eof_last_pts)
+{
+    BufferSourceContext *s = ctx->priv;
+    QueuedFrame *node;
+    unsigned state;
+    int ret = 0;
+
+    if (flags & AV_BUFFERSRC_FLAG_PUSH)
+        return AVERROR(EINVAL);
+
+    node = av_mallocz(sizeof(*node));
+    if (!node)
+        return AVERROR(ENOMEM);
+
+    state = atomic_load_explicit(&s->queue_state, memory_order_relaxed);
+    do {
+        if (state & QUEUE_EOF) {
+            av_free(node);
+            return AVERROR(EINVAL);
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&s->queue_state, &state,
+                                                    frame ? state + QUEUE_FRAME : state | QUEUE_EOF,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    if (frame) {
+        node->pts   = frame->pts + frame->duration;
+        node->flags = flags;
+        node->frame = copy_frame(frame, flags);
+        /* still queued so that the count of accepted frames stays right */
+        if (!node->frame)
+            ret = AVERROR(ENOMEM);
+    } else {
+        node->pts          = eof_pts;
+        node->eof          = 1;
+        node->eof_last_pts = eof_last_pts;
+        node->nb_frames    = state >> 1;
+    }
+
+    queue_push(s, node);
+    if (s->wakeup)
+        s->wakeup(s->wakeup_opaque);
+
+    return ret;
+}
+
+/* Returns the number of frames sent to the output, or a negative error. */
+static int process_queue(AVFilterContext *ctx)
+{
+    BufferSourceContext *s = ctx->priv;
+    QueuedFrame *node;
+    int nb_frames = 0, ret = 0;
+
+    while (ret >= 0 && (node = queue_pop(s))) {
+        AVFrame *frame = node->frame;
+
+        if (node->eof) {
+            s->queue_eof = node;
+            node = NULL;
+        } else if (!frame) {
+            s->nb_dequeued++;
+        } else {
+            s->nb_dequeued++;
+            s->nb_failed_requests = 0;
+            s->last_pts = node->pts;
+
+            if (!(node->flags & AV_BUFFERSRC_FLAG_NO_CHECK_FORMAT))
+                ret = check_frame(ctx, frame);
+            if (ret < 0)
+                av_frame_free(&frame);
+            else
+                ret = ff_filter_frame(ctx->outputs[0], frame);
+            nb_frames++;
+        }
+        av_free(node);
+
+        if (s->queue_eof &&
+            (s->nb_dequeued & QUEUE_COUNT_MASK) == s->queue_eof->nb_frames) {
+            s->eof = 1;
+            ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF,
+                                           s->queue_eof->eof_last_pts ?
+                                           s->last_pts : s->queue_eof->pts);
+            av_freep(&s->queue_eof);
+        }
+    }
+
+    return ret < 0 ? ret : nb_frames;
+}
+
+int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+{
+    BufferSourceContext *s = ctx->priv;
+    AVFrame *copy;
+    int ret;
+
+#if FF_API_OLD_CHANNEL_LAYOUT
+FF_DISABLE_DEPRECATION_WARNINGS
+    if (frame && frame->channel_layout &&
+        av_get_channel_layout_nb_channels(frame->channel_layout) != frame->channels) {
+        av_log(ctx, AV_LOG_ERROR, "Layout indicates a different number of channels than actually present\n");
+        return AVERROR(EINVAL);
+    }
+FF_ENABLE_DEPRECATION_WARNINGS
+#endif
+
+    if (s->threadsafe)
+        return queue_frame(ctx, frame, flags, AV_NOPTS_VALUE, 1);
+
+    s->nb_failed_requests = 0;
+
+    if (!frame)
+        return av_buffersrc_close(ctx, s->last_pts, flags);
+    if (s->eof)
+        return AVERROR(EINVAL);
+
+    s->last_pts = frame->pts + frame->duration;
+
+    if (!(flags & AV_BUFFERSRC_FLAG_NO_CHECK_FORMAT)) {
+        ret = check_frame(ctx, frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    copy = copy_frame(frame, flags);
+    if (!copy)
+        return AVERROR(ENOMEM);
+
     ret = ff_filter_frame(ctx->outputs[0], copy);
     if (ret < 0)
         return ret;
@@ -280,15 +481,50 @@ int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
 {
     BufferSourceContext *s = ctx->priv;
 
+    if (s->threadsafe)
+        return queue_frame(ctx, NULL, flags, pts, 0);
+
     s->eof = 1;
     ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF, pts);
     return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph) : 0;
 }
 
+void av_buffersrc_set_wakeup(AVFilterContext *ctx, void (*wakeup)(void *opaque),
+                             void *opaque)
+{
+    BufferSourceContext *s = ctx->priv;
+
+    s->wakeup        = wakeup;
+    s->wakeup_opaque = opaque;
+}
+
+int av_buffersrc_process_queue(AVFilterContext *ctx, int flags)
+{
+    BufferSourceContext *s = ctx->priv;
+    int nb_frames, ret;
+
+    if (!s->threadsafe)
+        return AVERROR(EINVAL);
+
+    nb_frames = process_queue(ctx);
+    if (nb_frames < 0)
+        return nb_frames;
+
+    if ((flags & AV_BUFFERSRC_FLAG_PUSH)) {
+        ret = push_frame(ctx->graph);
+        if (ret < 0)
+            return ret;
+    }
+
+    return nb_frames;
+}
+
 static av_cold int init_video(AVFilterContext *ctx)
 {
     BufferSourceContext *c = ctx->priv;
 
+    queue_init(c);
+
     if (c->pix_fmt == AV_PIX_FMT_NONE) {
         av_log(ctx, AV_LOG_ERROR, "Unspecified pixel format\n");
         return AVERROR(EINVAL);
@@ -328,6 +564,7 @@ static const AVOption buffer_options[] = {
     { "pixel_aspect",  "sample aspect ratio",    OFFSET(pixel_aspect),     AV_OPT_TYPE_RATIONAL, { .dbl = 0 }, 0, DBL_MAX, V },
     { "time_base",     NULL,                     OFFSET(time_base),        AV_OPT_TYPE_RATIONAL, { .dbl = 0 }, 0, DBL_MAX, V },
     { "frame_rate",    NULL,                     OFFSET(frame_rate),       AV_OPT_TYPE_RATIONAL, { .dbl = 0 }, 0, DBL_MAX, V },
+    { "threadsafe",    "accept frames from any thread", OFFSET(threadsafe), AV_OPT_TYPE_BOOL,     { .i64 = 0 }, 0, 1,       V },
     { NULL },
 };
 
@@ -339,6 +576,7 @@ static const AVOption abuffer_options[] = {
     { "sample_fmt",     NULL, OFFSET(sample_fmt),          AV_OPT_TYPE_SAMPLE_FMT, { .i64 = AV_SAMPLE_FMT_NONE }, .min = AV_SAMPLE_FMT_NONE, .max = INT_MAX, .flags = A },
     { "channel_layout", NULL, OFFSET(channel_layout_str),  AV_OPT_TYPE_STRING,             .flags = A },
     { "channels",       NULL, OFFSET(channels),            AV_OPT_TYPE_INT,      { .i64 = 0 }, 0, INT_MAX, A },
+    { "threadsafe",     "accept frames from any thread", OFFSET(threadsafe), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, A },
     { NULL },
 };
 
@@ -350,6 +588,8 @@ static av_cold int init_audio(AVFilterContext *ctx)
     char buf[128];
     int ret = 0;
 
+    queue_init(s);
+
     if (s->sample_fmt == AV_SAMPLE_FMT_NONE) {
         av_log(ctx, AV_LOG_ERROR, "Sample format was not set or was invalid\n");
         return AVERROR(EINVAL);
@@ -415,6 +655,15 @@ FF_ENABLE_DEPRECATION_WARNINGS
 static av_cold void uninit(AVFilterContext *ctx)
 {
     BufferSourceContext *s = ctx->priv;
+    QueuedFrame *node;
+
+    if (s->queue_tail) {
+        while ((node = queue_pop(s))) {
+            av_frame_free(&node->frame);
+            av_free(node);
+        }
+    }
+    av_freep(&s->queue_eof);
     av_buffer_unref(&s->hw_frames_ctx);
     av_channel_layout_uninit(&s->ch_layout);
 }
@@ -488,6 +737,11 @@ static int request_frame(AVFilterLink *link)
 {
     BufferSourceContext *c = link->src->priv;
 
+    if (c->threadsafe) {
+        int ret = process_queue(link->src);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
     if (c->eof)
         return AVERROR_EOF;
     c->nb_failed_requests++;
@@ -211,6 +211,57 @@ int av_buffersrc_add_frame_flags(AVFilterContext *buffer_src,
  */
 int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags);
 
+/**
+ * @name Threadsafe mode
+ *
+ * When the "threadsafe" option of the buffer source is set,
+ * av_buffersrc_add_frame_flags(), av_buffersrc_write_frame(),
+ * av_buffersrc_add_frame() and av_buffersrc_close() may be called from any
+ * number of threads concurrently with each other and with the thread
+ * running the filter graph. The frames are only queued, without locking;
+ * the graph takes them from the queue when it requests a frame from the
+ * buffer source, or when av_buffersrc_process_queue() is called.
+ * Format checks are done at that point, so their errors are returned by
+ * the functions running the graph. AV_BUFFERSRC_FLAG_PUSH can not be used
+ * when submitting frames in this mode.
+ *
+ * Frames submitted concurrently by different threads are queued in an
+ * unspecified order. A frame submitted concurrently with av_buffersrc_close()
+ * is either rejected with AVERROR(EINVAL), or accepted and output before EOF.
+ * @{
+ */
+
+/**
+ * Set a callback called after each frame or EOF is queued in threadsafe
+ * mode, from the submitting thread. It is meant to wake up the thread
+ * running the graph, which should then call av_buffersrc_process_queue():
+ * a graph that already failed to get a frame from this buffer source does
+ * not request one again by itself.
+ *
+ * Must be called before frames are submitted.
+ *
+ * @param ctx    an instance of the buffersrc or abuffersrc filter
+ * @param wakeup the callback, or NULL to remove it
+ * @param opaque passed to the callback
+ */
+void av_buffersrc_set_wakeup(AVFilterContext *ctx, void (*wakeup)(void *opaque),
+                             void *opaque);
+
+/**
+ * Send the frames queued in threadsafe mode to the filter graph.
+ * Must be called from the thread running the graph.
+ *
+ * @param ctx   an instance of the buffersrc or abuffersrc filter
+ * @param flags AV_BUFFERSRC_FLAG_PUSH to also run the graph
+ * @return the number of frames sent, or a negative AVERROR code,
+ *         AVERROR(EINVAL) if the filter is not in threadsafe mode
+ */
+int av_buffersrc_process_queue(AVFilterContext *ctx, int flags);
+
+/**
+ * @}
+ */
+
 /**
  * @}
  */
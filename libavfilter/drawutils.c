@@ -21,6 +21,7 @@
 
 #include <string.h>
 
+#include "config.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
 #include "libavutil/csp.h"
@@ -77,6 +78,26 @@ int ff_fill_rgba_map(uint8_t *rgba_map, enum AVPixelFormat pix_fmt)
     return 0;
 }
 
+static void blend_row_c(uint8_t *dst, const uint8_t *mask, ptrdiff_t mask_linesize,
+                        int w, unsigned src, unsigned alpha)
+{
+    for (int x = 0; x < w; x++) {
+        unsigned a = mask[x] * alpha;
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;
+    }
+}
+
+static void blend_row_2x2_c(uint8_t *dst, const uint8_t *mask, ptrdiff_t mask_linesize,
+                            int w, unsigned src, unsigned alpha)
+{
+    for (int x = 0; x < w; x++) {
+        unsigned t = mask[2 * x] + mask[2 * x + 1] +
+                     mask[2 * x + mask_linesize] + mask[2 * x + 1 + mask_linesize];
+        unsigned a = (t >> 2) * alpha;
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;
+    }
+}
+
 int ff_draw_init2(FFDrawContext *draw, enum AVPixelFormat format, enum AVColorSpace csp,
                   enum AVColorRange range, unsigned flags)
 {
@@ -145,6 +166,11 @@ int ff_draw_init2(FFDrawContext *draw, enum AVPixelFormat format, enum AVColorSp
     memcpy(draw->pixelstep, pixelstep, sizeof(draw->pixelstep));
     draw->hsub[1] = draw->hsub[2] = draw->hsub_max = desc->log2_chroma_w;
     draw->vsub[1] = draw->vsub[2] = draw->vsub_max = desc->log2_chroma_h;
+    draw->blend_row[0] = blend_row_c;
+    draw->blend_row[1] = blend_row_2x2_c;
+#if ARCH_X86
+    ff_draw_init_x86(draw);
+#endif
     return 0;
 }
 
@@ -510,7 +536,10 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
                           unsigned src, unsigned alpha,
                           const uint8_t *mask, int mask_linesize, int l2depth, int w,
                           unsigned hsub, unsigned vsub,
-                          int xm, int left, int right, int hband)
+                          int xm, int left, int right, int hband,
+                          void (*blend_row)(uint8_t *dst, const uint8_t *mask,
+                                            ptrdiff_t mask_linesize, int w,
+                                            unsigned src, unsigned alpha))
 {
     int x;
 
@@ -520,6 +549,12 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
         dst += dst_delta;
         xm += left;
     }
+    if (blend_row) {
+        blend_row(dst, mask + xm, mask_linesize, w, src, alpha);
+        dst += w * dst_delta;
+        xm += w << hsub;
+        w = 0;
+    }
     for (x = 0; x < w; x++) {
         blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
                     1 << hsub, hband, hsub + vsub, xm);
@@ -581,7 +616,7 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                                   color->comp[plane].u8[index], alpha,
                                   m, mask_linesize, l2depth, w_sub,
                                   draw->hsub[plane], draw->vsub[plane],
-                                  xm0, left, right, top);
+                                  xm0, left, right, top, NULL);
                 } else {
                     blend_line_hv16(p, draw->pixelstep[plane],
                                     color->comp[plane].u16[index], alpha,
@@ -593,12 +628,22 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                 m += top * mask_linesize;
             }
             if (depth <= 8) {
+                /* whole blocks of a byte mask over a plain 8-bit plane */
+                const int sub = draw->hsub[plane];
+                void (*blend_row)(uint8_t *dst, const uint8_t *mask,
+                                  ptrdiff_t mask_linesize, int w,
+                                  unsigned src, unsigned alpha) = NULL;
+
+                if (l2depth == 3 && depth == 8 && draw->pixelstep[plane] == 1 &&
+                    sub == draw->vsub[plane] && sub < FF_ARRAY_ELEMS(draw->blend_row))
+                    blend_row = draw->blend_row[sub];
                 for (y = 0; y < h_sub; y++) {
                     blend_line_hv(p, draw->pixelstep[plane],
                                   color->comp[plane].u8[index], alpha,
                                   m, mask_linesize, l2depth, w_sub,
                                   draw->hsub[plane], draw->vsub[plane],
-                                  xm0, left, right, 1 << draw->vsub[plane]);
+                                  xm0, left, right, 1 << draw->vsub[plane],
+                                  blend_row);
                     p += dst_linesize[plane];
                     m += mask_linesize << draw->vsub[plane];
                 }
@@ -619,7 +664,7 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                                   color->comp[plane].u8[index], alpha,
                                   m, mask_linesize, l2depth, w_sub,
                                   draw->hsub[plane], draw->vsub[plane],
-                                  xm0, left, right, bottom);
+                                  xm0, left, right, bottom, NULL);
                 } else {
                     blend_line_hv16(p, draw->pixelstep[plane],
                                     color->comp[plane].u16[index], alpha,
@@ -24,6 +24,7 @@
  * misc drawing utilities
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include "avfilter.h"
 #include "libavutil/pixfmt.h"
@@ -45,6 +46,15 @@ typedef struct FFDrawContext {
     unsigned flags;
     enum AVColorSpace csp;
     double rgb2yuv[3][3];
+
+    /**
+     * Blend w pixels of an 8-bit plane with the color component src, with
+     * an 8-bit mask scaled by alpha as in ff_blend_mask().
+     * blend_row[0] takes one mask value per pixel, blend_row[1] the mean of
+     * a 2x2 block, whose second row is mask_linesize bytes further.
+     */
+    void (*blend_row[2])(uint8_t *dst, const uint8_t *mask, ptrdiff_t mask_linesize,
+                         int w, unsigned src, unsigned alpha);
 } FFDrawContext;
 
 typedef struct FFDrawColor {
@@ -84,6 +94,8 @@ int ff_draw_init2(FFDrawContext *draw, enum AVPixelFormat format, enum AVColorSp
  */
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags);
 
+void ff_draw_init_x86(FFDrawContext *draw);
+
 
 
 /**
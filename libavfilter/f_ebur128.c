@@ -34,12 +34,14 @@
 #include "libavutil/channel_layout.h"
 #include "libavutil/dict.h"
 #include "libavutil/ffmath.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/xga_font_data.h"
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
 #include "libswresample/swresample.h"
 #include "audio.h"
 #include "avfilter.h"
+#include "f_ebur128.h"
 #include "filters.h"
 #include "formats.h"
 #include "internal.h"
@@ -87,6 +89,8 @@ typedef struct EBUR128Context {
     double sample_peak;             ///< global sample peak
     double *sample_peaks;           ///< sample peaks per channel
     double *true_peaks_per_frame;   ///< true peaks in a frame per channel
+    double *tp_history;             ///< last input samples of each channel for the true peak interpolation filter
+    EBUR128DSPContext dsp;
 #if CONFIG_SWRESAMPLE
     SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
     double *swr_buf;                ///< resampled audio data for true peak metering
@@ -115,15 +119,12 @@ typedef struct EBUR128Context {
     int idx_insample;               ///< current sample position of processed samples in single input frame
     AVFrame *insamples;             ///< input samples reference, updated regularly
 
-    /* Filter caches.
-     * The mult by 3 in the following is for X[i], X[i-1] and X[i-2] */
-    double *x;                      ///< 3 input samples cache for each channel
-    double *y;                      ///< 3 pre-filter samples cache for each channel
-    double *z;                      ///< 3 RLB-filter samples cache for each channel
-    double pre_b[3];                ///< pre-filter numerator coefficients
-    double pre_a[3];                ///< pre-filter denominator coefficients
-    double rlb_b[3];                ///< rlb-filter numerator coefficients
-    double rlb_a[3];                ///< rlb-filter denominator coefficients
+    /* K-weighting: the pre-filter and the RLB-filter run as two biquad
+     * sections over BIQUADS_LANES channels at a time. */
+    double *filter_state;           ///< i1, i2, o1 and o2 of both sections for each channel
+    double pre_coeffs[7];           ///< pre-filter coefficients, in the biquad lanes layout
+    double rlb_coeffs[7];           ///< RLB-filter coefficients, in the biquad lanes layout
+    BiquadsDSPContext biquads_dsp;
 
     struct integrator i400;         ///< 400ms integrator, used for Momentary loudness  (M), and Integrated loudness (I)
     struct integrator i3000;        ///<    3s integrator, used for Short term loudness (S), and Loudness Range      (LRA)
@@ -407,21 +408,26 @@ static int config_audio_input(AVFilterLink *inlink)
 
     double a0 = 1.0 + K / Q + K * K;
 
-    ebur128->pre_b[0] = (Vh + Vb * K / Q + K * K) / a0;
-    ebur128->pre_b[1] = 2.0 * (K * K - Vh) / a0;
-    ebur128->pre_b[2] = (Vh - Vb * K / Q + K * K) / a0;
-    ebur128->pre_a[1] = 2.0 * (K * K - 1.0) / a0;
-    ebur128->pre_a[2] = (1.0 - K / Q + K * K) / a0;
+    /* b0, b1, b2, -a1, -a2, then the wet and dry gains */
+    ebur128->pre_coeffs[0] = (Vh + Vb * K / Q + K * K) / a0;
+    ebur128->pre_coeffs[1] = 2.0 * (K * K - Vh) / a0;
+    ebur128->pre_coeffs[2] = (Vh - Vb * K / Q + K * K) / a0;
+    ebur128->pre_coeffs[3] = -2.0 * (K * K - 1.0) / a0;
+    ebur128->pre_coeffs[4] = -(1.0 - K / Q + K * K) / a0;
+    ebur128->pre_coeffs[5] = 1.0;
+    ebur128->pre_coeffs[6] = 0.0;
 
     f0 = 38.13547087602444;
     Q = 0.5003270373238773;
     K = tan(M_PI * f0 / (double)inlink->sample_rate);
 
-    ebur128->rlb_b[0] = 1.0;
-    ebur128->rlb_b[1] = -2.0;
-    ebur128->rlb_b[2] = 1.0;
-    ebur128->rlb_a[1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
-    ebur128->rlb_a[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+    ebur128->rlb_coeffs[0] = 1.0;
+    ebur128->rlb_coeffs[1] = -2.0;
+    ebur128->rlb_coeffs[2] = 1.0;
+    ebur128->rlb_coeffs[3] = -2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+    ebur128->rlb_coeffs[4] = -(1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+    ebur128->rlb_coeffs[5] = 1.0;
+    ebur128->rlb_coeffs[6] = 0.0;
 
     /* Force 100ms framing in case of metadata injection: the frames must have
      * a granularity of the window overlap to be accurately exploited.
@@ -447,11 +453,9 @@ static int config_audio_output(AVFilterLink *outlink)
                    AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
 
     ebur128->nb_channels  = nb_channels;
-    ebur128->x            = av_calloc(nb_channels, 3 * sizeof(*ebur128->x));
-    ebur128->y            = av_calloc(nb_channels, 3 * sizeof(*ebur128->y));
-    ebur128->z            = av_calloc(nb_channels, 3 * sizeof(*ebur128->z));
+    ebur128->filter_state = av_calloc(nb_channels, 2 * 4 * sizeof(*ebur128->filter_state));
     ebur128->ch_weighting = av_calloc(nb_channels, sizeof(*ebur128->ch_weighting));
-    if (!ebur128->ch_weighting || !ebur128->x || !ebur128->y || !ebur128->z)
+    if (!ebur128->ch_weighting || !ebur128->filter_state)
         return AVERROR(ENOMEM);
 
 #define I400_BINS(x)  ((x) * 4 / 10)
@@ -490,27 +494,39 @@ static int config_audio_output(AVFilterLink *outlink)
 
 #if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
-        int ret;
-
-        ebur128->swr_buf    = av_malloc_array(nb_channels, 19200 * sizeof(double));
         ebur128->true_peaks = av_calloc(nb_channels, sizeof(*ebur128->true_peaks));
         ebur128->true_peaks_per_frame = av_calloc(nb_channels, sizeof(*ebur128->true_peaks_per_frame));
-        ebur128->swr_ctx    = swr_alloc();
-        if (!ebur128->swr_buf || !ebur128->true_peaks ||
-            !ebur128->true_peaks_per_frame || !ebur128->swr_ctx)
+        if (!ebur128->true_peaks || !ebur128->true_peaks_per_frame)
             return AVERROR(ENOMEM);
 
-        av_opt_set_chlayout(ebur128->swr_ctx, "in_chlayout",    &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "in_sample_fmt", outlink->format, 0);
+        /* 48kHz input is upsampled with the interpolation filter of
+         * BS.1770-4 Annex 2 while filtering, other rates go through
+         * libswresample. */
+        if (outlink->sample_rate == 48000) {
+            ebur128->tp_history = av_calloc(nb_channels, (EBUR128_TP_TAPS - 1) *
+                                            sizeof(*ebur128->tp_history));
+            if (!ebur128->tp_history)
+                return AVERROR(ENOMEM);
+        } else {
+            int ret;
 
-        av_opt_set_chlayout(ebur128->swr_ctx, "out_chlayout",    &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
+            ebur128->swr_buf    = av_malloc_array(nb_channels, 19200 * sizeof(double));
+            ebur128->swr_ctx    = swr_alloc();
+            if (!ebur128->swr_buf || !ebur128->swr_ctx)
+                return AVERROR(ENOMEM);
 
-        ret = swr_init(ebur128->swr_ctx);
-        if (ret < 0)
-            return ret;
+            av_opt_set_chlayout(ebur128->swr_ctx, "in_chlayout",    &outlink->ch_layout, 0);
+            av_opt_set_int(ebur128->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
+            av_opt_set_sample_fmt(ebur128->swr_ctx, "in_sample_fmt", outlink->format, 0);
+
+            av_opt_set_chlayout(ebur128->swr_ctx, "out_chlayout",    &outlink->ch_layout, 0);
+            av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
+            av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
+
+            ret = swr_init(ebur128->swr_ctx);
+            if (ret < 0)
+                return ret;
+        }
     }
 #endif
 
@@ -541,6 +557,49 @@ static struct hist_entry *get_histogram(void)
     return h;
 }
 
+/* ITU-R BS.1770-4 Annex 2 */
+static const double tp_coeffs[EBUR128_TP_PHASES][EBUR128_TP_TAPS] = {
+    {  0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000,
+      -0.0594482421875,  0.1373291015625,  0.9721679687500, -0.1022949218750,
+       0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+    { -0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250,
+      -0.1665039062500,  0.4650878906250,  0.7797851562500, -0.2003173828125,
+       0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+    { -0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000,
+      -0.2003173828125,  0.7797851562500,  0.4650878906250, -0.1665039062500,
+       0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+    { -0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750,
+      -0.1022949218750,  0.9721679687500,  0.1373291015625, -0.0594482421875,
+       0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750 },
+};
+
+static void true_peak_c(double *peaks, const double *buf, ptrdiff_t len)
+{
+    for (ptrdiff_t n = 0; n < len; n++, buf += BIQUADS_LANES) {
+        for (int c = 0; c < BIQUADS_LANES; c++)
+            peaks[c] = FFMAX(peaks[c], fabs(buf[c]));
+        for (int p = 0; p < EBUR128_TP_PHASES; p++) {
+            double sum[BIQUADS_LANES];
+
+            for (int c = 0; c < BIQUADS_LANES; c++)
+                sum[c] = tp_coeffs[p][0] * buf[c];
+            for (int k = 1; k < EBUR128_TP_TAPS; k++)
+                for (int c = 0; c < BIQUADS_LANES; c++)
+                    sum[c] += tp_coeffs[p][k] * buf[c - k * BIQUADS_LANES];
+            for (int c = 0; c < BIQUADS_LANES; c++)
+                peaks[c] = FFMAX(peaks[c], fabs(sum[c]));
+        }
+    }
+}
+
+av_cold void ff_ebur128_dsp_init(EBUR128DSPContext *dsp)
+{
+    dsp->true_peak = true_peak_c;
+#if ARCH_X86
+    ff_ebur128_dsp_init_x86(dsp);
+#endif
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     EBUR128Context *ebur128 = ctx->priv;
@@ -566,6 +625,9 @@ static av_cold int init(AVFilterContext *ctx)
     // if meter is +18 scale, scale range is from -36 LU to +18 LU (or 3*18)
     ebur128->scale_range = 3 * ebur128->meter;
 
+    ff_biquads_init(&ebur128->biquads_dsp);
+    ff_ebur128_dsp_init(&ebur128->dsp);
+
     ebur128->i400.histogram  = get_histogram();
     ebur128->i3000.histogram = get_histogram();
     if (!ebur128->i400.histogram || !ebur128->i3000.histogram)
@@ -627,6 +689,214 @@ static int gate_update(struct integrator *integ, double power,
     return gate_hist_pos;
 }
 
+typedef struct ThreadData {
+    const double *samples;
+    int nb_samples;
+    int bin_id_400, bin_id_3000;
+} ThreadData;
+
+/* number of frames of a channel group filtered at once */
+#define LANE_BLOCK 256
+#define TP_HISTORY (EBUR128_TP_TAPS - 1)
+
+/* Adds the squared K-weighted samples of the nb_lanes first lanes of buf to
+ * the windows of the weighted channels from ch on. The lanes are updated
+ * together so that the running sums of the channels do not wait on each
+ * other. */
+static void update_windows(EBUR128Context *ebur128, int ch, int nb_lanes,
+                           const double *buf, int len, int bin_id_400, int bin_id_3000)
+{
+    double *cache_400 [BIQUADS_LANES], *cache_3000[BIQUADS_LANES];
+    double  sum_400   [BIQUADS_LANES],  sum_3000  [BIQUADS_LANES];
+    int lanes[BIQUADS_LANES], nb_weighted = 0;
+
+    for (int c = 0; c < nb_lanes; c++) {
+        if (!ebur128->ch_weighting[ch + c])
+            continue;
+        lanes     [nb_weighted] = c;
+        cache_400 [nb_weighted] = ebur128->i400.cache [ch + c];
+        cache_3000[nb_weighted] = ebur128->i3000.cache[ch + c];
+        sum_400   [nb_weighted] = ebur128->i400.sum [ch + c];
+        sum_3000  [nb_weighted] = ebur128->i3000.sum[ch + c];
+        nb_weighted++;
+    }
+
+    for (int i = 0; i < len; i++, buf += BIQUADS_LANES) {
+        for (int k = 0; k < nb_weighted; k++) {
+            const double bin = buf[lanes[k]] * buf[lanes[k]];
+
+            /* add the new value, and limit the sum to the cache size (400ms or 3s)
+             * by removing the oldest one */
+            sum_400 [k] = sum_400 [k] + bin - cache_400 [k][bin_id_400];
+            sum_3000[k] = sum_3000[k] + bin - cache_3000[k][bin_id_3000];
+
+            /* override old cache entry with the new value */
+            cache_400 [k][bin_id_400 ] = bin;
+            cache_3000[k][bin_id_3000] = bin;
+        }
+
+        if (++bin_id_400  == ebur128->i400.cache_size)
+            bin_id_400  = 0;
+        if (++bin_id_3000 == ebur128->i3000.cache_size)
+            bin_id_3000 = 0;
+    }
+
+    for (int k = 0; k < nb_weighted; k++) {
+        ebur128->i400.sum [ch + lanes[k]] = sum_400 [k];
+        ebur128->i3000.sum[ch + lanes[k]] = sum_3000[k];
+    }
+}
+
+/* K-weights one channel on its own, in the same order of operations as the
+ * lane functions. */
+static void filter_channel(EBUR128Context *ebur128, const ThreadData *td, int ch)
+{
+    const int nb_channels = ebur128->nb_channels;
+    const double *src = td->samples + ch;
+    const double *pre = ebur128->pre_coeffs, *rlb = ebur128->rlb_coeffs;
+    double *fstate = ebur128->filter_state + ch * 2 * 4;
+    double *cache_400  = ebur128->i400.cache [ch];
+    double *cache_3000 = ebur128->i3000.cache[ch];
+    double sum_400  = ebur128->i400.sum [ch];
+    double sum_3000 = ebur128->i3000.sum[ch];
+    int bin_id_400  = td->bin_id_400;
+    int bin_id_3000 = td->bin_id_3000;
+    double x1 = fstate[0], x2 = fstate[1], y1 = fstate[2], y2 = fstate[3];
+    double z1 = fstate[6], z2 = fstate[7];
+
+    if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
+        double peak = ebur128->sample_peaks[ch];
+        for (int i = 0; i < td->nb_samples; i++)
+            peak = FFMAX(peak, fabs(src[i * nb_channels]));
+        ebur128->sample_peaks[ch] = peak;
+    }
+
+    if (!ebur128->ch_weighting[ch])
+        return;
+
+    for (int i = 0; i < td->nb_samples; i++) {
+        const double x0 = src[i * nb_channels];
+        const double y0 = x2 * pre[2] + x1 * pre[1] + x0 * pre[0] + y2 * pre[4] + y1 * pre[3];
+        const double z0 = y2 * rlb[2] + y1 * rlb[1] + y0 * rlb[0] + z2 * rlb[4] + z1 * rlb[3];
+        const double bin = z0 * z0;
+
+        x2 = x1; x1 = x0;
+        y2 = y1; y1 = y0;
+        z2 = z1; z1 = z0;
+
+        sum_400  = sum_400  + bin - cache_400 [bin_id_400];
+        sum_3000 = sum_3000 + bin - cache_3000[bin_id_3000];
+        cache_400 [bin_id_400 ] = bin;
+        cache_3000[bin_id_3000] = bin;
+        if (++bin_id_400  == ebur128->i400.cache_size)
+            bin_id_400  = 0;
+        if (++bin_id_3000 == ebur128->i3000.cache_size)
+            bin_id_3000 = 0;
+    }
+
+    /* the RLB-filter input history is the pre-filter output history */
+    fstate[0] = x1; fstate[1] = x2; fstate[2] = y1; fstate[3] = y2;
+    fstate[4] = y1; fstate[5] = y2; fstate[6] = z1; fstate[7] = z2;
+    ebur128->i400.sum [ch] = sum_400;
+    ebur128->i3000.sum[ch] = sum_3000;
+}
+
+/* With the true peak interpolation filter, the channels of the job are
+ * filtered BIQUADS_LANES at a time: each group is transposed into a small
+ * interleaved block, in which the interpolation filter reads the input and
+ * the K-weighting runs in place. */
+static int filter_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    const ThreadData *td = arg;
+    const int nb_channels = ebur128->nb_channels;
+    const int ch_start = (nb_channels *  jobnr   ) / nb_jobs;
+    const int ch_end   = (nb_channels * (jobnr+1)) / nb_jobs;
+    LOCAL_ALIGNED_32(double, block, [(TP_HISTORY + LANE_BLOCK) * BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, state, [2 * 4 * BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, peaks, [BIQUADS_LANES]);
+    double *buf = block + TP_HISTORY * BIQUADS_LANES;
+
+    /* Without the interpolation filter the running sums of the windows bound
+     * the speed, and the transposition would cost more than the lanes save. */
+    if (!ebur128->tp_history) {
+        for (int ch = ch_start; ch < ch_end; ch++)
+            filter_channel(ebur128, td, ch);
+        return 0;
+    }
+
+    for (int g = ch_start; g < ch_end; g += BIQUADS_LANES) {
+        const int nb_lanes = FFMIN(ch_end - g, BIQUADS_LANES);
+        int bin_id_400  = td->bin_id_400;
+        int bin_id_3000 = td->bin_id_3000;
+
+        memset(block, 0, TP_HISTORY * BIQUADS_LANES * sizeof(*block));
+        memset(state, 0, 2 * 4 * BIQUADS_LANES * sizeof(*state));
+        memset(peaks, 0, BIQUADS_LANES * sizeof(*peaks));
+        for (int c = 0; c < nb_lanes; c++) {
+            const double *fstate = ebur128->filter_state + (g + c) * 2 * 4;
+
+            const double *history = ebur128->tp_history + (g + c) * TP_HISTORY;
+
+            for (int k = 0; k < 2 * 4; k++)
+                state[k * BIQUADS_LANES + c] = fstate[k];
+            for (int k = 0; k < TP_HISTORY; k++)
+                block[k * BIQUADS_LANES + c] = history[k];
+        }
+
+        for (int n = 0; n < td->nb_samples; n += LANE_BLOCK) {
+            const int len = FFMIN(td->nb_samples - n, LANE_BLOCK);
+
+            if (nb_lanes < BIQUADS_LANES)
+                memset(buf, 0, len * BIQUADS_LANES * sizeof(*buf));
+            for (int c = 0; c < nb_lanes; c++) {
+                const double *src = td->samples + n * nb_channels + g + c;
+
+                for (int i = 0; i < len; i++)
+                    buf[i * BIQUADS_LANES + c] = src[i * nb_channels];
+            }
+
+            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
+                for (int c = 0; c < nb_lanes; c++) {
+                    double peak = ebur128->sample_peaks[g + c];
+
+                    for (int i = 0; i < len; i++)
+                        peak = FFMAX(peak, fabs(buf[i * BIQUADS_LANES + c]));
+                    ebur128->sample_peaks[g + c] = peak;
+                }
+            }
+
+            ebur128->dsp.true_peak(peaks, buf, len);
+            /* keep the last input frames before filtering them */
+            memmove(block, block + len * BIQUADS_LANES,
+                    TP_HISTORY * BIQUADS_LANES * sizeof(*block));
+
+            ebur128->biquads_dsp.filter_di_dbl(buf, ebur128->pre_coeffs, state, len);
+            ebur128->biquads_dsp.filter_di_dbl(buf, ebur128->rlb_coeffs,
+                                               state + 4 * BIQUADS_LANES, len);
+
+            update_windows(ebur128, g, nb_lanes, buf, len, bin_id_400, bin_id_3000);
+            bin_id_400  = (bin_id_400  + len) % ebur128->i400.cache_size;
+            bin_id_3000 = (bin_id_3000 + len) % ebur128->i3000.cache_size;
+        }
+
+        for (int c = 0; c < nb_lanes; c++) {
+            double *fstate  = ebur128->filter_state + (g + c) * 2 * 4;
+            double *history = ebur128->tp_history + (g + c) * TP_HISTORY;
+
+            for (int k = 0; k < 2 * 4; k++)
+                fstate[k] = state[k * BIQUADS_LANES + c];
+            for (int k = 0; k < TP_HISTORY; k++)
+                history[k] = block[k * BIQUADS_LANES + c];
+            ebur128->true_peaks[g + c] = FFMAX(ebur128->true_peaks[g + c], peaks[c]);
+            ebur128->true_peaks_per_frame[g + c] = FFMAX(ebur128->true_peaks_per_frame[g + c],
+                                                         peaks[c]);
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 {
     int i, ch, idx_insample, ret;
@@ -637,81 +907,53 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     const double *samples = (double *)insamples->data[0];
     AVFrame *pic;
 
-#if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS && ebur128->idx_insample == 0) {
-        const double *swr_samples = ebur128->swr_buf;
-        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
-                              (const uint8_t **)insamples->data, nb_samples);
-        if (ret < 0)
-            return ret;
         for (ch = 0; ch < nb_channels; ch++)
             ebur128->true_peaks_per_frame[ch] = 0.0;
-        for (idx_insample = 0; idx_insample < ret; idx_insample++) {
-            for (ch = 0; ch < nb_channels; ch++) {
-                ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], fabs(*swr_samples));
-                ebur128->true_peaks_per_frame[ch] = FFMAX(ebur128->true_peaks_per_frame[ch],
-                                                          fabs(*swr_samples));
-                swr_samples++;
+#if CONFIG_SWRESAMPLE
+        if (ebur128->swr_ctx) {
+            const double *swr_samples = ebur128->swr_buf;
+            int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
+                                  (const uint8_t **)insamples->data, nb_samples);
+            if (ret < 0)
+                return ret;
+            for (idx_insample = 0; idx_insample < ret; idx_insample++) {
+                for (ch = 0; ch < nb_channels; ch++) {
+                    ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], fabs(*swr_samples));
+                    ebur128->true_peaks_per_frame[ch] = FFMAX(ebur128->true_peaks_per_frame[ch],
+                                                              fabs(*swr_samples));
+                    swr_samples++;
+                }
             }
         }
-    }
 #endif
+    }
 
     for (idx_insample = ebur128->idx_insample; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos;
-        const int bin_id_3000 = ebur128->i3000.cache_pos;
+        ThreadData td;
+
+        /* filter all the samples up to the next loudness computation at once,
+         * one channel at a time */
+        td.samples    = samples + idx_insample * nb_channels;
+        td.nb_samples = FFMIN(nb_samples - idx_insample,
+                              inlink->sample_rate / 10 - ebur128->sample_count);
+        td.bin_id_400  = ebur128->i400.cache_pos;
+        td.bin_id_3000 = ebur128->i3000.cache_pos;
+        ff_filter_execute(ctx, filter_channels, &td, NULL,
+                          FFMIN(nb_channels, ff_filter_get_nb_threads(ctx)));
 
 #define MOVE_TO_NEXT_CACHED_ENTRY(time) do {                \
-    ebur128->i##time.cache_pos++;                           \
-    if (ebur128->i##time.cache_pos ==                       \
+    ebur128->i##time.cache_pos += td.nb_samples;            \
+    if (ebur128->i##time.cache_pos >=                       \
         ebur128->i##time.cache_size) {                      \
-        ebur128->i##time.filled    = 1;                     \
-        ebur128->i##time.cache_pos = 0;                     \
+        ebur128->i##time.filled     = 1;                    \
+        ebur128->i##time.cache_pos -= ebur128->i##time.cache_size; \
     }                                                       \
 } while (0)
 
         MOVE_TO_NEXT_CACHED_ENTRY(400);
         MOVE_TO_NEXT_CACHED_ENTRY(3000);
 
-        for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
-
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
-                ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(samples[idx_insample * nb_channels + ch]));
-
-            ebur128->x[ch * 3] = samples[idx_insample * nb_channels + ch]; // set X[i]
-
-            if (!ebur128->ch_weighting[ch])
-                continue;
-
-            /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, NUM, DEN) do {                                             \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*NUM[0] + src[1]*NUM[1] + src[2]*NUM[2]              \
-                                   - dst[1]*DEN[1] - dst[2]*DEN[2];             \
-} while (0)
-
-            // TODO: merge both filters in one?
-            FILTER(y, x, ebur128->pre_b, ebur128->pre_a);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, ebur128->rlb_b, ebur128->rlb_a);  // apply RLB-filter
-
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
-
-            /* add the new value, and limit the sum to the cache size (400ms or 3s)
-             * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
-
-            /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
-        }
-
 #define FIND_PEAK(global, sp, ptype) do {                        \
     int ch;                                                      \
     double maxpeak;                                              \
@@ -726,6 +968,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
         FIND_PEAK(ebur128->sample_peak, ebur128->sample_peaks, SAMPLES);
         FIND_PEAK(ebur128->true_peak,   ebur128->true_peaks,   TRUE);
 
+        /* point to the last filtered sample */
+        idx_insample          += td.nb_samples - 1;
+        ebur128->sample_count += td.nb_samples - 1;
+
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
@@ -1086,9 +1332,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
 
     av_freep(&ebur128->y_line_ref);
-    av_freep(&ebur128->x);
-    av_freep(&ebur128->y);
-    av_freep(&ebur128->z);
+    av_freep(&ebur128->filter_state);
+    av_freep(&ebur128->tp_history);
     av_freep(&ebur128->ch_weighting);
     av_freep(&ebur128->true_peaks);
     av_freep(&ebur128->sample_peaks);
@@ -1131,5 +1376,5 @@ const AVFilter ff_af_ebur128 = {
     .outputs       = NULL,
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &ebur128_class,
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
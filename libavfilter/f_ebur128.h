@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_F_EBUR128_H
+#define AVFILTER_F_EBUR128_H
+
+#include <stddef.h>
+
+#include "af_biquadsdsp.h"
+
+/* Number of phases and taps per phase of the ITU-R BS.1770-4 Annex 2
+ * true-peak interpolation filter. */
+#define EBUR128_TP_PHASES 4
+#define EBUR128_TP_TAPS   12
+
+typedef struct EBUR128DSPContext {
+    /**
+     * Upsample len frames of BIQUADS_LANES interleaved channels 4 times and
+     * raise peaks[lane] to the largest absolute value of each lane, input
+     * samples included: the ripple of the filter may put all the upsampled
+     * values slightly below them.
+     * buf is preceded by the EBUR128_TP_TAPS - 1 previous frames.
+     * buf and peaks must be 32-byte aligned.
+     */
+    void (*true_peak)(double *peaks, const double *buf, ptrdiff_t len);
+} EBUR128DSPContext;
+
+void ff_ebur128_dsp_init(EBUR128DSPContext *dsp);
+void ff_ebur128_dsp_init_x86(EBUR128DSPContext *dsp);
+
+#endif /* AVFILTER_F_EBUR128_H */
@@ -0,0 +1,87 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Block differences and comb detection used by the inverse telecine filters
+ */
+
+#include <stdlib.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "ivtcdsp.h"
+
+uint64_t ff_ivtc_block_sad_c(const uint8_t *src1, ptrdiff_t stride1,
+                             const uint8_t *src2, ptrdiff_t stride2,
+                             ptrdiff_t width, ptrdiff_t height)
+{
+    uint64_t sum = 0;
+
+    for (ptrdiff_t y = 0; y < height; y++) {
+        for (ptrdiff_t x = 0; x < width; x++)
+            sum += abs(src1[x] - src2[x]);
+        src1 += stride1;
+        src2 += stride2;
+    }
+    return sum;
+}
+
+uint64_t ff_ivtc_block_sad16_c(const uint8_t *src1, ptrdiff_t stride1,
+                               const uint8_t *src2, ptrdiff_t stride2,
+                               ptrdiff_t width, ptrdiff_t height)
+{
+    uint64_t sum = 0;
+
+    for (ptrdiff_t y = 0; y < height; y++) {
+        const uint16_t *src1_16 = (const uint16_t *)src1;
+        const uint16_t *src2_16 = (const uint16_t *)src2;
+
+        for (ptrdiff_t x = 0; x < width; x++)
+            sum += abs(src1_16[x] - src2_16[x]);
+        src1 += stride1;
+        src2 += stride2;
+    }
+    return sum;
+}
+
+void ff_ivtc_comb_row_c(uint8_t *dst, const uint8_t *prv2, const uint8_t *prv,
+                        const uint8_t *cur, const uint8_t *nxt,
+                        const uint8_t *nxt2, ptrdiff_t width, int thresh)
+{
+    const int thresh6 = thresh * 6;
+
+    for (ptrdiff_t x = 0; x < width; x++) {
+        const int s1 = abs(cur[x] - prv[x]);
+        const int s2 = abs(cur[x] - nxt[x]);
+        /* [1 -3 4 -3 1] vertical filter */
+        const int f = abs(4 * cur[x] - 3 * (prv[x] + nxt[x]) + prv2[x] + nxt2[x]);
+
+        dst[x] = s1 > thresh && s2 > thresh && f > thresh6 ? 0xff : 0;
+    }
+}
+
+av_cold void ff_ivtcdsp_init(IVTCDSPContext *dsp, int depth)
+{
+    dsp->block_sad = depth > 8 ? ff_ivtc_block_sad16_c : ff_ivtc_block_sad_c;
+    dsp->comb_row  = ff_ivtc_comb_row_c;
+
+#if ARCH_X86
+    ff_ivtcdsp_init_x86(dsp, depth);
+#endif
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Block differences and comb detection used by the inverse telecine
+ * filters fieldmatch and decimate
+ */
+
+#ifndef AVFILTER_IVTCDSP_H
+#define AVFILTER_IVTCDSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct IVTCDSPContext {
+    /**
+     * Return the sum of absolute differences between the width x height
+     * blocks at src1 and src2. width is in pixels.
+     */
+    uint64_t (*block_sad)(const uint8_t *src1, ptrdiff_t stride1,
+                          const uint8_t *src2, ptrdiff_t stride2,
+                          ptrdiff_t width, ptrdiff_t height);
+
+    /**
+     * Mark the combed pixels of the line cur: dst[x] is set to 0xff if
+     * cur[x] differs by more than thresh from both prv[x] and nxt[x] and
+     * the [1 -3 4 -3 1] vertical filter over prv2, prv, cur, nxt, nxt2
+     * exceeds 6 * thresh, and to 0 otherwise. 8-bit only, thresh must be
+     * in the 0-255 range.
+     */
+    void (*comb_row)(uint8_t *dst, const uint8_t *prv2, const uint8_t *prv,
+                     const uint8_t *cur, const uint8_t *nxt,
+                     const uint8_t *nxt2, ptrdiff_t width, int thresh);
+} IVTCDSPContext;
+
+uint64_t ff_ivtc_block_sad_c(const uint8_t *src1, ptrdiff_t stride1,
+                             const uint8_t *src2, ptrdiff_t stride2,
+                             ptrdiff_t width, ptrdiff_t height);
+uint64_t ff_ivtc_block_sad16_c(const uint8_t *src1, ptrdiff_t stride1,
+                               const uint8_t *src2, ptrdiff_t stride2,
+                               ptrdiff_t width, ptrdiff_t height);
+void ff_ivtc_comb_row_c(uint8_t *dst, const uint8_t *prv2, const uint8_t *prv,
+                        const uint8_t *cur, const uint8_t *nxt,
+                        const uint8_t *nxt2, ptrdiff_t width, int thresh);
+
+/**
+ * @param depth 8 for 8-bit samples, 16 for samples stored in 16 bits
+ */
+void ff_ivtcdsp_init(IVTCDSPContext *dsp, int depth);
+void ff_ivtcdsp_init_x86(IVTCDSPContext *dsp, int depth);
+
+#endif /* AVFILTER_IVTCDSP_H */
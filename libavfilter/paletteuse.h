@@ -0,0 +1,49 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_H
+#define AVFILTER_PALETTEUSE_H
+
+#include <stdint.h>
+
+#include "libavutil/pixfmt.h"
+
+/* The number of colors passed to nearest_color must be a multiple of this. */
+#define PALETTEUSE_NEAREST_ALIGN 8
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Find the color of pal nearest to (L, a, b). pal holds the L, a and b
+     * planes of the colors, each AVPALETTE_COUNT entries apart, and the
+     * distance is the squared euclidean distance clipped to INT32_MAX - 1.
+     * Return the index of the nearest color, or -1 if several colors are at
+     * the smallest distance.
+     */
+    int (*nearest_color)(const int32_t *pal, int nb_colors, int L, int a, int b);
+
+    /**
+     * Largest number of colors for which nearest_color is faster than
+     * walking the k-d tree of the palette, 0 if it never is.
+     */
+    int nearest_color_max;
+} PaletteUseDSPContext;
+
+void ff_paletteuse_init(PaletteUseDSPContext *dsp);
+void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSE_H */
@@ -0,0 +1,91 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Row and column statistics used by the detection filters
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "rowstats.h"
+
+uint64_t ff_rowstats_count_below_c(const uint8_t *src, ptrdiff_t stride,
+                                   ptrdiff_t width, ptrdiff_t height, int thresh)
+{
+    uint64_t count = 0;
+
+    for (ptrdiff_t y = 0; y < height; y++) {
+        for (ptrdiff_t x = 0; x < width; x++)
+            count += src[x] < thresh;
+        src += stride;
+    }
+    return count;
+}
+
+uint64_t ff_rowstats_row_sum_c(const uint8_t *src, ptrdiff_t width)
+{
+    uint64_t sum = 0;
+
+    for (ptrdiff_t x = 0; x < width; x++)
+        sum += src[x];
+    return sum;
+}
+
+uint64_t ff_rowstats_row_sum16_c(const uint8_t *src, ptrdiff_t width)
+{
+    const uint16_t *src16 = (const uint16_t *)src;
+    uint64_t sum = 0;
+
+    for (ptrdiff_t x = 0; x < width; x++)
+        sum += src16[x];
+    return sum;
+}
+
+void ff_rowstats_column_sum_c(uint32_t *sum, const uint8_t *src, ptrdiff_t stride,
+                              ptrdiff_t width, ptrdiff_t height)
+{
+    for (ptrdiff_t y = 0; y < height; y++) {
+        for (ptrdiff_t x = 0; x < width; x++)
+            sum[x] += src[x];
+        src += stride;
+    }
+}
+
+void ff_rowstats_column_sum16_c(uint32_t *sum, const uint8_t *src, ptrdiff_t stride,
+                                ptrdiff_t width, ptrdiff_t height)
+{
+    for (ptrdiff_t y = 0; y < height; y++) {
+        const uint16_t *src16 = (const uint16_t *)src;
+
+        for (ptrdiff_t x = 0; x < width; x++)
+            sum[x] += src16[x];
+        src += stride;
+    }
+}
+
+av_cold void ff_rowstats_init(RowStatsDSPContext *dsp, int depth)
+{
+    dsp->count_below = ff_rowstats_count_below_c;
+    dsp->row_sum     = depth > 8 ? ff_rowstats_row_sum16_c    : ff_rowstats_row_sum_c;
+    dsp->column_sum  = depth > 8 ? ff_rowstats_column_sum16_c : ff_rowstats_column_sum_c;
+
+#if ARCH_X86
+    ff_rowstats_init_x86(dsp, depth);
+#endif
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Row and column statistics used by the detection filters
+ *
+ * Differences between two frames are not computed here; use scene_sad.h,
+ * which is shared with select, scdet and the other scene change filters.
+ */
+
+#ifndef AVFILTER_ROWSTATS_H
+#define AVFILTER_ROWSTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct RowStatsDSPContext {
+    /**
+     * Count the pixels of the width x height block at src whose value is
+     * below thresh. 8-bit only.
+     */
+    uint64_t (*count_below)(const uint8_t *src, ptrdiff_t stride,
+                            ptrdiff_t width, ptrdiff_t height, int thresh);
+
+    /**
+     * Return the sum of the width pixels at src.
+     */
+    uint64_t (*row_sum)(const uint8_t *src, ptrdiff_t width);
+
+    /**
+     * Add the values of the height rows of width pixels at src to the
+     * per-column sums in sum.
+     */
+    void (*column_sum)(uint32_t *sum, const uint8_t *src, ptrdiff_t stride,
+                       ptrdiff_t width, ptrdiff_t height);
+} RowStatsDSPContext;
+
+uint64_t ff_rowstats_count_below_c(const uint8_t *src, ptrdiff_t stride,
+                                   ptrdiff_t width, ptrdiff_t height, int thresh);
+uint64_t ff_rowstats_row_sum_c(const uint8_t *src, ptrdiff_t width);
+uint64_t ff_rowstats_row_sum16_c(const uint8_t *src, ptrdiff_t width);
+void ff_rowstats_column_sum_c(uint32_t *sum, const uint8_t *src, ptrdiff_t stride,
+                              ptrdiff_t width, ptrdiff_t height);
+void ff_rowstats_column_sum16_c(uint32_t *sum, const uint8_t *src, ptrdiff_t stride,
+                                ptrdiff_t width, ptrdiff_t height);
+
+/**
+ * @param depth 8 for 8-bit samples, 16 for samples stored in 16 bits
+ */
+void ff_rowstats_init(RowStatsDSPContext *dsp, int depth);
+void ff_rowstats_init_x86(RowStatsDSPContext *dsp, int depth);
+
+#endif /* AVFILTER_ROWSTATS_H */
@@ -24,6 +24,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* number of 4x4 block sums to allocate for one row of a w pixels wide plane */
+#define SSIM_SUM_LEN(w) (((w) >> 2) + 3)
+
 typedef struct SSIMDSPContext {
     void (*ssim_4x4_line)(const uint8_t *buf, ptrdiff_t buf_stride,
                           const uint8_t *ref, ptrdiff_t ref_stride,
@@ -31,6 +34,14 @@ typedef struct SSIMDSPContext {
     double (*ssim_end_line)(const int (*sum0)[4], const int (*sum1)[4], int w);
 } SSIMDSPContext;
 
+void ff_ssim_init(SSIMDSPContext *dsp);
 void ff_ssim_init_x86(SSIMDSPContext *dsp);
 
+/* versions of the SSIMDSPContext functions for samples over 8 bits */
+void ff_ssim_4x4xn_16bit(const uint8_t *main, ptrdiff_t main_stride,
+                         const uint8_t *ref, ptrdiff_t ref_stride,
+                         int64_t (*sums)[4], int w);
+float ff_ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4],
+                         int w, int max);
+
 #endif /* AVFILTER_SSIM_H */
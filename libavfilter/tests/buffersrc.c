@@ -0,0 +1,290 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Feeds a threadsafe abuffer from several threads while the graph runs on
+ * the main thread, and checks that every accepted frame and the EOF come
+ * out of the graph exactly once, also when frames race with EOF.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define PRODUCERS 4
+#define FRAMES    1000
+#define CLOSERS   2
+#define RUNS      50
+
+typedef struct TestContext {
+    AVFilterGraph   *graph;
+    AVFilterContext *src, *sink;
+
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    int              pending;       ///< frames were queued since the last wakeup
+
+    atomic_int       nb_submitted;
+    int              close_after;   ///< frames to submit before closing
+    int              eof_last_pts;  ///< close with a NULL frame instead of av_buffersrc_close()
+
+    uint8_t          accepted[PRODUCERS * FRAMES];
+    int              received[PRODUCERS * FRAMES];
+    int              close_ret[CLOSERS];
+} TestContext;
+
+typedef struct ThreadArg {
+    TestContext *t;
+    int          idx;
+} ThreadArg;
+
+static void wakeup(void *opaque)
+{
+    TestContext *t = opaque;
+
+    pthread_mutex_lock(&t->lock);
+    t->pending = 1;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+}
+
+static int init_graph(TestContext *t)
+{
+    int ret;
+
+    t->graph = avfilter_graph_alloc();
+    if (!t->graph)
+        return AVERROR(ENOMEM);
+    ret = avfilter_graph_create_filter(&t->src, avfilter_get_by_name("abuffer"), "src",
+                                       "sample_rate=48000:sample_fmt=s16:"
+                                       "channel_layout=mono:threadsafe=1",
+                                       NULL, t->graph);
+    if (ret < 0)
+        return ret;
+    ret = avfilter_graph_create_filter(&t->sink, avfilter_get_by_name("abuffersink"),
+                                       "sink", NULL, NULL, t->graph);
+    if (ret < 0)
+        return ret;
+    ret = avfilter_link(t->src, 0, t->sink, 0);
+    if (ret < 0)
+        return ret;
+    ret = avfilter_graph_config(t->graph, NULL);
+    if (ret < 0)
+        return ret;
+    av_buffersrc_set_wakeup(t->src, wakeup, t);
+    return 0;
+}
+
+/* Submits frames until all are sent or EOF rejects them. The pts of a frame
+ * identifies it. */
+static void *producer(void *arg)
+{
+    ThreadArg *a = arg;
+    TestContext *t = a->t;
+
+    for (int i = 0; i < FRAMES; i++) {
+        const int id = a->idx * FRAMES + i;
+        AVFrame *frame = av_frame_alloc();
+        int ret;
+
+        if (!frame)
+            break;
+        frame->format      = AV_SAMPLE_FMT_S16;
+        frame->sample_rate = 48000;
+        frame->nb_samples  = 1;
+        frame->pts         = id;
+        av_channel_layout_default(&frame->ch_layout, 1);
+        ret = av_frame_get_buffer(frame, 0);
+        if (ret >= 0) {
+            ret = av_buffersrc_add_frame_flags(t->src, frame, 0);
+            if (ret >= 0)
+                t->accepted[id] = 1;
+            atomic_fetch_add(&t->nb_submitted, 1);
+        }
+        av_frame_free(&frame);
+        if (ret < 0) {
+            /* do not keep the closers waiting */
+            atomic_fetch_add(&t->nb_submitted, FRAMES - i);
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void *closer(void *arg)
+{
+    ThreadArg *a = arg;
+    TestContext *t = a->t;
+
+    while (atomic_load(&t->nb_submitted) < t->close_after)
+        av_usleep(100);
+    t->close_ret[a->idx] = t->eof_last_pts ?
+                           av_buffersrc_add_frame(t->src, NULL) :
+                           av_buffersrc_close(t->src, PRODUCERS * FRAMES, 0);
+    return NULL;
+}
+
+/* Runs the graph until EOF, returns the number of EOFs seen or a negative
+ * error code. */
+static int consume(TestContext *t, int nb_threads, pthread_t *threads)
+{
+    AVFrame *frame = av_frame_alloc();
+    int eof = 0, ret = 0;
+
+    if (!frame)
+        return AVERROR(ENOMEM);
+
+    while (!eof) {
+        pthread_mutex_lock(&t->lock);
+        while (!t->pending)
+            pthread_cond_wait(&t->cond, &t->lock);
+        t->pending = 0;
+        pthread_mutex_unlock(&t->lock);
+
+        ret = av_buffersrc_process_queue(t->src, 0);
+        if (ret < 0)
+            break;
+        while ((ret = av_buffersink_get_frame(t->sink, frame)) >= 0) {
+            if (frame->pts < 0 || frame->pts >= PRODUCERS * FRAMES) {
+                ret = AVERROR_BUG;
+                break;
+            }
+            t->received[frame->pts]++;
+            av_frame_unref(frame);
+        }
+        if (ret == AVERROR_EOF) {
+            eof = 1;
+            ret = 0;
+        } else if (ret != AVERROR(EAGAIN)) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < nb_threads; i++)
+        pthread_join(threads[i], NULL);
+
+    /* nothing may come after EOF */
+    if (ret >= 0) {
+        ret = av_buffersrc_process_queue(t->src, 0);
+        if (ret > 0)
+            ret = AVERROR_BUG;
+        else if (ret == 0 && av_buffersink_get_frame(t->sink, frame) != AVERROR_EOF)
+            ret = AVERROR_BUG;
+    }
+
+    av_frame_free(&frame);
+    return ret < 0 ? ret : eof;
+}
+
+/* Returns 0 if the frames and EOF came out as expected. */
+static int run(TestContext *t, int closers)
+{
+    pthread_t threads[PRODUCERS + CLOSERS];
+    ThreadArg args[PRODUCERS + CLOSERS];
+    int nb_threads = 0, nb_accepted = 0, nb_closed = 0, ret;
+
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->cond, NULL);
+
+    ret = init_graph(t);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i < PRODUCERS + closers; i++) {
+        args[i].t   = t;
+        args[i].idx = i < PRODUCERS ? i : i - PRODUCERS;
+        if (pthread_create(&threads[i], NULL, i < PRODUCERS ? producer : closer, &args[i])) {
+            /* let the started threads finish */
+            t->close_after = 0;
+            av_buffersrc_close(t->src, 0, 0);
+            consume(t, nb_threads, threads);
+            ret = AVERROR(EAGAIN);
+            goto end;
+        }
+        nb_threads++;
+    }
+
+    ret = consume(t, nb_threads, threads);
+    if (ret < 0)
+        goto end;
+    if (ret != 1) {
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    ret = 0;
+    for (int i = 0; i < PRODUCERS * FRAMES; i++) {
+        if (t->received[i] != t->accepted[i])
+            ret = AVERROR_BUG;
+        nb_accepted += t->accepted[i];
+    }
+    for (int i = 0; i < closers; i++)
+        nb_closed += t->close_ret[i] >= 0;
+    if (nb_closed != 1)
+        ret = AVERROR_BUG;
+    /* closing after the last submission must not lose any frame */
+    if (t->close_after == PRODUCERS * FRAMES && nb_accepted != PRODUCERS * FRAMES)
+        ret = AVERROR_BUG;
+
+end:
+    avfilter_graph_free(&t->graph);
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->cond);
+    return ret;
+}
+
+int main(void)
+{
+    TestContext *t = av_mallocz(sizeof(*t));
+    int ret;
+
+    if (!t)
+        return 1;
+    t->close_after = PRODUCERS * FRAMES;
+    ret = run(t, 1);
+    av_free(t);
+    printf("%d producers, %d frames each: %s\n", PRODUCERS, FRAMES,
+           ret < 0 ? "FAILED" : "all received once, then EOF");
+
+    /* close at varying points while the producers are still submitting */
+    for (int i = 0; i < RUNS && ret >= 0; i++) {
+        TestContext *r = av_mallocz(sizeof(*r));
+
+        if (!r) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        r->close_after  = i * PRODUCERS * FRAMES / RUNS;
+        r->eof_last_pts = i & 1;
+        ret = run(r, CLOSERS);
+        av_free(r);
+    }
+    printf("%d runs closing concurrently from %d threads: %s\n", RUNS, CLOSERS,
+           ret < 0 ? "FAILED" : "every accepted frame received once, then EOF");
+
+    return ret < 0;
+}
@@ -25,6 +25,7 @@
  * David Bartovčak and Miroslav Vrankić
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
@@ -331,6 +332,27 @@ static void filter_row##name##_serial(const uint8_t *ssrc, uint8_t *ddst,   \
 FILTER_ROW_SERIAL(uint8_t, 8)
 FILTER_ROW_SERIAL(uint16_t, 16)
 
+av_cold void ff_atadenoise_init(ATADenoiseDSPContext *dsp, int depth,
+                                int algorithm, const float *sigma)
+{
+    for (int p = 0; p < 4; p++) {
+        if (depth == 8 && sigma[p] == INT16_MAX)
+            dsp->filter_row[p] = algorithm == PARALLEL ? filter_row8 : filter_row8_serial;
+        else if (sigma[p] == INT16_MAX)
+            dsp->filter_row[p] = algorithm == PARALLEL ? filter_row16 : filter_row16_serial;
+        else if (depth == 8 && sigma[p] < INT16_MAX)
+            dsp->filter_row[p] = algorithm == PARALLEL ? fweight_row8 : fweight_row8_serial;
+        else if (sigma[p] < INT16_MAX)
+            dsp->filter_row[p] = algorithm == PARALLEL ? fweight_row16 : fweight_row16_serial;
+    }
+
+#if ARCH_X86
+    ff_atadenoise_init_x86(dsp, depth, algorithm, sigma);
+#elif ARCH_AARCH64
+    ff_atadenoise_init_aarch64(dsp, depth, algorithm, sigma);
+#endif
+}
+
 static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     ATADenoiseContext *s = ctx->priv;
@@ -398,16 +420,7 @@ static int config_input(AVFilterLink *inlink)
     if ((ret = av_image_fill_linesizes(s->linesizes, inlink->format, inlink->w)) < 0)
         return ret;
 
-    for (int p = 0; p < s->nb_planes; p++) {
-        if (depth == 8 && s->sigma[p] == INT16_MAX)
-            s->dsp.filter_row[p] = s->algorithm == PARALLEL ? filter_row8 : filter_row8_serial;
-        else if (s->sigma[p] == INT16_MAX)
-            s->dsp.filter_row[p] = s->algorithm == PARALLEL ? filter_row16 : filter_row16_serial;
-        else if (depth == 8 && s->sigma[p] < INT16_MAX)
-            s->dsp.filter_row[p] = s->algorithm == PARALLEL ? fweight_row8 : fweight_row8_serial;
-        else if (s->sigma[p] < INT16_MAX)
-            s->dsp.filter_row[p] = s->algorithm == PARALLEL ? fweight_row16 : fweight_row16_serial;
-    }
+    ff_atadenoise_init(&s->dsp, depth, s->algorithm, s->sigma);
 
     s->thra[0] = s->fthra[0] * (1 << depth) - 1;
     s->thra[1] = s->fthra[1] * (1 << depth) - 1;
@@ -426,10 +439,6 @@ static int config_input(AVFilterLink *inlink)
         }
     }
 
-#if ARCH_X86
-    ff_atadenoise_init_x86(&s->dsp, depth, s->algorithm, s->sigma);
-#endif
-
     return 0;
 }
 
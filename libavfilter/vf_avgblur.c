@@ -25,6 +25,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
+#include "boxblurdsp.h"
 #include "internal.h"
 #include "video.h"
 
@@ -41,8 +42,11 @@ typedef struct AverageBlurContext {
     int planewidth[4];
     int planeheight[4];
     void *buffer;
+    size_t buffer_size;
+    int nb_threads;
     uint16_t lut[256 * 256 * 256];
     int nb_planes;
+    BoxBlurDSPContext dsp;
 
     int (*filter[2])(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 } AverageBlurContext;
@@ -79,70 +83,44 @@ static int filter_##name(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     lutunused const uint16_t *lut = s->lut;                                       \
     const int size_w = s->radius;                                                 \
     const int size_h = s->radiusV;                                                \
-    btype *col_sum = (btype *)s->buffer + size_w;                                 \
+    btype *col_sum = (btype *)((uint8_t *)s->buffer +                             \
+                               jobnr * s->buffer_size) + size_w;                  \
     const int dlinesize = td->dlinesize / sizeof(type);                           \
     const int linesize = td->linesize / sizeof(type);                             \
     const int height = td->height;                                                \
     const int width = td->width;                                                  \
-    const type *src = td->ptr;                                                    \
-    type *dst = td->dptr;                                                         \
+    const int slice_start = (height *  jobnr     ) / nb_jobs;                     \
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;                     \
+    const type *src = (const type *)td->ptr + slice_start * linesize;             \
+    type *dst = (type *)td->dptr + slice_start * dlinesize;                       \
     btype sum = 0;                                                                \
                                                                                   \
-    for (int x = -size_w; x < 0; x++) {                                           \
-        sum = src[0] * size_h;                                                    \
-        for (int y = 0; y <= size_h; y++)                                         \
-            sum += src[y * linesize];                                             \
-        av_assert2(sum >= 0);                                                     \
-        col_sum[x] = sum;                                                         \
-    }                                                                             \
+    for (int x = -size_w; x < width + size_w; x++) {                              \
+        const type *srcx = (const type *)td->ptr + av_clip(x, 0, width - 1);      \
                                                                                   \
-    for (int x = 0; x < width; x++) {                                             \
-        sum = src[x] * size_h;                                                    \
-        for (int y = 0; y <= size_h; y++)                                         \
-            sum += src[x + y * linesize];                                         \
+        sum = 0;                                                                  \
+        for (int y = slice_start - size_h; y <= slice_start + size_h; y++)        \
+            sum += srcx[av_clip(y, 0, height - 1) * linesize];                    \
         av_assert2(sum >= 0);                                                     \
         col_sum[x] = sum;                                                         \
     }                                                                             \
                                                                                   \
-    for (int x = width; x < width + size_w; x++) {                                \
-        sum = src[width - 1] * size_h;                                            \
-        for (int y = 0; y <= size_h; y++)                                         \
-            sum += src[width - 1 + y * linesize];                                 \
-        av_assert2(sum >= 0);                                                     \
-        col_sum[x] = sum;                                                         \
-    }                                                                             \
+    for (int y = slice_start; y < slice_end; y++) {                               \
+        if (y > slice_start) {                                                    \
+            const int syp = FFMIN(size_h, height - y - 1) * linesize;             \
+            const int syn = FFMIN(y, size_h + 1) * linesize;                      \
                                                                                   \
-    sum = 0;                                                                      \
-    for (int x = -size_w; x <= size_w; x++)                                       \
-        sum += col_sum[x];                                                        \
-    av_assert2(sum >= 0);                                                         \
-    dst[0] = lutdiv(sum, area);                                                   \
+            for (int x = -size_w; x < 0; x++)                                     \
+                col_sum[x] += src[0 + syp] - src[0 - syn];                        \
                                                                                   \
-    for (int x = 1; x < width; x++) {                                             \
-        sum = sum - col_sum[x - size_w - 1] + col_sum[x + size_w];                \
-        av_assert2(sum >= 0);                                                     \
-        dst[x] = lutdiv(sum, area);                                               \
-    }                                                                             \
-                                                                                  \
-    src = td->ptr;                                                                \
-    src += linesize;                                                              \
-    dst += dlinesize;                                                             \
+            s->dsp.update_col_sums(col_sum, (const uint8_t *)(src + syp),         \
+                                   (const uint8_t *)(src - syn), width);          \
                                                                                   \
-    for (int y = 1; y < height; y++) {                                            \
-        const int syp = FFMIN(size_h, height - y - 1) * linesize;                 \
-        const int syn = FFMIN(y, size_h + 1) * linesize;                          \
+            for (int x = width; x < width + size_w; x++)                          \
+                col_sum[x] += src[width - 1 + syp] - src[width - 1 - syn];        \
+        }                                                                         \
                                                                                   \
         sum = 0;                                                                  \
-                                                                                  \
-        for (int x = -size_w; x < 0; x++)                                         \
-            col_sum[x] += src[0 + syp] - src[0 - syn];                            \
-                                                                                  \
-        for (int x = 0; x < width; x++)                                           \
-            col_sum[x] += src[x + syp] - src[x - syn];                            \
-                                                                                  \
-        for (int x = width; x < width + size_w; x++)                              \
-            col_sum[x] += src[width - 1 + syp] - src[width - 1 - syn];            \
-                                                                                  \
         for (int x = -size_w; x <= size_w; x++)                                   \
             sum += col_sum[x];                                                    \
         av_assert2(sum >= 0);                                                     \
@@ -209,8 +187,11 @@ static int config_input(AVFilterLink *inlink)
     s->planeheight[0] = s->planeheight[3] = inlink->h;
 
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
+    ff_boxblurdsp_init(&s->dsp, s->depth > 8 ? 16 : 8);
 
-    s->buffer = av_calloc(inlink->w + (1024 * 2 + 1), 4 * ((s->depth + 7) / 8));
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->buffer_size = (inlink->w + (1024 * 2 + 1)) * 4 * ((s->depth + 7) / 8);
+    s->buffer = av_calloc(s->nb_threads, s->buffer_size);
     if (!s->buffer)
         return AVERROR(ENOMEM);
 
@@ -242,7 +223,8 @@ static void averageiir2d(AVFilterContext *ctx, AVFrame *in, AVFrame *out, int pl
     td.linesize = in->linesize[plane];
     td.dptr = out->data[plane];
     td.dlinesize = out->linesize[plane];
-    s->filter[slow](ctx, &td, 0, 0);
+    ff_filter_execute(ctx, s->filter[slow], &td, NULL,
+                      FFMIN(height, s->nb_threads));
 }
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -342,6 +324,6 @@ const AVFilter ff_vf_avgblur = {
     FILTER_INPUTS(avgblur_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
     .process_command = process_command,
 };
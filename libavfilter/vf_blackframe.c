@@ -31,18 +31,26 @@
 #include <inttypes.h>
 
 #include "libavutil/internal.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "avfilter.h"
 #include "internal.h"
+#include "rowstats.h"
 #include "video.h"
 
 typedef struct BlackFrameContext {
     const AVClass *class;
     int bamount;          ///< black amount
     int bthresh;          ///< black threshold
+    int step;             ///< analyze one frame out of step
+    int row_step;         ///< analyze one row out of row_step
+    int nb_rows;          ///< number of rows analyzed per frame
     unsigned int frame;   ///< frame number
     unsigned int nblack;  ///< number of black pixels counted so far
     unsigned int last_keyframe; ///< frame number of the last received key-frame
+    unsigned int *counts; ///< per-job number of black pixels
+    int nb_jobs;
+    RowStatsDSPContext dsp;
 } BlackFrameContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -55,26 +63,58 @@ static const enum AVPixelFormat pix_fmts[] = {
     snprintf(buf, sizeof(buf), format, value);  \
     av_dict_set(metadata, key, buf, 0)
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    BlackFrameContext *s = ctx->priv;
+
+    s->nb_rows = (inlink->h + s->row_step - 1) / s->row_step;
+    s->nb_jobs = FFMAX(1, FFMIN(s->nb_rows, ff_filter_get_nb_threads(ctx)));
+    av_freep(&s->counts);
+    s->counts = av_calloc(s->nb_jobs, sizeof(*s->counts));
+    if (!s->counts)
+        return AVERROR(ENOMEM);
+
+    ff_rowstats_init(&s->dsp, 8);
+
+    return 0;
+}
+
+static int count_black(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BlackFrameContext *s = ctx->priv;
+    const AVFrame *frame = arg;
+    const ptrdiff_t linesize = frame->linesize[0] * s->row_step;
+    const int slice_start = (s->nb_rows *  jobnr     ) / nb_jobs;
+    const int slice_end   = (s->nb_rows * (jobnr + 1)) / nb_jobs;
+
+    s->counts[jobnr] = s->dsp.count_below(frame->data[0] + slice_start * linesize,
+                                          linesize, ctx->inputs[0]->w,
+                                          slice_end - slice_start, s->bthresh);
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     AVFilterContext *ctx = inlink->dst;
     BlackFrameContext *s = ctx->priv;
-    int x, i;
     int pblack = 0;
-    uint8_t *p = frame->data[0];
     AVDictionary **metadata;
     char buf[32];
 
-    for (i = 0; i < frame->height; i++) {
-        for (x = 0; x < inlink->w; x++)
-            s->nblack += p[x] < s->bthresh;
-        p += frame->linesize[0];
-    }
-
     if (frame->flags & AV_FRAME_FLAG_KEY)
         s->last_keyframe = s->frame;
 
-    pblack = s->nblack * 100 / (inlink->w * inlink->h);
+    if (s->frame % s->step) {
+        s->frame++;
+        return ff_filter_frame(inlink->dst->outputs[0], frame);
+    }
+
+    ff_filter_execute(ctx, count_black, frame, NULL, s->nb_jobs);
+    for (int i = 0; i < s->nb_jobs; i++)
+        s->nblack += s->counts[i];
+
+    pblack = s->nblack * 100 / (inlink->w * s->nb_rows);
     if (pblack >= s->bamount) {
         metadata = &frame->metadata;
 
@@ -92,6 +132,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     return ff_filter_frame(inlink->dst->outputs[0], frame);
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    BlackFrameContext *s = ctx->priv;
+
+    av_freep(&s->counts);
+}
+
 #define OFFSET(x) offsetof(BlackFrameContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption blackframe_options[] = {
@@ -101,6 +148,10 @@ static const AVOption blackframe_options[] = {
                                                  OFFSET(bthresh), AV_OPT_TYPE_INT, { .i64 = 32 }, 0, 255,     FLAGS },
     { "thresh", "threshold below which a pixel value is considered black",
                                                  OFFSET(bthresh), AV_OPT_TYPE_INT, { .i64 = 32 }, 0, 255,     FLAGS },
+    { "step", "analyze only one frame out of step",
+                                                 OFFSET(step),    AV_OPT_TYPE_INT, { .i64 = 1 },  1, INT_MAX, FLAGS },
+    { "row_step", "analyze only one row out of row_step",
+                                                 OFFSET(row_step), AV_OPT_TYPE_INT, { .i64 = 1 }, 1, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -110,6 +161,7 @@ static const AVFilterPad avfilter_vf_blackframe_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
 };
@@ -119,7 +171,8 @@ const AVFilter ff_vf_blackframe = {
     .description   = NULL_IF_CONFIG_SMALL("Detect frames that are (almost) black."),
     .priv_size     = sizeof(BlackFrameContext),
     .priv_class    = &blackframe_class,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .uninit        = uninit,
+    .flags         = AVFILTER_FLAG_METADATA_ONLY | AVFILTER_FLAG_SLICE_THREADS,
     FILTER_INPUTS(avfilter_vf_blackframe_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
@@ -27,8 +27,11 @@
 
 #include "libavutil/avstring.h"
 #include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
 #include "avfilter.h"
+#include "boxblurdsp.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -44,15 +47,20 @@ typedef struct BoxBlurContext {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    int nb_jobs;
+    size_t temp_size; ///< size of each temporary buffer
+    uint8_t *temp;    ///< per-job pairs of temporary buffers used in blur_power()
+    BoxBlurDSPContext dsp;
 } BoxBlurContext;
 
+/* number of columns blurred together by the vertical pass */
+#define VBLUR_COLUMNS 32
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     BoxBlurContext *s = ctx->priv;
 
-    av_freep(&s->temp[0]);
-    av_freep(&s->temp[1]);
+    av_freep(&s->temp);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -80,12 +88,15 @@ static int config_input(AVFilterLink *inlink)
     int w = inlink->w, h = inlink->h;
     int ret;
 
-    if (!(s->temp[0] = av_malloc(2*FFMAX(w, h))) ||
-        !(s->temp[1] = av_malloc(2*FFMAX(w, h))))
+    s->nb_jobs   = FFMAX(1, FFMIN(FFMIN(w, h), ff_filter_get_nb_threads(ctx)));
+    s->temp_size = 2 * FFMAX(w, h * VBLUR_COLUMNS);
+    av_freep(&s->temp);
+    if (!(s->temp = av_malloc_array(2 * s->nb_jobs, s->temp_size)))
         return AVERROR(ENOMEM);
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
+    ff_boxblurdsp_init(&s->dsp, desc->comp[0].depth > 8 ? 16 : 8);
 
     ret = ff_boxblur_eval_filter_params(inlink,
                                         &s->luma_param,
@@ -198,6 +209,77 @@ static inline void blur_power(uint8_t *dst, int dst_step, const uint8_t *src, in
     }
 }
 
+/* Start the running sums of blur_columns(). */
+#define INIT_COLUMN_SUMS(type, depth)                                       \
+static void init_column_sums ## depth(uint32_t *sum, const uint8_t *src8,   \
+                                      ptrdiff_t src_stride, int w,          \
+                                      int radius, int inv)                  \
+{                                                                           \
+    const type *src = (const type *)src8;                                   \
+    int i, y;                                                               \
+                                                                            \
+    for (i = 0; i < w; i++)                                                 \
+        sum[i] = src[radius*src_stride + i];                                \
+                                                                            \
+    for (y = 0; y < radius; y++)                                            \
+        for (i = 0; i < w; i++)                                             \
+            sum[i] += src[y*src_stride + i]<<1;                             \
+                                                                            \
+    for (i = 0; i < w; i++)                                                 \
+        sum[i] = sum[i]*inv + (1<<15);                                      \
+}
+
+INIT_COLUMN_SUMS(uint8_t,   8)
+INIT_COLUMN_SUMS(uint16_t, 16)
+
+#undef INIT_COLUMN_SUMS
+
+/* Same as blur(), applied to the w adjacent columns starting at src at once,
+ * walking the lines in memory order. */
+static void blur_columns(const BoxBlurDSPContext *dsp,
+                         uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+                         int w, int len, int radius, int pixsize)
+{
+    const int length = radius*2 + 1;
+    const int inv = ((1<<16) + length/2)/length;
+    DECLARE_ALIGNED(32, uint32_t, sum)[VBLUR_COLUMNS];
+    int y;
+
+    if (pixsize == 1) init_column_sums8 (sum, src, src_linesize,    w, radius, inv);
+    else              init_column_sums16(sum, src, src_linesize>>1, w, radius, inv);
+
+    for (y = 0; y < len; y++) {
+        const int add = y < len-radius ? radius+y : 2*len-radius-y-1;
+        const int sub = y <= radius ? radius-y : y-radius-1;
+
+        dsp->vblur_row(sum, dst, src + add*src_linesize, src + sub*src_linesize, inv, w);
+        dst += dst_linesize;
+    }
+}
+
+static void blur_power_columns(const BoxBlurDSPContext *dsp,
+                               uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+                               int w, int len, int radius, int power, uint8_t *temp[2], int pixsize)
+{
+    uint8_t *a = temp[0], *b = temp[1];
+    const int temp_linesize = w * pixsize;
+
+    if (radius && power) {
+        blur_columns(dsp, a, temp_linesize, src, src_linesize, w, len, radius, pixsize);
+        for (; power > 2; power--) {
+            uint8_t *c;
+            blur_columns(dsp, b, temp_linesize, a, temp_linesize, w, len, radius, pixsize);
+            c = a; a = b; b = c;
+        }
+        if (power > 1)
+            blur_columns(dsp, dst, dst_linesize, a, temp_linesize, w, len, radius, pixsize);
+        else
+            av_image_copy_plane(dst, dst_linesize, a, temp_linesize, w * pixsize, len);
+    } else if (dst != src) {
+        av_image_copy_plane(dst, dst_linesize, src, src_linesize, w * pixsize, len);
+    }
+}
+
 static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
                   int w, int h, int radius, int power, uint8_t *temp[2], int pixsize)
 {
@@ -211,7 +293,8 @@ static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    w, radius, power, temp, pixsize);
 }
 
-static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+static void vblur(const BoxBlurDSPContext *dsp,
+                  uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
                   int w, int h, int radius, int power, uint8_t *temp[2], int pixsize)
 {
     int x;
@@ -219,9 +302,64 @@ static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
     if (radius == 0 && dst == src)
         return;
 
-    for (x = 0; x < w; x++)
-        blur_power(dst + x*pixsize, dst_linesize, src + x*pixsize, src_linesize,
-                   h, radius, power, temp, pixsize);
+    for (x = 0; x < w; x += VBLUR_COLUMNS)
+        blur_power_columns(dsp, dst + x*pixsize, dst_linesize, src + x*pixsize, src_linesize,
+                           FFMIN(w - x, VBLUR_COLUMNS), h, radius, power, temp, pixsize);
+}
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w[4], h[4];
+    int pixsize;
+} ThreadData;
+
+static void get_temp(BoxBlurContext *s, int jobnr, uint8_t *temp[2])
+{
+    temp[0] = s->temp + (2 * jobnr    ) * s->temp_size;
+    temp[1] = s->temp + (2 * jobnr + 1) * s->temp_size;
+}
+
+static int hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2];
+
+    get_temp(s, jobnr, temp);
+
+    for (int plane = 0; plane < 4 && td->in->data[plane] && td->in->linesize[plane]; plane++) {
+        const int slice_start = (td->h[plane] *  jobnr     ) / nb_jobs;
+        const int slice_end   = (td->h[plane] * (jobnr + 1)) / nb_jobs;
+
+        hblur(td->out->data[plane] + slice_start * td->out->linesize[plane], td->out->linesize[plane],
+              td->in ->data[plane] + slice_start * td->in ->linesize[plane], td->in ->linesize[plane],
+              td->w[plane], slice_end - slice_start, s->radius[plane], s->power[plane],
+              temp, td->pixsize);
+    }
+
+    return 0;
+}
+
+static int vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int pixsize = td->pixsize;
+    uint8_t *temp[2];
+
+    get_temp(s, jobnr, temp);
+
+    for (int plane = 0; plane < 4 && td->in->data[plane] && td->in->linesize[plane]; plane++) {
+        const int slice_start = (td->w[plane] *  jobnr     ) / nb_jobs;
+        const int slice_end   = (td->w[plane] * (jobnr + 1)) / nb_jobs;
+
+        vblur(&s->dsp, td->out->data[plane] + slice_start * pixsize, td->out->linesize[plane],
+              td->out->data[plane] + slice_start * pixsize, td->out->linesize[plane],
+              slice_end - slice_start, td->h[plane], s->radius[plane], s->power[plane],
+              temp, pixsize);
+    }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
@@ -230,13 +368,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     BoxBlurContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
-    int plane;
     int cw = AV_CEIL_RSHIFT(inlink->w, s->hsub), ch = AV_CEIL_RSHIFT(in->height, s->vsub);
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { in->height, ch, ch, in->height };
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     const int depth = desc->comp[0].depth;
-    const int pixsize = (depth+7)/8;
+    ThreadData td = {
+        .in      = in,
+        .w       = { inlink->w, cw, cw, inlink->w },
+        .h       = { in->height, ch, ch, in->height },
+        .pixsize = (depth+7)/8,
+    };
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -244,18 +384,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         return AVERROR(ENOMEM);
     }
     av_frame_copy_props(out, in);
+    td.out = out;
 
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
-
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
+    ff_filter_execute(ctx, hblur_slice, &td, NULL, s->nb_jobs);
+    ff_filter_execute(ctx, vblur_slice, &td, NULL, s->nb_jobs);
 
     av_frame_free(&in);
 
@@ -304,5 +436,5 @@ const AVFilter ff_vf_boxblur = {
     FILTER_INPUTS(avfilter_vf_boxblur_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -31,9 +31,12 @@
 
 #include "avfilter.h"
 #include "internal.h"
+#include "rowstats.h"
 #include "video.h"
 #include "edge_common.h"
 
+#define COLUMN_BLOCK 64
+
 typedef struct CropDetectContext {
     const AVClass *class;
     int x1, y1, x2, y2;
@@ -41,8 +44,10 @@ typedef struct CropDetectContext {
     float limit_upscaled;
     int round;
     int skip;
+    int step;
     int reset_count;
     int frame_nb;
+    int step_count;
     int max_pixsteps[4];
     int max_outliers;
     int mode;
@@ -56,6 +61,9 @@ typedef struct CropDetectContext {
     uint16_t *gradients;
     char     *directions;
     int      *bboxes[4];
+    int col_start, col_end;
+    uint32_t col_totals[COLUMN_BLOCK];
+    RowStatsDSPContext dsp;
 } CropDetectContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -141,6 +149,71 @@ static int checkline(void *ctx, const unsigned char *src, int stride, int len, i
     return total;
 }
 
+/**
+ * Compute the checkline() value of the n columns starting at src, walking
+ * the frame row by row so that every cache line fetched is fully used.
+ */
+static void checkcolumns(const RowStatsDSPContext *dsp, uint32_t *totals,
+                         const uint8_t *src, int stride, int len, int bpp, int n)
+{
+    const int div = bpp >= 3 ? len * 3 : len;
+    int i;
+
+    memset(totals, 0, n * sizeof(*totals));
+
+    if (bpp <= 2) {
+        dsp->column_sum(totals, src, stride, n, len);
+    } else {
+        while (--len >= 0) {
+            for (i = 0; i < n; i++)
+                totals[i] += src[i * bpp] + src[i * bpp + 1] + src[i * bpp + 2];
+            src += stride;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+        totals[i] /= div;
+}
+
+/**
+ * Return the average of column x, computing it along with the neighbouring
+ * columns in the scan direction dir when it is not cached yet.
+ */
+static int checkcolumn(AVFilterContext *ctx, const AVFrame *frame, int x, int dir, int bpp)
+{
+    CropDetectContext *s = ctx->priv;
+
+    if (x < s->col_start || x >= s->col_end) {
+        const int start = dir > 0 ? x : FFMAX(x - COLUMN_BLOCK + 1, 0);
+        const int end   = FFMIN(start + COLUMN_BLOCK, frame->width);
+
+        checkcolumns(&s->dsp, s->col_totals, frame->data[0] + bpp * start,
+                     frame->linesize[0], frame->height, bpp, end - start);
+        s->col_start = start;
+        s->col_end   = end;
+    }
+
+    av_log(ctx, AV_LOG_DEBUG, "total:%"PRIu32"\n", s->col_totals[x - s->col_start]);
+    return s->col_totals[x - s->col_start];
+}
+
+/**
+ * Return the average of the len pixels of the row at src.
+ */
+static int checkrow(AVFilterContext *ctx, const uint8_t *src, int len, int bpp)
+{
+    CropDetectContext *s = ctx->priv;
+    int total;
+
+    if (bpp > 2)
+        return checkline(ctx, src, bpp, len, bpp);
+
+    total = s->dsp.row_sum(src, len) / len;
+
+    av_log(ctx, AV_LOG_DEBUG, "total:%d\n", total);
+    return total;
+}
+
 static int checkline_edge(void *ctx, const unsigned char *src, int stride, int len, int bpp)
 {
     const uint16_t *src16 = (const uint16_t *)src;
@@ -209,6 +282,7 @@ static int config_input(AVFilterLink *inlink)
     av_image_fill_max_pixsteps(s->max_pixsteps, NULL, desc);
 
     s->bitdepth = desc->comp[0].depth;
+    ff_rowstats_init(&s->dsp, s->max_pixsteps[0] == 2 ? 16 : 8);
 
     if (s->limit < 1.0)
         s->limit_upscaled = s->limit * ((1 << s->bitdepth) - 1);
@@ -268,6 +342,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
                           const uint8_t *src, int src_linesize, int src_stride) = (bpp == 2) ? &ff_gaussian_blur_16 : &ff_gaussian_blur_8;
 
 
+    // after the first s->skip frames, only analyze one frame out of s->step
+    if (s->frame_nb >= 0 && s->step_count++ % s->step)
+        return ff_filter_frame(inlink->dst->outputs[0], frame);
+
     // ignore first s->skip frames
     if (++s->frame_nb > 0) {
         metadata = &frame->metadata;
@@ -281,10 +359,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
             s->frame_nb = 1;
         }
 
-#define FIND(DST, FROM, NOEND, INC, STEP0, STEP1, LEN) \
+#define FIND(DST, FROM, NOEND, INC, CHECK) \
         outliers = 0;\
         for (last_y = y = FROM; NOEND; y = y INC) {\
-            if (checkline(ctx, frame->data[0] + STEP0 * y, STEP1, LEN, bpp) > limit_upscaled) {\
+            if (CHECK > limit_upscaled) {\
                 if (++outliers > s->max_outliers) { \
                     DST = last_y;\
                     break;\
@@ -294,10 +372,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         }
 
         if (s->mode == MODE_BLACK) {
-            FIND(s->y1,                 0,               y < s->y1, +1, frame->linesize[0], bpp, frame->width);
-            FIND(s->y2, frame->height - 1, y > FFMAX(s->y2, s->y1), -1, frame->linesize[0], bpp, frame->width);
-            FIND(s->x1,                 0,               y < s->x1, +1, bpp, frame->linesize[0], frame->height);
-            FIND(s->x2,  frame->width - 1, y > FFMAX(s->x2, s->x1), -1, bpp, frame->linesize[0], frame->height);
+#define ROW(y)         checkrow(ctx, frame->data[0] + frame->linesize[0] * (y), frame->width, bpp)
+#define COLUMN(x, dir) checkcolumn(ctx, frame, x, dir, bpp)
+            FIND(s->y1,                 0,               y < s->y1, +1, ROW(y));
+            FIND(s->y2, frame->height - 1, y > FFMAX(s->y2, s->y1), -1, ROW(y));
+            s->col_start = s->col_end = 0;
+            FIND(s->x1,                 0,               y < s->x1, +1, COLUMN(y, +1));
+            FIND(s->x2,  frame->width - 1, y > FFMAX(s->x2, s->x1), -1, COLUMN(y, -1));
         } else { // MODE_MV_EDGES
             sd = av_frame_get_side_data(frame, AV_FRAME_DATA_MOTION_VECTORS);
             s->x1 = 0;
@@ -472,6 +553,7 @@ static const AVOption cropdetect_options[] = {
     { "round", "Value by which the width/height should be divisible", OFFSET(round),       AV_OPT_TYPE_INT, { .i64 = 16 }, 0, INT_MAX, FLAGS },
     { "reset", "Recalculate the crop area after this many frames",    OFFSET(reset_count), AV_OPT_TYPE_INT, { .i64 = 0 },  0, INT_MAX, FLAGS },
     { "skip",  "Number of initial frames to skip",                    OFFSET(skip),        AV_OPT_TYPE_INT, { .i64 = 2 },  0, INT_MAX, FLAGS },
+    { "step",  "Analyze only one frame out of step",                  OFFSET(step),        AV_OPT_TYPE_INT, { .i64 = 1 },  1, INT_MAX, FLAGS },
     { "reset_count", "Recalculate the crop area after this many frames",OFFSET(reset_count),AV_OPT_TYPE_INT,{ .i64 = 0 },  0, INT_MAX, FLAGS },
     { "max_outliers", "Threshold count of outliers",                  OFFSET(max_outliers),AV_OPT_TYPE_INT, { .i64 = 0 },  0, INT_MAX, FLAGS },
     { "mode", "set mode", OFFSET(mode), AV_OPT_TYPE_INT, {.i64=MODE_BLACK}, 0, MODE_NB-1, FLAGS, "mode" },
@@ -40,6 +40,7 @@
 #include "filters.h"
 #include "formats.h"
 #include "internal.h"
+#include "ivtcdsp.h"
 #include "video.h"
 
 #define INPUT_MAIN     0
@@ -111,6 +112,9 @@ typedef struct FieldMatchContext {
     int *c_array;
     int tpitchy, tpitchuv;
     uint8_t *tbuffer;
+    uint64_t (*accum)[6];           ///< per-job metric accumulators
+    int nb_threads;
+    IVTCDSPContext dsp;
 } FieldMatchContext;
 
 #define OFFSET(x) offsetof(FieldMatchContext, x)
@@ -165,23 +169,34 @@ static int get_height(const FieldMatchContext *fm, const AVFrame *f, int plane,
     return plane ? AV_CEIL_RSHIFT(f->height, fm->vsub[input]) : f->height;
 }
 
-static int64_t luma_abs_diff(const AVFrame *f1, const AVFrame *f2)
+typedef struct ThreadData {
+    const AVFrame *f1, *f2;
+} ThreadData;
+
+static int luma_abs_diff_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int x, y;
-    const uint8_t *srcp1 = f1->data[0];
-    const uint8_t *srcp2 = f2->data[0];
-    const int src1_linesize = f1->linesize[0];
-    const int src2_linesize = f2->linesize[0];
-    const int width  = f1->width;
-    const int height = f1->height;
+    FieldMatchContext *fm = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *f1 = td->f1, *f2 = td->f2;
+    const int slice_start = (f1->height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (f1->height * (jobnr + 1)) / nb_jobs;
+
+    fm->accum[jobnr][0] =
+        fm->dsp.block_sad(f1->data[0] + slice_start * f1->linesize[0], f1->linesize[0],
+                          f2->data[0] + slice_start * f2->linesize[0], f2->linesize[0],
+                          f1->width, slice_end - slice_start);
+    return 0;
+}
+
+static int64_t luma_abs_diff(AVFilterContext *ctx, const AVFrame *f1, const AVFrame *f2)
+{
+    FieldMatchContext *fm = ctx->priv;
+    ThreadData td = { .f1 = f1, .f2 = f2 };
     int64_t acc = 0;
 
-    for (y = 0; y < height; y++) {
-        for (x = 0; x < width; x++)
-            acc += abs(srcp1[x] - srcp2[x]);
-        srcp1 += src1_linesize;
-        srcp2 += src2_linesize;
-    }
+    ff_filter_execute(ctx, luma_abs_diff_slice, &td, NULL, fm->nb_threads);
+    for (int i = 0; i < fm->nb_threads; i++)
+        acc += fm->accum[i][0];
     return acc;
 }
 
@@ -195,81 +210,70 @@ static void fill_buf(uint8_t *data, int w, int h, int linesize, uint8_t v)
     }
 }
 
-static int calc_combed_score(const FieldMatchContext *fm, const AVFrame *src)
+/**
+ * Mark the combed pixels of a band of lines of each plane in cmask.
+ */
+static int build_comb_mask_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int x, y, plane, max_v = 0;
+    FieldMatchContext *fm = ctx->priv;
+    const AVFrame *src = arg;
+    int y, plane;
     const int cthresh = fm->cthresh;
-    const int cthresh6 = cthresh * 6;
 
     for (plane = 0; plane < (fm->chroma ? 3 : 1); plane++) {
-        const uint8_t *srcp = src->data[plane];
         const int src_linesize = src->linesize[plane];
         const int width  = get_width (fm, src, plane, INPUT_MAIN);
         const int height = get_height(fm, src, plane, INPUT_MAIN);
-        uint8_t *cmkp = fm->cmask_data[plane];
         const int cmk_linesize = fm->cmask_linesize[plane];
+        const int slice_start = (height *  jobnr     ) / nb_jobs;
+        const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+        const uint8_t *srcp = src->data[plane] + slice_start * src_linesize;
+        uint8_t *cmkp = fm->cmask_data[plane] + slice_start * cmk_linesize;
 
         if (cthresh < 0) {
-            fill_buf(cmkp, width, height, cmk_linesize, 0xff);
+            fill_buf(cmkp, width, slice_end - slice_start, cmk_linesize, 0xff);
             continue;
         }
-        fill_buf(cmkp, width, height, cmk_linesize, 0);
-
-        /* [1 -3 4 -3 1] vertical filter */
-#define FILTER(xm2, xm1, xp1, xp2) \
-        abs(  4 * srcp[x] \
-             -3 * (srcp[x + (xm1)*src_linesize] + srcp[x + (xp1)*src_linesize]) \
-             +    (srcp[x + (xm2)*src_linesize] + srcp[x + (xp2)*src_linesize])) > cthresh6
-
-        /* first line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x + src_linesize]);
-            if (s1 > cthresh && FILTER(2, 1, 1, 2))
-                cmkp[x] = 0xff;
-        }
-        srcp += src_linesize;
-        cmkp += cmk_linesize;
-
-        /* second line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-            const int s2 = abs(srcp[x] - srcp[x + src_linesize]);
-            if (s1 > cthresh && s2 > cthresh && FILTER(2, -1, 1, 2))
-                cmkp[x] = 0xff;
-        }
-        srcp += src_linesize;
-        cmkp += cmk_linesize;
-
-        /* all lines minus first two and last two */
-        for (y = 2; y < height-2; y++) {
-            for (x = 0; x < width; x++) {
-                const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-                const int s2 = abs(srcp[x] - srcp[x + src_linesize]);
-                if (s1 > cthresh && s2 > cthresh && FILTER(-2, -1, 1, 2))
-                    cmkp[x] = 0xff;
+        for (y = slice_start; y < slice_end; y++) {
+            const uint8_t *prv2, *prv, *nxt, *nxt2;
+
+            /* the lines outside the plane are mirrored into it */
+            if (y == 0) {
+                prv2 = nxt2 = srcp + 2 * src_linesize;
+                prv  = nxt  = srcp +     src_linesize;
+            } else if (y == 1) {
+                prv2 = nxt2 = srcp + 2 * src_linesize;
+                prv  = srcp - src_linesize;
+                nxt  = srcp + src_linesize;
+            } else if (y == height - 1) {
+                prv2 = nxt2 = srcp - 2 * src_linesize;
+                prv  = nxt  = srcp -     src_linesize;
+            } else if (y == height - 2) {
+                prv2 = nxt2 = srcp - 2 * src_linesize;
+                prv  = srcp - src_linesize;
+                nxt  = srcp + src_linesize;
+            } else {
+                prv2 = srcp - 2 * src_linesize;
+                prv  = srcp -     src_linesize;
+                nxt  = srcp +     src_linesize;
+                nxt2 = srcp + 2 * src_linesize;
             }
+            fm->dsp.comb_row(cmkp, prv2, prv, srcp, nxt, nxt2, width, cthresh);
             srcp += src_linesize;
             cmkp += cmk_linesize;
         }
-
-        /* before-last line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-            const int s2 = abs(srcp[x] - srcp[x + src_linesize]);
-            if (s1 > cthresh && s2 > cthresh && FILTER(-2, -1, 1, -2))
-                cmkp[x] = 0xff;
-        }
-        srcp += src_linesize;
-        cmkp += cmk_linesize;
-
-        /* last line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-            if (s1 > cthresh && FILTER(-2, -1, -1, -2))
-                cmkp[x] = 0xff;
-        }
     }
 
+    return 0;
+}
+
+static int calc_combed_score(AVFilterContext *ctx, const AVFrame *src)
+{
+    FieldMatchContext *fm = ctx->priv;
+    int x, y, max_v = 0;
+
+    ff_filter_execute(ctx, build_comb_mask_slice, (void *)src, NULL, fm->nb_threads);
+
     if (fm->chroma) {
         uint8_t *cmkp  = fm->cmask_data[0];
         uint8_t *cmkpU = fm->cmask_data[1];
@@ -412,22 +416,19 @@ static void build_abs_diff_mask(const uint8_t *prvp, int prv_linesize,
 }
 
 /**
- * Build a map over which pixels differ a lot/a little
+ * Build a map over which pixels differ a lot/a little, for the line pairs
+ * kstart to kend - 1 of the abs diff mask
  */
 static void build_diff_map(FieldMatchContext *fm,
-                           const uint8_t *prvp, int prv_linesize,
-                           const uint8_t *nxtp, int nxt_linesize,
                            uint8_t *dstp, int dst_linesize, int height,
-                           int width, int plane)
+                           int width, int plane, int kstart, int kend)
 {
     int x, y, u, diff, count;
     int tpitch = plane ? fm->tpitchuv : fm->tpitchy;
-    const uint8_t *dp = fm->tbuffer + tpitch;
-
-    build_abs_diff_mask(prvp, prv_linesize, nxtp, nxt_linesize,
-                        fm->tbuffer, tpitch, width, height>>1);
+    const uint8_t *dp = fm->tbuffer + tpitch * (kstart + 1);
 
-    for (y = 2; y < height - 2; y += 2) {
+    dstp += kstart * dst_linesize;
+    for (y = 2 + 2 * kstart; y < 2 + 2 * kend; y += 2) {
         for (x = 1; x < width - 1; x++) {
             diff = dp[x];
             if (diff > 3) {
@@ -486,101 +487,201 @@ static AVFrame *select_frame(FieldMatchContext *fm, int match)
     else  /* match == mC */              return fm->src;
 }
 
-static int compare_fields(FieldMatchContext *fm, int match1, int match2, int field)
+typedef struct CompareData {
+    int plane, width, height;
+    int nb_pairs;                       ///< number of line pairs compared
+    int startx, stopx, y0a, y1a;
+    const uint8_t *diffp, *diffn;       ///< fields used for the diff map
+    int diffp_linesize, diffn_linesize;
+    uint8_t *mapp, *mapd;               ///< map for the metrics / the diff map
+    int map_linesize;                   ///< line size of a map field
+    const uint8_t *srcf;
+    int srcf_linesize;
+    const uint8_t *prvpf, *nxtpf;
+    int prvf_linesize, nxtf_linesize;
+} CompareData;
+
+static int build_abs_diff_mask_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const CompareData *cd = arg;
+    const int tpitch = cd->plane ? fm->tpitchuv : fm->tpitchy;
+    const int map_linesize = fm->map_linesize[cd->plane];
+    const int nb_lines = cd->height >> 1;
+    int slice_start = (cd->height *  jobnr     ) / nb_jobs;
+    int slice_end   = (cd->height * (jobnr + 1)) / nb_jobs;
+
+    fill_buf(fm->map_data[cd->plane] + slice_start * map_linesize,
+             cd->width, slice_end - slice_start, map_linesize, 0);
+
+    slice_start = (nb_lines *  jobnr     ) / nb_jobs;
+    slice_end   = (nb_lines * (jobnr + 1)) / nb_jobs;
+    build_abs_diff_mask(cd->diffp + slice_start * cd->diffp_linesize, cd->diffp_linesize,
+                        cd->diffn + slice_start * cd->diffn_linesize, cd->diffn_linesize,
+                        fm->tbuffer + slice_start * tpitch, tpitch,
+                        cd->width, slice_end - slice_start);
+    return 0;
+}
+
+static int build_diff_map_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const CompareData *cd = arg;
+
+    build_diff_map(fm, cd->mapd, cd->map_linesize, cd->height, cd->width, cd->plane,
+                   (cd->nb_pairs *  jobnr     ) / nb_jobs,
+                   (cd->nb_pairs * (jobnr + 1)) / nb_jobs);
+    return 0;
+}
+
+static int compare_fields_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const CompareData *cd = arg;
+    const int kstart = (cd->nb_pairs *  jobnr     ) / nb_jobs;
+    const int kend   = (cd->nb_pairs * (jobnr + 1)) / nb_jobs;
+    const int map_linesize  = cd->map_linesize;
+    const int srcf_linesize = cd->srcf_linesize;
+    const int prvf_linesize = cd->prvf_linesize;
+    const int nxtf_linesize = cd->nxtf_linesize;
+    const uint8_t *mapp  = cd->mapp  + kstart * map_linesize;
+    const uint8_t *srcf  = cd->srcf  + kstart * srcf_linesize;
+    const uint8_t *srcpf = srcf - srcf_linesize;
+    const uint8_t *srcnf = srcf + srcf_linesize;
+    const uint8_t *prvpf = cd->prvpf + kstart * prvf_linesize;
+    const uint8_t *prvnf = prvpf + prvf_linesize;
+    const uint8_t *nxtpf = cd->nxtpf + kstart * nxtf_linesize;
+    const uint8_t *nxtnf = nxtpf + nxtf_linesize;
+    uint64_t accumPc = 0, accumPm = 0, accumPml = 0;
+    uint64_t accumNc = 0, accumNm = 0, accumNml = 0;
+    int x, y, temp1, temp2;
+
+    for (y = 2 + 2 * kstart; y < 2 + 2 * kend; y += 2) {
+        if (cd->y0a == cd->y1a || y < cd->y0a || y > cd->y1a) {
+            for (x = cd->startx; x < cd->stopx; x++) {
+                if (mapp[x] > 0 || mapp[x + map_linesize] > 0) {
+                    temp1 = srcpf[x] + (srcf[x] << 2) + srcnf[x]; // [1 4 1]
+
+                    temp2 = abs(3 * (prvpf[x] + prvnf[x]) - temp1);
+                    if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
+                        accumPc += temp2;
+                    if (temp2 > 42) {
+                        if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
+                            accumPm += temp2;
+                        if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
+                            accumPml += temp2;
+                    }
+
+                    temp2 = abs(3 * (nxtpf[x] + nxtnf[x]) - temp1);
+                    if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
+                        accumNc += temp2;
+                    if (temp2 > 42) {
+                        if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
+                            accumNm += temp2;
+                        if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
+                            accumNml += temp2;
+                    }
+                }
+            }
+        }
+        prvpf += prvf_linesize;
+        prvnf += prvf_linesize;
+        srcpf += srcf_linesize;
+        srcf  += srcf_linesize;
+        srcnf += srcf_linesize;
+        nxtpf += nxtf_linesize;
+        nxtnf += nxtf_linesize;
+        mapp  += map_linesize;
+    }
+
+    fm->accum[jobnr][0] += accumPc;
+    fm->accum[jobnr][1] += accumPm;
+    fm->accum[jobnr][2] += accumPml;
+    fm->accum[jobnr][3] += accumNc;
+    fm->accum[jobnr][4] += accumNm;
+    fm->accum[jobnr][5] += accumNml;
+    return 0;
+}
+
+static int compare_fields(AVFilterContext *ctx, int match1, int match2, int field)
 {
-    int plane, ret;
+    FieldMatchContext *fm = ctx->priv;
+    int plane, ret, i;
     uint64_t accumPc = 0, accumPm = 0, accumPml = 0;
     uint64_t accumNc = 0, accumNm = 0, accumNml = 0;
     int norm1, norm2, mtn1, mtn2;
     float c1, c2, mr;
     const AVFrame *src = fm->src;
 
+    memset(fm->accum, 0, fm->nb_threads * sizeof(*fm->accum));
+
     for (plane = 0; plane < (fm->mchroma ? 3 : 1); plane++) {
-        int x, y, temp1, temp2, fbase;
+        int fbase;
+        CompareData cd;
         const AVFrame *prev, *next;
-        uint8_t *mapp    = fm->map_data[plane];
-        int map_linesize = fm->map_linesize[plane];
-        const uint8_t *srcp = src->data[plane];
-        const int src_linesize  = src->linesize[plane];
-        const int srcf_linesize = src_linesize << 1;
-        int prv_linesize,  nxt_linesize;
+        const uint8_t *prvpf, *nxtpf;
         int prvf_linesize, nxtf_linesize;
+        const int src_linesize = src->linesize[plane];
+        const int map_linesize = fm->map_linesize[plane] << 1;
         const int width  = get_width (fm, src, plane, INPUT_MAIN);
         const int height = get_height(fm, src, plane, INPUT_MAIN);
-        const int y0a = fm->y0 >> (plane ? fm->vsub[INPUT_MAIN] : 0);
-        const int y1a = fm->y1 >> (plane ? fm->vsub[INPUT_MAIN] : 0);
         const int startx = (plane == 0 ? 8 : 8 >> fm->hsub[INPUT_MAIN]);
-        const int stopx  = width - startx;
-        const uint8_t *srcpf, *srcf, *srcnf;
-        const uint8_t *prvpf, *prvnf, *nxtpf, *nxtnf;
-
-        fill_buf(mapp, width, height, map_linesize, 0);
+        uint8_t *mapp;
 
         /* match1 */
         fbase = get_field_base(match1, field);
-        srcf  = srcp + (fbase + 1) * src_linesize;
-        srcpf = srcf - srcf_linesize;
-        srcnf = srcf + srcf_linesize;
-        mapp  = mapp + fbase * map_linesize;
+        mapp  = fm->map_data[plane] + fbase * fm->map_linesize[plane];
+        cd.srcf = src->data[plane] + (fbase + 1) * src_linesize;
         prev = select_frame(fm, match1);
-        prv_linesize  = prev->linesize[plane];
-        prvf_linesize = prv_linesize << 1;
-        prvpf = prev->data[plane] + fbase * prv_linesize;   // previous frame, previous field
-        prvnf = prvpf + prvf_linesize;                      // previous frame, next     field
+        prvf_linesize = prev->linesize[plane] << 1;
+        prvpf = prev->data[plane] + fbase * prev->linesize[plane];  // previous frame, previous field
 
         /* match2 */
         fbase = get_field_base(match2, field);
         next = select_frame(fm, match2);
-        nxt_linesize  = next->linesize[plane];
-        nxtf_linesize = nxt_linesize << 1;
-        nxtpf = next->data[plane] + fbase * nxt_linesize;   // next frame, previous field
-        nxtnf = nxtpf + nxtf_linesize;                      // next frame, next     field
-
-        map_linesize <<= 1;
-        if ((match1 >= 3 && field == 1) || (match1 < 3 && field != 1))
-            build_diff_map(fm, prvpf, prvf_linesize, nxtpf, nxtf_linesize,
-                           mapp, map_linesize, height, width, plane);
-        else
-            build_diff_map(fm, prvnf, prvf_linesize, nxtnf, nxtf_linesize,
-                           mapp + map_linesize, map_linesize, height, width, plane);
-
-        for (y = 2; y < height - 2; y += 2) {
-            if (y0a == y1a || y < y0a || y > y1a) {
-                for (x = startx; x < stopx; x++) {
-                    if (mapp[x] > 0 || mapp[x + map_linesize] > 0) {
-                        temp1 = srcpf[x] + (srcf[x] << 2) + srcnf[x]; // [1 4 1]
-
-                        temp2 = abs(3 * (prvpf[x] + prvnf[x]) - temp1);
-                        if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
-                            accumPc += temp2;
-                        if (temp2 > 42) {
-                            if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
-                                accumPm += temp2;
-                            if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
-                                accumPml += temp2;
-                        }
-
-                        temp2 = abs(3 * (nxtpf[x] + nxtnf[x]) - temp1);
-                        if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
-                            accumNc += temp2;
-                        if (temp2 > 42) {
-                            if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
-                                accumNm += temp2;
-                            if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
-                                accumNml += temp2;
-                        }
-                    }
-                }
-            }
-            prvpf += prvf_linesize;
-            prvnf += prvf_linesize;
-            srcpf += srcf_linesize;
-            srcf  += srcf_linesize;
-            srcnf += srcf_linesize;
-            nxtpf += nxtf_linesize;
-            nxtnf += nxtf_linesize;
-            mapp  += map_linesize;
+        nxtf_linesize = next->linesize[plane] << 1;
+        nxtpf = next->data[plane] + fbase * next->linesize[plane];  // next frame, previous field
+
+        cd.plane          = plane;
+        cd.width          = width;
+        cd.height         = height;
+        cd.nb_pairs       = FFMAX((height - 3) / 2, 0);
+        cd.startx         = startx;
+        cd.stopx          = width - startx;
+        cd.y0a            = fm->y0 >> (plane ? fm->vsub[INPUT_MAIN] : 0);
+        cd.y1a            = fm->y1 >> (plane ? fm->vsub[INPUT_MAIN] : 0);
+        cd.mapp           = mapp;
+        cd.map_linesize   = map_linesize;
+        cd.srcf_linesize  = src_linesize << 1;
+        cd.prvpf          = prvpf;
+        cd.prvf_linesize  = prvf_linesize;
+        cd.nxtpf          = nxtpf;
+        cd.nxtf_linesize  = nxtf_linesize;
+        cd.diffp_linesize = prvf_linesize;
+        cd.diffn_linesize = nxtf_linesize;
+
+        if ((match1 >= 3 && field == 1) || (match1 < 3 && field != 1)) {
+            cd.diffp = prvpf;
+            cd.diffn = nxtpf;
+            cd.mapd  = mapp;
+        } else {
+            cd.diffp = prvpf + prvf_linesize;   // previous frame, next field
+            cd.diffn = nxtpf + nxtf_linesize;   // next frame, next field
+            cd.mapd  = mapp + map_linesize;
         }
+
+        ff_filter_execute(ctx, build_abs_diff_mask_slice, &cd, NULL, fm->nb_threads);
+        ff_filter_execute(ctx, build_diff_map_slice,      &cd, NULL, fm->nb_threads);
+        ff_filter_execute(ctx, compare_fields_slice,      &cd, NULL, fm->nb_threads);
+    }
+
+    for (i = 0; i < fm->nb_threads; i++) {
+        accumPc  += fm->accum[i][0];
+        accumPm  += fm->accum[i][1];
+        accumPml += fm->accum[i][2];
+        accumNc  += fm->accum[i][3];
+        accumNm  += fm->accum[i][4];
+        accumNml += fm->accum[i][5];
     }
 
     if (accumPm < 500 && accumNm < 500 && (accumPml >= 500 || accumNml >= 500) &&
@@ -659,7 +760,7 @@ static int checkmm(AVFilterContext *ctx, int *combs, int m1, int m2,
             gen_frames[mid] = create_weave_frame(ctx, mid, field,               \
                                                  fm->prv, fm->src, fm->nxt,     \
                                                  INPUT_MAIN);                   \
-        combs[mid] = calc_combed_score(fm, gen_frames[mid]);                    \
+        combs[mid] = calc_combed_score(ctx, gen_frames[mid]);                   \
     }                                                                           \
 } while (0)
 
@@ -733,7 +834,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 ret = AVERROR(ENOMEM);
                 goto fail;
             }
-            combs[i] = calc_combed_score(fm, gen_frames[i]);
+            combs[i] = calc_combed_score(ctx, gen_frames[i]);
         }
         av_log(ctx, AV_LOG_INFO, "COMBS: %3d %3d %3d %3d %3d\n",
                combs[0], combs[1], combs[2], combs[3], combs[4]);
@@ -746,22 +847,22 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
 
     /* p/c selection and optional 3-way p/c/n matches */
-    match = compare_fields(fm, fxo[mC], fxo[mP], field);
+    match = compare_fields(ctx, fxo[mC], fxo[mP], field);
     if (fm->mode == MODE_PCN || fm->mode == MODE_PCN_UB)
-        match = compare_fields(fm, match, fxo[mN], field);
+        match = compare_fields(ctx, match, fxo[mN], field);
 
     /* scene change check */
     if (fm->combmatch == COMBMATCH_SC) {
         if (fm->lastn == outlink->frame_count_in - 1) {
             if (fm->lastscdiff > fm->scthresh)
                 sc = 1;
-        } else if (luma_abs_diff(fm->prv, fm->src) > fm->scthresh) {
+        } else if (luma_abs_diff(ctx, fm->prv, fm->src) > fm->scthresh) {
             sc = 1;
         }
 
         if (!sc) {
             fm->lastn = outlink->frame_count_in;
-            fm->lastscdiff = luma_abs_diff(fm->src, fm->nxt);
+            fm->lastscdiff = luma_abs_diff(ctx, fm->src, fm->nxt);
             sc = fm->lastscdiff > fm->scthresh;
         }
     }
@@ -983,9 +1084,13 @@ static int config_input(AVFilterLink *inlink)
     fm->c_array = av_malloc_array((((w + fm->blockx/2)/fm->blockx)+1) *
                             (((h + fm->blocky/2)/fm->blocky)+1),
                             4 * sizeof(*fm->c_array));
-    if (!fm->tbuffer || !fm->c_array)
+    fm->nb_threads = ff_filter_get_nb_threads(ctx);
+    fm->accum = av_calloc(fm->nb_threads, sizeof(*fm->accum));
+    if (!fm->tbuffer || !fm->c_array || !fm->accum)
         return AVERROR(ENOMEM);
 
+    ff_ivtcdsp_init(&fm->dsp, 8);
+
     return 0;
 }
 
@@ -1041,6 +1146,7 @@ static av_cold void fieldmatch_uninit(AVFilterContext *ctx)
     av_freep(&fm->cmask_data[0]);
     av_freep(&fm->tbuffer);
     av_freep(&fm->c_array);
+    av_freep(&fm->accum);
 }
 
 static int config_output(AVFilterLink *outlink)
@@ -1079,5 +1185,5 @@ const AVFilter ff_vf_fieldmatch = {
     FILTER_OUTPUTS(fieldmatch_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class     = &fieldmatch_class,
-    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -22,12 +22,14 @@
  */
 
 #include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/timestamp.h"
 
 #include "avfilter.h"
 #include "filters.h"
+#include "internal.h"
 #include "scene_sad.h"
 #include "video.h"
 
@@ -42,8 +44,12 @@ typedef struct FreezeDetectContext {
     int64_t n;
     int64_t reference_n;
     int frozen;
+    uint64_t *sads;              ///< per-job sum of absolute differences
+    int nb_jobs;
 
     double noise;
+    int step;
+    int row_step;
     int64_t duration;            ///< minimum duration of frozen frame until notification
 } FreezeDetectContext;
 
@@ -56,6 +62,8 @@ static const AVOption freezedetect_options[] = {
     { "noise",               "set noise tolerance",                       OFFSET(noise),  AV_OPT_TYPE_DOUBLE,   {.dbl=0.001},     0,       1.0, V|F },
     { "d",                   "set minimum duration in seconds",        OFFSET(duration),  AV_OPT_TYPE_DURATION, {.i64=2000000},   0, INT64_MAX, V|F },
     { "duration",            "set minimum duration in seconds",        OFFSET(duration),  AV_OPT_TYPE_DURATION, {.i64=2000000},   0, INT64_MAX, V|F },
+    { "step",                "compare only one frame out of step",         OFFSET(step),  AV_OPT_TYPE_INT,      {.i64=1},         1,   INT_MAX, V|F },
+    { "row_step",            "compare only one row out of row_step",   OFFSET(row_step),  AV_OPT_TYPE_INT,      {.i64=1},         1,   INT_MAX, V|F },
 
     {NULL}
 };
@@ -101,12 +109,19 @@ static int config_input(AVFilterLink *inlink)
         ptrdiff_t line_size = av_image_get_linesize(inlink->format, inlink->w, plane);
         s->width[plane] = line_size >> (s->bitdepth > 8);
         s->height[plane] = inlink->h >> ((plane == 1 || plane == 2) ? pix_desc->log2_chroma_h : 0);
+        s->height[plane] = (s->height[plane] + s->row_step - 1) / s->row_step;
     }
 
     s->sad = ff_scene_sad_get_fn(s->bitdepth == 8 ? 8 : 16);
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    s->nb_jobs = FFMAX(1, FFMIN(inlink->h, ff_filter_get_nb_threads(ctx)));
+    av_freep(&s->sads);
+    s->sads = av_calloc(s->nb_jobs, sizeof(*s->sads));
+    if (!s->sads)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -114,23 +129,53 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     FreezeDetectContext *s = ctx->priv;
     av_frame_free(&s->reference_frame);
+    av_freep(&s->sads);
 }
 
-static int is_frozen(FreezeDetectContext *s, AVFrame *reference, AVFrame *frame)
+typedef struct ThreadData {
+    AVFrame *reference, *frame;
+} ThreadData;
+
+static int compute_sad(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    FreezeDetectContext *s = ctx->priv;
+    ThreadData *td = arg;
     uint64_t sad = 0;
-    uint64_t count = 0;
-    double mafd;
+
     for (int plane = 0; plane < 4; plane++) {
         if (s->width[plane]) {
+            const int slice_start = (s->height[plane] *  jobnr     ) / nb_jobs;
+            const int slice_end   = (s->height[plane] * (jobnr + 1)) / nb_jobs;
+            const ptrdiff_t linesize     = td->frame->linesize[plane] * s->row_step;
+            const ptrdiff_t ref_linesize = td->reference->linesize[plane] * s->row_step;
             uint64_t plane_sad;
-            s->sad(frame->data[plane], frame->linesize[plane],
-                   reference->data[plane], reference->linesize[plane],
-                   s->width[plane], s->height[plane], &plane_sad);
+
+            if (slice_end <= slice_start)
+                continue;
+            s->sad(td->frame->data[plane] + slice_start * linesize, linesize,
+                   td->reference->data[plane] + slice_start * ref_linesize, ref_linesize,
+                   s->width[plane], slice_end - slice_start, &plane_sad);
             sad += plane_sad;
-            count += s->width[plane] * s->height[plane];
         }
     }
+
+    s->sads[jobnr] = sad;
+    return 0;
+}
+
+static int is_frozen(AVFilterContext *ctx, AVFrame *reference, AVFrame *frame)
+{
+    FreezeDetectContext *s = ctx->priv;
+    ThreadData td = { .reference = reference, .frame = frame };
+    uint64_t sad = 0;
+    uint64_t count = 0;
+    double mafd;
+
+    ff_filter_execute(ctx, compute_sad, &td, NULL, s->nb_jobs);
+    for (int i = 0; i < s->nb_jobs; i++)
+        sad += s->sads[i];
+    for (int plane = 0; plane < 4; plane++)
+        count += s->width[plane] * s->height[plane];
     mafd = (double)sad / count / (1ULL << s->bitdepth);
     return (mafd <= s->noise);
 }
@@ -159,6 +204,9 @@ static int activate(AVFilterContext *ctx)
         int frozen = 0;
         s->n++;
 
+        if (s->reference_frame && (s->n - s->reference_n) % s->step)
+            return ff_filter_frame(outlink, frame);
+
         if (s->reference_frame) {
             int64_t duration;
             if (s->reference_frame->pts == AV_NOPTS_VALUE || frame->pts == AV_NOPTS_VALUE || frame->pts < s->reference_frame->pts)     // Discontinuity?
@@ -166,7 +214,7 @@ static int activate(AVFilterContext *ctx)
             else
                 duration = av_rescale_q(frame->pts - s->reference_frame->pts, inlink->time_base, AV_TIME_BASE_Q);
 
-            frozen = is_frozen(s, s->reference_frame, frame);
+            frozen = is_frozen(ctx, s->reference_frame, frame);
             if (duration >= s->duration) {
                 if (!s->frozen)
                     set_meta(s, frame, "lavfi.freezedetect.freeze_start", av_ts2timestr(s->reference_frame->pts, &inlink->time_base));
@@ -210,7 +258,7 @@ const AVFilter ff_vf_freezedetect = {
     .priv_size     = sizeof(FreezeDetectContext),
     .priv_class    = &freezedetect_class,
     .uninit        = uninit,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_METADATA_ONLY | AVFILTER_FLAG_SLICE_THREADS,
     FILTER_INPUTS(freezedetect_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
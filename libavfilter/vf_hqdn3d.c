@@ -76,6 +76,42 @@ static void denoise_temporal(uint8_t *src, uint8_t *dst,
     }
 }
 
+av_always_inline
+static void denoise_row(uint8_t *src, uint8_t *dst,
+                        uint16_t *line_ant, uint16_t *frame_ant,
+                        ptrdiff_t w, int16_t *spatial, int16_t *temporal,
+                        int depth)
+{
+    long x;
+    uint32_t pixel_ant;
+    uint32_t tmp;
+
+    pixel_ant = LOAD(0);
+    for (x = 0; x < w-1; x++) {
+        line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
+        pixel_ant = lowpass(pixel_ant, LOAD(x+1), spatial, depth);
+        frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+        STORE(x, tmp);
+    }
+    line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
+    frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+    STORE(x, tmp);
+}
+
+#define DENOISE_ROW(depth)                                                    \
+static void denoise_row_ ## depth ## _c(uint8_t *src, uint8_t *dst,          \
+                                        uint16_t *line_ant,                   \
+                                        uint16_t *frame_ant, ptrdiff_t w,     \
+                                        int16_t *spatial, int16_t *temporal)  \
+{                                                                             \
+    denoise_row(src, dst, line_ant, frame_ant, w, spatial, temporal, depth);  \
+}
+
+DENOISE_ROW(8)
+DENOISE_ROW(9)
+DENOISE_ROW(10)
+DENOISE_ROW(16)
+
 av_always_inline
 static void denoise_spatial(HQDN3DContext *s,
                             uint8_t *src, uint8_t *dst,
@@ -103,20 +139,10 @@ static void denoise_spatial(HQDN3DContext *s,
         src += sstride;
         dst += dstride;
         frame_ant += w;
-        if (s->denoise_row[depth]) {
+        if (s->denoise_row[depth])
             s->denoise_row[depth](src, dst, line_ant, frame_ant, w, spatial, temporal);
-            continue;
-        }
-        pixel_ant = LOAD(0);
-        for (x = 0; x < w-1; x++) {
-            line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
-            pixel_ant = lowpass(pixel_ant, LOAD(x+1), spatial, depth);
-            frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
-            STORE(x, tmp);
-        }
-        line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
-        frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
-        STORE(x, tmp);
+        else
+            denoise_row(src, dst, line_ant, frame_ant, w, spatial, temporal, depth);
     }
 }
 
@@ -243,6 +269,20 @@ static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_NONE
 };
 
+av_cold void ff_hqdn3d_init(HQDN3DContext *hqdn3d)
+{
+    hqdn3d->denoise_row[8]  = denoise_row_8_c;
+    hqdn3d->denoise_row[9]  = denoise_row_9_c;
+    hqdn3d->denoise_row[10] = denoise_row_10_c;
+    hqdn3d->denoise_row[16] = denoise_row_16_c;
+
+#if ARCH_X86
+    ff_hqdn3d_init_x86(hqdn3d);
+#elif ARCH_AARCH64
+    ff_hqdn3d_init_aarch64(hqdn3d);
+#endif
+}
+
 static void calc_coefs(AVFilterContext *ctx)
 {
     HQDN3DContext *s = ctx->priv;
@@ -278,9 +318,7 @@ static int config_input(AVFilterLink *inlink)
 
     calc_coefs(ctx);
 
-#if ARCH_X86
-    ff_hqdn3d_init_x86(s);
-#endif
+    ff_hqdn3d_init(s);
 
     return 0;
 }
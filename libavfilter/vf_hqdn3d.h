@@ -44,6 +44,8 @@ typedef struct HQDN3DContext {
 #define CHROMA_SPATIAL 2
 #define CHROMA_TMP     3
 
+void ff_hqdn3d_init(HQDN3DContext *hqdn3d);
 void ff_hqdn3d_init_x86(HQDN3DContext *hqdn3d);
+void ff_hqdn3d_init_aarch64(HQDN3DContext *hqdn3d);
 
 #endif /* AVFILTER_HQDN3D_H */
@@ -67,6 +67,10 @@ enum {
 
 #define HIST_SIZE (1<<15)
 
+typedef struct ThreadData {
+    const AVFrame *prv, *cur;
+} ThreadData;
+
 typedef struct PaletteGenContext {
     const AVClass *class;
 
@@ -76,6 +80,9 @@ typedef struct PaletteGenContext {
 
     AVFrame *prev_frame;                    // previous frame used for the diff stats_mode
     struct hist_node histogram[HIST_SIZE];  // histogram/hashtable of the colors
+    struct hist_node (*job_hists)[HIST_SIZE]; // histograms of the slice jobs, merged in slice order
+    int nb_jobs;                            // number of slice jobs
+    int *jobs_ret;                          // return values of the slice jobs
     struct color_ref **refs;                // references of all the colors used in the stream
     int nb_refs;                            // number of color references (or number of different colors)
     struct range_box boxes[256];            // define the segmentation of the colorspace (the final palette)
@@ -415,15 +422,55 @@ static int color_inc(struct hist_node *hist, uint32_t color)
     return 1;
 }
 
+/**
+ * Add the colors of src to hist and empty src. The colors new to hist are
+ * appended to its buckets in the order src got them, so merging the
+ * histograms of consecutive slices in order gives the same hash table as
+ * scanning all the slices at once. Returns the number of new colors.
+ */
+static int merge_histogram(struct hist_node *hist, struct hist_node *src)
+{
+    int nb_diff_colors = 0;
+
+    for (int j = 0; j < HIST_SIZE; j++) {
+        struct hist_node *node = &hist[j];
+
+        for (int k = 0; k < src[j].nb_entries; k++) {
+            const struct color_ref *ref = &src[j].entries[k];
+            struct color_ref *e = NULL;
+
+            for (int i = 0; i < node->nb_entries; i++) {
+                if (node->entries[i].color == ref->color) {
+                    e = &node->entries[i];
+                    break;
+                }
+            }
+            if (e) {
+                e->count += ref->count;
+                continue;
+            }
+            e = av_dynarray2_add((void**)&node->entries, &node->nb_entries,
+                                 sizeof(*node->entries), (const uint8_t *)ref);
+            if (!e)
+                return AVERROR(ENOMEM);
+            nb_diff_colors++;
+        }
+        av_freep(&src[j].entries);
+        src[j].nb_entries = 0;
+    }
+    return nb_diff_colors;
+}
+
 /**
  * Update histogram when pixels differ from previous frame.
  */
 static int update_histogram_diff(struct hist_node *hist,
-                                 const AVFrame *f1, const AVFrame *f2)
+                                 const AVFrame *f1, const AVFrame *f2,
+                                 int slice_start, int slice_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f1->height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         const uint32_t *p = (const uint32_t *)(f1->data[0] + y*f1->linesize[0]);
         const uint32_t *q = (const uint32_t *)(f2->data[0] + y*f2->linesize[0]);
 
@@ -442,11 +489,12 @@ static int update_histogram_diff(struct hist_node *hist,
 /**
  * Simple histogram of the frame.
  */
-static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
+static int update_histogram_frame(struct hist_node *hist, const AVFrame *f,
+                                  int slice_start, int slice_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f->height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
 
         for (x = 0; x < f->width; x++) {
@@ -459,6 +507,57 @@ static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
     return nb_diff_colors;
 }
 
+static void free_job_hists(PaletteGenContext *s)
+{
+    for (int i = 0; i < s->nb_jobs; i++)
+        for (int j = 0; j < HIST_SIZE; j++)
+            av_freep(&s->job_hists[i][j].entries);
+    av_freep(&s->job_hists);
+    s->nb_jobs = 0;
+}
+
+static int update_histogram_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteGenContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = (td->cur->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (td->cur->height * (jobnr+1)) / nb_jobs;
+
+    return td->prv ? update_histogram_diff(s->job_hists[jobnr], td->prv, td->cur, slice_start, slice_end)
+                   : update_histogram_frame(s->job_hists[jobnr], td->cur, slice_start, slice_end);
+}
+
+/**
+ * Build the histogram of the frame (or of its differences with the previous
+ * one) in slices, then merge the slice histograms in order.
+ */
+static int update_histogram(AVFilterContext *ctx, const AVFrame *prv, const AVFrame *cur)
+{
+    PaletteGenContext *s = ctx->priv;
+    const int nb_jobs = FFMIN(s->nb_jobs, cur->height);
+    ThreadData td = { .prv = prv, .cur = cur };
+    int ret = 0, nb_diff_colors = 0;
+
+    if (nb_jobs <= 1)
+        return prv ? update_histogram_diff(s->histogram, prv, cur, 0, cur->height)
+                   : update_histogram_frame(s->histogram, cur, 0, cur->height);
+
+    ff_filter_execute(ctx, update_histogram_slice, &td, s->jobs_ret, nb_jobs);
+    for (int i = 0; i < nb_jobs; i++) {
+        if (ret >= 0)
+            ret = s->jobs_ret[i];
+        if (ret >= 0) {
+            ret = merge_histogram(s->histogram, s->job_hists[i]);
+            nb_diff_colors += ret;
+        } else {
+            for (int j = 0; j < HIST_SIZE; j++)
+                av_freep(&s->job_hists[i][j].entries);
+            memset(s->job_hists[i], 0, sizeof(s->job_hists[i]));
+        }
+    }
+    return ret < 0 ? ret : nb_diff_colors;
+}
+
 /**
  * Update the histogram for each passing frame. No frame will be pushed here.
  */
@@ -471,8 +570,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     if (in->color_trc != AVCOL_TRC_UNSPECIFIED && in->color_trc != AVCOL_TRC_IEC61966_2_1)
         av_log(ctx, AV_LOG_WARNING, "The input frame is not in sRGB, colors may be off\n");
 
-    ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in)
-                        : update_histogram_frame(s->histogram, in);
+    ret = update_histogram(ctx, s->prev_frame, in);
     if (ret > 0)
         s->nb_refs += ret;
 
@@ -520,6 +618,24 @@ static int request_frame(AVFilterLink *outlink)
     return r;
 }
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    PaletteGenContext *s = ctx->priv;
+    const int nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx), inlink->h);
+
+    free_job_hists(s);
+    av_freep(&s->jobs_ret);
+    if (nb_jobs <= 1)
+        return 0;
+    s->job_hists = av_calloc(nb_jobs, sizeof(*s->job_hists));
+    s->jobs_ret  = av_calloc(nb_jobs, sizeof(*s->jobs_ret));
+    if (!s->job_hists || !s->jobs_ret)
+        return AVERROR(ENOMEM);
+    s->nb_jobs = nb_jobs;
+    return 0;
+}
+
 /**
  * The output is one simple 16x16 squared-pixels palette.
  */
@@ -551,12 +667,15 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&s->histogram[i].entries);
     av_freep(&s->refs);
     av_frame_free(&s->prev_frame);
+    free_job_hists(s);
+    av_freep(&s->jobs_ret);
 }
 
 static const AVFilterPad palettegen_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
 };
@@ -580,4 +699,5 @@ const AVFilter ff_vf_palettegen = {
     FILTER_OUTPUTS(palettegen_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &palettegen_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
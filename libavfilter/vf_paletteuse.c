@@ -24,17 +24,21 @@
  * Use a palette to downsample an input video stream.
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/bprint.h"
 #include "libavutil/file_open.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "formats.h"
 #include "framesync.h"
 #include "internal.h"
 #include "palette.h"
+#include "paletteuse.h"
 #include "video.h"
 
 enum dithering_mode {
@@ -80,16 +84,39 @@ struct cache_node {
     int nb_entries;
 };
 
+/* Error diffusion reaches at most 2 pixels to the right on the current row
+ * and 2 pixels to the left on the next one, so a row can be dithered up to 4
+ * pixels behind the row above without changing the order in which errors are
+ * added to any pixel. Rows are dithered in steps of WAVEFRONT_STEP pixels. */
+#define WAVEFRONT_LAG  4
+#define WAVEFRONT_STEP 64
+
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;     /* processing window */
+    int wavefront;      /* error diffusion split over several jobs */
+} ThreadData;
+
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              const ThreadData *td, int y, int x0, int x1);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*caches)[CACHE_SIZE]; /* lookup caches, one per slice job */
+    int nb_caches;
+    int *jobs_ret;
+    atomic_int *row_done;   /* number of dithered pixels of each window row */
+    atomic_int next_row;    /* next window row to dither */
+    AVMutex progress_lock;
+    AVCond progress_cond;
+    int progress_init;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
+    int32_t map_lab[3][AVPALETTE_COUNT];    /* Lab planes of the tree nodes, for nearest_color() */
+    int nb_map_lab;                         /* number of nodes, padded with far away colors; 0 to walk the tree */
+    PaletteUseDSPContext dsp;
     uint32_t palette[AVPALETTE_COUNT];
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
@@ -233,15 +260,70 @@ struct stack_node {
     int dx2;
 };
 
+/* Lab value of the colors padding map_lab, further from any color than
+ * sqrt(INT32_MAX) */
+#define FAR_LAB (1 << 24)
+
+static int nearest_color_c(const int32_t *pal, int nb_colors, int L, int a, int b)
+{
+    int64_t best = INT64_MAX;
+    int best_id = -1, nb_best = 0;
+
+    for (int i = 0; i < nb_colors; i++) {
+        const int64_t dL = (int64_t)pal[i                      ] - L;
+        const int64_t da = (int64_t)pal[i +     AVPALETTE_COUNT] - a;
+        const int64_t db = (int64_t)pal[i + 2 * AVPALETTE_COUNT] - b;
+        const int64_t d  = FFMIN(dL*dL + da*da + db*db, INT32_MAX - 1);
+
+        if (d < best) {
+            best    = d;
+            best_id = i;
+            nb_best = 1;
+        } else if (d == best) {
+            nb_best++;
+        }
+    }
+    return nb_best == 1 ? best_id : -1;
+}
+
+av_cold void ff_paletteuse_init(PaletteUseDSPContext *dsp)
+{
+    dsp->nearest_color     = nearest_color_c;
+    dsp->nearest_color_max = 0;
+#if ARCH_X86
+    ff_paletteuse_init_x86(dsp);
+#endif
+}
+
+/**
+ * Find the palette entry nearest to the color. With small palettes, opaque
+ * colors are compared to all the tree nodes at once; the tree is still
+ * walked when several nodes are at the same distance, since it may pick any
+ * of them.
+ */
+static av_always_inline uint8_t color_nearest(const PaletteUseContext *s, uint32_t color)
+{
+    const struct color_info clrinfo = get_color_from_srgb(color);
+
+    if (color >> 24 >= s->trans_thresh && s->nb_map_lab) {
+        const int node_id = s->dsp.nearest_color(s->map_lab[0], s->nb_map_lab,
+                                                 clrinfo.lab[0], clrinfo.lab[1],
+                                                 clrinfo.lab[2]);
+        if (node_id >= 0)
+            return s->map[node_id].palette_id;
+    }
+    return colormap_nearest(s->map, &clrinfo, s->trans_thresh);
+}
+
 /**
  * Check if the requested color is in the cache already. If not, find it in the
  * color tree and cache it.
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color)
 {
-    struct color_info clrinfo;
     const uint32_t hash = ff_lowbias32(color) & (CACHE_SIZE - 1);
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -260,17 +342,16 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
     if (!e)
         return AVERROR(ENOMEM);
     e->color = color;
-    clrinfo = get_color_from_srgb(color);
-    e->pal_entry = colormap_nearest(s->map, &clrinfo, s->trans_thresh);
+    e->pal_entry = color_nearest(s, color);
 
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb)
 {
     uint32_t dstc;
-    const int dstx = color_get(s, c);
+    const int dstx = color_get(s, cache, c);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -287,170 +368,169 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                                      int x_start, int y_start, int w, int h,
+/**
+ * Map the pixels x0 to x1-1 of row y, diffusing the error inside the
+ * processing window of td.
+ */
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      const ThreadData *td, int y, int x0, int x1,
                                       enum dithering_mode dither)
 {
-    const int src_linesize = in ->linesize[0] >> 2;
-    const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
-
-    w += x_start;
-    h += y_start;
-
-    for (int y = y_start; y < h; y++) {
-        for (int x = x_start; x < w; x++) {
-            int er, eg, eb;
-
-            if (dither == DITHERING_BAYER) {
-                const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
-                const uint8_t a8 = src[x] >> 24;
-                const uint8_t r8 = src[x] >> 16 & 0xff;
-                const uint8_t g8 = src[x] >>  8 & 0xff;
-                const uint8_t b8 = src[x]       & 0xff;
-                const uint8_t r = av_clip_uint8(r8 + d);
-                const uint8_t g = av_clip_uint8(g8 + d);
-                const uint8_t b = av_clip_uint8(b8 + d);
-                const uint32_t color_new = (unsigned)(a8) << 24 | r << 16 | g << 8 | b;
-                const int color = color_get(s, color_new);
-
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-
-            } else if (dither == DITHERING_HECKBERT) {
-                const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
-
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-
-                if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 3, 3);
-                if (         down) src[src_linesize + x    ] = dither_color(src[src_linesize + x    ], er, eg, eb, 3, 3);
-                if (right && down) src[src_linesize + x + 1] = dither_color(src[src_linesize + x + 1], er, eg, eb, 2, 3);
-
-            } else if (dither == DITHERING_FLOYD_STEINBERG) {
-                const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
-
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-
-                if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 7, 4);
-                if (left  && down) src[src_linesize + x - 1] = dither_color(src[src_linesize + x - 1], er, eg, eb, 3, 4);
-                if (         down) src[src_linesize + x    ] = dither_color(src[src_linesize + x    ], er, eg, eb, 5, 4);
-                if (right && down) src[src_linesize + x + 1] = dither_color(src[src_linesize + x + 1], er, eg, eb, 1, 4);
-
-            } else if (dither == DITHERING_SIERRA2) {
-                const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
-                const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
-
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-
-                if (right)          src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 4, 4);
-                if (right2)         src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 3, 4);
-
-                if (down) {
-                    if (left2)      src[  src_linesize + x - 2] = dither_color(src[  src_linesize + x - 2], er, eg, eb, 1, 4);
-                    if (left)       src[  src_linesize + x - 1] = dither_color(src[  src_linesize + x - 1], er, eg, eb, 2, 4);
-                    if (1)          src[  src_linesize + x    ] = dither_color(src[  src_linesize + x    ], er, eg, eb, 3, 4);
-                    if (right)      src[  src_linesize + x + 1] = dither_color(src[  src_linesize + x + 1], er, eg, eb, 2, 4);
-                    if (right2)     src[  src_linesize + x + 2] = dither_color(src[  src_linesize + x + 2], er, eg, eb, 1, 4);
-                }
+    const int src_linesize = td->in->linesize[0] >> 2;
+    uint32_t *src = ((uint32_t *)td->in->data[0]) + y*src_linesize;
+    uint8_t  *dst =              td->out->data[0]  + y*td->out->linesize[0];
+    const int x_start = td->x;
+    const int w = td->x + td->w;
+    const int h = td->y + td->h;
+
+    for (int x = x0; x < x1; x++) {
+        int er, eg, eb;
+
+        if (dither == DITHERING_BAYER) {
+            const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
+            const uint8_t a8 = src[x] >> 24;
+            const uint8_t r8 = src[x] >> 16 & 0xff;
+            const uint8_t g8 = src[x] >>  8 & 0xff;
+            const uint8_t b8 = src[x]       & 0xff;
+            const uint8_t r = av_clip_uint8(r8 + d);
+            const uint8_t g = av_clip_uint8(g8 + d);
+            const uint8_t b = av_clip_uint8(b8 + d);
+            const uint32_t color_new = (unsigned)(a8) << 24 | r << 16 | g << 8 | b;
+            const int color = color_get(s, cache, color_new);
+
+            if (color < 0)
+                return color;
+            dst[x] = color;
+
+        } else if (dither == DITHERING_HECKBERT) {
+            const int right = x < w - 1, down = y < h - 1;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
+
+            if (color < 0)
+                return color;
+            dst[x] = color;
+
+            if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 3, 3);
+            if (         down) src[src_linesize + x    ] = dither_color(src[src_linesize + x    ], er, eg, eb, 3, 3);
+            if (right && down) src[src_linesize + x + 1] = dither_color(src[src_linesize + x + 1], er, eg, eb, 2, 3);
+
+        } else if (dither == DITHERING_FLOYD_STEINBERG) {
+            const int right = x < w - 1, down = y < h - 1, left = x > x_start;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
+
+            if (color < 0)
+                return color;
+            dst[x] = color;
+
+            if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 7, 4);
+            if (left  && down) src[src_linesize + x - 1] = dither_color(src[src_linesize + x - 1], er, eg, eb, 3, 4);
+            if (         down) src[src_linesize + x    ] = dither_color(src[src_linesize + x    ], er, eg, eb, 5, 4);
+            if (right && down) src[src_linesize + x + 1] = dither_color(src[src_linesize + x + 1], er, eg, eb, 1, 4);
+
+        } else if (dither == DITHERING_SIERRA2) {
+            const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
+            const int right2 = x < w - 2,                    left2 = x > x_start + 1;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
+
+            if (color < 0)
+                return color;
+            dst[x] = color;
+
+            if (right)          src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 4, 4);
+            if (right2)         src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 3, 4);
+
+            if (down) {
+                if (left2)      src[  src_linesize + x - 2] = dither_color(src[  src_linesize + x - 2], er, eg, eb, 1, 4);
+                if (left)       src[  src_linesize + x - 1] = dither_color(src[  src_linesize + x - 1], er, eg, eb, 2, 4);
+                if (1)          src[  src_linesize + x    ] = dither_color(src[  src_linesize + x    ], er, eg, eb, 3, 4);
+                if (right)      src[  src_linesize + x + 1] = dither_color(src[  src_linesize + x + 1], er, eg, eb, 2, 4);
+                if (right2)     src[  src_linesize + x + 2] = dither_color(src[  src_linesize + x + 2], er, eg, eb, 1, 4);
+            }
 
-            } else if (dither == DITHERING_SIERRA2_4A) {
-                const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
-
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-
-                if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 2, 2);
-                if (left  && down) src[src_linesize + x - 1] = dither_color(src[src_linesize + x - 1], er, eg, eb, 1, 2);
-                if (         down) src[src_linesize + x    ] = dither_color(src[src_linesize + x    ], er, eg, eb, 1, 2);
-
-            } else if (dither == DITHERING_SIERRA3) {
-                const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
-                const int right2 = x < w - 2, down2 = y < h - 2, left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
-
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-
-                if (right)         src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 5, 5);
-                if (right2)        src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 3, 5);
-
-                if (down) {
-                    if (left2)     src[src_linesize   + x - 2] = dither_color(src[src_linesize   + x - 2], er, eg, eb, 2, 5);
-                    if (left)      src[src_linesize   + x - 1] = dither_color(src[src_linesize   + x - 1], er, eg, eb, 4, 5);
-                    if (1)         src[src_linesize   + x    ] = dither_color(src[src_linesize   + x    ], er, eg, eb, 5, 5);
-                    if (right)     src[src_linesize   + x + 1] = dither_color(src[src_linesize   + x + 1], er, eg, eb, 4, 5);
-                    if (right2)    src[src_linesize   + x + 2] = dither_color(src[src_linesize   + x + 2], er, eg, eb, 2, 5);
-
-                    if (down2) {
-                        if (left)  src[src_linesize*2 + x - 1] = dither_color(src[src_linesize*2 + x - 1], er, eg, eb, 2, 5);
-                        if (1)     src[src_linesize*2 + x    ] = dither_color(src[src_linesize*2 + x    ], er, eg, eb, 3, 5);
-                        if (right) src[src_linesize*2 + x + 1] = dither_color(src[src_linesize*2 + x + 1], er, eg, eb, 2, 5);
-                    }
+        } else if (dither == DITHERING_SIERRA2_4A) {
+            const int right = x < w - 1, down = y < h - 1, left = x > x_start;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
+
+            if (color < 0)
+                return color;
+            dst[x] = color;
+
+            if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 2, 2);
+            if (left  && down) src[src_linesize + x - 1] = dither_color(src[src_linesize + x - 1], er, eg, eb, 1, 2);
+            if (         down) src[src_linesize + x    ] = dither_color(src[src_linesize + x    ], er, eg, eb, 1, 2);
+
+        } else if (dither == DITHERING_SIERRA3) {
+            const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
+            const int right2 = x < w - 2, down2 = y < h - 2, left2 = x > x_start + 1;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
+
+            if (color < 0)
+                return color;
+            dst[x] = color;
+
+            if (right)         src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 5, 5);
+            if (right2)        src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 3, 5);
+
+            if (down) {
+                if (left2)     src[src_linesize   + x - 2] = dither_color(src[src_linesize   + x - 2], er, eg, eb, 2, 5);
+                if (left)      src[src_linesize   + x - 1] = dither_color(src[src_linesize   + x - 1], er, eg, eb, 4, 5);
+                if (1)         src[src_linesize   + x    ] = dither_color(src[src_linesize   + x    ], er, eg, eb, 5, 5);
+                if (right)     src[src_linesize   + x + 1] = dither_color(src[src_linesize   + x + 1], er, eg, eb, 4, 5);
+                if (right2)    src[src_linesize   + x + 2] = dither_color(src[src_linesize   + x + 2], er, eg, eb, 2, 5);
+
+                if (down2) {
+                    if (left)  src[src_linesize*2 + x - 1] = dither_color(src[src_linesize*2 + x - 1], er, eg, eb, 2, 5);
+                    if (1)     src[src_linesize*2 + x    ] = dither_color(src[src_linesize*2 + x    ], er, eg, eb, 3, 5);
+                    if (right) src[src_linesize*2 + x + 1] = dither_color(src[src_linesize*2 + x + 1], er, eg, eb, 2, 5);
                 }
+            }
 
-            } else if (dither == DITHERING_BURKES) {
-                const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
-                const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+        } else if (dither == DITHERING_BURKES) {
+            const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
+            const int right2 = x < w - 2,                    left2 = x > x_start + 1;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
-                dst[x] = color;
+            if (color < 0)
+                return color;
+            dst[x] = color;
 
-                if (right)      src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 8, 5);
-                if (right2)     src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 4, 5);
+            if (right)      src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 8, 5);
+            if (right2)     src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 4, 5);
 
-                if (down) {
-                    if (left2)  src[src_linesize   + x - 2] = dither_color(src[src_linesize   + x - 2], er, eg, eb, 2, 5);
-                    if (left)   src[src_linesize   + x - 1] = dither_color(src[src_linesize   + x - 1], er, eg, eb, 4, 5);
-                    if (1)      src[src_linesize   + x    ] = dither_color(src[src_linesize   + x    ], er, eg, eb, 8, 5);
-                    if (right)  src[src_linesize   + x + 1] = dither_color(src[src_linesize   + x + 1], er, eg, eb, 4, 5);
-                    if (right2) src[src_linesize   + x + 2] = dither_color(src[src_linesize   + x + 2], er, eg, eb, 2, 5);
-                }
+            if (down) {
+                if (left2)  src[src_linesize   + x - 2] = dither_color(src[src_linesize   + x - 2], er, eg, eb, 2, 5);
+                if (left)   src[src_linesize   + x - 1] = dither_color(src[src_linesize   + x - 1], er, eg, eb, 4, 5);
+                if (1)      src[src_linesize   + x    ] = dither_color(src[src_linesize   + x    ], er, eg, eb, 8, 5);
+                if (right)  src[src_linesize   + x + 1] = dither_color(src[src_linesize   + x + 1], er, eg, eb, 4, 5);
+                if (right2) src[src_linesize   + x + 2] = dither_color(src[src_linesize   + x + 2], er, eg, eb, 2, 5);
+            }
 
-            } else if (dither == DITHERING_ATKINSON) {
-                const int right  = x < w - 1, down  = y < h - 1, left = x > x_start;
-                const int right2 = x < w - 2, down2 = y < h - 2;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+        } else if (dither == DITHERING_ATKINSON) {
+            const int right  = x < w - 1, down  = y < h - 1, left = x > x_start;
+            const int right2 = x < w - 2, down2 = y < h - 2;
+            const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
-                dst[x] = color;
+            if (color < 0)
+                return color;
+            dst[x] = color;
 
-                if (right)     src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 1, 3);
-                if (right2)    src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 1, 3);
+            if (right)     src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 1, 3);
+            if (right2)    src[                 x + 2] = dither_color(src[                 x + 2], er, eg, eb, 1, 3);
 
-                if (down) {
-                    if (left)  src[src_linesize   + x - 1] = dither_color(src[src_linesize   + x - 1], er, eg, eb, 1, 3);
-                    if (1)     src[src_linesize   + x    ] = dither_color(src[src_linesize   + x    ], er, eg, eb, 1, 3);
-                    if (right) src[src_linesize   + x + 1] = dither_color(src[src_linesize   + x + 1], er, eg, eb, 1, 3);
-                    if (down2) src[src_linesize*2 + x    ] = dither_color(src[src_linesize*2 + x    ], er, eg, eb, 1, 3);
-                }
+            if (down) {
+                if (left)  src[src_linesize   + x - 1] = dither_color(src[src_linesize   + x - 1], er, eg, eb, 1, 3);
+                if (1)     src[src_linesize   + x    ] = dither_color(src[src_linesize   + x    ], er, eg, eb, 1, 3);
+                if (right) src[src_linesize   + x + 1] = dither_color(src[src_linesize   + x + 1], er, eg, eb, 1, 3);
+                if (down2) src[src_linesize*2 + x    ] = dither_color(src[src_linesize*2 + x    ], er, eg, eb, 1, 3);
+            }
 
-            } else {
-                const int color = color_get(s, src[x]);
+        } else {
+            const int color = color_get(s, cache, src[x]);
 
-                if (color < 0)
-                    return color;
-                dst[x] = color;
-            }
+            if (color < 0)
+                return color;
+            dst[x] = color;
         }
-        src += src_linesize;
-        dst += dst_linesize;
     }
     return 0;
 }
@@ -672,6 +752,12 @@ static void load_colormap(PaletteUseContext *s)
 
     colormap_insert(s->map, color_used, &nb_used, s->palette, s->trans_thresh, &box);
 
+    s->nb_map_lab = nb_used <= s->dsp.nearest_color_max ?
+                    FFALIGN(nb_used, PALETTEUSE_NEAREST_ALIGN) : 0;
+    for (int i = 0; i < s->nb_map_lab; i++)
+        for (int c = 0; c < 3; c++)
+            s->map_lab[c][i] = i < nb_used ? s->map[i].c.lab[c] : FAR_LAB;
+
     if (s->dot_filename)
         disp_tree(s->map, s->dot_filename);
 }
@@ -765,9 +851,65 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+static void wait_row(PaletteUseContext *s, int y, int n)
+{
+    if (atomic_load_explicit(&s->row_done[y], memory_order_acquire) >= n)
+        return;
+    ff_mutex_lock(&s->progress_lock);
+    while (atomic_load_explicit(&s->row_done[y], memory_order_acquire) < n)
+        ff_cond_wait(&s->progress_cond, &s->progress_lock);
+    ff_mutex_unlock(&s->progress_lock);
+}
+
+static void report_row(PaletteUseContext *s, int y, int n)
+{
+    atomic_store_explicit(&s->row_done[y], n, memory_order_release);
+    ff_mutex_lock(&s->progress_lock);
+    ff_cond_broadcast(&s->progress_cond);
+    ff_mutex_unlock(&s->progress_lock);
+}
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    struct cache_node *cache = s->caches[jobnr];
+    int y, ret = 0;
+
+    if (!td->wavefront) {
+        const int slice_start = td->y + (td->h *  jobnr   ) / nb_jobs;
+        const int slice_end   = td->y + (td->h * (jobnr+1)) / nb_jobs;
+
+        for (y = slice_start; y < slice_end; y++) {
+            ret = s->set_frame(s, cache, td, y, td->x, td->x + td->w);
+            if (ret < 0)
+                return ret;
+        }
+        return 0;
+    }
+
+    /* The rows are taken in order by whichever job is free, so the row above
+     * is always being dithered by a running job, whatever the number of
+     * threads. After an error, the remaining rows are only reported as done
+     * so that no job waits forever. */
+    while ((y = atomic_fetch_add_explicit(&s->next_row, 1, memory_order_relaxed)) < td->h) {
+        for (int x = 0; x < td->w; x += WAVEFRONT_STEP) {
+            const int x1 = FFMIN(x + WAVEFRONT_STEP, td->w);
+
+            if (y)
+                wait_row(s, y - 1, FFMIN(x1 + WAVEFRONT_LAG, td->w));
+            if (ret >= 0)
+                ret = s->set_frame(s, cache, td, td->y + y, td->x + x, td->x + x1);
+            report_row(s, y, x1);
+        }
+    }
+    return ret;
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
-    int x, y, w, h, ret;
+    ThreadData td;
+    int x, y, w, h, nb_jobs, ret;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -793,7 +935,27 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    /* The per-pixel dithering modes are split into slices of rows, error
+     * diffusion runs as a wavefront over the rows. Each job has its own
+     * cache, which keeps the output independent of the number of threads. */
+    nb_jobs = av_clip(h, 1, s->nb_caches);
+    td.in  = in;
+    td.out = out;
+    td.x   = x;
+    td.y   = y;
+    td.w   = w;
+    td.h   = h;
+    td.wavefront = nb_jobs > 1 && s->dither != DITHERING_NONE &&
+                                  s->dither != DITHERING_BAYER;
+    if (td.wavefront) {
+        for (int i = 0; i < h; i++)
+            atomic_init(&s->row_done[i], 0);
+        atomic_init(&s->next_row, 0);
+    }
+    ff_filter_execute(ctx, set_frame_slice, &td, s->jobs_ret, nb_jobs);
+    ret = 0;
+    for (int i = 0; i < nb_jobs && ret >= 0; i++)
+        ret = s->jobs_ret[i];
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -804,12 +966,36 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     return 0;
 }
 
+static void reset_caches(PaletteUseContext *s)
+{
+    for (int j = 0; j < s->nb_caches; j++) {
+        for (int i = 0; i < CACHE_SIZE; i++)
+            av_freep(&s->caches[j][i].entries);
+        memset(s->caches[j], 0, sizeof(s->caches[j]));
+    }
+}
+
 static int config_output(AVFilterLink *outlink)
 {
-    int ret;
+    int ret, nb_caches;
     AVFilterContext *ctx = outlink->src;
     PaletteUseContext *s = ctx->priv;
 
+    nb_caches = FFMIN(ff_filter_get_nb_threads(ctx), ctx->inputs[0]->h);
+    nb_caches = FFMAX(nb_caches, 1);
+
+    reset_caches(s);
+    av_freep(&s->caches);
+    av_freep(&s->jobs_ret);
+    av_freep(&s->row_done);
+    s->nb_caches = 0;
+    s->caches   = av_calloc(nb_caches, sizeof(*s->caches));
+    s->jobs_ret = av_calloc(nb_caches, sizeof(*s->jobs_ret));
+    s->row_done = av_calloc(ctx->inputs[0]->h, sizeof(*s->row_done));
+    if (!s->caches || !s->jobs_ret || !s->row_done)
+        return AVERROR(ENOMEM);
+    s->nb_caches = nb_caches;
+
     ret = ff_framesync_init_dualinput(&s->fs, ctx);
     if (ret < 0)
         return ret;
@@ -852,9 +1038,7 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        reset_caches(s);
     }
 
     i = 0;
@@ -902,10 +1086,10 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(name, value)                                           \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            const ThreadData *td, int y, int x0, int x1)        \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value);                \
+    return set_frame(s, cache, td, y, x0, x1, value);                           \
 }
 
 DEFINE_SET_FRAME(none,            DITHERING_NONE)
@@ -941,13 +1125,25 @@ static int dither_value(int p)
 static av_cold int init(AVFilterContext *ctx)
 {
     PaletteUseContext *s = ctx->priv;
+    int ret;
 
     s->last_in  = av_frame_alloc();
     s->last_out = av_frame_alloc();
     if (!s->last_in || !s->last_out)
         return AVERROR(ENOMEM);
 
+    ret = ff_mutex_init(&s->progress_lock, NULL);
+    if (ret)
+        return AVERROR(ret);
+    ret = ff_cond_init(&s->progress_cond, NULL);
+    if (ret) {
+        ff_mutex_destroy(&s->progress_lock);
+        return AVERROR(ret);
+    }
+    s->progress_init = 1;
+
     s->set_frame = set_frame_lut[s->dither];
+    ff_paletteuse_init(&s->dsp);
 
     if (s->dither == DITHERING_BAYER) {
         const int delta = 1 << (5 - s->bayer_scale); // to avoid too much luma
@@ -970,10 +1166,16 @@ static av_cold void uninit(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (int i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    reset_caches(s);
+    av_freep(&s->caches);
+    av_freep(&s->jobs_ret);
+    av_freep(&s->row_done);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
+    if (s->progress_init) {
+        ff_mutex_destroy(&s->progress_lock);
+        ff_cond_destroy(&s->progress_cond);
+    }
 }
 
 static const AVFilterPad paletteuse_inputs[] = {
@@ -1006,4 +1208,5 @@ const AVFilter ff_vf_paletteuse = {
     FILTER_OUTPUTS(paletteuse_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
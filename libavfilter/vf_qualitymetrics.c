@@ -0,0 +1,505 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Calculate PSNR, SSIM and VMAF motion between two input videos in a
+ * single pass.
+ *
+ * Every slice job walks its band of rows of 4x4 blocks of each plane once.
+ * For each row of blocks, it computes the SSIM sums, then the squared errors
+ * and the motion blur of the same 4 rows while they are in cache. The row
+ * functions are shared with the psnr, ssim and vmafmotion filters, so the
+ * results are the same as theirs, and are exported with the same metadata
+ * keys.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "framesync.h"
+#include "internal.h"
+#include "psnr.h"
+#include "ssim.h"
+#include "video.h"
+#include "vmaf_motion.h"
+
+enum Metric {
+    METRIC_PSNR   = 1 << 0,
+    METRIC_SSIM   = 1 << 1,
+    METRIC_MOTION = 1 << 2,
+};
+
+typedef struct JobScore {
+    uint64_t sse[4];
+    double ssim[4];
+    uint64_t sad;
+} JobScore;
+
+typedef struct QualityMetricsContext {
+    const AVClass *class;
+    FFFrameSync fs;
+    int metrics;
+
+    int nb_components;
+    int nb_threads;
+    int depth;
+    int max;
+    size_t sum_size;                ///< size of the SSIM sums of one 4x4 block
+    int planewidth[4];
+    int planeheight[4];
+    double planeweight[4];
+    char comps[4];
+    uint64_t nb_frames;
+
+    JobScore *score;
+    void **temp;                    ///< per job SSIM sums and motion row buffers
+
+    /* PSNR */
+    double mse, min_mse, max_mse, mse_comp[4];
+    PSNRDSPContext psnr_dsp;
+
+    /* SSIM */
+    double ssim[4], ssim_total;
+    SSIMDSPContext ssim_dsp;
+
+    /* VMAF motion */
+    uint16_t filter[5];
+    VMAFMotionDSPContext motion_dsp;
+    uint16_t *blur[2];              ///< blurred luma of the current and previous frame
+    ptrdiff_t blur_stride;
+    double motion_sum;
+} QualityMetricsContext;
+
+#define OFFSET(x) offsetof(QualityMetricsContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption qualitymetrics_options[] = {
+    { "metrics", "set the metrics to compute", OFFSET(metrics), AV_OPT_TYPE_FLAGS,
+      { .i64 = METRIC_PSNR | METRIC_SSIM | METRIC_MOTION }, 1, METRIC_PSNR | METRIC_SSIM | METRIC_MOTION, FLAGS, "metrics" },
+        { "psnr",   "peak signal to noise ratio",      0, AV_OPT_TYPE_CONST, { .i64 = METRIC_PSNR   }, 0, 0, FLAGS, "metrics" },
+        { "ssim",   "structural similarity",           0, AV_OPT_TYPE_CONST, { .i64 = METRIC_SSIM   }, 0, 0, FLAGS, "metrics" },
+        { "motion", "VMAF motion of the main input",   0, AV_OPT_TYPE_CONST, { .i64 = METRIC_MOTION }, 0, 0, FLAGS, "metrics" },
+    { NULL }
+};
+
+FRAMESYNC_DEFINE_CLASS(qualitymetrics, QualityMetricsContext, fs);
+
+typedef struct ThreadData {
+    const AVFrame *main, *ref;
+    int has_prev;
+} ThreadData;
+
+static int compute_metrics(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    QualityMetricsContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    JobScore *score = &s->score[jobnr];
+    void *temp = s->temp[jobnr];
+
+    memset(score, 0, sizeof(*score));
+
+    for (int c = 0; c < s->nb_components; c++) {
+        const uint8_t *main_data = td->main->data[c];
+        const uint8_t *ref_data  = td->ref->data[c];
+        const int main_stride = td->main->linesize[c];
+        const int ref_stride  = td->ref->linesize[c];
+        const int width  = s->planewidth[c];
+        const int height = s->planeheight[c];
+        const int psnr   = s->metrics & METRIC_PSNR;
+        const int ssim   = s->metrics & METRIC_SSIM;
+        const int motion = c == 0 && s->metrics & METRIC_MOTION;
+        /* The job gets a band of rows of 4x4 blocks; the last one also
+         * takes the rows below the last whole block. */
+        const int slice_start = ((height >> 2) *  jobnr   ) / nb_jobs;
+        const int slice_end   = ((height >> 2) * (jobnr+1)) / nb_jobs;
+        const int row_end = jobnr == nb_jobs - 1 ? height : 4 * slice_end;
+        const ptrdiff_t blur_stride = s->blur_stride / sizeof(uint16_t);
+        void *sum0 = temp;
+        void *sum1 = (uint8_t *)temp + SSIM_SUM_LEN(width) * s->sum_size;
+        uint16_t *tmp = (uint16_t *)((uint8_t *)temp + 2 * SSIM_SUM_LEN(width) * s->sum_size);
+        int z = FFMAX(slice_start - 1, 0);
+
+        /* one pass over the band: each row of blocks is read once for all
+         * the metrics */
+        for (int y = 4 * slice_start; y < row_end; y += 4) {
+            const int b = y >> 2;
+
+            if (ssim && b < slice_end) {
+                for (; z <= b; z++) {
+                    FFSWAP(void*, sum0, sum1);
+                    if (s->depth > 8)
+                        ff_ssim_4x4xn_16bit(&main_data[4 * z * main_stride], main_stride,
+                                            &ref_data[4 * z * ref_stride], ref_stride,
+                                            sum0, width >> 2);
+                    else
+                        s->ssim_dsp.ssim_4x4_line(&main_data[4 * z * main_stride], main_stride,
+                                                  &ref_data[4 * z * ref_stride], ref_stride,
+                                                  sum0, width >> 2);
+                }
+
+                if (b > 0) {
+                    if (s->depth > 8)
+                        score->ssim[c] += ff_ssim_endn_16bit((const int64_t (*)[4])sum0,
+                                                             (const int64_t (*)[4])sum1,
+                                                             (width >> 2) - 1, s->max);
+                    else
+                        score->ssim[c] += s->ssim_dsp.ssim_end_line((const int (*)[4])sum0,
+                                                                    (const int (*)[4])sum1,
+                                                                    (width >> 2) - 1);
+                }
+            }
+
+            for (int yy = y; yy < FFMIN(y + 4, row_end); yy++) {
+                if (psnr)
+                    score->sse[c] += s->psnr_dsp.sse_line(main_data + yy * main_stride,
+                                                          ref_data  + yy * ref_stride, width);
+
+                if (motion) {
+                    uint16_t *cur = s->blur[0] + yy * blur_stride;
+                    const uint16_t *prev = s->blur[1] + yy * blur_stride;
+
+                    s->motion_dsp.convolution_y_row(s->filter, 5, main_data, tmp,
+                                                    width, height, yy, main_stride);
+                    s->motion_dsp.convolution_x(s->filter, 5, tmp, cur, width, 1, 0, 0);
+                    if (td->has_prev)
+                        score->sad += s->motion_dsp.sad(cur, prev, width, 1, 0, 0);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void set_meta(AVDictionary **metadata, const char *key, char comp, const char *fmt, float d)
+{
+    char value[128];
+    snprintf(value, sizeof(value), fmt, d);
+    if (comp) {
+        char key2[128];
+        snprintf(key2, sizeof(key2), "%s%c", key, comp);
+        av_dict_set(metadata, key2, value, 0);
+    } else {
+        av_dict_set(metadata, key, value, 0);
+    }
+}
+
+static inline double get_psnr(double mse, uint64_t nb_frames, int max)
+{
+    return 10.0 * log10((double)max * max / (mse / nb_frames));
+}
+
+static double ssim_db(double ssim, double weight)
+{
+    return (fabs(weight - ssim) > 1e-9) ? 10.0 * log10(weight / (weight - ssim)) : INFINITY;
+}
+
+static int do_qualitymetrics(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    QualityMetricsContext *s = ctx->priv;
+    AVFrame *master, *ref;
+    AVDictionary **metadata;
+    ThreadData td;
+    int ret, nb_jobs;
+
+    ret = ff_framesync_dualinput_get(fs, &master, &ref);
+    if (ret < 0)
+        return ret;
+    if (ctx->is_disabled || !ref)
+        return ff_filter_frame(ctx->outputs[0], master);
+    metadata = &master->metadata;
+
+    if (master->color_range != ref->color_range) {
+        av_log(ctx, AV_LOG_WARNING, "master and reference "
+               "frames use different color ranges (%s != %s)\n",
+               av_color_range_name(master->color_range),
+               av_color_range_name(ref->color_range));
+    }
+
+    td.main = master;
+    td.ref  = ref;
+    td.has_prev = s->nb_frames > 0;
+    nb_jobs = FFMAX(1, FFMIN(s->nb_threads, s->planeheight[s->nb_components > 1] >> 2));
+    ff_filter_execute(ctx, compute_metrics, &td, NULL, nb_jobs);
+
+    if (s->metrics & METRIC_PSNR) {
+        double comp_mse[4], mse = 0.;
+
+        for (int c = 0; c < s->nb_components; c++) {
+            uint64_t sum = 0;
+            for (int j = 0; j < nb_jobs; j++)
+                sum += s->score[j].sse[c];
+            comp_mse[c] = sum / ((double)s->planewidth[c] * s->planeheight[c]);
+            mse += comp_mse[c] * s->planeweight[c];
+            s->mse_comp[c] += comp_mse[c];
+        }
+        s->min_mse = FFMIN(s->min_mse, mse);
+        s->max_mse = FFMAX(s->max_mse, mse);
+        s->mse += mse;
+
+        for (int c = 0; c < s->nb_components; c++) {
+            set_meta(metadata, "lavfi.psnr.mse.",  av_tolower(s->comps[c]), "%f", comp_mse[c]);
+            set_meta(metadata, "lavfi.psnr.psnr.", av_tolower(s->comps[c]), "%f", get_psnr(comp_mse[c], 1, s->max));
+        }
+        set_meta(metadata, "lavfi.psnr.mse_avg",  0, "%f", mse);
+        set_meta(metadata, "lavfi.psnr.psnr_avg", 0, "%f", get_psnr(mse, 1, s->max));
+    }
+
+    if (s->metrics & METRIC_SSIM) {
+        double ssimv = 0.0;
+
+        for (int c = 0; c < s->nb_components; c++) {
+            double ssim = 0.0;
+            for (int j = 0; j < nb_jobs; j++)
+                ssim += s->score[j].ssim[c];
+            ssim /= ((s->planewidth[c] >> 2) - 1) * ((s->planeheight[c] >> 2) - 1);
+            ssimv += s->planeweight[c] * ssim;
+            s->ssim[c] += ssim;
+            set_meta(metadata, "lavfi.ssim.", s->comps[c], "%f", ssim);
+        }
+        s->ssim_total += ssimv;
+
+        set_meta(metadata, "lavfi.ssim.All", 0, "%f", ssimv);
+        set_meta(metadata, "lavfi.ssim.dB",  0, "%f", ssim_db(ssimv, 1.0));
+    }
+
+    if (s->metrics & METRIC_MOTION) {
+        double motion = 0.0;
+
+        if (td.has_prev) {
+            uint64_t sad = 0;
+            for (int j = 0; j < nb_jobs; j++)
+                sad += s->score[j].sad;
+            // the output score is always normalized to 8 bits
+            motion = sad * 1.0 / ((int64_t)s->planewidth[0] * s->planeheight[0] << (VMAF_MOTION_BIT_SHIFT - 8));
+        }
+        FFSWAP(uint16_t *, s->blur[0], s->blur[1]);
+        s->motion_sum += motion;
+
+        set_meta(metadata, "lavfi.vmafmotion.score", 0, "%0.2f", motion);
+    }
+
+    s->nb_frames++;
+
+    return ff_filter_frame(ctx->outputs[0], master);
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+
+    s->min_mse = +INFINITY;
+    s->max_mse = -INFINITY;
+
+    s->fs.on_event = do_qualitymetrics;
+    return 0;
+}
+
+static const enum AVPixelFormat pix_fmts[] = {
+    AV_PIX_FMT_GRAY8,
+    AV_PIX_FMT_YUV410P, AV_PIX_FMT_YUV411P, AV_PIX_FMT_YUV420P,
+    AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV444P,
+    AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P,
+    AV_PIX_FMT_YUVJ440P, AV_PIX_FMT_YUVJ444P,
+    AV_PIX_FMT_GRAY10,
+    AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV422P10, AV_PIX_FMT_YUV444P10,
+    AV_PIX_FMT_NONE
+};
+
+static int config_input_ref(AVFilterLink *inlink)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    AVFilterContext *ctx  = inlink->dst;
+    QualityMetricsContext *s = ctx->priv;
+    double sum = 0;
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->nb_components = desc->nb_components;
+    s->depth = desc->comp[0].depth;
+    s->max = (1 << s->depth) - 1;
+    s->sum_size = s->depth > 8 ? sizeof(int64_t[4]) : sizeof(int[4]);
+
+    if (ctx->inputs[0]->w != ctx->inputs[1]->w ||
+        ctx->inputs[0]->h != ctx->inputs[1]->h) {
+        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+        return AVERROR(EINVAL);
+    }
+    if (inlink->w < 8 || inlink->h < 8) {
+        av_log(ctx, AV_LOG_ERROR, "Input videos must be at least 8x8.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->comps[0] = 'Y';
+    s->comps[1] = 'U';
+    s->comps[2] = 'V';
+
+    s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
+    s->planeheight[0] = inlink->h;
+    s->planewidth[1]  = s->planewidth[2]  = AV_CEIL_RSHIFT(inlink->w, desc->log2_chroma_w);
+    s->planewidth[0]  = inlink->w;
+    for (int i = 0; i < s->nb_components; i++)
+        sum += s->planeheight[i] * s->planewidth[i];
+    for (int i = 0; i < s->nb_components; i++)
+        s->planeweight[i] = s->planeheight[i] * s->planewidth[i] / sum;
+
+    s->score = av_calloc(s->nb_threads, sizeof(*s->score));
+    s->temp  = av_calloc(s->nb_threads, sizeof(*s->temp));
+    if (!s->score || !s->temp)
+        return AVERROR(ENOMEM);
+
+    for (int t = 0; t < s->nb_threads; t++) {
+        /* SSIM sums for two rows of 4x4 blocks, then a motion blur row */
+        s->temp[t] = av_malloc(2 * SSIM_SUM_LEN(inlink->w) * s->sum_size +
+                               inlink->w * sizeof(uint16_t));
+        if (!s->temp[t])
+            return AVERROR(ENOMEM);
+    }
+
+    if (s->metrics & METRIC_MOTION) {
+        s->blur_stride = FFALIGN(inlink->w * sizeof(uint16_t), 32);
+        for (int i = 0; i < 2; i++) {
+            s->blur[i] = av_malloc(s->blur_stride * inlink->h);
+            if (!s->blur[i])
+                return AVERROR(ENOMEM);
+        }
+        ff_vmafmotion_init_dsp(&s->motion_dsp, s->filter, s->depth);
+    }
+
+    ff_psnr_init(&s->psnr_dsp, s->depth);
+    ff_ssim_init(&s->ssim_dsp);
+
+    return 0;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    QualityMetricsContext *s = ctx->priv;
+    AVFilterLink *mainlink = ctx->inputs[0];
+    int ret;
+
+    ret = ff_framesync_init_dualinput(&s->fs, ctx);
+    if (ret < 0)
+        return ret;
+    outlink->w = mainlink->w;
+    outlink->h = mainlink->h;
+    outlink->time_base = mainlink->time_base;
+    outlink->sample_aspect_ratio = mainlink->sample_aspect_ratio;
+    outlink->frame_rate = mainlink->frame_rate;
+
+    if ((ret = ff_framesync_configure(&s->fs)) < 0)
+        return ret;
+
+    outlink->time_base = s->fs.time_base;
+
+    if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
+        av_cmp_q(ctx->inputs[1]->time_base, outlink->time_base))
+        av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and second input %d/%d, results may be incorrect!\n",
+               mainlink->time_base.num, mainlink->time_base.den,
+               ctx->inputs[1]->time_base.num, ctx->inputs[1]->time_base.den);
+
+    return 0;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+    return ff_framesync_activate(&s->fs);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+
+    if (s->nb_frames > 0) {
+        char buf[256];
+
+        if (s->metrics & METRIC_PSNR) {
+            buf[0] = 0;
+            for (int c = 0; c < s->nb_components; c++)
+                av_strlcatf(buf, sizeof(buf), " %c:%f", av_tolower(s->comps[c]),
+                            get_psnr(s->mse_comp[c], s->nb_frames, s->max));
+            av_log(ctx, AV_LOG_INFO, "PSNR%s average:%f min:%f max:%f\n",
+                   buf,
+                   get_psnr(s->mse, s->nb_frames, s->max),
+                   get_psnr(s->max_mse, 1, s->max),
+                   get_psnr(s->min_mse, 1, s->max));
+        }
+
+        if (s->metrics & METRIC_SSIM) {
+            buf[0] = 0;
+            for (int c = 0; c < s->nb_components; c++)
+                av_strlcatf(buf, sizeof(buf), " %c:%f (%f)", s->comps[c],
+                            s->ssim[c] / s->nb_frames, ssim_db(s->ssim[c], s->nb_frames));
+            av_log(ctx, AV_LOG_INFO, "SSIM%s All:%f (%f)\n", buf,
+                   s->ssim_total / s->nb_frames, ssim_db(s->ssim_total, s->nb_frames));
+        }
+
+        if (s->metrics & METRIC_MOTION)
+            av_log(ctx, AV_LOG_INFO, "VMAF Motion avg: %.3f\n",
+                   s->motion_sum / s->nb_frames);
+    }
+
+    ff_framesync_uninit(&s->fs);
+
+    for (int t = 0; t < s->nb_threads && s->temp; t++)
+        av_freep(&s->temp[t]);
+    av_freep(&s->temp);
+    av_freep(&s->score);
+    av_freep(&s->blur[0]);
+    av_freep(&s->blur[1]);
+}
+
+static const AVFilterPad qualitymetrics_inputs[] = {
+    {
+        .name         = "main",
+        .type         = AVMEDIA_TYPE_VIDEO,
+    },{
+        .name         = "reference",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input_ref,
+    },
+};
+
+static const AVFilterPad qualitymetrics_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_output,
+    },
+};
+
+const AVFilter ff_vf_qualitymetrics = {
+    .name          = "qualitymetrics",
+    .description   = NULL_IF_CONFIG_SMALL("Calculate PSNR, SSIM and VMAF motion between two video streams."),
+    .preinit       = qualitymetrics_framesync_preinit,
+    .init          = init,
+    .uninit        = uninit,
+    .activate      = activate,
+    .priv_size     = sizeof(QualityMetricsContext),
+    .priv_class    = &qualitymetrics_class,
+    FILTER_INPUTS(qualitymetrics_inputs),
+    FILTER_OUTPUTS(qualitymetrics_outputs),
+    FILTER_PIXFMTS_ARRAY(pix_fmts),
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS             |
+                     AVFILTER_FLAG_METADATA_ONLY,
+};
@@ -91,134 +91,6 @@ static void set_meta(AVDictionary **metadata, const char *key, char comp, float
     }
 }
 
-static void ssim_4x4xn_16bit(const uint8_t *main8, ptrdiff_t main_stride,
-                             const uint8_t *ref8, ptrdiff_t ref_stride,
-                             int64_t (*sums)[4], int width)
-{
-    const uint16_t *main16 = (const uint16_t *)main8;
-    const uint16_t *ref16  = (const uint16_t *)ref8;
-    int x, y, z;
-
-    main_stride >>= 1;
-    ref_stride >>= 1;
-
-    for (z = 0; z < width; z++) {
-        uint64_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
-
-        for (y = 0; y < 4; y++) {
-            for (x = 0; x < 4; x++) {
-                unsigned a = main16[x + y * main_stride];
-                unsigned b = ref16[x + y * ref_stride];
-
-                s1  += a;
-                s2  += b;
-                ss  += a*a;
-                ss  += b*b;
-                s12 += a*b;
-            }
-        }
-
-        sums[z][0] = s1;
-        sums[z][1] = s2;
-        sums[z][2] = ss;
-        sums[z][3] = s12;
-        main16 += 4;
-        ref16 += 4;
-    }
-}
-
-static void ssim_4x4xn_8bit(const uint8_t *main, ptrdiff_t main_stride,
-                            const uint8_t *ref, ptrdiff_t ref_stride,
-                            int (*sums)[4], int width)
-{
-    int x, y, z;
-
-    for (z = 0; z < width; z++) {
-        uint32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
-
-        for (y = 0; y < 4; y++) {
-            for (x = 0; x < 4; x++) {
-                int a = main[x + y * main_stride];
-                int b = ref[x + y * ref_stride];
-
-                s1  += a;
-                s2  += b;
-                ss  += a*a;
-                ss  += b*b;
-                s12 += a*b;
-            }
-        }
-
-        sums[z][0] = s1;
-        sums[z][1] = s2;
-        sums[z][2] = ss;
-        sums[z][3] = s12;
-        main += 4;
-        ref += 4;
-    }
-}
-
-static float ssim_end1x(int64_t s1, int64_t s2, int64_t ss, int64_t s12, int max)
-{
-    int64_t ssim_c1 = (int64_t)(.01*.01*max*max*64 + .5);
-    int64_t ssim_c2 = (int64_t)(.03*.03*max*max*64*63 + .5);
-
-    int64_t fs1 = s1;
-    int64_t fs2 = s2;
-    int64_t fss = ss;
-    int64_t fs12 = s12;
-    int64_t vars = fss * 64 - fs1 * fs1 - fs2 * fs2;
-    int64_t covar = fs12 * 64 - fs1 * fs2;
-
-    return (float)(2 * fs1 * fs2 + ssim_c1) * (float)(2 * covar + ssim_c2)
-         / ((float)(fs1 * fs1 + fs2 * fs2 + ssim_c1) * (float)(vars + ssim_c2));
-}
-
-static float ssim_end1(int s1, int s2, int ss, int s12)
-{
-    static const int ssim_c1 = (int)(.01*.01*255*255*64 + .5);
-    static const int ssim_c2 = (int)(.03*.03*255*255*64*63 + .5);
-
-    int fs1 = s1;
-    int fs2 = s2;
-    int fss = ss;
-    int fs12 = s12;
-    int vars = fss * 64 - fs1 * fs1 - fs2 * fs2;
-    int covar = fs12 * 64 - fs1 * fs2;
-
-    return (float)(2 * fs1 * fs2 + ssim_c1) * (float)(2 * covar + ssim_c2)
-         / ((float)(fs1 * fs1 + fs2 * fs2 + ssim_c1) * (float)(vars + ssim_c2));
-}
-
-static float ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4], int width, int max)
-{
-    float ssim = 0.0;
-    int i;
-
-    for (i = 0; i < width; i++)
-        ssim += ssim_end1x(sum0[i][0] + sum0[i + 1][0] + sum1[i][0] + sum1[i + 1][0],
-                           sum0[i][1] + sum0[i + 1][1] + sum1[i][1] + sum1[i + 1][1],
-                           sum0[i][2] + sum0[i + 1][2] + sum1[i][2] + sum1[i + 1][2],
-                           sum0[i][3] + sum0[i + 1][3] + sum1[i][3] + sum1[i + 1][3],
-                           max);
-    return ssim;
-}
-
-static double ssim_endn_8bit(const int (*sum0)[4], const int (*sum1)[4], int width)
-{
-    double ssim = 0.0;
-    int i;
-
-    for (i = 0; i < width; i++)
-        ssim += ssim_end1(sum0[i][0] + sum0[i + 1][0] + sum1[i][0] + sum1[i + 1][0],
-                          sum0[i][1] + sum0[i + 1][1] + sum1[i][1] + sum1[i + 1][1],
-                          sum0[i][2] + sum0[i + 1][2] + sum1[i][2] + sum1[i + 1][2],
-                          sum0[i][3] + sum0[i + 1][3] + sum1[i][3] + sum1[i + 1][3]);
-    return ssim;
-}
-
-#define SUM_LEN(w) (((w) >> 2) + 3)
-
 typedef struct ThreadData {
     const uint8_t *main_data[4];
     const uint8_t *ref_data[4];
@@ -254,7 +126,7 @@ static int ssim_plane_16bit(AVFilterContext *ctx, void *arg,
         int z = ystart - 1;
         double ssim = 0.0;
         int64_t (*sum0)[4] = temp;
-        int64_t (*sum1)[4] = sum0 + SUM_LEN(width);
+        int64_t (*sum1)[4] = sum0 + SSIM_SUM_LEN(width);
 
         width >>= 2;
         height >>= 2;
@@ -262,12 +134,12 @@ static int ssim_plane_16bit(AVFilterContext *ctx, void *arg,
         for (int y = ystart; y < slice_end; y++) {
             for (; z <= y; z++) {
                 FFSWAP(void*, sum0, sum1);
-                ssim_4x4xn_16bit(&main_data[4 * z * main_stride], main_stride,
+                ff_ssim_4x4xn_16bit(&main_data[4 * z * main_stride], main_stride,
                                  &ref_data[4 * z * ref_stride], ref_stride,
                                  sum0, width);
             }
 
-            ssim += ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
+            ssim += ff_ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
         }
 
         score[c] = ssim;
@@ -297,7 +169,7 @@ static int ssim_plane(AVFilterContext *ctx, void *arg,
         int z = ystart - 1;
         double ssim = 0.0;
         int (*sum0)[4] = temp;
-        int (*sum1)[4] = sum0 + SUM_LEN(width);
+        int (*sum1)[4] = sum0 + SSIM_SUM_LEN(width);
 
         width >>= 2;
         height >>= 2;
@@ -475,18 +347,14 @@ static int config_input_ref(AVFilterLink *inlink)
         return AVERROR(ENOMEM);
 
     for (int t = 0; t < s->nb_threads; t++) {
-        s->temp[t] = av_calloc(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
+        s->temp[t] = av_calloc(2 * SSIM_SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
         if (!s->temp[t])
             return AVERROR(ENOMEM);
     }
     s->max = (1 << desc->comp[0].depth) - 1;
 
     s->ssim_plane = desc->comp[0].depth > 8 ? ssim_plane_16bit : ssim_plane;
-    s->dsp.ssim_4x4_line = ssim_4x4xn_8bit;
-    s->dsp.ssim_end_line = ssim_endn_8bit;
-#if ARCH_X86
-    ff_ssim_init_x86(&s->dsp);
-#endif
+    ff_ssim_init(&s->dsp);
 
     s->score = av_calloc(s->nb_threads, sizeof(*s->score));
     if (!s->score)
@@ -38,6 +38,7 @@
 #endif
 #include "libavutil/avstring.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
 #include "drawutils.h"
@@ -48,6 +49,13 @@
 
 #define FF_ASS_FEATURE_WRAP_UNICODE     (LIBASS_VERSION >= 0x01600010)
 
+/* blend parameters of one rendered image, derived with the image list */
+typedef struct AssImageCache {
+    FFDrawColor color;
+    int mx, my;                ///< offset of the blended box in the bitmap
+    int w, h;                  ///< size of the blended box, 0 if fully transparent
+} AssImageCache;
+
 typedef struct AssContext {
     const AVClass *class;
     ASS_Library  *library;
@@ -65,6 +73,14 @@ typedef struct AssContext {
     int shaping;
     FFDrawContext draw;
     int wrap_unicode;
+
+    /* state derived from the last rendered image list, reused as long as
+     * libass reports no change */
+    int cache_valid;
+    AssImageCache *images;     ///< blend parameters of each image
+    unsigned int images_size;
+    int nb_images;
+    int ymin, ymax;            ///< vertical extent covered by the images
 } AssContext;
 
 #define OFFSET(x) offsetof(AssContext, x)
@@ -137,6 +153,7 @@ static av_cold void uninit(AVFilterContext *ctx)
         ass_renderer_done(ass->renderer);
     if (ass->library)
         ass_library_done(ass->library);
+    av_freep(&ass->images);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -170,19 +187,138 @@ static int config_input(AVFilterLink *inlink)
 #define AB(c)  (((c)>>8) &0xFF)
 #define AA(c)  ((0xFF-(c)) &0xFF)
 
-static void overlay_ass_image(AssContext *ass, AVFrame *picref,
+/* Find the box of the image that holds all its non-zero mask values, grown
+ * to whole blocks of the chroma subsampling of the frame: the blocks left out
+ * are fully transparent, and blending them would leave the pixels unchanged. */
+static void trim_image(const AssContext *ass, const ASS_Image *img, AssImageCache *cache)
+{
+    const int halign = 1 << ass->draw.hsub_max;
+    const int valign = 1 << ass->draw.vsub_max;
+    int left = img->w, right = 0, top = img->h, bottom = 0;
+    int x0, x1, y0, y1;
+
+    for (int y = 0; y < img->h; y++) {
+        const uint8_t *row = img->bitmap + y * img->stride;
+        int l = 0, r = img->w;
+
+        while (l < r && !row[l])
+            l++;
+        if (l == r)
+            continue;
+        while (!row[r - 1])
+            r--;
+        left   = FFMIN(left, l);
+        right  = FFMAX(right, r);
+        top    = FFMIN(top, y);
+        bottom = y + 1;
+    }
+
+    if (left >= right) {
+        cache->w = cache->h = 0;
+        return;
+    }
+
+    x0 = FFMAX((img->dst_x + left) & ~(halign - 1), img->dst_x);
+    x1 = FFMIN((img->dst_x + right + halign - 1) & ~(halign - 1), img->dst_x + img->w);
+    y0 = FFMAX((img->dst_y + top) & ~(valign - 1), img->dst_y);
+    y1 = FFMIN((img->dst_y + bottom + valign - 1) & ~(valign - 1), img->dst_y + img->h);
+    cache->mx = x0 - img->dst_x;
+    cache->my = y0 - img->dst_y;
+    cache->w  = x1 - x0;
+    cache->h  = y1 - y0;
+}
+
+static int update_image_cache(AssContext *ass, const AVFrame *picref,
                               const ASS_Image *image)
 {
-    for (; image; image = image->next) {
-        uint8_t rgba_color[] = {AR(image->color), AG(image->color), AB(image->color), AA(image->color)};
-        FFDrawColor color;
-        ff_draw_color(&ass->draw, &color, rgba_color);
-        ff_blend_mask(&ass->draw, &color,
-                      picref->data, picref->linesize,
-                      picref->width, picref->height,
-                      image->bitmap, image->stride, image->w, image->h,
-                      3, 0, image->dst_x, image->dst_y);
+    const ASS_Image *img;
+    AssImageCache *cache;
+    int nb_images = 0;
+
+    for (img = image; img; img = img->next)
+        nb_images++;
+
+    cache = av_fast_realloc(ass->images, &ass->images_size,
+                            FFMAX(nb_images, 1) * sizeof(*cache));
+    if (!cache)
+        return AVERROR(ENOMEM);
+    ass->images = cache;
+
+    ass->ymin = picref->height;
+    ass->ymax = 0;
+    for (img = image; img; img = img->next, cache++) {
+        uint8_t rgba_color[] = {AR(img->color), AG(img->color), AB(img->color), AA(img->color)};
+        ff_draw_color(&ass->draw, &cache->color, rgba_color);
+        trim_image(ass, img, cache);
+        if (!cache->w || !cache->color.rgba[3])
+            continue;
+        ass->ymin = FFMIN(ass->ymin, FFMAX(img->dst_y + cache->my, 0));
+        ass->ymax = FFMAX(ass->ymax, FFMIN(img->dst_y + cache->my + cache->h, picref->height));
     }
+    ass->nb_images   = nb_images;
+    ass->cache_valid = 1;
+
+    return 0;
+}
+
+typedef struct ThreadData {
+    AVFrame *picref;
+    const ASS_Image *image;
+} ThreadData;
+
+/* Blend all images over one horizontal band of the frame. The bands are
+ * aligned on the chroma subsampling so that every chroma sample is blended
+ * by a single job, which keeps the result identical to a whole-frame blend. */
+static int overlay_ass_image_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AssContext *ass = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *picref = td->picref;
+    const int align = 1 << ass->draw.vsub_max;
+    const int start = ass->ymin & ~(align - 1);
+    const int nb_units = (ass->ymax - start + align - 1) / align;
+    const int slice_start = start + (nb_units *  jobnr     ) / nb_jobs * align;
+    const int slice_end   = FFMIN(start + (nb_units * (jobnr + 1)) / nb_jobs * align,
+                                  picref->height);
+    uint8_t *data[4] = { NULL };
+    const ASS_Image *image;
+    AssImageCache *cache = ass->images;
+
+    if (slice_end <= slice_start)
+        return 0;
+
+    for (int plane = 0; plane < ass->draw.nb_planes; plane++)
+        data[plane] = picref->data[plane] +
+                      (slice_start >> ass->draw.vsub[plane]) * picref->linesize[plane];
+
+    for (image = td->image; image; image = image->next, cache++) {
+        if (!cache->w)
+            continue;
+        ff_blend_mask(&ass->draw, &cache->color,
+                      data, picref->linesize,
+                      picref->width, slice_end - slice_start,
+                      image->bitmap + cache->my * image->stride + cache->mx,
+                      image->stride, cache->w, cache->h, 3, 0,
+                      image->dst_x + cache->mx, image->dst_y + cache->my - slice_start);
+    }
+
+    return 0;
+}
+
+static void overlay_ass_image(AVFilterContext *ctx, AVFrame *picref,
+                              const ASS_Image *image)
+{
+    AssContext *ass = ctx->priv;
+    ThreadData td = { .picref = picref, .image = image };
+    const int align = 1 << ass->draw.vsub_max;
+    int nb_jobs;
+
+    if (!image || ass->ymax <= ass->ymin)
+        return;
+
+    nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx),
+                    (ass->ymax - (ass->ymin & ~(align - 1)) + align - 1) / align);
+    ff_filter_execute(ctx, overlay_ass_image_slice, &td, NULL, FFMAX(nb_jobs, 1));
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
@@ -198,7 +334,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
     if (detect_change)
         av_log(ctx, AV_LOG_DEBUG, "Change happened at time ms:%f\n", time_ms);
 
-    overlay_ass_image(ass, picref, image);
+    /* colors and blended boxes only depend on the image list, which libass
+     * guarantees to be identical to the previous one when nothing changed */
+    if (detect_change || !ass->cache_valid) {
+        int ret = update_image_cache(ass, picref, image);
+        if (ret < 0) {
+            av_frame_free(&picref);
+            return ret;
+        }
+    }
+
+    overlay_ass_image(ctx, picref, image);
 
     return ff_filter_frame(outlink, picref);
 }
@@ -257,6 +403,7 @@ const AVFilter ff_vf_ass = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &ass_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif
 
@@ -512,5 +659,6 @@ const AVFilter ff_vf_subtitles = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &subtitles_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif
@@ -33,15 +33,7 @@
 #include "video.h"
 #include "vmaf_motion.h"
 
-#define BIT_SHIFT 15
-
-static const float FILTER_5[5] = {
-    0.054488685,
-    0.244201342,
-    0.402619947,
-    0.244201342,
-    0.054488685
-};
+#define BIT_SHIFT VMAF_MOTION_BIT_SHIFT
 
 typedef struct VMAFMotionContext {
     const AVClass *class;
@@ -60,133 +52,6 @@ static const AVOption vmafmotion_options[] = {
 
 AVFILTER_DEFINE_CLASS(vmafmotion);
 
-static uint64_t image_sad(const uint16_t *img1, const uint16_t *img2, int w,
-                          int h, ptrdiff_t _img1_stride, ptrdiff_t _img2_stride)
-{
-    ptrdiff_t img1_stride = _img1_stride / sizeof(*img1);
-    ptrdiff_t img2_stride = _img2_stride / sizeof(*img2);
-    uint64_t sum = 0;
-    int i, j;
-
-    for (i = 0; i < h; i++) {
-        for (j = 0; j < w; j++) {
-            sum += abs(img1[j] - img2[j]);
-        }
-        img1 += img1_stride;
-        img2 += img2_stride;
-    }
-
-    return sum;
-}
-
-static void convolution_x(const uint16_t *filter, int filt_w, const uint16_t *src,
-                          uint16_t *dst, int w, int h, ptrdiff_t _src_stride,
-                          ptrdiff_t _dst_stride)
-{
-    ptrdiff_t src_stride = _src_stride / sizeof(*src);
-    ptrdiff_t dst_stride = _dst_stride / sizeof(*dst);
-    int radius = filt_w / 2;
-    int borders_left = radius;
-    int borders_right = w - (filt_w - radius);
-    int i, j, k;
-    int sum = 0;
-
-    for (i = 0; i < h; i++) {
-        for (j = 0; j < borders_left; j++) {
-            sum = 0;
-            for (k = 0; k < filt_w; k++) {
-                int j_tap = FFABS(j - radius + k);
-                if (j_tap >= w) {
-                    j_tap = w - (j_tap - w + 1);
-                }
-                sum += filter[k] * src[i * src_stride + j_tap];
-            }
-            dst[i * dst_stride + j] = sum >> BIT_SHIFT;
-        }
-
-        for (j = borders_left; j < borders_right; j++) {
-            int sum = 0;
-            for (k = 0; k < filt_w; k++) {
-                sum += filter[k] * src[i * src_stride + j - radius + k];
-            }
-            dst[i * dst_stride + j] = sum >> BIT_SHIFT;
-        }
-
-        for (j = borders_right; j < w; j++) {
-            sum = 0;
-            for (k = 0; k < filt_w; k++) {
-                int j_tap = FFABS(j - radius + k);
-                if (j_tap >= w) {
-                    j_tap = w - (j_tap - w + 1);
-                }
-                sum += filter[k] * src[i * src_stride + j_tap];
-            }
-            dst[i * dst_stride + j] = sum >> BIT_SHIFT;
-        }
-    }
-}
-
-#define conv_y_fn(type, bits) \
-static void convolution_y_##bits##bit(const uint16_t *filter, int filt_w, \
-                                      const uint8_t *_src, uint16_t *dst, \
-                                      int w, int h, ptrdiff_t _src_stride, \
-                                      ptrdiff_t _dst_stride) \
-{ \
-    const type *src = (const type *) _src; \
-    ptrdiff_t src_stride = _src_stride / sizeof(*src); \
-    ptrdiff_t dst_stride = _dst_stride / sizeof(*dst); \
-    int radius = filt_w / 2; \
-    int borders_top = radius; \
-    int borders_bottom = h - (filt_w - radius); \
-    int i, j, k; \
-    int sum = 0; \
-    \
-    for (i = 0; i < borders_top; i++) { \
-        for (j = 0; j < w; j++) { \
-            sum = 0; \
-            for (k = 0; k < filt_w; k++) { \
-                int i_tap = FFABS(i - radius + k); \
-                if (i_tap >= h) { \
-                    i_tap = h - (i_tap - h + 1); \
-                } \
-                sum += filter[k] * src[i_tap * src_stride + j]; \
-            } \
-            dst[i * dst_stride + j] = sum >> bits; \
-        } \
-    } \
-    for (i = borders_top; i < borders_bottom; i++) { \
-        for (j = 0; j < w; j++) { \
-            sum = 0; \
-            for (k = 0; k < filt_w; k++) { \
-                sum += filter[k] * src[(i - radius + k) * src_stride + j]; \
-            } \
-            dst[i * dst_stride + j] = sum >> bits; \
-        } \
-    } \
-    for (i = borders_bottom; i < h; i++) { \
-        for (j = 0; j < w; j++) { \
-            sum = 0; \
-            for (k = 0; k < filt_w; k++) { \
-                int i_tap = FFABS(i - radius + k); \
-                if (i_tap >= h) { \
-                    i_tap = h - (i_tap - h + 1); \
-                } \
-                sum += filter[k] * src[i_tap * src_stride + j]; \
-            } \
-            dst[i * dst_stride + j] = sum >> bits; \
-        } \
-    } \
-}
-
-conv_y_fn(uint8_t, 8)
-conv_y_fn(uint16_t, 10)
-
-static void vmafmotiondsp_init(VMAFMotionDSPContext *dsp, int bpp) {
-    dsp->convolution_x = convolution_x;
-    dsp->convolution_y = bpp == 10 ? convolution_y_10bit : convolution_y_8bit;
-    dsp->sad = image_sad;
-}
-
 double ff_vmafmotion_process(VMAFMotionData *s, AVFrame *ref)
 {
     double score;
@@ -237,7 +102,6 @@ int ff_vmafmotion_init(VMAFMotionData *s,
                        int w, int h, enum AVPixelFormat fmt)
 {
     size_t data_sz;
-    int i;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
 
     if (w < 3 || h < 3)
@@ -254,11 +118,7 @@ int ff_vmafmotion_init(VMAFMotionData *s,
         return AVERROR(ENOMEM);
     }
 
-    for (i = 0; i < 5; i++) {
-        s->filter[i] = lrint(FILTER_5[i] * (1 << BIT_SHIFT));
-    }
-
-    vmafmotiondsp_init(&s->vmafdsp, desc->comp[0].depth);
+    ff_vmafmotion_init_dsp(&s->vmafdsp, s->filter, desc->comp[0].depth);
 
     return 0;
 }
@@ -21,6 +21,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/common.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
@@ -269,6 +270,29 @@ static void filter16_scale(uint8_t *out_pixel8, const int32_t *work_pixel, int l
         *out_pixel = av_clip(*work_pixel, 0, max) >> 15;
 }
 
+av_cold void ff_w3fdif_init(W3FDIFDSPContext *dsp, int depth)
+{
+    if (depth <= 8) {
+        dsp->filter_simple_low   = filter_simple_low;
+        dsp->filter_complex_low  = filter_complex_low;
+        dsp->filter_simple_high  = filter_simple_high;
+        dsp->filter_complex_high = filter_complex_high;
+        dsp->filter_scale        = filter_scale;
+    } else {
+        dsp->filter_simple_low   = filter16_simple_low;
+        dsp->filter_complex_low  = filter16_complex_low;
+        dsp->filter_simple_high  = filter16_simple_high;
+        dsp->filter_complex_high = filter16_complex_high;
+        dsp->filter_scale        = filter16_scale;
+    }
+
+#if ARCH_X86
+    ff_w3fdif_init_x86(dsp, depth);
+#elif ARCH_AARCH64
+    ff_w3fdif_init_aarch64(dsp, depth);
+#endif
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -302,23 +326,7 @@ static int config_input(AVFilterLink *inlink)
 
     depth = desc->comp[0].depth;
     s->max = ((1 << depth) - 1) * 256 * 128;
-    if (depth <= 8) {
-        s->dsp.filter_simple_low   = filter_simple_low;
-        s->dsp.filter_complex_low  = filter_complex_low;
-        s->dsp.filter_simple_high  = filter_simple_high;
-        s->dsp.filter_complex_high = filter_complex_high;
-        s->dsp.filter_scale        = filter_scale;
-    } else {
-        s->dsp.filter_simple_low   = filter16_simple_low;
-        s->dsp.filter_complex_low  = filter16_complex_low;
-        s->dsp.filter_simple_high  = filter16_simple_high;
-        s->dsp.filter_complex_high = filter16_complex_high;
-        s->dsp.filter_scale        = filter16_scale;
-    }
-
-#if ARCH_X86
-    ff_w3fdif_init_x86(&s->dsp, depth);
-#endif
+    ff_w3fdif_init(&s->dsp, depth);
 
     return 0;
 }
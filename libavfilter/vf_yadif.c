@@ -19,6 +19,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/common.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
@@ -279,6 +280,23 @@ static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_NONE
 };
 
+av_cold void ff_yadif_init_filter_line(YADIFContext *yadif)
+{
+    if (yadif->csp->comp[0].depth > 8) {
+        yadif->filter_line  = filter_line_c_16bit;
+        yadif->filter_edges = filter_edges_16bit;
+    } else {
+        yadif->filter_line  = filter_line_c;
+        yadif->filter_edges = filter_edges;
+    }
+
+#if ARCH_X86
+    ff_yadif_init_x86(yadif);
+#elif ARCH_AARCH64
+    ff_yadif_init_aarch64(yadif);
+#endif
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -308,17 +326,7 @@ static int config_output(AVFilterLink *outlink)
 
     s->csp = av_pix_fmt_desc_get(outlink->format);
     s->filter = filter;
-    if (s->csp->comp[0].depth > 8) {
-        s->filter_line  = filter_line_c_16bit;
-        s->filter_edges = filter_edges_16bit;
-    } else {
-        s->filter_line  = filter_line_c;
-        s->filter_edges = filter_edges;
-    }
-
-#if ARCH_X86
-    ff_yadif_init_x86(s);
-#endif
+    ff_yadif_init_filter_line(s);
 
     return 0;
 }
@@ -18,13 +18,18 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <math.h>
+
+#include "libavutil/attributes.h"
 #include "libavutil/eval.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "internal.h"
 #include "video.h"
+#include "zoompan.h"
 #include "libswscale/swscale.h"
 
 static const char *const var_names[] = {
@@ -75,6 +80,29 @@ enum var_name {
     VARS_NB
 };
 
+enum InterpMethod {
+    INTERP_BICUBIC,
+    INTERP_SWS,
+    NB_INTERP
+};
+
+#define COEFF_BITS ZOOMPAN_COEFF_BITS
+
+/**
+ * Separable resampling filter for one direction of one plane: output
+ * sample i is the sum over k < taps of coeffs[i * stride + k] *
+ * src[offset + pos[i] + k], with offset + pos[i] + taps always inside the
+ * source plane. stride is taps rounded up to a multiple of 4, the extra
+ * coefficients are 0.
+ */
+typedef struct ZPFilter {
+    int taps, stride;
+    int offset;
+    int *pos;
+    int16_t *coeffs;
+    unsigned pos_size, coeffs_size;
+} ZPFilter;
+
 typedef struct ZPcontext {
     const AVClass *class;
     char *zoom_expr_str;
@@ -88,7 +116,16 @@ typedef struct ZPcontext {
     double x, y;
     double prev_zoom;
     int prev_nb_frames;
+    int interp;
     struct SwsContext *sws;
+    ZPFilter hfilter[2], vfilter[2];   ///< luma/alpha and chroma filters
+    double *fscratch;
+    unsigned fscratch_size;
+    int16_t *tmp;                      ///< one intermediate row per job
+    int tmp_size;                      ///< size of one row of tmp
+    unsigned tmp_alloc;
+    int nb_jobs;
+    ZoompanDSPContext dsp;
     int64_t frame_count;
     const AVPixFmtDescriptor *desc;
     AVFrame *in;
@@ -109,16 +146,78 @@ static const AVOption zoompan_options[] = {
     { "d", "set the duration expression", OFFSET(duration_expr_str), AV_OPT_TYPE_STRING, {.str="90"}, .flags = FLAGS },
     { "s", "set the output image size", OFFSET(w), AV_OPT_TYPE_IMAGE_SIZE, {.str="hd720"}, .flags = FLAGS },
     { "fps", "set the output framerate", OFFSET(framerate), AV_OPT_TYPE_VIDEO_RATE, { .str = "25" }, 0, INT_MAX, .flags = FLAGS },
+    { "interp", "set the interpolation method", OFFSET(interp), AV_OPT_TYPE_INT, {.i64=INTERP_SWS}, 0, NB_INTERP-1, FLAGS, "interp" },
+        { "bicubic", "sub-pixel bicubic",                    0, AV_OPT_TYPE_CONST, {.i64=INTERP_BICUBIC}, 0, 0, FLAGS, "interp" },
+        { "sws",     "libswscale bicubic on the pixel grid", 0, AV_OPT_TYPE_CONST, {.i64=INTERP_SWS},     0, 0, FLAGS, "interp" },
     { NULL }
 };
 
 AVFILTER_DEFINE_CLASS(zoompan);
 
+void ff_zoompan_vfilter_row_c(int16_t *dst, const uint8_t *src, ptrdiff_t linesize,
+                              const int16_t *coeffs, int taps, int width)
+{
+    /* the only tap count when zooming in; unrolled so that the compiler
+     * can vectorize over x */
+    if (taps == 4) {
+        const int c0 = coeffs[0], c1 = coeffs[1], c2 = coeffs[2], c3 = coeffs[3];
+        const uint8_t *s0 = src, *s1 = s0 + linesize, *s2 = s1 + linesize, *s3 = s2 + linesize;
+
+        for (int x = 0; x < width; x++) {
+            const int sum = c0 * s0[x] + c1 * s1[x] + c2 * s2[x] + c3 * s3[x];
+            dst[x] = (sum + (1 << (COEFF_BITS - 7))) >> (COEFF_BITS - 6);
+        }
+        return;
+    }
+
+    for (int x = 0; x < width; x++) {
+        int sum = 0;
+
+        for (int k = 0; k < taps; k++)
+            sum += coeffs[k] * src[k * linesize + x];
+        dst[x] = (sum + (1 << (COEFF_BITS - 7))) >> (COEFF_BITS - 6);
+    }
+}
+
+void ff_zoompan_hfilter_row_c(uint8_t *dst, const int16_t *src, const int *pos,
+                              const int16_t *coeffs, int taps, int width)
+{
+    if (taps == 4) {
+        for (int x = 0; x < width; x++) {
+            const int16_t *c = coeffs + x * 4;
+            const int16_t *t = src + pos[x];
+            const int sum = c[0] * t[0] + c[1] * t[1] + c[2] * t[2] + c[3] * t[3];
+            dst[x] = av_clip_uint8((sum + (1 << (COEFF_BITS + 5))) >> (COEFF_BITS + 6));
+        }
+        return;
+    }
+
+    for (int x = 0; x < width; x++) {
+        const int16_t *c = coeffs + x * taps;
+        const int16_t *t = src + pos[x];
+        int sum = 0;
+
+        for (int k = 0; k < taps; k++)
+            sum += c[k] * t[k];
+        dst[x] = av_clip_uint8((sum + (1 << (COEFF_BITS + 5))) >> (COEFF_BITS + 6));
+    }
+}
+
+av_cold void ff_zoompan_init(ZoompanDSPContext *dsp)
+{
+    dsp->vfilter_row = ff_zoompan_vfilter_row_c;
+    dsp->hfilter_row = ff_zoompan_hfilter_row_c;
+#if ARCH_X86
+    ff_zoompan_init_x86(dsp);
+#endif
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     ZPContext *s = ctx->priv;
 
     s->prev_zoom = 1;
+    ff_zoompan_init(&s->dsp);
     return 0;
 }
 
@@ -135,6 +234,8 @@ static int config_output(AVFilterLink *outlink)
     s->desc = av_pix_fmt_desc_get(outlink->format);
     s->finished = 1;
 
+    s->nb_jobs = FFMAX(1, FFMIN(outlink->h, ff_filter_get_nb_threads(ctx)));
+
     ret = av_expr_parse(&s->zoom_expr, s->zoom_expr_str, var_names, NULL, NULL, NULL, NULL, 0, ctx);
     if (ret < 0)
         return ret;
@@ -150,6 +251,147 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
+/* bicubic with B = 0, C = 0.6, the libswscale default */
+static double bicubic(double x)
+{
+    const double B = 0, C = 0.6;
+
+    x = fabs(x);
+    if (x < 1)
+        return ((12 - 9 * B - 6 * C) * x * x * x +
+                (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6;
+    if (x < 2)
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x +
+                (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6;
+    return 0;
+}
+
+/**
+ * Set up f to map the source interval [start, start + len) of a plane of
+ * src_size samples onto dst_size output samples. The kernel is widened when
+ * downscaling, and taps falling outside the plane are folded onto the edge.
+ */
+static int init_filter(ZPContext *s, ZPFilter *f, int dst_size, int src_size,
+                       double start, double len)
+{
+    const double scale = len / dst_size;
+    const double fs = FFMAX(scale, 1.0);
+    const int raw_taps = ceil(4 * fs);
+    const int taps = FFMIN(raw_taps, src_size);
+    const int stride = FFALIGN(taps, 4);
+    double *w;
+
+    av_fast_malloc(&f->pos, &f->pos_size, dst_size * sizeof(*f->pos));
+    av_fast_malloc(&f->coeffs, &f->coeffs_size, dst_size * stride * sizeof(*f->coeffs));
+    av_fast_malloc(&s->fscratch, &s->fscratch_size, taps * sizeof(*s->fscratch));
+    if (!f->pos || !f->coeffs || !s->fscratch)
+        return AVERROR(ENOMEM);
+    f->taps   = taps;
+    f->stride = stride;
+    w = s->fscratch;
+
+    for (int i = 0; i < dst_size; i++) {
+        const double center = start + (i + 0.5) * scale - 0.5;
+        const int first = floor(center - 2 * fs) + 1;
+        const int pos = av_clip(first, 0, src_size - taps);
+        int16_t *coeffs = f->coeffs + i * stride;
+        double sum = 0;
+        int isum = 0, max = 0;
+
+        for (int k = 0; k < taps; k++)
+            w[k] = 0;
+        for (int k = 0; k < raw_taps; k++) {
+            const double v = bicubic((first + k - center) / fs);
+            w[av_clip(first + k, 0, src_size - 1) - pos] += v;
+            sum += v;
+        }
+        for (int k = 0; k < taps; k++) {
+            coeffs[k] = lrint(w[k] / sum * (1 << COEFF_BITS));
+            isum += coeffs[k];
+            if (coeffs[k] > coeffs[max])
+                max = k;
+        }
+        for (int k = taps; k < stride; k++)
+            coeffs[k] = 0;
+        coeffs[max] += (1 << COEFF_BITS) - isum;
+        f->pos[i] = pos;
+    }
+
+    /* positions relative to the first one, so that the horizontal pass can
+     * index the intermediate row directly */
+    f->offset = f->pos[0];
+    for (int i = 0; i < dst_size; i++)
+        f->pos[i] -= f->offset;
+
+    return 0;
+}
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int resample_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ZPContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int16_t *tmp = s->tmp + jobnr * s->tmp_size;
+
+    for (int p = 0; p < s->desc->nb_components; p++) {
+        const int chroma = p == 1 || p == 2;
+        const ZPFilter *hf = &s->hfilter[chroma];
+        const ZPFilter *vf = &s->vfilter[chroma];
+        const int w = chroma ? AV_CEIL_RSHIFT(td->out->width,  s->desc->log2_chroma_w) : td->out->width;
+        const int h = chroma ? AV_CEIL_RSHIFT(td->out->height, s->desc->log2_chroma_h) : td->out->height;
+        const int slice_start = (h *  jobnr     ) / nb_jobs;
+        const int slice_end   = (h * (jobnr + 1)) / nb_jobs;
+        const ptrdiff_t src_linesize = td->in->linesize[p];
+        const uint8_t *src_plane = td->in->data[p] + vf->offset * src_linesize + hf->offset;
+        const int tmp_w = hf->pos[w - 1] + hf->taps;
+
+        for (int y = slice_start; y < slice_end; y++) {
+            const uint8_t *src = src_plane + vf->pos[y] * src_linesize;
+            uint8_t *dst = td->out->data[p] + y * td->out->linesize[p];
+
+            /* vertical pass over the columns used by the horizontal pass */
+            s->dsp.vfilter_row(tmp, src, src_linesize, vf->coeffs + y * vf->stride,
+                               vf->taps, tmp_w);
+            s->dsp.hfilter_row(dst, tmp, hf->pos, hf->coeffs, hf->stride, w);
+        }
+    }
+
+    return 0;
+}
+
+static int resample_bicubic(AVFilterContext *ctx, AVFrame *out, AVFrame *in,
+                            double zoom, double x, double y)
+{
+    ZPContext *s = ctx->priv;
+    const int cw = s->desc->log2_chroma_w, ch = s->desc->log2_chroma_h;
+    const double w = in->width / zoom, h = in->height / zoom;
+    /* the horizontal pass reads up to 3 zero weighted samples past the
+     * columns of the vertical pass */
+    const int tmp_size = FFALIGN(in->width + 3, 16);
+    ThreadData td = { .in = in, .out = out };
+    int ret;
+
+    /* sized from the current frame, the input size may change midstream */
+    av_fast_mallocz(&s->tmp, &s->tmp_alloc, s->nb_jobs * tmp_size * sizeof(*s->tmp));
+    if (!s->tmp)
+        return AVERROR(ENOMEM);
+    s->tmp_size = tmp_size;
+
+    if ((ret = init_filter(s, &s->hfilter[0], out->width, in->width, x, w)) < 0 ||
+        (ret = init_filter(s, &s->vfilter[0], out->height, in->height, y, h)) < 0 ||
+        (ret = init_filter(s, &s->hfilter[1], AV_CEIL_RSHIFT(out->width, cw),
+                           AV_CEIL_RSHIFT(in->width, cw), x / (1 << cw), w / (1 << cw))) < 0 ||
+        (ret = init_filter(s, &s->vfilter[1], AV_CEIL_RSHIFT(out->height, ch),
+                           AV_CEIL_RSHIFT(in->height, ch), y / (1 << ch), h / (1 << ch))) < 0)
+        return ret;
+
+    ff_filter_execute(ctx, resample_slice, &td, NULL, s->nb_jobs);
+    return 0;
+}
+
 static int output_single_frame(AVFilterContext *ctx, AVFrame *in, double *var_values, int i,
                                double *zoom, double *dx, double *dy)
 {
@@ -198,40 +440,36 @@ static int output_single_frame(AVFilterContext *ctx, AVFrame *in, double *var_va
         return ret;
     }
 
-    px[1] = px[2] = AV_CEIL_RSHIFT(x, s->desc->log2_chroma_w);
-    px[0] = px[3] = x;
-
-    py[1] = py[2] = AV_CEIL_RSHIFT(y, s->desc->log2_chroma_h);
-    py[0] = py[3] = y;
+    if (s->interp == INTERP_BICUBIC) {
+        if ((ret = resample_bicubic(ctx, out, in, *zoom, *dx, *dy)) < 0)
+            goto error;
+    } else {
+        px[1] = px[2] = AV_CEIL_RSHIFT(x, s->desc->log2_chroma_w);
+        px[0] = px[3] = x;
+
+        py[1] = py[2] = AV_CEIL_RSHIFT(y, s->desc->log2_chroma_h);
+        py[0] = py[3] = y;
+
+        for (k = 0; in->data[k]; k++)
+            input[k] = in->data[k] + py[k] * in->linesize[k] + px[k];
+
+        /* the crop offset is applied through the input pointers, so the
+         * context only needs to be rebuilt when the crop size changes */
+        s->sws = sws_getCachedContext(s->sws, w, h, in->format,
+                                      outlink->w, outlink->h, outlink->format,
+                                      SWS_BICUBIC, NULL, NULL, NULL);
+        if (!s->sws) {
+            ret = AVERROR(EINVAL);
+            goto error;
+        }
 
-    s->sws = sws_alloc_context();
-    if (!s->sws) {
-        ret = AVERROR(ENOMEM);
-        goto error;
+        sws_scale(s->sws, (const uint8_t *const *)&input, in->linesize, 0, h, out->data, out->linesize);
     }
 
-    for (k = 0; in->data[k]; k++)
-        input[k] = in->data[k] + py[k] * in->linesize[k] + px[k];
-
-    av_opt_set_int(s->sws, "srcw", w, 0);
-    av_opt_set_int(s->sws, "srch", h, 0);
-    av_opt_set_int(s->sws, "src_format", in->format, 0);
-    av_opt_set_int(s->sws, "dstw", outlink->w, 0);
-    av_opt_set_int(s->sws, "dsth", outlink->h, 0);
-    av_opt_set_int(s->sws, "dst_format", outlink->format, 0);
-    av_opt_set_int(s->sws, "sws_flags", SWS_BICUBIC, 0);
-
-    if ((ret = sws_init_context(s->sws, NULL, NULL)) < 0)
-        goto error;
-
-    sws_scale(s->sws, (const uint8_t *const *)&input, in->linesize, 0, h, out->data, out->linesize);
-
     out->pts = pts;
     s->frame_count++;
 
     ret = ff_filter_frame(outlink, out);
-    sws_freeContext(s->sws);
-    s->sws = NULL;
     s->current_frame++;
 
     if (s->current_frame >= s->nb_frames) {
@@ -249,8 +487,6 @@ static int output_single_frame(AVFilterContext *ctx, AVFrame *in, double *var_va
     }
     return ret;
 error:
-    sws_freeContext(s->sws);
-    s->sws = NULL;
     av_frame_free(&out);
     return ret;
 }
@@ -344,6 +580,14 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     sws_freeContext(s->sws);
     s->sws = NULL;
+    for (int i = 0; i < 2; i++) {
+        av_freep(&s->hfilter[i].pos);
+        av_freep(&s->hfilter[i].coeffs);
+        av_freep(&s->vfilter[i].pos);
+        av_freep(&s->vfilter[i].coeffs);
+    }
+    av_freep(&s->fscratch);
+    av_freep(&s->tmp);
     av_expr_free(s->x_expr);
     av_expr_free(s->y_expr);
     av_expr_free(s->zoom_expr);
@@ -369,4 +613,5 @@ const AVFilter ff_vf_zoompan = {
     FILTER_INPUTS(ff_video_default_filterpad),
     FILTER_OUTPUTS(outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
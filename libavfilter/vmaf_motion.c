@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2017 Ronald S. Bultje <rsbultje@gmail.com>
+ * Copyright (c) 2017 Ashish Pratap Singh <ashk43712@gmail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * VMAF motion functions shared by the vmafmotion and qualitymetrics filters
+ */
+
+#include <math.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "vmaf_motion.h"
+
+#define BIT_SHIFT VMAF_MOTION_BIT_SHIFT
+
+static const float FILTER_5[5] = {
+    0.054488685,
+    0.244201342,
+    0.402619947,
+    0.244201342,
+    0.054488685
+};
+
+static uint64_t image_sad(const uint16_t *img1, const uint16_t *img2, int w,
+                          int h, ptrdiff_t _img1_stride, ptrdiff_t _img2_stride)
+{
+    ptrdiff_t img1_stride = _img1_stride / sizeof(*img1);
+    ptrdiff_t img2_stride = _img2_stride / sizeof(*img2);
+    uint64_t sum = 0;
+    int i, j;
+
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < w; j++) {
+            sum += abs(img1[j] - img2[j]);
+        }
+        img1 += img1_stride;
+        img2 += img2_stride;
+    }
+
+    return sum;
+}
+
+static void convolution_x(const uint16_t *filter, int filt_w, const uint16_t *src,
+                          uint16_t *dst, int w, int h, ptrdiff_t _src_stride,
+                          ptrdiff_t _dst_stride)
+{
+    ptrdiff_t src_stride = _src_stride / sizeof(*src);
+    ptrdiff_t dst_stride = _dst_stride / sizeof(*dst);
+    int radius = filt_w / 2;
+    int borders_left = radius;
+    int borders_right = w - (filt_w - radius);
+    int i, j, k;
+    int sum = 0;
+
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < borders_left; j++) {
+            sum = 0;
+            for (k = 0; k < filt_w; k++) {
+                int j_tap = FFABS(j - radius + k);
+                if (j_tap >= w) {
+                    j_tap = w - (j_tap - w + 1);
+                }
+                sum += filter[k] * src[i * src_stride + j_tap];
+            }
+            dst[i * dst_stride + j] = sum >> BIT_SHIFT;
+        }
+
+        if (filt_w == 5) {
+            const uint16_t *s = src + i * src_stride - 2;
+            for (j = borders_left; j < borders_right; j++) {
+                int sum = filter[0] * s[j]     + filter[1] * s[j + 1] +
+                          filter[2] * s[j + 2] + filter[3] * s[j + 3] +
+                          filter[4] * s[j + 4];
+                dst[i * dst_stride + j] = sum >> BIT_SHIFT;
+            }
+        } else {
+            for (j = borders_left; j < borders_right; j++) {
+                int sum = 0;
+                for (k = 0; k < filt_w; k++) {
+                    sum += filter[k] * src[i * src_stride + j - radius + k];
+                }
+                dst[i * dst_stride + j] = sum >> BIT_SHIFT;
+            }
+        }
+
+        for (j = borders_right; j < w; j++) {
+            sum = 0;
+            for (k = 0; k < filt_w; k++) {
+                int j_tap = FFABS(j - radius + k);
+                if (j_tap >= w) {
+                    j_tap = w - (j_tap - w + 1);
+                }
+                sum += filter[k] * src[i * src_stride + j_tap];
+            }
+            dst[i * dst_stride + j] = sum >> BIT_SHIFT;
+        }
+    }
+}
+
+#define conv_y_fn(type, bits) \
+static void convolution_y_row_##bits##bit(const uint16_t *filter, int filt_w, \
+                                          const uint8_t *_src, uint16_t *dst, \
+                                          int w, int h, int i, \
+                                          ptrdiff_t _src_stride) \
+{ \
+    const type *src = (const type *) _src; \
+    ptrdiff_t src_stride = _src_stride / sizeof(*src); \
+    int radius = filt_w / 2; \
+    int j, k; \
+    \
+    if (filt_w == 5 && i >= 2 && i < h - 3) { \
+        const type *s0 = src + (i - 2) * src_stride, *s1 = s0 + src_stride; \
+        const type *s2 = s1 + src_stride, *s3 = s2 + src_stride; \
+        const type *s4 = s3 + src_stride; \
+        for (j = 0; j < w; j++) { \
+            int sum = filter[0] * s0[j] + filter[1] * s1[j] + filter[2] * s2[j] + \
+                      filter[3] * s3[j] + filter[4] * s4[j]; \
+            dst[j] = sum >> bits; \
+        } \
+        return; \
+    } \
+    if (i >= radius && i < h - (filt_w - radius)) { \
+        src += (i - radius) * src_stride; \
+        for (j = 0; j < w; j++) { \
+            int sum = 0; \
+            for (k = 0; k < filt_w; k++) \
+                sum += filter[k] * src[k * src_stride + j]; \
+            dst[j] = sum >> bits; \
+        } \
+        return; \
+    } \
+    for (j = 0; j < w; j++) { \
+        int sum = 0; \
+        for (k = 0; k < filt_w; k++) { \
+            int i_tap = FFABS(i - radius + k); \
+            if (i_tap >= h) { \
+                i_tap = h - (i_tap - h + 1); \
+            } \
+            sum += filter[k] * src[i_tap * src_stride + j]; \
+        } \
+        dst[j] = sum >> bits; \
+    } \
+} \
+\
+static void convolution_y_##bits##bit(const uint16_t *filter, int filt_w, \
+                                      const uint8_t *src, uint16_t *dst, \
+                                      int w, int h, ptrdiff_t src_stride, \
+                                      ptrdiff_t dst_stride) \
+{ \
+    for (int i = 0; i < h; i++) \
+        convolution_y_row_##bits##bit(filter, filt_w, src, \
+                                      dst + i * (dst_stride / sizeof(*dst)), \
+                                      w, h, i, src_stride); \
+}
+
+conv_y_fn(uint8_t, 8)
+conv_y_fn(uint16_t, 10)
+
+av_cold void ff_vmafmotion_init_dsp(VMAFMotionDSPContext *dsp, uint16_t *filter, int bpp)
+{
+    for (int i = 0; i < 5; i++)
+        filter[i] = lrint(FILTER_5[i] * (1 << BIT_SHIFT));
+
+    dsp->convolution_x = convolution_x;
+    dsp->convolution_y = bpp == 10 ? convolution_y_10bit : convolution_y_8bit;
+    dsp->convolution_y_row = bpp == 10 ? convolution_y_row_10bit : convolution_y_row_8bit;
+    dsp->sad = image_sad;
+}
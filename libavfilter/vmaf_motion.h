@@ -26,6 +26,9 @@
 #include <stdint.h>
 #include "video.h"
 
+/* fractional bits of the blur filter coefficients */
+#define VMAF_MOTION_BIT_SHIFT 15
+
 typedef struct VMAFMotionDSPContext {
     uint64_t (*sad)(const uint16_t *img1, const uint16_t *img2, int w, int h,
                     ptrdiff_t img1_stride, ptrdiff_t img2_stride);
@@ -35,8 +38,16 @@ typedef struct VMAFMotionDSPContext {
     void (*convolution_y)(const uint16_t *filter, int filt_w, const uint8_t *src,
                           uint16_t *dst, int w, int h, ptrdiff_t src_stride,
                           ptrdiff_t dst_stride);
+    /* row y of convolution_y() over the h rows at src */
+    void (*convolution_y_row)(const uint16_t *filter, int filt_w, const uint8_t *src,
+                              uint16_t *dst, int w, int h, int y, ptrdiff_t src_stride);
 } VMAFMotionDSPContext;
 
+/**
+ * Set the DSP functions for samples of bpp bits, and the 5 taps of the
+ * blur filter in filter.
+ */
+void ff_vmafmotion_init_dsp(VMAFMotionDSPContext *dsp, uint16_t *filter, int bpp);
 void ff_vmafmotion_init_x86(VMAFMotionDSPContext *dsp);
 
 typedef struct VMAFMotionData {
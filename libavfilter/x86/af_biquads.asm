@@ -0,0 +1,177 @@
+;******************************************************************************
+;* Biquad filters over interleaved channel lanes
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; A frame holds 8 lanes, so 32 bytes of floats or 64 bytes of doubles; the
+; passes filter mmsize bytes of the lanes of every frame in turn.
+%define FRAME_SIZE 32
+
+%if ARCH_X86_64
+
+; m0 = b0, m1 = b1, m2 = b2, m3 = -a1, m4 = -a2, m5 = wet, m6 = dry
+; %1 = SS or SD
+%macro LOAD_COEFFS 1
+%ifidn %1, SS
+%assign %%size 4
+%else
+%assign %%size 8
+%endif
+    VBROADCAST%1  m0, [coeffsq + 0*%%size]
+    VBROADCAST%1  m1, [coeffsq + 1*%%size]
+    VBROADCAST%1  m2, [coeffsq + 2*%%size]
+    VBROADCAST%1  m3, [coeffsq + 3*%%size]
+    VBROADCAST%1  m4, [coeffsq + 4*%%size]
+    VBROADCAST%1  m5, [coeffsq + 5*%%size]
+    VBROADCAST%1  m6, [coeffsq + 6*%%size]
+%endmacro
+
+; out = o0 * wet + in * dry, with o0 in m12 and in in m11
+; %1 = ps or pd
+%macro MIX_STORE 1
+    mul%1        m12, m5
+    mul%1        m11, m6
+    add%1        m12, m11
+    mova      [ptrq], m12
+%endmacro
+
+; %1 = byte offset of the lanes within the frame, %2 = frame size,
+; %3 = ps or pd
+%macro DI_PASS 3
+    mova          m7, [stateq + 0*%2 + %1]   ; i1
+    mova          m8, [stateq + 1*%2 + %1]   ; i2
+    mova          m9, [stateq + 2*%2 + %1]   ; o1
+    mova         m10, [stateq + 3*%2 + %1]   ; o2
+    lea         ptrq, [bufq + %1]
+    mov         cntq, lenq
+%%loop:
+    mova         m11, [ptrq]
+    mul%3        m12, m8, m2
+    mul%3        m13, m7, m1
+    add%3        m12, m13
+    mul%3        m13, m11, m0
+    add%3        m12, m13
+    mul%3        m13, m10, m4
+    add%3        m12, m13
+    mul%3        m13, m9, m3
+    add%3        m12, m13
+    mova          m8, m7
+    mova          m7, m11
+    mova         m10, m9
+    mova          m9, m12
+    MIX_STORE     %3
+    add         ptrq, %2
+    dec         cntq
+    jg %%loop
+    mova [stateq + 0*%2 + %1], m7
+    mova [stateq + 1*%2 + %1], m8
+    mova [stateq + 2*%2 + %1], m9
+    mova [stateq + 3*%2 + %1], m10
+%endmacro
+
+%macro TDII_PASS 1
+    mova          m7, [stateq + 0*FRAME_SIZE + %1]   ; w1
+    mova          m8, [stateq + 1*FRAME_SIZE + %1]   ; w2
+    lea         ptrq, [bufq + %1]
+    mov         cntq, lenq
+%%loop:
+    mova         m11, [ptrq]
+    mulps        m12, m11, m0
+    addps        m12, m7
+    mulps         m7, m11, m1
+    addps         m7, m8
+    mulps        m13, m12, m3
+    addps         m7, m13
+    mulps         m8, m11, m2
+    mulps        m13, m12, m4
+    addps         m8, m13
+    MIX_STORE     ps
+    add         ptrq, FRAME_SIZE
+    dec         cntq
+    jg %%loop
+    mova [stateq + 0*FRAME_SIZE + %1], m7
+    mova [stateq + 1*FRAME_SIZE + %1], m8
+%endmacro
+
+%macro BIQUAD_FUNCS 0
+;-----------------------------------------------------------------------------
+; void ff_biquad_di_flt(float *buf, const float *coeffs, float *state,
+;                       ptrdiff_t len)
+;-----------------------------------------------------------------------------
+cglobal biquad_di_flt, 4, 6, 14, buf, coeffs, state, len, ptr, cnt
+    test        lenq, lenq
+    jle .end
+    LOAD_COEFFS   SS
+    DI_PASS        0, FRAME_SIZE, ps
+%if mmsize == 16
+    DI_PASS       16, FRAME_SIZE, ps
+%endif
+.end:
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_biquad_tdii_flt(float *buf, const float *coeffs, float *state,
+;                         ptrdiff_t len)
+;-----------------------------------------------------------------------------
+cglobal biquad_tdii_flt, 4, 6, 14, buf, coeffs, state, len, ptr, cnt
+    test        lenq, lenq
+    jle .end
+    LOAD_COEFFS   SS
+    TDII_PASS      0
+%if mmsize == 16
+    TDII_PASS     16
+%endif
+.end:
+    RET
+%endmacro
+
+%macro BIQUAD_DBL_FUNCS 0
+;-----------------------------------------------------------------------------
+; void ff_biquad_di_dbl(double *buf, const double *coeffs, double *state,
+;                       ptrdiff_t len)
+;-----------------------------------------------------------------------------
+cglobal biquad_di_dbl, 4, 6, 14, buf, coeffs, state, len, ptr, cnt
+    test        lenq, lenq
+    jle .end
+    LOAD_COEFFS   SD
+%assign %%off 0
+%rep 2*FRAME_SIZE / mmsize
+    DI_PASS    %%off, 2*FRAME_SIZE, pd
+%assign %%off %%off + mmsize
+%endrep
+.end:
+    RET
+%endmacro
+
+INIT_XMM sse
+BIQUAD_FUNCS
+
+INIT_XMM sse2
+BIQUAD_DBL_FUNCS
+
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+BIQUAD_FUNCS
+BIQUAD_DBL_FUNCS
+%endif
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,282 @@
+;*****************************************************************************
+;* x86-optimized row kernels of the running sum box blurs
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_255: times 16 dw 255
+
+SECTION .text
+
+%if ARCH_X86_64
+
+;-----------------------------------------------------------------------------
+; void ff_boxblur_vblur_row(uint32_t *sum, uint8_t *dst, const uint8_t *srca,
+;                           const uint8_t *srcs, int inv, ptrdiff_t width)
+; width must be a non-zero multiple of 8 (sse2) or 16 (avx2)
+;-----------------------------------------------------------------------------
+%macro VBLUR_ROW 1 ; depth
+cglobal boxblur_vblur_row%1, 6, 6, 8, sum, dst, srca, srcs, inv, width
+%if %1 == 8
+    %define sumx sumq + 4*widthq
+%else
+    %define sumx sumq + 2*widthq
+%endif
+    movd          xm7, invd
+%if cpuflag(avx2)
+    vpbroadcastd   m7, xm7
+%else
+    pshuflw        m7, m7, 0
+    punpcklqdq     m7, m7
+    pxor           m6, m6
+%endif
+%if %1 == 16
+    add        widthq, widthq
+%endif
+    add          dstq, widthq
+    add         srcaq, widthq
+    add         srcsq, widthq
+    lea          sumq, [sumx]
+    neg        widthq
+.loop:
+%if cpuflag(avx2)
+%if %1 == 8
+    pmovzxbd       m0, [srcaq + widthq]
+    pmovzxbd       m1, [srcsq + widthq]
+    pmovzxbd       m2, [srcaq + widthq + 8]
+    pmovzxbd       m3, [srcsq + widthq + 8]
+%else
+    pmovzxwd       m0, [srcaq + widthq]
+    pmovzxwd       m1, [srcsq + widthq]
+    pmovzxwd       m2, [srcaq + widthq + 16]
+    pmovzxwd       m3, [srcsq + widthq + 16]
+%endif
+    psubd          m0, m1
+    psubd          m2, m3
+    pmulld         m0, m7
+    pmulld         m2, m7
+    movu           m1, [sumx]
+    movu           m3, [sumx + mmsize]
+    paddd          m0, m1
+    paddd          m2, m3
+    movu       [sumx], m0
+    movu [sumx + mmsize], m2
+    psrad          m0, 16
+    psrad          m2, 16
+    packssdw       m0, m2
+    vpermq         m0, m0, q3120
+%if %1 == 8
+    pand           m0, [pw_255]
+    vextracti128  xm1, m0, 1
+    packuswb      xm0, xm1
+    movu [dstq + widthq], xm0
+    add        widthq, 16
+%else
+    movu [dstq + widthq], m0
+    add        widthq, 32
+%endif
+%else ; sse2
+%if %1 == 8
+    movq           m0, [srcaq + widthq]
+    movq           m1, [srcsq + widthq]
+    punpcklbw      m0, m6
+    punpcklbw      m1, m6
+%else
+    movu           m0, [srcaq + widthq]
+    movu           m1, [srcsq + widthq]
+%endif
+    ; unsigned 16x16 -> 32 bit products, the difference wraps like the sum
+    pmulhuw        m2, m0, m7
+    pmullw         m0, m7
+    pmulhuw        m3, m1, m7
+    pmullw         m1, m7
+    punpckhwd      m4, m0, m2
+    punpcklwd      m0, m2
+    punpckhwd      m5, m1, m3
+    punpcklwd      m1, m3
+    psubd          m0, m1
+    psubd          m4, m5
+    movu           m1, [sumx]
+    movu           m5, [sumx + mmsize]
+    paddd          m0, m1
+    paddd          m4, m5
+    movu       [sumx], m0
+    movu [sumx + mmsize], m4
+    psrad          m0, 16
+    psrad          m4, 16
+    packssdw       m0, m4
+%if %1 == 8
+    pand           m0, [pw_255]
+    packuswb       m0, m0
+    movq [dstq + widthq], m0
+    add        widthq, 8
+%else
+    movu [dstq + widthq], m0
+    add        widthq, 16
+%endif
+%endif
+    jl .loop
+    RET
+%undef sumx
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_boxblur_update_col_sums8(int32_t *col_sum, const uint8_t *add,
+;                                  const uint8_t *sub, ptrdiff_t width)
+; width must be a non-zero multiple of 16
+;-----------------------------------------------------------------------------
+%macro UPDATE_COL_SUMS8 0
+cglobal boxblur_update_col_sums8, 4, 4, 6, sum, add, sub, width
+    add          addq, widthq
+    add          subq, widthq
+    lea          sumq, [sumq + 4*widthq]
+    neg        widthq
+%if notcpuflag(avx2)
+    pxor           m5, m5
+%endif
+.loop:
+%if cpuflag(avx2)
+    pmovzxbd       m0, [addq + widthq]
+    pmovzxbd       m2, [subq + widthq]
+    pmovzxbd       m1, [addq + widthq + 8]
+    pmovzxbd       m3, [subq + widthq + 8]
+    psubd          m0, m2
+    psubd          m1, m3
+    movu           m2, [sumq + 4*widthq]
+    movu           m3, [sumq + 4*widthq + 32]
+    paddd          m0, m2
+    paddd          m1, m3
+    movu [sumq + 4*widthq     ], m0
+    movu [sumq + 4*widthq + 32], m1
+%else
+    movu           m0, [addq + widthq]
+    movu           m2, [subq + widthq]
+    punpckhbw      m1, m0, m5
+    punpcklbw      m0, m5
+    punpckhbw      m3, m2, m5
+    punpcklbw      m2, m5
+    psubw          m0, m2
+    psubw          m1, m3
+    ; sign extend the word differences to dwords
+    punpcklwd      m2, m0, m0
+    punpckhwd      m0, m0
+    punpcklwd      m3, m1, m1
+    punpckhwd      m1, m1
+    psrad          m2, 16
+    psrad          m0, 16
+    psrad          m3, 16
+    psrad          m1, 16
+    movu           m4, [sumq + 4*widthq]
+    paddd          m2, m4
+    movu           m4, [sumq + 4*widthq + 16]
+    paddd          m0, m4
+    movu           m4, [sumq + 4*widthq + 32]
+    paddd          m3, m4
+    movu           m4, [sumq + 4*widthq + 48]
+    paddd          m1, m4
+    movu [sumq + 4*widthq     ], m2
+    movu [sumq + 4*widthq + 16], m0
+    movu [sumq + 4*widthq + 32], m3
+    movu [sumq + 4*widthq + 48], m1
+%endif
+    add        widthq, 16
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_boxblur_update_col_sums16(int64_t *col_sum, const uint16_t *add,
+;                                   const uint16_t *sub, ptrdiff_t width)
+; width must be a non-zero multiple of 8
+;-----------------------------------------------------------------------------
+%macro UPDATE_COL_SUMS16 0
+cglobal boxblur_update_col_sums16, 4, 4, 6, sum, add, sub, width
+    add        widthq, widthq
+    add          addq, widthq
+    add          subq, widthq
+    lea          sumq, [sumq + 4*widthq]
+    neg        widthq
+%if notcpuflag(avx2)
+    pxor           m5, m5
+%endif
+.loop:
+%if cpuflag(avx2)
+    pmovzxwd       m0, [addq + widthq]
+    pmovzxwd       m1, [subq + widthq]
+    psubd          m0, m1
+    vextracti128  xm1, m0, 1
+    pmovsxdq       m0, xm0
+    pmovsxdq       m1, xm1
+    movu           m2, [sumq + 4*widthq]
+    movu           m3, [sumq + 4*widthq + 32]
+    paddq          m0, m2
+    paddq          m1, m3
+    movu [sumq + 4*widthq     ], m0
+    movu [sumq + 4*widthq + 32], m1
+%else
+    movu           m0, [addq + widthq]
+    movu           m2, [subq + widthq]
+    punpckhwd      m1, m0, m5
+    punpcklwd      m0, m5
+    punpckhwd      m3, m2, m5
+    punpcklwd      m2, m5
+    psubd          m0, m2
+    psubd          m1, m3
+    ; sign extend the dword differences to qwords
+    pcmpgtd        m4, m5, m0
+    punpckhdq      m2, m0, m4
+    punpckldq      m0, m4
+    pcmpgtd        m4, m5, m1
+    punpckhdq      m3, m1, m4
+    punpckldq      m1, m4
+    movu           m4, [sumq + 4*widthq]
+    paddq          m0, m4
+    movu           m4, [sumq + 4*widthq + 16]
+    paddq          m2, m4
+    movu           m4, [sumq + 4*widthq + 32]
+    paddq          m1, m4
+    movu           m4, [sumq + 4*widthq + 48]
+    paddq          m3, m4
+    movu [sumq + 4*widthq     ], m0
+    movu [sumq + 4*widthq + 16], m2
+    movu [sumq + 4*widthq + 32], m1
+    movu [sumq + 4*widthq + 48], m3
+%endif
+    add        widthq, 16
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+VBLUR_ROW 8
+VBLUR_ROW 16
+UPDATE_COL_SUMS8
+UPDATE_COL_SUMS16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+VBLUR_ROW 8
+VBLUR_ROW 16
+UPDATE_COL_SUMS8
+UPDATE_COL_SUMS16
+%endif
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,97 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/boxblurdsp.h"
+
+/* The assembly only handles whole blocks of STEP pixels; the remaining
+ * columns are done by the C versions. */
+#define VBLUR_ROW_FUNC(OPT, DEPTH, STEP)                                       \
+void ff_boxblur_vblur_row##DEPTH##_##OPT(uint32_t *sum, uint8_t *dst,          \
+                                         const uint8_t *srca,                  \
+                                         const uint8_t *srcs,                  \
+                                         int inv, ptrdiff_t width);            \
+                                                                               \
+static void vblur_row##DEPTH##_##OPT(uint32_t *sum, uint8_t *dst,              \
+                                     const uint8_t *srca, const uint8_t *srcs, \
+                                     int inv, ptrdiff_t width)                 \
+{                                                                              \
+    const ptrdiff_t awidth = width & ~(STEP - 1);                              \
+    const int bpp = DEPTH / 8;                                                 \
+                                                                               \
+    if (awidth)                                                                \
+        ff_boxblur_vblur_row##DEPTH##_##OPT(sum, dst, srca, srcs, inv, awidth);\
+    ff_boxblur_vblur_row##DEPTH##_c(sum + awidth, dst + bpp * awidth,          \
+                                    srca + bpp * awidth, srcs + bpp * awidth,  \
+                                    inv, width - awidth);                      \
+}
+
+#define UPDATE_COL_SUMS_FUNC(OPT, DEPTH, STEP, BTYPE)                          \
+void ff_boxblur_update_col_sums##DEPTH##_##OPT(void *col_sum,                  \
+                                               const uint8_t *add,             \
+                                               const uint8_t *sub,             \
+                                               ptrdiff_t width);               \
+                                                                               \
+static void update_col_sums##DEPTH##_##OPT(void *col_sum, const uint8_t *add,  \
+                                           const uint8_t *sub,                 \
+                                           ptrdiff_t width)                    \
+{                                                                              \
+    const ptrdiff_t awidth = width & ~(STEP - 1);                              \
+    const int bpp = DEPTH / 8;                                                 \
+                                                                               \
+    if (awidth)                                                                \
+        ff_boxblur_update_col_sums##DEPTH##_##OPT(col_sum, add, sub, awidth);  \
+    ff_boxblur_update_col_sums##DEPTH##_c((BTYPE *)col_sum + awidth,           \
+                                          add + bpp * awidth,                  \
+                                          sub + bpp * awidth,                  \
+                                          width - awidth);                     \
+}
+
+#if HAVE_X86ASM && ARCH_X86_64
+VBLUR_ROW_FUNC(sse2,  8,  8)
+VBLUR_ROW_FUNC(sse2, 16,  8)
+UPDATE_COL_SUMS_FUNC(sse2,  8, 16, int32_t)
+UPDATE_COL_SUMS_FUNC(sse2, 16,  8, int64_t)
+#if HAVE_AVX2_EXTERNAL
+VBLUR_ROW_FUNC(avx2,  8, 16)
+VBLUR_ROW_FUNC(avx2, 16, 16)
+UPDATE_COL_SUMS_FUNC(avx2,  8, 16, int32_t)
+UPDATE_COL_SUMS_FUNC(avx2, 16,  8, int64_t)
+#endif
+#endif
+
+av_cold void ff_boxblurdsp_init_x86(BoxBlurDSPContext *dsp, int depth)
+{
+#if HAVE_X86ASM && ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        dsp->vblur_row       = depth > 8 ? vblur_row16_sse2       : vblur_row8_sse2;
+        dsp->update_col_sums = depth > 8 ? update_col_sums16_sse2 : update_col_sums8_sse2;
+    }
+#if HAVE_AVX2_EXTERNAL
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->vblur_row       = depth > 8 ? vblur_row16_avx2       : vblur_row8_avx2;
+        dsp->update_col_sums = depth > 8 ? update_col_sums16_avx2 : update_col_sums8_avx2;
+    }
+#endif
+#endif
+}
@@ -0,0 +1,142 @@
+;*****************************************************************************
+;* x86-optimized mask blending for the drawing utilities
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pb_1:     times 32 db 1
+pd_blend: times 8 dd 0x1010101
+
+SECTION .text
+
+%if ARCH_X86_64
+
+; The blend is done on dwords, as in the C code:
+; a = mask * alpha, dst = ((0x1010101 - a) * dst + a * src) >> 24
+; which never exceeds 32 bits.
+; m0 = mask words, m1 = dst words; m0 = blended words
+; m4 = zero, m5 = alpha, m6 = src, m7 = 0x1010101
+%macro BLEND_WORDS 0
+    punpckhwd      m2, m0, m4
+    punpcklwd      m0, m4
+    punpckhwd      m3, m1, m4
+    punpcklwd      m1, m4
+    pmulld         m0, m5
+    pmulld         m2, m5
+    psubd          m8, m7, m0
+    psubd          m9, m7, m2
+    pmulld         m8, m1
+    pmulld         m9, m3
+    pmulld         m0, m6
+    pmulld         m2, m6
+    paddd          m0, m8
+    paddd          m2, m9
+    psrld          m0, 24
+    psrld          m2, 24
+    packusdw       m0, m2
+%endmacro
+
+; store the mmsize / 2 blended words of m0 as bytes at dst
+%macro STORE_BYTES 0
+%if mmsize == 32
+    vextracti128  xm1, m0, 1
+    packuswb      xm0, xm1
+    movu   [dstq + wq], xm0
+%else
+    packuswb       m0, m0
+    movq   [dstq + wq], m0
+%endif
+%endmacro
+
+%macro LOAD_CONSTS 0
+    movd          xm5, alphad
+    movd          xm6, srcd
+%if cpuflag(avx2)
+    vpbroadcastd   m5, xm5
+    vpbroadcastd   m6, xm6
+%else
+    SPLATD         m5
+    SPLATD         m6
+%endif
+    mova           m7, [pd_blend]
+    pxor           m4, m4
+%endmacro
+
+%macro BLEND_ROW 0
+;-----------------------------------------------------------------------------
+; void ff_draw_blend_row(uint8_t *dst, const uint8_t *mask,
+;                        ptrdiff_t mask_linesize, int w,
+;                        unsigned src, unsigned alpha)
+; w must be a non-zero multiple of mmsize / 2
+;-----------------------------------------------------------------------------
+cglobal draw_blend_row, 6, 6, 10, dst, mask, mask_linesize, w, src, alpha
+    LOAD_CONSTS
+    movsxdifnidn   wq, wd
+    add          dstq, wq
+    add         maskq, wq
+    neg            wq
+.loop:
+    pmovzxbw       m0, [maskq + wq]
+    pmovzxbw       m1, [dstq + wq]
+    BLEND_WORDS
+    STORE_BYTES
+    add            wq, mmsize / 2
+    jl .loop
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_draw_blend_row_2x2(uint8_t *dst, const uint8_t *mask,
+;                            ptrdiff_t mask_linesize, int w,
+;                            unsigned src, unsigned alpha)
+; w must be a non-zero multiple of mmsize / 2
+;-----------------------------------------------------------------------------
+cglobal draw_blend_row_2x2, 6, 6, 11, dst, mask, mask_linesize, w, src, alpha
+    LOAD_CONSTS
+    mova          m10, [pb_1]
+    movsxdifnidn   wq, wd
+    add          dstq, wq
+    lea         maskq, [maskq + wq * 2]
+    add mask_linesizeq, maskq
+    neg            wq
+.loop:
+    movu           m0, [maskq + wq * 2]
+    movu           m2, [mask_linesizeq + wq * 2]
+    pmaddubsw      m0, m10
+    pmaddubsw      m2, m10
+    paddw          m0, m2
+    psrlw          m0, 2
+    pmovzxbw       m1, [dstq + wq]
+    BLEND_WORDS
+    STORE_BYTES
+    add            wq, mmsize / 2
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse4
+BLEND_ROW
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BLEND_ROW
+%endif
+
+%endif ; ARCH_X86_64
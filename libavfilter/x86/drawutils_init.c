@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/drawutils.h"
+
+/* The assembly only handles whole vectors; the remaining pixels are done
+ * in C, in the same way. */
+#define BLEND_ROW_FUNCS(OPT, MMSIZE)                                           \
+void ff_draw_blend_row_##OPT(uint8_t *dst, const uint8_t *mask,                \
+                             ptrdiff_t mask_linesize, int w,                   \
+                             unsigned src, unsigned alpha);                    \
+void ff_draw_blend_row_2x2_##OPT(uint8_t *dst, const uint8_t *mask,            \
+                                 ptrdiff_t mask_linesize, int w,               \
+                                 unsigned src, unsigned alpha);                \
+                                                                               \
+static void blend_row_##OPT(uint8_t *dst, const uint8_t *mask,                 \
+                            ptrdiff_t mask_linesize, int w,                    \
+                            unsigned src, unsigned alpha)                      \
+{                                                                              \
+    int aw = w & ~(MMSIZE / 2 - 1);                                            \
+    if (aw)                                                                    \
+        ff_draw_blend_row_##OPT(dst, mask, mask_linesize, aw, src, alpha);     \
+    for (int x = aw; x < w; x++) {                                             \
+        unsigned a = mask[x] * alpha;                                          \
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;                   \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static void blend_row_2x2_##OPT(uint8_t *dst, const uint8_t *mask,             \
+                                ptrdiff_t mask_linesize, int w,                \
+                                unsigned src, unsigned alpha)                  \
+{                                                                              \
+    int aw = w & ~(MMSIZE / 2 - 1);                                            \
+    if (aw)                                                                    \
+        ff_draw_blend_row_2x2_##OPT(dst, mask, mask_linesize, aw, src, alpha); \
+    for (int x = aw; x < w; x++) {                                             \
+        unsigned t = mask[2 * x] + mask[2 * x + 1] +                           \
+                     mask[2 * x + mask_linesize] +                             \
+                     mask[2 * x + 1 + mask_linesize];                          \
+        unsigned a = (t >> 2) * alpha;                                         \
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;                   \
+    }                                                                          \
+}
+
+#if ARCH_X86_64
+BLEND_ROW_FUNCS(sse4, 16)
+BLEND_ROW_FUNCS(avx2, 32)
+#endif
+
+av_cold void ff_draw_init_x86(FFDrawContext *draw)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        draw->blend_row[0] = blend_row_sse4;
+        draw->blend_row[1] = blend_row_2x2_sse4;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        draw->blend_row[0] = blend_row_avx2;
+        draw->blend_row[1] = blend_row_2x2_avx2;
+    }
+#endif
+}
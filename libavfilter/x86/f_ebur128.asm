@@ -0,0 +1,119 @@
+;******************************************************************************
+;* EBU R128 true-peak interpolation over interleaved channel lanes
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+; each coefficient is repeated so that it can be used as a ymm operand
+%macro TP_COEFFS 12
+%rep 12
+    times 4 dq %1
+%rotate 1
+%endrep
+%endmacro
+
+pd_abs: times 4 dq 0x7fffffffffffffff
+
+; ITU-R BS.1770-4 Annex 2, one row of 12 taps per phase
+tp_coeffs:
+TP_COEFFS  0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000, \
+          -0.0594482421875,  0.1373291015625,  0.9721679687500, -0.1022949218750, \
+           0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500
+TP_COEFFS -0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250, \
+          -0.1665039062500,  0.4650878906250,  0.7797851562500, -0.2003173828125, \
+           0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375
+TP_COEFFS -0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000, \
+          -0.2003173828125,  0.7797851562500,  0.4650878906250, -0.1665039062500, \
+           0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875
+TP_COEFFS -0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750, \
+          -0.1022949218750,  0.9721679687500,  0.1373291015625, -0.0594482421875, \
+           0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750
+
+SECTION .text
+
+; A frame holds 8 lanes of doubles, so 64 bytes; the passes handle mmsize
+; bytes of the lanes of every frame in turn.
+%define FRAME_SIZE 64
+%define TAPS       12
+%define PHASES     4
+
+%if ARCH_X86_64
+
+; m0-m11 = the last 12 input frames, m12 = sum, m13 = peaks, m14 = product,
+; m15 = abs mask
+; %1 = byte offset of the lanes within the frame
+%macro TP_PASS 1
+    mova         m13, [peaksq + %1]
+    lea         ptrq, [bufq + %1]
+    mov         cntq, lenq
+%%loop:
+%assign %%k 0
+%rep TAPS
+    mova   m %+ %%k, [ptrq - %%k*FRAME_SIZE]
+%assign %%k %%k+1
+%endrep
+    andpd        m14, m0, m15
+    maxpd        m13, m14
+%assign %%p 0
+%rep PHASES
+    mulpd        m12, m0, [tp_coeffs + %%p*TAPS*32]
+%assign %%k 1
+%rep TAPS - 1
+    mulpd        m14, m %+ %%k, [tp_coeffs + (%%p*TAPS + %%k)*32]
+    addpd        m12, m14
+%assign %%k %%k+1
+%endrep
+    andpd        m12, m15
+    maxpd        m13, m12
+%assign %%p %%p+1
+%endrep
+    add         ptrq, FRAME_SIZE
+    dec         cntq
+    jg %%loop
+    mova [peaksq + %1], m13
+%endmacro
+
+%macro TRUE_PEAK_FUNC 0
+;-----------------------------------------------------------------------------
+; void ff_ebur128_true_peak(double *peaks, const double *buf, ptrdiff_t len)
+;-----------------------------------------------------------------------------
+cglobal ebur128_true_peak, 3, 5, 16, peaks, buf, len, ptr, cnt
+    test        lenq, lenq
+    jle .end
+    mova         m15, [pd_abs]
+%assign %%off 0
+%rep FRAME_SIZE / mmsize
+    TP_PASS    %%off
+%assign %%off %%off + mmsize
+%endrep
+.end:
+    RET
+%endmacro
+
+INIT_XMM sse2
+TRUE_PEAK_FUNC
+
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+TRUE_PEAK_FUNC
+%endif
+
+%endif ; ARCH_X86_64
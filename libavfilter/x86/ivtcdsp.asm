@@ -0,0 +1,177 @@
+;*****************************************************************************
+;* x86-optimized block differences and comb detection for fieldmatch/decimate
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+
+%macro IVTC 0
+;-----------------------------------------------------------------------------
+; uint64_t ff_ivtc_block_sad(const uint8_t *src1, ptrdiff_t stride1,
+;                            const uint8_t *src2, ptrdiff_t stride2,
+;                            ptrdiff_t width, ptrdiff_t height)
+; width must be a non-zero multiple of 8, height must be > 0
+;-----------------------------------------------------------------------------
+cglobal ivtc_block_sad, 6, 8, 3, src1, stride1, src2, stride2, width, height, x, wa
+    pxor           m0, m0
+    mov           waq, widthq
+    and           waq, ~(mmsize - 1)
+.nextrow:
+    xor            xd, xd
+    cmp            xq, waq
+    jge .tail
+.loop:
+    movu           m1, [src1q + xq]
+    movu           m2, [src2q + xq]
+    psadbw         m1, m2
+    paddq          m0, m1
+    add            xq, mmsize
+    cmp            xq, waq
+    jl .loop
+.tail:
+%if mmsize == 32
+    test       widthd, 16
+    jz .tail8
+    movu          xm1, [src1q + xq]
+    movu          xm2, [src2q + xq]
+    psadbw        xm1, xm2
+    paddq          m0, m1
+    add            xq, 16
+.tail8:
+%endif
+    test       widthd, 8
+    jz .next
+    movq          xm1, [src1q + xq]
+    movq          xm2, [src2q + xq]
+    psadbw        xm1, xm2
+    paddq          m0, m1
+.next:
+    add         src1q, stride1q
+    add         src2q, stride2q
+    dec       heightq
+    jg .nextrow
+
+%if mmsize == 32
+    vextracti128  xm1, m0, 1
+    paddq         xm0, xm1
+%endif
+    pshufd        xm1, xm0, q3232
+    paddq         xm0, xm1
+    movq          rax, xm0
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_ivtc_comb_row(uint8_t *dst, const uint8_t *prv2, const uint8_t *prv,
+;                       const uint8_t *cur, const uint8_t *nxt,
+;                       const uint8_t *nxt2, ptrdiff_t width, int thresh)
+; width must be a non-zero multiple of mmsize
+;-----------------------------------------------------------------------------
+cglobal ivtc_comb_row, 8, 8, 11, dst, prv2, prv, cur, nxt, nxt2, width, thresh
+    movd          xm8, threshd
+    imul      threshd, 6
+    movd          xm9, threshd
+%if cpuflag(avx2)
+    vpbroadcastb   m8, xm8
+    vpbroadcastw   m9, xm9
+%else
+    punpcklbw      m8, m8
+    pshuflw        m8, m8, 0
+    punpcklqdq     m8, m8
+    pshuflw        m9, m9, 0
+    punpcklqdq     m9, m9
+%endif
+    pxor          m10, m10
+    add          dstq, widthq
+    add         prv2q, widthq
+    add          prvq, widthq
+    add          curq, widthq
+    add          nxtq, widthq
+    add         nxt2q, widthq
+    neg        widthq
+.loop:
+    movu           m0, [curq + widthq]
+    movu           m1, [prvq + widthq]
+    movu           m2, [nxtq + widthq]
+
+    ; min(|cur - prv|, |cur - nxt|) <= thresh
+    psubusb        m3, m0, m1
+    psubusb        m4, m1, m0
+    por            m3, m4
+    psubusb        m4, m0, m2
+    psubusb        m5, m2, m0
+    por            m4, m5
+    pminub         m3, m4
+    psubusb        m3, m8
+    pcmpeqb        m3, m10
+
+    ; 4 * cur - 3 * (prv + nxt) + prv2 + nxt2, in words
+    punpcklbw      m4, m1, m10
+    punpckhbw      m1, m10
+    punpcklbw      m5, m2, m10
+    punpckhbw      m2, m10
+    paddw          m4, m5
+    paddw          m1, m2
+    psllw          m5, m4, 1
+    psllw          m2, m1, 1
+    paddw          m4, m5
+    paddw          m1, m2
+    punpcklbw      m5, m0, m10
+    punpckhbw      m0, m10
+    psllw          m5, 2
+    psllw          m0, 2
+    psubw          m5, m4
+    psubw          m0, m1
+    movu           m6, [prv2q + widthq]
+    movu           m7, [nxt2q + widthq]
+    punpcklbw      m4, m6, m10
+    punpckhbw      m6, m10
+    punpcklbw      m1, m7, m10
+    punpckhbw      m7, m10
+    paddw          m4, m1
+    paddw          m6, m7
+    paddw          m5, m4
+    paddw          m0, m6
+
+    ; |filter| > 6 * thresh
+    psubw          m4, m10, m5
+    psubw          m6, m10, m0
+    pmaxsw         m5, m4
+    pmaxsw         m0, m6
+    pcmpgtw        m5, m9
+    pcmpgtw        m0, m9
+    packsswb       m5, m0
+    pandn          m3, m5
+    movu  [dstq + widthq], m3
+    add        widthq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+IVTC
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+IVTC
+%endif
+
+%endif ; ARCH_X86_64
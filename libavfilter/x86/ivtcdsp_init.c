@@ -0,0 +1,90 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/ivtcdsp.h"
+
+/* The block difference assembly handles widths that are a multiple of 8,
+ * which covers the default decimate blocks of both luma and 4:2:0 chroma;
+ * the comb detection handles whole vectors. The remaining columns are done
+ * by the C versions. */
+#define IVTC_FUNCS(OPT, MMSIZE)                                                \
+uint64_t ff_ivtc_block_sad_##OPT(const uint8_t *src1, ptrdiff_t stride1,       \
+                                 const uint8_t *src2, ptrdiff_t stride2,       \
+                                 ptrdiff_t width, ptrdiff_t height);           \
+void ff_ivtc_comb_row_##OPT(uint8_t *dst, const uint8_t *prv2,                 \
+                            const uint8_t *prv, const uint8_t *cur,            \
+                            const uint8_t *nxt, const uint8_t *nxt2,           \
+                            ptrdiff_t width, int thresh);                      \
+                                                                               \
+static uint64_t block_sad_##OPT(const uint8_t *src1, ptrdiff_t stride1,        \
+                                const uint8_t *src2, ptrdiff_t stride2,        \
+                                ptrdiff_t width, ptrdiff_t height)             \
+{                                                                              \
+    ptrdiff_t awidth = width & ~7;                                             \
+    uint64_t sum = 0;                                                          \
+    if (awidth && height > 0)                                                  \
+        sum = ff_ivtc_block_sad_##OPT(src1, stride1, src2, stride2,            \
+                                      awidth, height);                         \
+    return sum + ff_ivtc_block_sad_c(src1 + awidth, stride1,                   \
+                                     src2 + awidth, stride2,                   \
+                                     width - awidth, height);                  \
+}                                                                              \
+                                                                               \
+static void comb_row_##OPT(uint8_t *dst, const uint8_t *prv2,                  \
+                           const uint8_t *prv, const uint8_t *cur,             \
+                           const uint8_t *nxt, const uint8_t *nxt2,            \
+                           ptrdiff_t width, int thresh)                        \
+{                                                                              \
+    ptrdiff_t awidth = width & ~(MMSIZE - 1);                                  \
+    if (awidth)                                                                \
+        ff_ivtc_comb_row_##OPT(dst, prv2, prv, cur, nxt, nxt2, awidth, thresh);\
+    ff_ivtc_comb_row_c(dst + awidth, prv2 + awidth, prv + awidth,              \
+                       cur + awidth, nxt + awidth, nxt2 + awidth,              \
+                       width - awidth, thresh);                                \
+}
+
+#if HAVE_X86ASM && ARCH_X86_64
+IVTC_FUNCS(sse2, 16)
+#if HAVE_AVX2_EXTERNAL
+IVTC_FUNCS(avx2, 32)
+#endif
+#endif
+
+av_cold void ff_ivtcdsp_init_x86(IVTCDSPContext *dsp, int depth)
+{
+#if HAVE_X86ASM && ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        if (depth == 8)
+            dsp->block_sad = block_sad_sse2;
+        dsp->comb_row = comb_row_sse2;
+    }
+#if HAVE_AVX2_EXTERNAL
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        if (depth == 8)
+            dsp->block_sad = block_sad_avx2;
+        dsp->comb_row = comb_row_avx2;
+    }
+#endif
+#endif
+}
@@ -0,0 +1,214 @@
+;*****************************************************************************
+;* x86-optimized row and column statistics for the detection filters
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pb_1: times 32 db 1
+
+SECTION .text
+
+%if ARCH_X86_64
+
+; sum the qwords of m0 and return the result
+%macro HADDQ_RET 0
+%if mmsize == 32
+    vextracti128  xm1, m0, 1
+    paddq         xm0, xm1
+%endif
+    pshufd        xm1, xm0, q3232
+    paddq         xm0, xm1
+    movq          rax, xm0
+    RET
+%endmacro
+
+%macro ROWSTATS 0
+;-----------------------------------------------------------------------------
+; uint64_t ff_rowstats_count_below(const uint8_t *src, ptrdiff_t stride,
+;                                  ptrdiff_t width, ptrdiff_t height,
+;                                  int thresh)
+; width must be a non-zero multiple of mmsize, height must be > 0
+;-----------------------------------------------------------------------------
+cglobal rowstats_count_below, 5, 6, 6, src, stride, width, height, thresh, x
+    movd          xm2, threshd
+%if cpuflag(avx2)
+    vpbroadcastb   m2, xm2
+%else
+    punpcklbw      m2, m2
+    pshuflw        m2, m2, 0
+    punpcklqdq     m2, m2
+%endif
+    mova           m3, [pb_1]
+    pxor           m4, m4
+    pxor           m0, m0
+    add          srcq, widthq
+    neg        widthq
+.nextrow:
+    mov            xq, widthq
+.loop:
+    movu           m1, [srcq + xq]
+    pmaxub         m5, m1, m2
+    pcmpeqb        m5, m1          ; src >= thresh
+    pandn          m5, m3
+    psadbw         m5, m4
+    paddq          m0, m5
+    add            xq, mmsize
+    jl .loop
+    add          srcq, strideq
+    dec       heightq
+    jg .nextrow
+    HADDQ_RET
+
+;-----------------------------------------------------------------------------
+; uint64_t ff_rowstats_row_sum(const uint8_t *src, ptrdiff_t width)
+; width must be a non-zero multiple of mmsize
+;-----------------------------------------------------------------------------
+cglobal rowstats_row_sum, 2, 2, 3, src, width
+    pxor           m1, m1
+    pxor           m0, m0
+    add          srcq, widthq
+    neg        widthq
+.loop:
+    movu           m2, [srcq + widthq]
+    psadbw         m2, m1
+    paddq          m0, m2
+    add        widthq, mmsize
+    jl .loop
+    HADDQ_RET
+
+;-----------------------------------------------------------------------------
+; uint64_t ff_rowstats_row_sum16(const uint8_t *src, ptrdiff_t width)
+; width is in pixels and must be a non-zero multiple of mmsize / 2 and not
+; larger than 65536 so that the dword sums cannot overflow
+;-----------------------------------------------------------------------------
+cglobal rowstats_row_sum16, 2, 2, 4, src, width
+    pxor           m1, m1
+    pxor           m0, m0
+    lea          srcq, [srcq + 2*widthq]
+    add        widthq, widthq
+    neg        widthq
+.loop:
+    movu           m2, [srcq + widthq]
+    punpckhwd      m3, m2, m1
+    punpcklwd      m2, m1
+    paddd          m0, m2
+    paddd          m0, m3
+    add        widthq, mmsize
+    jl .loop
+    punpckhdq      m2, m0, m1
+    punpckldq      m0, m1
+    paddq          m0, m2
+    HADDQ_RET
+
+;-----------------------------------------------------------------------------
+; void ff_rowstats_column_sum(uint32_t *sum, const uint8_t *src,
+;                             ptrdiff_t stride, ptrdiff_t width,
+;                             ptrdiff_t height)
+; width must be a non-zero multiple of mmsize, height must be > 0
+;-----------------------------------------------------------------------------
+cglobal rowstats_column_sum, 5, 6, 6, sum, src, stride, width, height, x
+    pxor           m5, m5
+    add          srcq, widthq
+    lea          sumq, [sumq + 4*widthq]
+    neg        widthq
+.nextrow:
+    mov            xq, widthq
+.loop:
+%if cpuflag(avx2)
+    pmovzxbd       m0, [srcq + xq]
+    pmovzxbd       m1, [srcq + xq +  8]
+    pmovzxbd       m2, [srcq + xq + 16]
+    pmovzxbd       m3, [srcq + xq + 24]
+%else
+    movu           m1, [srcq + xq]
+    punpckhbw      m3, m1, m5
+    punpcklbw      m1, m5
+    punpcklwd      m0, m1, m5
+    punpckhwd      m1, m5
+    punpcklwd      m2, m3, m5
+    punpckhwd      m3, m5
+%endif
+    movu           m4, [sumq + 4*xq]
+    paddd          m0, m4
+    movu           m4, [sumq + 4*xq +   mmsize]
+    paddd          m1, m4
+    movu           m4, [sumq + 4*xq + 2*mmsize]
+    paddd          m2, m4
+    movu           m4, [sumq + 4*xq + 3*mmsize]
+    paddd          m3, m4
+    movu [sumq + 4*xq           ], m0
+    movu [sumq + 4*xq +   mmsize], m1
+    movu [sumq + 4*xq + 2*mmsize], m2
+    movu [sumq + 4*xq + 3*mmsize], m3
+    add            xq, mmsize
+    jl .loop
+    add          srcq, strideq
+    dec       heightq
+    jg .nextrow
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_rowstats_column_sum16(uint32_t *sum, const uint8_t *src,
+;                               ptrdiff_t stride, ptrdiff_t width,
+;                               ptrdiff_t height)
+; width is in pixels and must be a non-zero multiple of mmsize / 2,
+; height must be > 0
+;-----------------------------------------------------------------------------
+cglobal rowstats_column_sum16, 5, 6, 5, sum, src, stride, width, height, x
+    pxor           m4, m4
+    lea          srcq, [srcq + 2*widthq]
+    lea          sumq, [sumq + 4*widthq]
+    add        widthq, widthq
+    neg        widthq
+.nextrow:
+    mov            xq, widthq
+.loop:
+%if cpuflag(avx2)
+    pmovzxwd       m0, [srcq + xq]
+    pmovzxwd       m1, [srcq + xq + 16]
+%else
+    movu           m1, [srcq + xq]
+    punpcklwd      m0, m1, m4
+    punpckhwd      m1, m4
+%endif
+    movu           m2, [sumq + 2*xq]
+    movu           m3, [sumq + 2*xq + mmsize]
+    paddd          m0, m2
+    paddd          m1, m3
+    movu [sumq + 2*xq         ], m0
+    movu [sumq + 2*xq + mmsize], m1
+    add            xq, mmsize
+    jl .loop
+    add          srcq, strideq
+    dec       heightq
+    jg .nextrow
+    RET
+%endmacro
+
+INIT_XMM sse2
+ROWSTATS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+ROWSTATS
+%endif
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,120 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/rowstats.h"
+
+/* The assembly only handles whole vectors; the remaining columns are done
+ * by the C versions. */
+#define ROWSTATS_FUNCS(OPT, MMSIZE)                                            \
+uint64_t ff_rowstats_count_below_##OPT(const uint8_t *src, ptrdiff_t stride,   \
+                                       ptrdiff_t width, ptrdiff_t height,      \
+                                       int thresh);                            \
+uint64_t ff_rowstats_row_sum_##OPT(const uint8_t *src, ptrdiff_t width);       \
+uint64_t ff_rowstats_row_sum16_##OPT(const uint8_t *src, ptrdiff_t width);     \
+void ff_rowstats_column_sum_##OPT(uint32_t *sum, const uint8_t *src,           \
+                                  ptrdiff_t stride, ptrdiff_t width,           \
+                                  ptrdiff_t height);                           \
+void ff_rowstats_column_sum16_##OPT(uint32_t *sum, const uint8_t *src,         \
+                                    ptrdiff_t stride, ptrdiff_t width,         \
+                                    ptrdiff_t height);                         \
+                                                                               \
+static uint64_t count_below_##OPT(const uint8_t *src, ptrdiff_t stride,        \
+                                  ptrdiff_t width, ptrdiff_t height,           \
+                                  int thresh)                                  \
+{                                                                              \
+    ptrdiff_t awidth = width & ~(MMSIZE - 1);                                  \
+    uint64_t count = 0;                                                        \
+    if (awidth && height > 0)                                                  \
+        count = ff_rowstats_count_below_##OPT(src, stride, awidth, height,     \
+                                              thresh);                         \
+    return count + ff_rowstats_count_below_c(src + awidth, stride,             \
+                                             width - awidth, height, thresh);  \
+}                                                                              \
+                                                                               \
+static uint64_t row_sum_##OPT(const uint8_t *src, ptrdiff_t width)             \
+{                                                                              \
+    ptrdiff_t awidth = width & ~(MMSIZE - 1);                                  \
+    uint64_t sum = 0;                                                          \
+    if (awidth)                                                                \
+        sum = ff_rowstats_row_sum_##OPT(src, awidth);                          \
+    return sum + ff_rowstats_row_sum_c(src + awidth, width - awidth);          \
+}                                                                              \
+                                                                               \
+static uint64_t row_sum16_##OPT(const uint8_t *src, ptrdiff_t width)           \
+{                                                                              \
+    ptrdiff_t awidth = width & ~(MMSIZE / 2 - 1);                              \
+    uint64_t sum = 0;                                                          \
+    for (ptrdiff_t x = 0; x < awidth; x += 1 << 16)                            \
+        sum += ff_rowstats_row_sum16_##OPT(src + 2 * x,                        \
+                                           FFMIN(awidth - x, 1 << 16));        \
+    return sum + ff_rowstats_row_sum16_c(src + 2 * awidth, width - awidth);    \
+}                                                                              \
+                                                                               \
+static void column_sum_##OPT(uint32_t *sum, const uint8_t *src,                \
+                             ptrdiff_t stride, ptrdiff_t width,                \
+                             ptrdiff_t height)                                 \
+{                                                                              \
+    ptrdiff_t awidth = width & ~(MMSIZE - 1);                                  \
+    if (awidth && height > 0)                                                  \
+        ff_rowstats_column_sum_##OPT(sum, src, stride, awidth, height);        \
+    ff_rowstats_column_sum_c(sum + awidth, src + awidth, stride,               \
+                             width - awidth, height);                          \
+}                                                                              \
+                                                                               \
+static void column_sum16_##OPT(uint32_t *sum, const uint8_t *src,              \
+                               ptrdiff_t stride, ptrdiff_t width,              \
+                               ptrdiff_t height)                               \
+{                                                                              \
+    ptrdiff_t awidth = width & ~(MMSIZE / 2 - 1);                              \
+    if (awidth && height > 0)                                                  \
+        ff_rowstats_column_sum16_##OPT(sum, src, stride, awidth, height);      \
+    ff_rowstats_column_sum16_c(sum + awidth, src + 2 * awidth, stride,         \
+                               width - awidth, height);                        \
+}
+
+#if HAVE_X86ASM && ARCH_X86_64
+ROWSTATS_FUNCS(sse2, 16)
+#if HAVE_AVX2_EXTERNAL
+ROWSTATS_FUNCS(avx2, 32)
+#endif
+#endif
+
+av_cold void ff_rowstats_init_x86(RowStatsDSPContext *dsp, int depth)
+{
+#if HAVE_X86ASM && ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        dsp->count_below = count_below_sse2;
+        dsp->row_sum     = depth > 8 ? row_sum16_sse2    : row_sum_sse2;
+        dsp->column_sum  = depth > 8 ? column_sum16_sse2 : column_sum_sse2;
+    }
+#if HAVE_AVX2_EXTERNAL
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->count_below = count_below_avx2;
+        dsp->row_sum     = depth > 8 ? row_sum16_avx2    : row_sum_avx2;
+        dsp->column_sum  = depth > 8 ? column_sum16_avx2 : column_sum_avx2;
+    }
+#endif
+#endif
+}
@@ -0,0 +1,114 @@
+;*****************************************************************************
+;* x86-optimized functions for the paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_dist_max: times 4 dq 2147483646.0 ; INT32_MAX - 1
+
+SECTION .text
+
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+
+%define PLANE_SIZE 256 * 4 ; AVPALETTE_COUNT int32_t
+
+; %1 = clipped distances of the 4 colors at iq + %3, %2 is clobbered.
+; The coordinates and their differences fit in 26 bits, so the squares and
+; their sums are exact in double precision.
+%macro DIST 3
+    cvtdq2pd       %1, [palq + iq*4 + %3*4]
+    cvtdq2pd       %2, [palq + iq*4 + %3*4 + PLANE_SIZE]
+    subpd          %1, m0
+    subpd          %2, m1
+    mulpd          %1, %1
+    mulpd          %2, %2
+    addpd          %1, %2
+    cvtdq2pd       %2, [palq + iq*4 + %3*4 + 2*PLANE_SIZE]
+    subpd          %2, m2
+    mulpd          %2, %2
+    addpd          %1, %2
+    minpd          %1, m3
+%endmacro
+
+;-----------------------------------------------------------------------------
+; int ff_paletteuse_nearest_color(const int32_t *pal, int nb_colors,
+;                                 int L, int a, int b)
+; nb_colors must be a non-zero multiple of 8
+;-----------------------------------------------------------------------------
+INIT_YMM avx2
+cglobal paletteuse_nearest_color, 5, 8, 9, pal, n, L, a, b, i, idx, mask
+    movsxdifnidn   nq, nd
+    cvtsi2sd      xm0, Ld
+    cvtsi2sd      xm1, ad
+    cvtsi2sd      xm2, bd
+    vbroadcastsd   m0, xm0
+    vbroadcastsd   m1, xm1
+    vbroadcastsd   m2, xm2
+    mova           m3, [pd_dist_max]
+
+    ; smallest distance
+    mova           m4, m3
+    mova           m8, m3
+    xor            iq, iq
+.min_loop:
+    DIST           m5, m6, 0
+    DIST           m7, m6, 4
+    minpd          m4, m5
+    minpd          m8, m7
+    add            iq, 8
+    cmp            iq, nq
+    jl .min_loop
+    minpd          m4, m8
+    vextractf128  xm5, m4, 1
+    minpd         xm4, xm5
+    unpckhpd      xm5, xm4, xm4
+    minpd         xm4, xm5
+    vbroadcastsd   m4, xm4
+
+    ; index of the only color at that distance
+    mov          idxd, -1
+    xor            iq, iq
+.eq_loop:
+    DIST           m5, m6, 0
+    cmpeqpd        m5, m4
+    movmskpd    maskd, m5
+    test        maskd, maskd
+    jnz .found
+.next:
+    add            iq, 4
+    cmp            iq, nq
+    jl .eq_loop
+    mov           eax, idxd
+    RET
+.found:
+    cmp          idxd, -1
+    jne .tie
+    lea            Ld, [maskq - 1]
+    test           Ld, maskd
+    jnz .tie
+    bsf         maskd, maskd
+    lea          idxd, [iq + maskq]
+    jmp .next
+.tie:
+    mov           eax, -1
+    RET
+
+%endif ; HAVE_AVX2_EXTERNAL && ARCH_X86_64
@@ -0,0 +1,39 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/paletteuse.h"
+
+int ff_paletteuse_nearest_color_avx2(const int32_t *pal, int nb_colors, int L, int a, int b);
+
+av_cold void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp)
+{
+#if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    /* Comparing all the colors with 4 doubles per vector only beats
+     * walking the k-d tree for small palettes. */
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->nearest_color     = ff_paletteuse_nearest_color_avx2;
+        dsp->nearest_color_max = 32;
+    }
+#endif
+}
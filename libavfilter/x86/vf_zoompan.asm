@@ -0,0 +1,161 @@
+;*****************************************************************************
+;* x86-optimized functions for the zoompan filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_128:    times 8 dd 128
+pd_1_19:   times 4 dd 1 << 19
+
+SECTION .text
+
+%if ARCH_X86_64
+
+;-----------------------------------------------------------------------------
+; void ff_zoompan_vfilter_row(int16_t *dst, const uint8_t *src,
+;                             ptrdiff_t linesize, const int16_t *coeffs,
+;                             int taps, int width)
+; width must be a non-zero multiple of 8 (sse2) or 16 (avx2)
+;-----------------------------------------------------------------------------
+%macro VFILTER_ROW 0
+cglobal zoompan_vfilter_row, 6, 10, 8, dst, src, linesize, coeffs, taps, width, x, srcp, k, coef
+    movsxdifnidn widthq, widthd
+    mova           m7, [pd_128]
+%if notcpuflag(avx2)
+    pxor           m6, m6
+%endif
+    xor            xq, xq
+.loop_x:
+    mova           m0, m7
+    mova           m1, m7
+    lea         srcpq, [srcq + xq]
+    mov            kd, tapsd
+    mov         coefq, coeffsq
+.loop_k:
+    ; two rows per pmaddwd; with an odd number of taps the last coefficient
+    ; pair is (c, 0) and the second row is not read
+%if cpuflag(avx2)
+    vpbroadcastd   m2, [coefq]
+    pmovzxbw       m3, [srcpq]
+%else
+    movd           m2, [coefq]
+    pshufd         m2, m2, 0
+    movq           m3, [srcpq]
+    punpcklbw      m3, m6
+%endif
+    mova           m4, m3
+    cmp            kd, 1
+    je .pair
+%if cpuflag(avx2)
+    pmovzxbw       m4, [srcpq + linesizeq]
+%else
+    movq           m4, [srcpq + linesizeq]
+    punpcklbw      m4, m6
+%endif
+.pair:
+    punpckhwd      m5, m3, m4
+    punpcklwd      m3, m4
+    pmaddwd        m3, m2
+    pmaddwd        m5, m2
+    paddd          m0, m3
+    paddd          m1, m5
+    lea         srcpq, [srcpq + 2*linesizeq]
+    add         coefq, 4
+    sub            kd, 2
+    jg .loop_k
+    psrad          m0, 8
+    psrad          m1, 8
+    packssdw       m0, m1
+    movu [dstq + 2*xq], m0
+    add            xq, mmsize / 2
+    cmp            xq, widthq
+    jl .loop_x
+    RET
+%endmacro
+
+INIT_XMM sse2
+VFILTER_ROW
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+VFILTER_ROW
+%endif
+
+;-----------------------------------------------------------------------------
+; void ff_zoompan_hfilter_row(uint8_t *dst, const int16_t *src, const int *pos,
+;                             const int16_t *coeffs, int taps, int width)
+; taps must be a multiple of 4, width a non-zero multiple of 4
+;-----------------------------------------------------------------------------
+INIT_XMM ssse3
+cglobal zoompan_hfilter_row, 6, 13, 6, dst, src, pos, coeffs, taps, width, p0, p1, p2, p3, k, c0, c2
+    movsxdifnidn tapsq, tapsd
+    movsxdifnidn widthq, widthd
+    mova           m5, [pd_1_19]
+.loop_x:
+    movsxd        p0q, [posq]
+    movsxd        p1q, [posq + 4]
+    movsxd        p2q, [posq + 8]
+    movsxd        p3q, [posq + 12]
+    lea           p0q, [srcq + 2*p0q]
+    lea           p1q, [srcq + 2*p1q]
+    lea           p2q, [srcq + 2*p2q]
+    lea           p3q, [srcq + 2*p3q]
+    mov           c0q, coeffsq
+    lea           c2q, [coeffsq + 4*tapsq]
+    pxor           m0, m0
+    pxor           m1, m1
+    mov            kq, tapsq
+.loop_k:
+    ; 4 taps of outputs 0 and 1 in m2, of outputs 2 and 3 in m3
+    movq           m2, [p0q]
+    movhps         m2, [p1q]
+    movq           m3, [p2q]
+    movhps         m3, [p3q]
+    movq           m4, [c0q]
+    movhps         m4, [c0q + 2*tapsq]
+    pmaddwd        m2, m4
+    movq           m4, [c2q]
+    movhps         m4, [c2q + 2*tapsq]
+    pmaddwd        m3, m4
+    paddd          m0, m2
+    paddd          m1, m3
+    add           p0q, 8
+    add           p1q, 8
+    add           p2q, 8
+    add           p3q, 8
+    add           c0q, 8
+    add           c2q, 8
+    sub            kq, 4
+    jg .loop_k
+    phaddd         m0, m1
+    paddd          m0, m5
+    psrad          m0, 20
+    packssdw       m0, m0
+    packuswb       m0, m0
+    movd       [dstq], m0
+    add          dstq, 4
+    add          posq, 16
+    lea       coeffsq, [coeffsq + 8*tapsq]
+    sub        widthq, 4
+    jg .loop_x
+    RET
+
+%endif ; ARCH_X86_64
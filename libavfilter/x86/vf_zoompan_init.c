@@ -0,0 +1,79 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/zoompan.h"
+
+/* The assembly only handles whole blocks of STEP samples; the remaining
+ * ones are done by the C versions. */
+#define VFILTER_ROW_FUNC(OPT, STEP)                                            \
+void ff_zoompan_vfilter_row_##OPT(int16_t *dst, const uint8_t *src,            \
+                                  ptrdiff_t linesize, const int16_t *coeffs,   \
+                                  int taps, int width);                        \
+                                                                               \
+static void vfilter_row_##OPT(int16_t *dst, const uint8_t *src,                \
+                              ptrdiff_t linesize, const int16_t *coeffs,       \
+                              int taps, int width)                             \
+{                                                                              \
+    const int awidth = width & ~(STEP - 1);                                    \
+                                                                               \
+    if (awidth)                                                                \
+        ff_zoompan_vfilter_row_##OPT(dst, src, linesize, coeffs, taps, awidth);\
+    ff_zoompan_vfilter_row_c(dst + awidth, src + awidth, linesize, coeffs,     \
+                             taps, width - awidth);                            \
+}
+
+#if HAVE_X86ASM && ARCH_X86_64
+VFILTER_ROW_FUNC(sse2,  8)
+#if HAVE_AVX2_EXTERNAL
+VFILTER_ROW_FUNC(avx2, 16)
+#endif
+
+void ff_zoompan_hfilter_row_ssse3(uint8_t *dst, const int16_t *src, const int *pos,
+                                  const int16_t *coeffs, int taps, int width);
+
+static void hfilter_row_ssse3(uint8_t *dst, const int16_t *src, const int *pos,
+                              const int16_t *coeffs, int taps, int width)
+{
+    const int awidth = width & ~3;
+
+    if (awidth)
+        ff_zoompan_hfilter_row_ssse3(dst, src, pos, coeffs, taps, awidth);
+    ff_zoompan_hfilter_row_c(dst + awidth, src, pos + awidth,
+                             coeffs + awidth * taps, taps, width - awidth);
+}
+#endif
+
+av_cold void ff_zoompan_init_x86(ZoompanDSPContext *dsp)
+{
+#if HAVE_X86ASM && ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        dsp->vfilter_row = vfilter_row_sse2;
+    if (EXTERNAL_SSSE3(cpu_flags))
+        dsp->hfilter_row = hfilter_row_ssse3;
+#if HAVE_AVX2_EXTERNAL
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        dsp->vfilter_row = vfilter_row_avx2;
+#endif
+#endif
+}
@@ -88,7 +88,13 @@ typedef struct YADIFContext {
     int current_field;  ///< YADIFCurrentField
 } YADIFContext;
 
+/**
+ * Set filter_line and filter_edges for the bit depth of yadif->csp.
+ */
+void ff_yadif_init_filter_line(YADIFContext *yadif);
+
 void ff_yadif_init_x86(YADIFContext *yadif);
+void ff_yadif_init_aarch64(YADIFContext *yadif);
 
 int ff_yadif_filter_frame(AVFilterLink *link, AVFrame *frame);
 
@@ -0,0 +1,54 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_ZOOMPAN_H
+#define AVFILTER_ZOOMPAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ZOOMPAN_COEFF_BITS 14
+
+typedef struct ZoompanDSPContext {
+    /**
+     * Vertical pass of the bicubic resampler:
+     * dst[x] = (sum over k < taps of coeffs[k] * src[k * linesize + x] + 128) >> 8,
+     * keeping 6 fractional bits. When taps is odd, coeffs[taps] must be 0.
+     */
+    void (*vfilter_row)(int16_t *dst, const uint8_t *src, ptrdiff_t linesize,
+                        const int16_t *coeffs, int taps, int width);
+
+    /**
+     * Horizontal pass of the bicubic resampler:
+     * dst[x] = clip((sum over k < taps of coeffs[x * taps + k] * src[pos[x] + k]
+     *               + (1 << 19)) >> 20).
+     * taps must be a multiple of 4.
+     */
+    void (*hfilter_row)(uint8_t *dst, const int16_t *src, const int *pos,
+                        const int16_t *coeffs, int taps, int width);
+} ZoompanDSPContext;
+
+void ff_zoompan_vfilter_row_c(int16_t *dst, const uint8_t *src, ptrdiff_t linesize,
+                              const int16_t *coeffs, int taps, int width);
+void ff_zoompan_hfilter_row_c(uint8_t *dst, const int16_t *src, const int *pos,
+                              const int16_t *coeffs, int taps, int width);
+
+void ff_zoompan_init(ZoompanDSPContext *dsp);
+void ff_zoompan_init_x86(ZoompanDSPContext *dsp);
+
+#endif /* AVFILTER_ZOOMPAN_H */
@@ -65,6 +65,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     av_freep(&sti->priv_pts);
     av_freep(&sti->index_entries);
     av_freep(&sti->probe_data.buf);
+    avpriv_packet_list_free(&sti->interleave_queue);
 
     av_bsf_free(&sti->extract_extradata.bsf);
 
@@ -139,6 +140,7 @@ void avformat_free_context(AVFormatContext *s)
     av_packet_free(&si->pkt);
     av_packet_free(&si->parse_pkt);
     av_freep(&s->streams);
+    av_freep(&si->interleave_heap);
     ff_flush_packet_queue(s);
     av_freep(&s->url);
     av_free(s);
@@ -224,7 +226,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
  * @param src pointer to source AVStream
  * @return >=0 on success, AVERROR code on error
  */
-static int stream_params_copy(AVStream *dst, const AVStream *src)
+int ff_stream_params_copy(AVStream *dst, const AVStream *src)
 {
     int ret;
 
@@ -269,7 +271,7 @@ AVStream *ff_stream_clone(AVFormatContext *dst_ctx, const AVStream *src)
     if (!st)
         return NULL;
 
-    ret = stream_params_copy(st, src);
+    ret = ff_stream_params_copy(st, src);
     if (ret < 0) {
         ff_remove_stream(dst_ctx, st);
         return NULL;
@@ -1726,6 +1726,16 @@ typedef struct AVFormatContext {
      * @return 0 on success, a negative AVERROR code on failure
      */
     int (*io_close2)(struct AVFormatContext *s, AVIOContext *pb);
+
+    /**
+     * Number of threads used by avformat_find_stream_info() to decode the
+     * streams in parallel, 0 for automatic. Packets are still read on the
+     * calling thread. With more than one thread the log callback and the
+     * decoders may be called from other threads.
+     * - encoding: unused
+     * - decoding: set by user
+     */
+    int stream_info_threads;
 } AVFormatContext;
 
 /**
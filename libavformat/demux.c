@@ -25,12 +25,14 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/cpu.h"
 #include "libavutil/dict.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -1250,6 +1252,73 @@ static int64_t ts_to_samples(AVStream *st, int64_t ts)
     return av_rescale(ts, st->time_base.num * st->codecpar->sample_rate, st->time_base.den);
 }
 
+#if HAVE_THREADS
+typedef struct StreamInfoThread {
+    struct StreamInfoWorkers *w;
+    pthread_t thread;
+    AVPacket *pkt;
+} StreamInfoThread;
+
+/**
+ * Worker threads decoding packets for avformat_find_stream_info().
+ *
+ * Packets are still read, parsed and accounted on the calling thread, only
+ * the decoding is moved to the workers. A stream is decoded by at most one
+ * worker at a time, and the calling thread waits for a stream to be idle
+ * before touching its codec context again, so the result is the same as
+ * when decoding on the calling thread.
+ */
+typedef struct StreamInfoWorkers {
+    StreamInfoThread *threads;
+    int nb_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  work_cond;
+    pthread_cond_t  done_cond;
+    /* streams with queued work not yet picked up by a worker */
+    FFStream *ready_head, *ready_tail;
+    int exit;
+} StreamInfoWorkers;
+
+static int stream_info_busy(StreamInfoWorkers *w, FFStream *sti)
+{
+    int busy;
+
+    pthread_mutex_lock(&w->lock);
+    busy = sti->info->decode_busy;
+    pthread_mutex_unlock(&w->lock);
+
+    return busy;
+}
+
+static void stream_info_wait(StreamInfoWorkers *w, FFStream *sti)
+{
+    pthread_mutex_lock(&w->lock);
+    while (sti->info->decode_busy)
+        pthread_cond_wait(&w->done_cond, &w->lock);
+    pthread_mutex_unlock(&w->lock);
+}
+#else
+static int stream_info_busy(struct StreamInfoWorkers *w, FFStream *sti)
+{
+    return 0;
+}
+
+static void stream_info_wait(struct StreamInfoWorkers *w, FFStream *sti)
+{
+}
+#endif
+
+static void stream_info_wait_all(AVFormatContext *s)
+{
+    struct StreamInfoWorkers *const w = ffformatcontext(s)->stream_info_workers;
+
+    if (!w)
+        return;
+    for (unsigned i = 0; i < s->nb_streams; i++)
+        stream_info_wait(w, ffstream(s->streams[i]));
+}
+
 static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
 {
     FFFormatContext *const si = ffformatcontext(s);
@@ -1265,6 +1334,7 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             if (ret == AVERROR(EAGAIN))
                 return ret;
+            stream_info_wait_all(s);
             /* flush the parsers */
             for (unsigned i = 0; i < s->nb_streams; i++) {
                 AVStream *const st  = s->streams[i];
@@ -1280,6 +1350,9 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
         st  = s->streams[pkt->stream_index];
         sti = ffstream(st);
 
+        if (si->stream_info_workers)
+            stream_info_wait(si->stream_info_workers, sti);
+
         st->event_flags |= AVSTREAM_EVENT_FLAG_NEW_PACKETS;
 
         /* update context if required */
@@ -2005,34 +2078,32 @@ static int has_codec_parameters(const AVStream *st, const char **errmsg_ptr)
     return 1;
 }
 
-/* returns 1 or 0 if or if not decoded data was returned, or a negative error */
-static int try_decode_frame(AVFormatContext *s, AVStream *st,
-                            const AVPacket *pkt, AVDictionary **options)
+static int probe_decoder_needs_open(const AVStream *st)
+{
+    const FFStream *const sti = cffstream(st);
+
+    return !avcodec_is_open(sti->avctx) &&
+           sti->info->found_decoder <= 0 &&
+           (st->codecpar->codec_id != -sti->info->found_decoder || !st->codecpar->codec_id);
+}
+
+/* returns 0 if the stream can be decoded, a negative value otherwise */
+static int open_probe_decoder(AVFormatContext *s, AVStream *st,
+                              AVDictionary **options)
 {
     FFStream *const sti = ffstream(st);
     AVCodecContext *const avctx = sti->avctx;
     const AVCodec *codec;
-    int got_picture = 1, ret = 0;
-    AVFrame *frame = av_frame_alloc();
-    AVSubtitle subtitle;
-    int do_skip_frame = 0;
-    enum AVDiscard skip_frame;
-    int pkt_to_send = pkt->size > 0;
-
-    if (!frame)
-        return AVERROR(ENOMEM);
+    int ret;
 
-    if (!avcodec_is_open(avctx) &&
-        sti->info->found_decoder <= 0 &&
-        (st->codecpar->codec_id != -sti->info->found_decoder || !st->codecpar->codec_id)) {
+    if (probe_decoder_needs_open(st)) {
         AVDictionary *thread_opt = NULL;
 
         codec = find_probe_decoder(s, st, st->codecpar->codec_id);
 
         if (!codec) {
             sti->info->found_decoder = -st->codecpar->codec_id;
-            ret                     = -1;
-            goto fail;
+            return -1;
         }
 
         /* Force thread count to 1 since the H.264 decoder will not extract
@@ -2049,16 +2120,29 @@ static int try_decode_frame(AVFormatContext *s, AVStream *st,
             av_dict_free(&thread_opt);
         if (ret < 0) {
             sti->info->found_decoder = -avctx->codec_id;
-            goto fail;
+            return ret;
         }
         sti->info->found_decoder = 1;
     } else if (!sti->info->found_decoder)
         sti->info->found_decoder = 1;
 
-    if (sti->info->found_decoder < 0) {
-        ret = -1;
-        goto fail;
-    }
+    return sti->info->found_decoder < 0 ? -1 : 0;
+}
+
+/* returns 1 or 0 if or if not decoded data was returned, or a negative error */
+static int decode_probe_frame(AVStream *st, const AVPacket *pkt)
+{
+    FFStream *const sti = ffstream(st);
+    AVCodecContext *const avctx = sti->avctx;
+    int got_picture = 1, ret = 0;
+    AVFrame *frame = av_frame_alloc();
+    AVSubtitle subtitle;
+    int do_skip_frame = 0;
+    enum AVDiscard skip_frame;
+    int pkt_to_send = pkt->size > 0;
+
+    if (!frame)
+        return AVERROR(ENOMEM);
 
     if (avpriv_codec_get_cap_skip_frame_fill_param(avctx->codec)) {
         do_skip_frame = 1;
@@ -2099,7 +2183,6 @@ static int try_decode_frame(AVFormatContext *s, AVStream *st,
         }
     }
 
-fail:
     if (do_skip_frame) {
         avctx->skip_frame = skip_frame;
     }
@@ -2108,6 +2191,241 @@ fail:
     return ret;
 }
 
+/* returns 1 or 0 if or if not decoded data was returned, or a negative error */
+static int try_decode_frame(AVFormatContext *s, AVStream *st,
+                            const AVPacket *pkt, AVDictionary **options)
+{
+    int ret = open_probe_decoder(s, st, options);
+    if (ret < 0)
+        return ret;
+    return decode_probe_frame(st, pkt);
+}
+
+#if HAVE_THREADS
+static void stream_info_push_ready(StreamInfoWorkers *w, FFStream *sti)
+{
+    sti->info->decode_next = NULL;
+    if (w->ready_tail)
+        w->ready_tail->info->decode_next = sti;
+    else
+        w->ready_head = sti;
+    w->ready_tail = sti;
+}
+
+static void *stream_info_worker(void *arg)
+{
+    StreamInfoThread *const thread = arg;
+    StreamInfoWorkers *const w = thread->w;
+
+    pthread_mutex_lock(&w->lock);
+    while (1) {
+        FFStream *sti;
+        int flush, ret;
+
+        while (!w->exit && !w->ready_head)
+            pthread_cond_wait(&w->work_cond, &w->lock);
+        if (w->exit)
+            break;
+
+        sti = w->ready_head;
+        w->ready_head = sti->info->decode_next;
+        if (!w->ready_head)
+            w->ready_tail = NULL;
+
+        flush = avpriv_packet_list_get(&sti->info->decode_queue, thread->pkt) < 0;
+        if (flush)
+            sti->info->decode_flush = 0;
+        pthread_mutex_unlock(&w->lock);
+
+        ret = decode_probe_frame(&sti->pub, thread->pkt);
+        av_packet_unref(thread->pkt);
+        if (!flush)
+            sti->codec_info_nb_frames++;
+
+        pthread_mutex_lock(&w->lock);
+        sti->info->decode_ret = ret;
+        if (sti->info->decode_queue.head || sti->info->decode_flush) {
+            stream_info_push_ready(w, sti);
+        } else {
+            sti->info->decode_busy = 0;
+            pthread_cond_broadcast(&w->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+/**
+ * Queue a packet for decoding, or a decoder flush if pkt is NULL.
+ * codec_info_nb_frames is incremented once the packet has been decoded.
+ */
+static int stream_info_queue(StreamInfoWorkers *w, FFStream *sti,
+                             const AVPacket *pkt)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&w->lock);
+    if (pkt)
+        ret = avpriv_packet_list_put(&sti->info->decode_queue,
+                                     (AVPacket *)pkt, av_packet_ref, 0);
+    else
+        sti->info->decode_flush = 1;
+    if (ret >= 0 && !sti->info->decode_busy) {
+        sti->info->decode_busy = 1;
+        stream_info_push_ready(w, sti);
+        pthread_cond_signal(&w->work_cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return ret;
+}
+
+static void stream_info_workers_free(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    StreamInfoWorkers *const w = si->stream_info_workers;
+
+    if (!w)
+        return;
+
+    pthread_mutex_lock(&w->lock);
+    w->exit = 1;
+    pthread_cond_broadcast(&w->work_cond);
+    pthread_mutex_unlock(&w->lock);
+
+    for (int i = 0; i < w->nb_threads; i++) {
+        pthread_join(w->threads[i].thread, NULL);
+        av_packet_free(&w->threads[i].pkt);
+    }
+    av_freep(&w->threads);
+
+    for (unsigned i = 0; i < s->nb_streams; i++) {
+        FFStreamInfo *const info = ffstream(s->streams[i])->info;
+        if (!info)
+            continue;
+        avpriv_packet_list_free(&info->decode_queue);
+        info->decode_flush = 0;
+        info->decode_busy  = 0;
+        info->decode_next  = NULL;
+    }
+
+    pthread_cond_destroy(&w->done_cond);
+    pthread_cond_destroy(&w->work_cond);
+    pthread_mutex_destroy(&w->lock);
+    av_freep(&si->stream_info_workers);
+}
+
+static int stream_info_workers_init(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    StreamInfoWorkers *w;
+    int nb_threads = s->stream_info_threads;
+    int ret;
+
+    if (!nb_threads)
+        nb_threads = FFMIN(av_cpu_count(), 16);
+    /* Without a header all streams may not be known yet. */
+    if (!(s->ctx_flags & AVFMTCTX_NOHEADER))
+        nb_threads = FFMIN(nb_threads, s->nb_streams);
+    if (nb_threads <= 1)
+        return 0;
+
+    w = av_mallocz(sizeof(*w));
+    if (!w)
+        return AVERROR(ENOMEM);
+    w->threads = av_calloc(nb_threads, sizeof(*w->threads));
+    if (!w->threads) {
+        av_free(w);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_mutex_init(&w->lock, NULL))) {
+        av_freep(&w->threads);
+        av_free(w);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&w->work_cond, NULL))) {
+        pthread_mutex_destroy(&w->lock);
+        av_freep(&w->threads);
+        av_free(w);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&w->done_cond, NULL))) {
+        pthread_cond_destroy(&w->work_cond);
+        pthread_mutex_destroy(&w->lock);
+        av_freep(&w->threads);
+        av_free(w);
+        return AVERROR(ret);
+    }
+    si->stream_info_workers = w;
+
+    for (int i = 0; i < nb_threads; i++) {
+        StreamInfoThread *const thread = &w->threads[i];
+
+        thread->w   = w;
+        thread->pkt = av_packet_alloc();
+        if (!thread->pkt) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        if ((ret = pthread_create(&thread->thread, NULL, stream_info_worker, thread))) {
+            av_packet_free(&thread->pkt);
+            ret = AVERROR(ret);
+            break;
+        }
+        w->nb_threads++;
+    }
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Could only start %d of %d stream info "
+               "threads: %s\n", w->nb_threads, nb_threads, av_err2str(ret));
+        if (!w->nb_threads)
+            stream_info_workers_free(s);
+    }
+
+    return 0;
+}
+#else
+static int stream_info_queue(struct StreamInfoWorkers *w, FFStream *sti,
+                             const AVPacket *pkt)
+{
+    return AVERROR(ENOSYS);
+}
+
+static void stream_info_workers_free(AVFormatContext *s)
+{
+}
+
+static int stream_info_workers_init(AVFormatContext *s)
+{
+    return 0;
+}
+#endif
+
+/**
+ * Decode a packet read by avformat_find_stream_info(), on a worker thread
+ * when there are any. The decoder is opened on the calling thread, as the
+ * options are shared with it.
+ */
+static int queue_probe_frame(AVFormatContext *s, AVStream *st,
+                             const AVPacket *pkt, AVDictionary **options)
+{
+    struct StreamInfoWorkers *const w = ffformatcontext(s)->stream_info_workers;
+    FFStream *const sti = ffstream(st);
+
+    if (!w) {
+        try_decode_frame(s, st, pkt, options);
+        sti->codec_info_nb_frames++;
+        return 0;
+    }
+
+    if (open_probe_decoder(s, st, options) < 0) {
+        sti->codec_info_nb_frames++;
+        return 0;
+    }
+    return stream_info_queue(w, sti, pkt);
+}
+
 static int chapter_start_cmp(const void *p1, const void *p2)
 {
     const AVChapter *const ch1 = *(AVChapter**)p1;
@@ -2433,6 +2751,99 @@ static int extract_extradata(FFFormatContext *si, AVStream *st, const AVPacket *
     return 0;
 }
 
+/* returns 1 if no more packets are needed for the stream */
+static int stream_info_complete(AVFormatContext *ic, AVStream *st)
+{
+    FFStream *const sti = ffstream(st);
+    int fps_analyze_framecount = 20;
+    int count;
+
+    if (!has_codec_parameters(st, NULL))
+        return 0;
+    /* If the timebase is coarse (like the usual millisecond precision
+     * of mkv), we need to analyze more frames to reliably arrive at
+     * the correct fps. */
+    if (av_q2d(st->time_base) > 0.0005)
+        fps_analyze_framecount *= 2;
+    if (!tb_unreliable(ic, st))
+        fps_analyze_framecount = 0;
+    if (ic->fps_probe_size >= 0)
+        fps_analyze_framecount = ic->fps_probe_size;
+    if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
+        fps_analyze_framecount = 0;
+    /* variable fps and no guess at the real fps */
+    count = (ic->iformat->flags & AVFMT_NOTIMESTAMPS) ?
+               sti->info->codec_info_duration_fields/2 :
+               sti->info->duration_count;
+    if (!(st->r_frame_rate.num && st->avg_frame_rate.num) &&
+        st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+        if (count < fps_analyze_framecount)
+            return 0;
+    }
+    // Look at the first 3 frames if there is evidence of frame delay
+    // but the decoder delay is not set.
+    if (sti->info->frame_delay_evidence && count < 2 && sti->avctx->has_b_frames == 0)
+        return 0;
+    if (!sti->avctx->extradata &&
+        (!sti->extract_extradata.inited || sti->extract_extradata.bsf) &&
+        extract_extradata_check(st))
+        return 0;
+    if (sti->first_dts == AV_NOPTS_VALUE &&
+        (!(ic->iformat->flags & AVFMT_NOTIMESTAMPS) || sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) &&
+        sti->codec_info_nb_frames < ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : ic->max_ts_probe) &&
+        (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
+         st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO))
+        return 0;
+
+    return 1;
+}
+
+/**
+ * Return the index of the first stream needing more packets, or nb_streams
+ * if there is none.
+ *
+ * Streams still being decoded by a worker thread are skipped, so the index
+ * is exact only if need_index is set or nb_streams is returned. It is used
+ * to pick the options of the decoders opened later on.
+ */
+static unsigned first_incomplete_stream(AVFormatContext *ic, int need_index)
+{
+    struct StreamInfoWorkers *const w = ffformatcontext(ic)->stream_info_workers;
+    int skipped = 0;
+    unsigned i;
+
+    if (w && need_index) {
+        need_index = 0;
+        for (i = 0; i < ic->nb_streams; i++)
+            if (ic->streams[i]->codecpar->codec_id != AV_CODEC_ID_NONE &&
+                probe_decoder_needs_open(ic->streams[i]))
+                need_index = 1;
+    }
+
+    for (i = 0; i < ic->nb_streams; i++) {
+        AVStream *const st = ic->streams[i];
+
+        if (w && stream_info_busy(w, ffstream(st))) {
+            if (!need_index) {
+                skipped = 1;
+                continue;
+            }
+            stream_info_wait(w, ffstream(st));
+        }
+        if (!stream_info_complete(ic, st))
+            break;
+    }
+
+    if (skipped && i == ic->nb_streams) {
+        stream_info_wait_all(ic);
+        for (i = 0; i < ic->nb_streams; i++)
+            if (!stream_info_complete(ic, ic->streams[i]))
+                break;
+    }
+
+    return i;
+}
+
 int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 {
     FFFormatContext *const si = ffformatcontext(ic);
@@ -2528,6 +2939,12 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             av_dict_free(&thread_opt);
     }
 
+    if (ic->stream_info_threads != 1) {
+        ret = stream_info_workers_init(ic);
+        if (ret < 0)
+            goto find_stream_info_err;
+    }
+
     read_size = 0;
     for (;;) {
         const AVPacket *pkt;
@@ -2543,49 +2960,7 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         }
 
         /* check if one codec still needs to be handled */
-        for (i = 0; i < ic->nb_streams; i++) {
-            AVStream *const st  = ic->streams[i];
-            FFStream *const sti = ffstream(st);
-            int fps_analyze_framecount = 20;
-            int count;
-
-            if (!has_codec_parameters(st, NULL))
-                break;
-            /* If the timebase is coarse (like the usual millisecond precision
-             * of mkv), we need to analyze more frames to reliably arrive at
-             * the correct fps. */
-            if (av_q2d(st->time_base) > 0.0005)
-                fps_analyze_framecount *= 2;
-            if (!tb_unreliable(ic, st))
-                fps_analyze_framecount = 0;
-            if (ic->fps_probe_size >= 0)
-                fps_analyze_framecount = ic->fps_probe_size;
-            if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
-                fps_analyze_framecount = 0;
-            /* variable fps and no guess at the real fps */
-            count = (ic->iformat->flags & AVFMT_NOTIMESTAMPS) ?
-                       sti->info->codec_info_duration_fields/2 :
-                       sti->info->duration_count;
-            if (!(st->r_frame_rate.num && st->avg_frame_rate.num) &&
-                st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-                if (count < fps_analyze_framecount)
-                    break;
-            }
-            // Look at the first 3 frames if there is evidence of frame delay
-            // but the decoder delay is not set.
-            if (sti->info->frame_delay_evidence && count < 2 && sti->avctx->has_b_frames == 0)
-                break;
-            if (!sti->avctx->extradata &&
-                (!sti->extract_extradata.inited || sti->extract_extradata.bsf) &&
-                extract_extradata_check(st))
-                break;
-            if (sti->first_dts == AV_NOPTS_VALUE &&
-                (!(ic->iformat->flags & AVFMT_NOTIMESTAMPS) || sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) &&
-                sti->codec_info_nb_frames < ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : ic->max_ts_probe) &&
-                (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
-                 st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO))
-                break;
-        }
+        i = first_incomplete_stream(ic, options != NULL);
         analyzed_all_streams = 0;
         if (!missing_streams || !*missing_streams)
             if (i == ic->nb_streams) {
@@ -2644,6 +3019,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 
         st  = ic->streams[pkt->stream_index];
         sti = ffstream(st);
+        if (si->stream_info_workers)
+            stream_info_wait(si->stream_info_workers, sti);
         if (!(st->disposition & AV_DISPOSITION_ATTACHED_PIC))
             read_size += pkt->size;
 
@@ -2757,15 +3134,17 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        ret = queue_probe_frame(ic, st, pkt,
+                                (options && i < orig_nb_streams) ? &options[i] : NULL);
+        if (ret < 0)
+            goto unref_then_goto_end;
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt1);
 
-        sti->codec_info_nb_frames++;
         count++;
     }
+    stream_info_wait_all(ic);
 
     if (eof_reached) {
         for (unsigned stream_index = 0; stream_index < ic->nb_streams; stream_index++) {
@@ -2797,15 +3176,31 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         int err = 0;
         av_packet_unref(empty_pkt);
 
+        /* flush the decoders, all at once when there are worker threads */
+        for (unsigned i = 0; si->stream_info_workers && i < ic->nb_streams; i++) {
+            FFStream *const sti = ffstream(ic->streams[i]);
+
+            if (sti->info->found_decoder == 1) {
+                err = stream_info_queue(si->stream_info_workers, sti, NULL);
+                if (err < 0) {
+                    ret = err;
+                    goto find_stream_info_err;
+                }
+            }
+        }
+        stream_info_wait_all(ic);
+
         for (unsigned i = 0; i < ic->nb_streams; i++) {
             AVStream *const st  = ic->streams[i];
             FFStream *const sti = ffstream(st);
 
-            /* flush the decoders */
             if (sti->info->found_decoder == 1) {
-                err = try_decode_frame(ic, st, empty_pkt,
-                                        (options && i < orig_nb_streams)
-                                        ? &options[i] : NULL);
+                if (si->stream_info_workers)
+                    err = sti->info->decode_ret;
+                else
+                    err = try_decode_frame(ic, st, empty_pkt,
+                                           (options && i < orig_nb_streams)
+                                           ? &options[i] : NULL);
 
                 if (err < 0) {
                     av_log(ic, AV_LOG_INFO,
@@ -2814,6 +3209,7 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             }
         }
     }
+    stream_info_workers_free(ic);
 
     ff_rfps_calculate(ic);
 
@@ -3010,6 +3406,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     }
 
 find_stream_info_err:
+    stream_info_workers_free(ic);
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         AVStream *const st  = ic->streams[i];
         FFStream *const sti = ffstream(st);
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "libavutil/rational.h"
 #include "libavcodec/packet.h"
+#include "libavcodec/packet_internal.h"
 #include "avformat.h"
 
 #define MAX_STD_TIMEBASES (30*12+30+3+6)
@@ -53,6 +54,16 @@ typedef struct FFStreamInfo {
     int     fps_first_dts_idx;
     int64_t fps_last_dts;
     int     fps_last_dts_idx;
+
+    /**
+     * Decoding work handed to the avformat_find_stream_info() worker
+     * threads. All of these are protected by the worker pool lock.
+     */
+    PacketList decode_queue;        ///< packets waiting to be decoded
+    int decode_flush;               ///< a decoder flush is waiting
+    int decode_busy;                ///< work is queued or being done
+    int decode_ret;                 ///< result of the last decode call
+    struct FFStream *decode_next;   ///< next stream waiting for a worker
 } FFStreamInfo;
 
 /**
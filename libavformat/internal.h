@@ -79,6 +79,29 @@ typedef struct FFFormatContext {
      */
     int nb_interleaved_streams;
 
+    /**
+     * Streams with packets in their interleave_queue, kept as a binary
+     * min-heap ordered by the dts of the first queued packet.
+     * Only used by the generic dts interleaver. Muxing only.
+     */
+    int *interleave_heap;
+    unsigned nb_interleave_heap;
+    unsigned interleave_heap_size;
+
+    /**
+     * Number of streams the dts interleaver has to wait for before it can
+     * output a packet (see interleave_waits_for() in mux.c), and how many of
+     * them are currently in interleave_heap.
+     */
+    int nb_interleave_waiting;
+    int nb_interleave_waiting_queued;
+
+    /**
+     * Largest dts (in AV_TIME_BASE_Q) of the packets in the interleave
+     * queues; only valid while interleave_heap is not empty.
+     */
+    int64_t interleave_max_dts;
+
     /**
      * Whether the timestamp shift offset has already been determined.
      * -1: disabled, 0: not yet determined, 1: determined.
@@ -189,6 +212,12 @@ typedef struct FFFormatContext {
      * Contexts and child contexts do not contain a metadata option
      */
     int metafree;
+
+    /**
+     * Worker threads decoding for avformat_find_stream_info(),
+     * NULL outside of it or when it decodes on the calling thread.
+     */
+    struct StreamInfoWorkers *stream_info_workers;
 } FFFormatContext;
 
 static av_always_inline FFFormatContext *ffformatcontext(AVFormatContext *s)
@@ -379,6 +408,13 @@ typedef struct FFStream {
      */
     PacketListEntry *last_in_packet_buffer;
 
+    /**
+     * Packets of this stream queued by the generic dts interleaver, in
+     * dts order. When it is not empty, last_in_packet_buffer points to its
+     * last entry.
+     */
+    PacketList interleave_queue;
+
     int64_t last_IP_pts;
     int last_IP_duration;
 
@@ -638,6 +674,16 @@ enum AVCodecID ff_get_pcm_codec_id(int bps, int flt, int be, int sflags);
  */
 int ff_stream_side_data_copy(AVStream *dst, const AVStream *src);
 
+/**
+ * Copy all stream parameters from source to destination stream, with the
+ * exception of the index field, which is usually set by avformat_new_stream().
+ *
+ * @param dst pointer to destination AVStream
+ * @param src pointer to source AVStream
+ * @return >=0 on success, AVERROR code on error
+ */
+int ff_stream_params_copy(AVStream *dst, const AVStream *src);
+
 /**
  * Create a new stream and copy to it all parameters from a source stream, with
  * the exception of the index field, which is set when the new stream is
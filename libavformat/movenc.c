@@ -5740,6 +5740,93 @@ static void mov_parse_truehd_frame(AVPacket *pkt, MOVTrack *trk)
     return;
 }
 
+/* Packets at least this large are kept by reference until the fragment is
+ * written instead of being copied into the track's mdat_buf. */
+#define MOV_FRAG_REF_MIN_SIZE 4096
+
+static int64_t mov_frag_data_size(const MOVTrack *track)
+{
+    return (track->mdat_buf ? avio_tell(track->mdat_buf) : 0) + track->frag_ref_size;
+}
+
+static int mov_frag_add_chunk(MOVTrack *track, AVBufferRef *buf,
+                              const uint8_t *data, int size)
+{
+    MOVFragChunk *chunks = av_fast_realloc(track->frag_chunks,
+                                           &track->frag_chunks_allocated,
+                                           (track->nb_frag_chunks + 1) * sizeof(*chunks));
+    if (!chunks)
+        return AVERROR(ENOMEM);
+    track->frag_chunks = chunks;
+    chunks[track->nb_frag_chunks].buf  = buf;
+    chunks[track->nb_frag_chunks].data = data;
+    chunks[track->nb_frag_chunks].size = size;
+    track->nb_frag_chunks++;
+    return 0;
+}
+
+/**
+ * Append size bytes of the packet payload to the current fragment of the
+ * track without copying them; they are written out directly after the moof
+ * by mov_write_frag_data().
+ */
+static int mov_frag_ref_packet(MOVTrack *track, const AVPacket *pkt, int size)
+{
+    int64_t buffered = avio_tell(track->mdat_buf) - track->frag_buf_pos;
+    AVBufferRef *buf;
+    int ret;
+
+    if (buffered > 0) {
+        if ((ret = mov_frag_add_chunk(track, NULL, NULL, buffered)) < 0)
+            return ret;
+        track->frag_buf_pos += buffered;
+    }
+
+    buf = av_buffer_ref(pkt->buf);
+    if (!buf)
+        return AVERROR(ENOMEM);
+    if ((ret = mov_frag_add_chunk(track, buf, pkt->data, size)) < 0) {
+        av_buffer_unref(&buf);
+        return ret;
+    }
+    track->frag_ref_size += size;
+    return 0;
+}
+
+static void mov_frag_free_chunks(MOVTrack *track)
+{
+    for (int i = 0; i < track->nb_frag_chunks; i++)
+        av_buffer_unref(&track->frag_chunks[i].buf);
+    track->nb_frag_chunks = 0;
+    track->frag_ref_size  = 0;
+    track->frag_buf_pos   = 0;
+}
+
+/**
+ * Write the sample data of the current fragment of the track to pb,
+ * interleaving the referenced packets with the runs stored in mdat_buf.
+ */
+static void mov_write_frag_data(AVIOContext *pb, MOVTrack *track)
+{
+    uint8_t *buf;
+    int buf_size = avio_get_dyn_buf(track->mdat_buf, &buf);
+    int buf_pos  = 0;
+
+    for (int i = 0; i < track->nb_frag_chunks; i++) {
+        const MOVFragChunk *chunk = &track->frag_chunks[i];
+        if (chunk->buf) {
+            avio_write(pb, chunk->data, chunk->size);
+        } else {
+            avio_write(pb, buf + buf_pos, chunk->size);
+            buf_pos += chunk->size;
+        }
+    }
+    avio_write(pb, buf + buf_pos, buf_size - buf_pos);
+
+    mov_frag_free_chunks(track);
+    ffio_free_dyn_buf(&track->mdat_buf);
+}
+
 static int mov_flush_fragment_interleaving(AVFormatContext *s, MOVTrack *track)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -5973,8 +6060,7 @@ static int mov_flush_fragment(AVFormatContext *s, int force)
         }
         if (!track->entry)
             continue;
-        if (track->mdat_buf)
-            mdat_size += avio_tell(track->mdat_buf);
+        mdat_size += mov_frag_data_size(track);
         if (first_track < 0)
             first_track = i;
     }
@@ -5994,7 +6080,7 @@ static int mov_flush_fragment(AVFormatContext *s, int force)
         if (mov->flags & FF_MOV_FLAG_SEPARATE_MOOF) {
             if (!track->entry)
                 continue;
-            mdat_size = avio_tell(track->mdat_buf);
+            mdat_size = mov_frag_data_size(track);
             moof_tracks = i;
         } else {
             write_moof = i == first_track;
@@ -6014,19 +6100,14 @@ static int mov_flush_fragment(AVFormatContext *s, int force)
         track->entries_flushed = 0;
         track->end_reliable = 0;
         if (!mov->frag_interleave) {
-            if (!track->mdat_buf)
-                continue;
-            buf_size = avio_close_dyn_buf(track->mdat_buf, &buf);
-            track->mdat_buf = NULL;
-        } else {
-            if (!mov->mdat_buf)
-                continue;
+            if (track->mdat_buf)
+                mov_write_frag_data(s->pb, track);
+        } else if (mov->mdat_buf) {
             buf_size = avio_close_dyn_buf(mov->mdat_buf, &buf);
             mov->mdat_buf = NULL;
+            avio_write(s->pb, buf, buf_size);
+            av_free(buf);
         }
-
-        avio_write(s->pb, buf, buf_size);
-        av_free(buf);
     }
 
     mov->mdat_size = 0;
@@ -6288,6 +6369,10 @@ int ff_mov_write_packet(AVFormatContext *s, AVPacket *pkt)
             if (ret) {
                 goto err;
             }
+        } else if (pb == trk->mdat_buf && !mov->frag_interleave &&
+                   pkt->buf && size >= MOV_FRAG_REF_MIN_SIZE) {
+            if ((ret = mov_frag_ref_packet(trk, pkt, size)) < 0)
+                goto err;
         } else {
             avio_write(pb, pkt->data, size);
         }
@@ -6305,6 +6390,8 @@ int ff_mov_write_packet(AVFormatContext *s, AVPacket *pkt)
     }
 
     trk->cluster[trk->entry].pos              = avio_tell(pb) - size;
+    if (pb == trk->mdat_buf)
+        trk->cluster[trk->entry].pos         += trk->frag_ref_size;
     trk->cluster[trk->entry].samples_in_chunk = samples_in_chunk;
     trk->cluster[trk->entry].chunkNum         = 0;
     trk->cluster[trk->entry].size             = size;
@@ -6890,6 +6977,8 @@ static void mov_free(AVFormatContext *s)
 
         ff_mov_cenc_free(&track->cenc);
         ffio_free_dyn_buf(&track->mdat_buf);
+        mov_frag_free_chunks(track);
+        av_freep(&track->frag_chunks);
 
         avpriv_packet_list_free(&track->squashed_packet_queue);
     }
@@ -83,6 +83,16 @@ typedef struct MOVFragmentInfo {
     int size;
 } MOVFragmentInfo;
 
+/**
+ * A run of fragment sample data, either held by reference to the
+ * packet it came from or stored in the track's mdat_buf.
+ */
+typedef struct MOVFragChunk {
+    AVBufferRef *buf;   ///< packet data reference, NULL for a run of mdat_buf
+    const uint8_t *data;
+    int          size;
+} MOVFragChunk;
+
 typedef struct MOVTrack {
     int         mode;
     int         entry;
@@ -140,6 +150,11 @@ typedef struct MOVTrack {
     AVPacket *cover_image;
 
     AVIOContext *mdat_buf;
+    MOVFragChunk *frag_chunks;   ///< sample data of the current fragment, in order
+    int         nb_frag_chunks;
+    unsigned    frag_chunks_allocated;
+    int64_t     frag_ref_size;   ///< bytes of the fragment held by reference
+    int64_t     frag_buf_pos;    ///< bytes of mdat_buf covered by frag_chunks
     int64_t     data_offset;
     int         frag_discont;
     int         entries_flushed;
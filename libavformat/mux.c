@@ -181,6 +181,17 @@ static int validate_codec_tag(const AVFormatContext *s, const AVStream *st)
     return 1;
 }
 
+/**
+ * Whether the dts interleaver waits for packets of this stream before
+ * outputting anything, when max_interleave_delta is exceeded.
+ */
+static int interleave_waits_for(const AVCodecParameters *par)
+{
+    return par->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
+           par->codec_id   != AV_CODEC_ID_VP8 &&
+           par->codec_id   != AV_CODEC_ID_VP9 &&
+           par->codec_id   != AV_CODEC_ID_SMPTE_2038;
+}
 
 static int init_muxer(AVFormatContext *s, AVDictionary **options)
 {
@@ -332,6 +343,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
         if (par->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
             par->codec_id != AV_CODEC_ID_SMPTE_2038)
             si->nb_interleaved_streams++;
+        si->nb_interleave_waiting += interleave_waits_for(par);
     }
     si->interleave_packet = of->interleave_packet;
     if (!si->interleave_packet)
@@ -643,6 +655,24 @@ static void guess_pkt_duration(AVFormatContext *s, AVStream *st, AVPacket *pkt)
     }
 }
 
+static void lowest_queued_ts(AVFormatContext *s, const PacketListEntry *pktl,
+                             int use_pts, int64_t *ts, AVRational *tb)
+{
+    for (; pktl; pktl = pktl->next) {
+        AVRational cmp_tb = s->streams[pktl->pkt.stream_index]->time_base;
+        int64_t cmp_ts = use_pts ? pktl->pkt.pts : pktl->pkt.dts;
+        if (cmp_ts == AV_NOPTS_VALUE)
+            continue;
+        cmp_ts -= ffstream(s->streams[pktl->pkt.stream_index])->lowest_ts_allowed;
+        if (s->output_ts_offset)
+            cmp_ts += av_rescale_q(s->output_ts_offset, AV_TIME_BASE_Q, cmp_tb);
+        if (av_compare_ts(cmp_ts, cmp_tb, *ts, *tb) < 0) {
+            *ts = cmp_ts;
+            *tb = cmp_tb;
+        }
+    }
+}
+
 static void handle_avoid_negative_ts(FFFormatContext *si, FFStream *sti,
                                      AVPacket *pkt)
 {
@@ -664,19 +694,10 @@ static void handle_avoid_negative_ts(FFFormatContext *si, FFStream *sti,
 
         /* Peek into the muxing queue to improve our estimate
          * of the lowest timestamp if av_interleaved_write_frame() is used. */
-        for (const PacketListEntry *pktl = si->packet_buffer.head;
-             pktl; pktl = pktl->next) {
-            AVRational cmp_tb = s->streams[pktl->pkt.stream_index]->time_base;
-            int64_t cmp_ts = use_pts ? pktl->pkt.pts : pktl->pkt.dts;
-            if (cmp_ts == AV_NOPTS_VALUE)
-                continue;
-            cmp_ts -= ffstream(s->streams[pktl->pkt.stream_index])->lowest_ts_allowed;
-            if (s->output_ts_offset)
-                cmp_ts += av_rescale_q(s->output_ts_offset, AV_TIME_BASE_Q, cmp_tb);
-            if (av_compare_ts(cmp_ts, cmp_tb, ts, tb) < 0) {
-                ts = cmp_ts;
-                tb = cmp_tb;
-            }
+        lowest_queued_ts(s, si->packet_buffer.head, use_pts, &ts, &tb);
+        for (unsigned i = 0; i < si->nb_interleave_heap; i++) {
+            const FFStream *const sti2 = cffstream(s->streams[si->interleave_heap[i]]);
+            lowest_queued_ts(s, sti2->interleave_queue.head, use_pts, &ts, &tb);
         }
 
         if (ts < 0 ||
@@ -946,62 +967,261 @@ static int interleave_compare_dts(AVFormatContext *s, const AVPacket *next,
     return comp > 0;
 }
 
+/**
+ * Whether the first queued packet of stream a is output before the one
+ * of stream b. Never true for both orders, as ties are broken by the
+ * stream index.
+ */
+static int interleave_heap_before(AVFormatContext *s, int a, int b)
+{
+    const AVPacket *const pkt_a = &cffstream(s->streams[a])->interleave_queue.head->pkt;
+    const AVPacket *const pkt_b = &cffstream(s->streams[b])->interleave_queue.head->pkt;
+    return interleave_compare_dts(s, pkt_b, pkt_a);
+}
+
+static void interleave_heap_up(AVFormatContext *s, unsigned i)
+{
+    int *const heap = ffformatcontext(s)->interleave_heap;
+    int idx = heap[i];
+
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+        if (!interleave_heap_before(s, idx, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = idx;
+}
+
+static void interleave_heap_down(AVFormatContext *s, unsigned i)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    int *const heap = si->interleave_heap;
+    unsigned nb = si->nb_interleave_heap;
+    int idx = heap[i];
+
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= nb)
+            break;
+        if (child + 1 < nb && interleave_heap_before(s, heap[child + 1], heap[child]))
+            child++;
+        if (!interleave_heap_before(s, heap[child], idx))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = idx;
+}
+
+/**
+ * Unlink the first packet of the stream at the top of the heap.
+ * last_in_packet_buffer of the stream is left untouched.
+ */
+static PacketListEntry *interleave_heap_pop(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    AVStream *const st = s->streams[si->interleave_heap[0]];
+    PacketList *const queue = &ffstream(st)->interleave_queue;
+    PacketListEntry *const pktl = queue->head;
+
+    queue->head = pktl->next;
+    pktl->next  = NULL;
+    if (!queue->head) {
+        queue->tail = NULL;
+        si->nb_interleave_waiting_queued -= interleave_waits_for(st->codecpar);
+        si->interleave_heap[0] = si->interleave_heap[--si->nb_interleave_heap];
+    }
+    if (si->nb_interleave_heap)
+        interleave_heap_down(s, 0);
+
+    return pktl;
+}
+
+/**
+ * Move all queued packets to packet_buffer, in output order. The entries
+ * are relinked, so last_in_packet_buffer stays valid for every stream.
+ */
+static void interleave_queues_to_list(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    PacketList *const list = &si->packet_buffer;
+
+    while (si->nb_interleave_heap) {
+        PacketListEntry *const pktl = interleave_heap_pop(s);
+        if (list->tail)
+            list->tail->next = pktl;
+        else
+            list->head = pktl;
+        list->tail = pktl;
+    }
+}
+
+/**
+ * Whether packets can go to the per-stream interleave queues instead of
+ * packet_buffer. As long as the dts of every stream is nondecreasing,
+ * ff_interleave_add_packet() keeps packet_buffer sorted, which makes it
+ * the same as repeatedly taking the first packet of the stream whose
+ * queue head sorts first. Chunked interleaving and audio preloading do not
+ * order strictly by dts, and muxers without timestamps do not get their
+ * dts checked, so these always use the list.
+ */
+static int interleave_use_queues(AVFormatContext *s)
+{
+    return !ffformatcontext(s)->packet_buffer.head &&
+           !s->max_chunk_size && !s->max_chunk_duration &&
+           !s->audio_preload &&
+           !(s->oformat->flags & AVFMT_NOTIMESTAMPS);
+}
+
+static int interleave_queue_packet(AVFormatContext *s, AVPacket *pkt)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    AVStream *const st = s->streams[pkt->stream_index];
+    FFStream *const sti = ffstream(st);
+    PacketList *const queue = &sti->interleave_queue;
+    int64_t dts;
+    int ret;
+
+    if (queue->tail && interleave_compare_dts(s, &queue->tail->pkt, pkt)) {
+        /* The dts went backwards (possible after a dts of 0); only the
+         * list keeps the previous behaviour for this. */
+        interleave_queues_to_list(s);
+        return ff_interleave_add_packet(s, pkt, interleave_compare_dts);
+    }
+
+    if (si->interleave_heap_size < s->nb_streams) {
+        int *heap = av_realloc_array(si->interleave_heap, s->nb_streams,
+                                     sizeof(*heap));
+        if (!heap) {
+            av_packet_unref(pkt);
+            return AVERROR(ENOMEM);
+        }
+        si->interleave_heap      = heap;
+        si->interleave_heap_size = s->nb_streams;
+    }
+
+    if ((ret = avpriv_packet_list_put(queue, pkt, NULL, 0)) < 0) {
+        av_packet_unref(pkt);
+        return ret;
+    }
+    sti->last_in_packet_buffer = queue->tail;
+
+    /* Since the queues are drained in dts order, the largest dts can only
+     * leave them together with the last packet. */
+    dts = av_rescale_q(queue->tail->pkt.dts, st->time_base, AV_TIME_BASE_Q);
+    if (!si->nb_interleave_heap || dts > si->interleave_max_dts)
+        si->interleave_max_dts = dts;
+
+    if (queue->head == queue->tail) {
+        si->nb_interleave_waiting_queued += interleave_waits_for(st->codecpar);
+        si->interleave_heap[si->nb_interleave_heap++] = st->index;
+        interleave_heap_up(s, si->nb_interleave_heap - 1);
+    }
+
+    return 0;
+}
+
+static const PacketListEntry *interleave_top(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+
+    if (si->nb_interleave_heap)
+        return cffstream(s->streams[si->interleave_heap[0]])->interleave_queue.head;
+    return si->packet_buffer.head;
+}
+
+static void interleave_get_top(AVFormatContext *s, AVPacket *pkt)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    PacketListEntry *pktl;
+    FFStream *sti;
+
+    if (si->nb_interleave_heap) {
+        pktl = interleave_heap_pop(s);
+    } else {
+        pktl = si->packet_buffer.head;
+        si->packet_buffer.head = pktl->next;
+        if (!si->packet_buffer.head)
+            si->packet_buffer.tail = NULL;
+    }
+
+    sti = ffstream(s->streams[pktl->pkt.stream_index]);
+    if (sti->last_in_packet_buffer == pktl)
+        sti->last_in_packet_buffer = NULL;
+
+    av_packet_move_ref(pkt, &pktl->pkt);
+    av_free(pktl);
+}
+
 int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *pkt,
                                  int flush, int has_packet)
 {
     FFFormatContext *const si = ffformatcontext(s);
+    const PacketListEntry *top;
     int stream_count = 0;
     int noninterleaved_count = 0;
     int ret;
     int eof = flush;
 
     if (has_packet) {
-        if ((ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts)) < 0)
+        if (interleave_use_queues(s))
+            ret = interleave_queue_packet(s, pkt);
+        else
+            ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts);
+        if (ret < 0)
             return ret;
     }
 
-    for (unsigned i = 0; i < s->nb_streams; i++) {
-        const AVStream *const st  = s->streams[i];
-        const FFStream *const sti = cffstream(st);
-        const AVCodecParameters *const par = st->codecpar;
-        if (sti->last_in_packet_buffer) {
-            ++stream_count;
-        } else if (par->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
-                   par->codec_id != AV_CODEC_ID_VP8 &&
-                   par->codec_id != AV_CODEC_ID_VP9 &&
-                   par->codec_id != AV_CODEC_ID_SMPTE_2038) {
-            ++noninterleaved_count;
+    if (si->nb_interleave_heap) {
+        stream_count         = si->nb_interleave_heap;
+        noninterleaved_count = si->nb_interleave_waiting -
+                               si->nb_interleave_waiting_queued;
+    } else {
+        for (unsigned i = 0; i < s->nb_streams; i++) {
+            const AVStream *const st  = s->streams[i];
+            const FFStream *const sti = cffstream(st);
+            if (sti->last_in_packet_buffer)
+                ++stream_count;
+            else
+                noninterleaved_count += interleave_waits_for(st->codecpar);
         }
     }
 
     if (si->nb_interleaved_streams == stream_count)
         flush = 1;
 
+    top = interleave_top(s);
     if (s->max_interleave_delta > 0 &&
-        si->packet_buffer.head &&
-        si->packet_buffer.head->pkt.dts != AV_NOPTS_VALUE &&
+        top &&
+        top->pkt.dts != AV_NOPTS_VALUE &&
         !flush &&
         si->nb_interleaved_streams == stream_count+noninterleaved_count
     ) {
-        AVPacket *const top_pkt = &si->packet_buffer.head->pkt;
+        const AVPacket *const top_pkt = &top->pkt;
         int64_t delta_dts = INT64_MIN;
         int64_t top_dts = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
                                        AV_TIME_BASE_Q);
 
-        for (unsigned i = 0; i < s->nb_streams; i++) {
-            const AVStream *const st  = s->streams[i];
-            const FFStream *const sti = cffstream(st);
-            const PacketListEntry *const last = sti->last_in_packet_buffer;
-            int64_t last_dts;
+        if (si->nb_interleave_heap) {
+            delta_dts = si->interleave_max_dts - top_dts;
+        } else {
+            for (unsigned i = 0; i < s->nb_streams; i++) {
+                const AVStream *const st  = s->streams[i];
+                const FFStream *const sti = cffstream(st);
+                const PacketListEntry *const last = sti->last_in_packet_buffer;
+                int64_t last_dts;
 
-            if (!last)
-                continue;
+                if (!last)
+                    continue;
 
-            last_dts = av_rescale_q(last->pkt.dts,
-                                    st->time_base,
-                                    AV_TIME_BASE_Q);
-            delta_dts = FFMAX(delta_dts, last_dts - top_dts);
+                last_dts = av_rescale_q(last->pkt.dts,
+                                        st->time_base,
+                                        AV_TIME_BASE_Q);
+                delta_dts = FFMAX(delta_dts, last_dts - top_dts);
+            }
         }
 
         if (delta_dts > s->max_interleave_delta) {
@@ -1014,11 +1234,11 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *pkt,
     }
 
 #if FF_API_LAVF_SHORTEST
-    if (si->packet_buffer.head &&
+    if (top &&
         eof &&
         (s->flags & AVFMT_FLAG_SHORTEST) &&
         si->shortest_end == AV_NOPTS_VALUE) {
-        AVPacket *const top_pkt = &si->packet_buffer.head->pkt;
+        const AVPacket *const top_pkt = &top->pkt;
 
         si->shortest_end = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
@@ -1026,40 +1246,24 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *pkt,
     }
 
     if (si->shortest_end != AV_NOPTS_VALUE) {
-        while (si->packet_buffer.head) {
-            PacketListEntry *pktl = si->packet_buffer.head;
-            AVPacket *const top_pkt = &pktl->pkt;
-            AVStream *const st = s->streams[top_pkt->stream_index];
-            FFStream *const sti = ffstream(st);
-            int64_t top_dts = av_rescale_q(top_pkt->dts, st->time_base,
-                                        AV_TIME_BASE_Q);
+        while ((top = interleave_top(s))) {
+            const AVPacket *const top_pkt = &top->pkt;
+            int64_t top_dts = av_rescale_q(top_pkt->dts,
+                                           s->streams[top_pkt->stream_index]->time_base,
+                                           AV_TIME_BASE_Q);
 
             if (si->shortest_end + 1 >= top_dts)
                 break;
 
-            si->packet_buffer.head = pktl->next;
-            if (!si->packet_buffer.head)
-                si->packet_buffer.tail = NULL;
-
-            if (sti->last_in_packet_buffer == pktl)
-                sti->last_in_packet_buffer = NULL;
-
-            av_packet_unref(&pktl->pkt);
-            av_freep(&pktl);
+            interleave_get_top(s, pkt);
+            av_packet_unref(pkt);
             flush = 0;
         }
     }
 #endif
 
     if (stream_count && flush) {
-        PacketListEntry *pktl = si->packet_buffer.head;
-        AVStream *const st = s->streams[pktl->pkt.stream_index];
-        FFStream *const sti = ffstream(st);
-
-        if (sti->last_in_packet_buffer == pktl)
-            sti->last_in_packet_buffer = NULL;
-        avpriv_packet_list_get(&si->packet_buffer, pkt);
-
+        interleave_get_top(s, pkt);
         return 1;
     } else {
         return 0;
@@ -1091,7 +1295,11 @@ int ff_get_muxer_ts_offset(AVFormatContext *s, int stream_index, int64_t *offset
 const AVPacket *ff_interleaved_peek(AVFormatContext *s, int stream)
 {
     FFFormatContext *const si = ffformatcontext(s);
+    const FFStream *const sti = cffstream(s->streams[stream]);
     PacketListEntry *pktl = si->packet_buffer.head;
+
+    if (sti->interleave_queue.head)
+        return &sti->interleave_queue.head->pkt;
     while (pktl) {
         if (pktl->pkt.stream_index == stream) {
             return &pktl->pkt;
@@ -1334,6 +1542,45 @@ int av_write_trailer(AVFormatContext *s)
     return ret;
 }
 
+int ff_format_output_reset(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+
+    if (si->initialized || si->packet_buffer.head || si->nb_interleave_heap)
+        return AVERROR(EINVAL);
+
+    if (!s->priv_data && ffofmt(s->oformat)->priv_data_size > 0) {
+        s->priv_data = av_mallocz(ffofmt(s->oformat)->priv_data_size);
+        if (!s->priv_data)
+            return AVERROR(ENOMEM);
+        if (s->oformat->priv_class) {
+            *(const AVClass**)s->priv_data = s->oformat->priv_class;
+            av_opt_set_defaults(s->priv_data);
+        }
+    }
+
+    si->nb_interleaved_streams = 0;
+    si->nb_interleave_waiting  = 0;
+    si->shortest_end           = AV_NOPTS_VALUE;
+
+    for (unsigned i = 0; i < s->nb_streams; i++) {
+        FFStream *const sti = ffstream(s->streams[i]);
+
+        /* the bitstream filters have been flushed by the trailer */
+        av_bsf_free(&sti->bsfc);
+        sti->bitstream_checked          = 0;
+        sti->cur_dts                    = AV_NOPTS_VALUE;
+        sti->mux_ts_offset              = 0;
+        sti->interleaver_chunk_size     = 0;
+        sti->interleaver_chunk_duration = 0;
+        sti->last_in_packet_buffer      = NULL;
+        for (int j = 0; j < MAX_REORDER_DELAY + 1; j++)
+            sti->pts_buffer[j] = AV_NOPTS_VALUE;
+    }
+
+    return 0;
+}
+
 int av_get_output_timestamp(struct AVFormatContext *s, int stream,
                             int64_t *dts, int64_t *wall)
 {
@@ -211,6 +211,19 @@ enum AVWriteUncodedFrameFlags {
 
 };
 
+/**
+ * Reset the muxing state of a context whose trailer has been written, so
+ * that avformat_write_header() can be called on it again with the same
+ * streams, e.g. to start a new output file.
+ *
+ * The previous muxer instance may have changed the stream parameters, such
+ * as time_base or codecpar->codec_tag; the caller must restore them.
+ *
+ * @return 0 on success, a negative AVERROR code on failure, in particular
+ *         AVERROR(EINVAL) if the muxer is still initialized
+ */
+int ff_format_output_reset(AVFormatContext *s);
+
 /**
  * Make shift_size amount of space at read_start by shifting data in the output
  * at read_start until the current IO position. The underlying IO context must
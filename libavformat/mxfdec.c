@@ -290,6 +290,8 @@ typedef struct MXFIndexTable {
     int64_t *ptses;             /* maps EditUnit -> PTS */
     int nb_segments;
     MXFIndexTableSegment **segments;    /* sorted by IndexStartPosition */
+    uint64_t *segment_ends;     /* running maximum of the segment end positions */
+    int64_t *segment_offsets;   /* stream offset of the first edit unit of each segment */
     AVIndexEntry *fake_index;   /* used for calling ff_index_search_timestamp() */
     int8_t *offsets;            /* temporal offsets for display order to stored order conversion */
 } MXFIndexTable;
@@ -1885,45 +1887,84 @@ static int64_t mxf_essence_container_end(MXFContext *mxf, int body_sid)
     return 0;
 }
 
+/**
+ * Precompute the lookup tables used by mxf_edit_unit_absolute_offset()
+ * to find the segment containing an edit unit with a binary search.
+ */
+static int mxf_compute_index_lookup(MXFIndexTable *index_table)
+{
+    uint64_t end = 0;
+    int64_t offset = 0;
+
+    index_table->segment_ends    = av_malloc_array(index_table->nb_segments, sizeof(*index_table->segment_ends));
+    index_table->segment_offsets = av_malloc_array(index_table->nb_segments, sizeof(*index_table->segment_offsets));
+    if (!index_table->segment_ends || !index_table->segment_offsets)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < index_table->nb_segments; i++) {
+        MXFIndexTableSegment *s = index_table->segments[i];
+
+        if (s->index_duration)
+            end = FFMAX(end, s->index_start_position + s->index_duration);
+        index_table->segment_ends[i]    = end;
+        index_table->segment_offsets[i] = offset;
+        /* EditUnitByteCount == 0 for VBR indexes, which is fine since they use explicit StreamOffsets */
+        offset += s->edit_unit_byte_count * s->index_duration;
+    }
+
+    return 0;
+}
+
 /* EditUnit -> absolute offset */
 static int mxf_edit_unit_absolute_offset(MXFContext *mxf, MXFIndexTable *index_table, int64_t edit_unit, AVRational edit_rate, int64_t *edit_unit_out, int64_t *offset_out, MXFPartition **partition_out, int nag)
 {
-    int i;
-    int64_t offset_temp = 0;
+    int a, b, m;
+    int64_t offset_temp;
 
     edit_unit = av_rescale_q(edit_unit, index_table->segments[0]->index_edit_rate, edit_rate);
+    /* clamp if trying to seek before start, so that the search below
+     * compares a non-negative edit unit with the unsigned segment ends */
+    edit_unit = FFMAX(edit_unit, (int64_t)index_table->segments[0]->index_start_position);
 
-    for (i = 0; i < index_table->nb_segments; i++) {
-        MXFIndexTableSegment *s = index_table->segments[i];
+    /* find the first segment ending after edit_unit, edit units between
+     * segments belong to the next one */
+    a = -1;
+    b = index_table->nb_segments;
 
-        edit_unit = FFMAX(edit_unit, s->index_start_position);  /* clamp if trying to seek before start */
+    while (b - a > 1) {
+        m = (a + b) >> 1;
+        if (edit_unit < index_table->segment_ends[m])
+            b = m;
+        else
+            a = m;
+    }
 
-        if (edit_unit < s->index_start_position + s->index_duration) {
-            int64_t index = edit_unit - s->index_start_position;
+    if (b < index_table->nb_segments) {
+        MXFIndexTableSegment *s = index_table->segments[b];
+        int64_t index;
 
-            if (s->edit_unit_byte_count)
-                offset_temp += s->edit_unit_byte_count * index;
-            else {
-                if (s->nb_index_entries == 2 * s->index_duration + 1)
-                    index *= 2;     /* Avid index */
+        edit_unit = FFMAX(edit_unit, s->index_start_position);  /* clamp if in a gap before the segment */
+        index = edit_unit - s->index_start_position;
 
-                if (index < 0 || index >= s->nb_index_entries) {
-                    av_log(mxf->fc, AV_LOG_ERROR, "IndexSID %i segment at %"PRId64" IndexEntryArray too small\n",
-                           index_table->index_sid, s->index_start_position);
-                    return AVERROR_INVALIDDATA;
-                }
+        if (s->edit_unit_byte_count)
+            offset_temp = index_table->segment_offsets[b] + s->edit_unit_byte_count * index;
+        else {
+            if (s->nb_index_entries == 2 * s->index_duration + 1)
+                index *= 2;     /* Avid index */
 
-                offset_temp = s->stream_offset_entries[index];
+            if (index < 0 || index >= s->nb_index_entries) {
+                av_log(mxf->fc, AV_LOG_ERROR, "IndexSID %i segment at %"PRId64" IndexEntryArray too small\n",
+                       index_table->index_sid, s->index_start_position);
+                return AVERROR_INVALIDDATA;
             }
 
-            if (edit_unit_out)
-                *edit_unit_out = av_rescale_q(edit_unit, edit_rate, s->index_edit_rate);
-
-            return mxf_absolute_bodysid_offset(mxf, index_table->body_sid, offset_temp, offset_out, partition_out);
-        } else {
-            /* EditUnitByteCount == 0 for VBR indexes, which is fine since they use explicit StreamOffsets */
-            offset_temp += s->edit_unit_byte_count * s->index_duration;
+            offset_temp = s->stream_offset_entries[index];
         }
+
+        if (edit_unit_out)
+            *edit_unit_out = av_rescale_q(edit_unit, edit_rate, s->index_edit_rate);
+
+        return mxf_absolute_bodysid_offset(mxf, index_table->body_sid, offset_temp, offset_out, partition_out);
     }
 
     if (nag)
@@ -2162,6 +2203,9 @@ static int mxf_compute_index_tables(MXFContext *mxf)
             t->segments[k]->index_duration = mxf_track->original_duration;
             break;
         }
+
+        if ((ret = mxf_compute_index_lookup(t)) < 0)
+            goto finish_decoding_index;
     }
 
     ret = 0;
@@ -4152,6 +4196,8 @@ static int mxf_read_close(AVFormatContext *s)
     if (mxf->index_tables) {
         for (i = 0; i < mxf->nb_index_tables; i++) {
             av_freep(&mxf->index_tables[i].segments);
+            av_freep(&mxf->index_tables[i].segment_ends);
+            av_freep(&mxf->index_tables[i].segment_offsets);
             av_freep(&mxf->index_tables[i].ptses);
             av_freep(&mxf->index_tables[i].fake_index);
             av_freep(&mxf->index_tables[i].offsets);
@@ -110,6 +110,7 @@ typedef struct SegmentContext {
     int64_t time_delta;
     int  individual_header_trailer; /**< Set by a private option. */
     int  write_header_trailer; /**< Set by a private option. */
+    int  reuse_muxer;      ///< reset and reuse the segment muxer context instead of recreating it
     char *header_filename;  ///< filename to write the output header to
 
     int reset_timestamps;  ///< reset timestamps at the beginning of each segment
@@ -144,6 +145,26 @@ static void print_csv_escaped_str(AVIOContext *ctx, const char *str)
         avio_w8(ctx, '"');
 }
 
+static int segment_stream_params_copy(AVFormatContext *oc, AVStream *st,
+                                      const AVStream *ist)
+{
+    const AVCodecParameters *ipar = ist->codecpar;
+    AVCodecParameters *opar = st->codecpar;
+    int ret;
+
+    if ((ret = ff_stream_params_copy(st, ist)) < 0)
+        return ret;
+    if (!oc->oformat->codec_tag ||
+        av_codec_get_id (oc->oformat->codec_tag, ipar->codec_tag) == opar->codec_id ||
+        av_codec_get_tag(oc->oformat->codec_tag, ipar->codec_id) <= 0) {
+        opar->codec_tag = ipar->codec_tag;
+    } else {
+        opar->codec_tag = 0;
+    }
+
+    return 0;
+}
+
 static int segment_mux_init(AVFormatContext *s)
 {
     SegmentContext *seg = s->priv_data;
@@ -170,25 +191,37 @@ FF_ENABLE_DEPRECATION_WARNINGS
     oc->flags              = s->flags;
 
     for (i = 0; i < s->nb_streams; i++) {
-        AVStream *st, *ist = s->streams[i];
-        AVCodecParameters *ipar = ist->codecpar, *opar;
-
-        st = ff_stream_clone(oc, ist);
+        AVStream *st = avformat_new_stream(oc, NULL);
         if (!st)
             return AVERROR(ENOMEM);
-        opar = st->codecpar;
-        if (!oc->oformat->codec_tag ||
-            av_codec_get_id (oc->oformat->codec_tag, ipar->codec_tag) == opar->codec_id ||
-            av_codec_get_tag(oc->oformat->codec_tag, ipar->codec_id) <= 0) {
-            opar->codec_tag = ipar->codec_tag;
-        } else {
-            opar->codec_tag = 0;
-        }
+        if ((ret = segment_stream_params_copy(oc, st, s->streams[i])) < 0)
+            return ret;
     }
 
     return 0;
 }
 
+static int segment_mux_reset(AVFormatContext *s)
+{
+    SegmentContext *seg = s->priv_data;
+    AVFormatContext *oc = seg->avf;
+    int ret;
+
+    if ((ret = ff_format_output_reset(oc)) < 0)
+        return ret;
+
+    /* metadata may have been updated since, e.g. by increment_tc, and the
+     * previous muxer may have changed the stream parameters */
+    av_dict_free(&oc->metadata);
+    if ((ret = av_dict_copy(&oc->metadata, s->metadata, 0)) < 0)
+        return ret;
+    for (int i = 0; i < s->nb_streams; i++)
+        if ((ret = segment_stream_params_copy(oc, oc->streams[i], s->streams[i])) < 0)
+            return ret;
+
+    return 0;
+}
+
 static int set_segment_filename(AVFormatContext *s)
 {
     SegmentContext *seg = s->priv_data;
@@ -239,7 +272,10 @@ static int segment_start(AVFormatContext *s, int write_header)
     AVFormatContext *oc = seg->avf;
     int err = 0;
 
-    if (write_header) {
+    if (write_header && seg->reuse_muxer) {
+        if ((err = segment_mux_reset(s)) < 0)
+            return err;
+    } else if (write_header) {
         avformat_free_context(oc);
         seg->avf = NULL;
         if ((err = segment_mux_init(s)) < 0)
@@ -1077,6 +1113,7 @@ static const AVOption options[] = {
     { "individual_header_trailer", "write header/trailer to each segment", OFFSET(individual_header_trailer), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, E },
     { "write_header_trailer", "write a header to the first segment and a trailer to the last one", OFFSET(write_header_trailer), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, E },
     { "reset_timestamps", "reset timestamps at the beginning of each segment", OFFSET(reset_timestamps), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E },
+    { "reuse_muxer", "reuse the segment muxer context across segments", OFFSET(reuse_muxer), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E },
     { "initial_offset", "set initial timestamp offset", OFFSET(initial_offset), AV_OPT_TYPE_DURATION, {.i64 = 0}, -INT64_MAX, INT64_MAX, E },
     { "write_empty_segments", "allow writing empty 'filler' segments", OFFSET(write_empty), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E },
     { NULL },
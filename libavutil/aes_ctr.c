@@ -24,11 +24,15 @@
 #include "aes_ctr.h"
 #include "aes.h"
 #include "aes_internal.h"
+#include "intreadwrite.h"
 #include "macros.h"
 #include "mem.h"
 #include "random_seed.h"
 
 #define AES_BLOCK_SIZE (16)
+// number of counter blocks encrypted per av_aes_crypt() call, so that
+// SIMD implementations can pipeline several blocks
+#define AES_CTR_BATCH  (8)
 
 typedef struct AVAESCTR {
     uint8_t counter[AES_BLOCK_SIZE];
@@ -104,6 +108,29 @@ void av_aes_ctr_increment_iv(struct AVAESCTR *a)
     a->block_offset = 0;
 }
 
+static void aes_ctr_crypt_blocks(struct AVAESCTR *a, uint8_t *dst,
+                                 const uint8_t *src, int nb_blocks)
+{
+    DECLARE_ALIGNED(16, uint8_t, keystream)[AES_CTR_BATCH * AES_BLOCK_SIZE];
+
+    while (nb_blocks > 0) {
+        int n = FFMIN(nb_blocks, AES_CTR_BATCH);
+
+        for (int i = 0; i < n; i++) {
+            memcpy(keystream + i * AES_BLOCK_SIZE, a->counter, AES_BLOCK_SIZE);
+            av_aes_ctr_increment_be64(a->counter + 8);
+        }
+        av_aes_crypt(&a->aes, keystream, keystream, n, NULL, 0);
+
+        for (int i = 0; i < n * AES_BLOCK_SIZE; i += 8)
+            AV_WN64(dst + i, AV_RN64(src + i) ^ AV_RN64A(keystream + i));
+
+        src       += n * AES_BLOCK_SIZE;
+        dst       += n * AES_BLOCK_SIZE;
+        nb_blocks -= n;
+    }
+}
+
 void av_aes_ctr_crypt(struct AVAESCTR *a, uint8_t *dst, const uint8_t *src, int count)
 {
     const uint8_t* src_end = src + count;
@@ -111,6 +138,15 @@ void av_aes_ctr_crypt(struct AVAESCTR *a, uint8_t *dst, const uint8_t *src, int
     uint8_t* encrypted_counter_pos;
 
     while (src < src_end) {
+        if (a->block_offset == 0 && src_end - src >= AES_BLOCK_SIZE) {
+            int nb_blocks = (src_end - src) / AES_BLOCK_SIZE;
+
+            aes_ctr_crypt_blocks(a, dst, src, nb_blocks);
+            src += nb_blocks * AES_BLOCK_SIZE;
+            dst += nb_blocks * AES_BLOCK_SIZE;
+            continue;
+        }
+
         if (a->block_offset == 0) {
             av_aes_crypt(&a->aes, a->encrypted_counter, a->counter, 1, NULL, 0);
 
@@ -34,6 +34,7 @@
 #endif
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,6 +42,7 @@
 #include "common.h"
 #include "internal.h"
 #include "log.h"
+#include "mem.h"
 #include "thread.h"
 
 static AVMutex mutex = AV_MUTEX_INITIALIZER;
@@ -345,28 +347,17 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
     return ret;
 }
 
-void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+/* Write out one formatted message, called with the mutex held.
+ * Returns 0 if the message was folded into a repeat count. */
+static int log_output(int level, unsigned tint, const int type[2],
+                      char *part[4], int print_prefix)
 {
-    static int print_prefix = 1;
     static int count;
     static char prev[LINE_SZ];
-    AVBPrint part[4];
-    char line[LINE_SZ];
     static int is_atty;
-    int type[2];
-    unsigned tint = 0;
-
-    if (level >= 0) {
-        tint = level & 0xff00;
-        level &= 0xff;
-    }
-
-    if (level > av_log_level)
-        return;
-    ff_mutex_lock(&mutex);
+    char line[LINE_SZ];
 
-    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
-    snprintf(line, sizeof(line), "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
+    snprintf(line, sizeof(line), "%s%s%s%s", part[0], part[1], part[2], part[3]);
 
 #if HAVE_ISATTY
     if (!is_atty)
@@ -378,27 +369,467 @@ void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
         count++;
         if (is_atty == 1)
             fprintf(stderr, "    Last message repeated %d times\r", count);
-        goto end;
+        return 0;
     }
     if (count > 0) {
         fprintf(stderr, "    Last message repeated %d times\n", count);
         count = 0;
     }
     strcpy(prev, line);
-    sanitize(part[0].str);
-    colored_fputs(type[0], 0, part[0].str);
-    sanitize(part[1].str);
-    colored_fputs(type[1], 0, part[1].str);
-    sanitize(part[2].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2].str);
-    sanitize(part[3].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3].str);
+    sanitize(part[0]);
+    colored_fputs(type[0], 0, part[0]);
+    sanitize(part[1]);
+    colored_fputs(type[1], 0, part[1]);
+    sanitize(part[2]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2]);
+    sanitize(part[3]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3]);
+    return 1;
+}
+
+#if HAVE_PTHREADS
+/*
+ * Asynchronous logging: every logging thread formats its messages into its
+ * own single-producer ring buffer, which a writer thread drains in sequence
+ * number order. Logging threads thus never wait on each other or on stderr;
+ * when a ring is full the message is dropped and counted instead.
+ */
+
+typedef struct LogRecord {
+    unsigned seq;
+    int      level;
+    unsigned tint;
+    int      type[2];
+    int      print_prefix;
+    unsigned len[4];
+} LogRecord;
+
+typedef struct LogRing {
+    struct LogRing *next;
+    uint8_t        *buf;
+    size_t          size;           ///< power of two
+    atomic_size_t   head;           ///< written by the owning thread
+    atomic_size_t   tail;           ///< written by the writer thread
+    atomic_uint     dropped;
+    unsigned        dropped_reported;
+    int             print_prefix;
+    int             orphaned;       ///< owning thread exited, protected by async_lock
+} LogRing;
+
+static pthread_once_t  async_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   async_key;
+static int             async_key_err;
+static pthread_mutex_t async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t       async_writer;
+
+/* all protected by async_lock */
+static LogRing *async_rings;
+static size_t   async_buffer_size;
+static int      async_running;
+static int      async_stop;
+
+static atomic_int           async_enabled;
+static atomic_int           async_producers;
+static atomic_int           async_writer_idle;
+static atomic_uint          async_seq;
+static atomic_uint_least64_t async_dropped;
+
+/* the last message written by the writer did not end its line,
+ * protected by mutex */
+static int async_line_open;
+
+static void ring_copy_in(LogRing *r, size_t pos, const void *src, size_t len)
+{
+    size_t off = pos & (r->size - 1), n = FFMIN(len, r->size - off);
+
+    memcpy(r->buf + off, src, n);
+    memcpy(r->buf, (const uint8_t *)src + n, len - n);
+}
+
+static void ring_copy_out(const LogRing *r, size_t pos, void *dst, size_t len)
+{
+    size_t off = pos & (r->size - 1), n = FFMIN(len, r->size - off);
+
+    memcpy(dst, r->buf + off, n);
+    memcpy((uint8_t *)dst + n, r->buf, len - n);
+}
+
+static void ring_free(LogRing *ring)
+{
+    av_freep(&ring->buf);
+    av_free(ring);
+}
+
+static void ring_release(void *arg)
+{
+    LogRing *ring = arg;
+
+    pthread_mutex_lock(&async_lock);
+    if (async_running) {
+        /* the writer frees it once drained */
+        ring->orphaned = 1;
+    } else {
+        LogRing **p = &async_rings;
+        while (*p != ring)
+            p = &(*p)->next;
+        *p = ring->next;
+        ring_free(ring);
+    }
+    pthread_mutex_unlock(&async_lock);
+}
 
+static void async_init(void)
+{
+    async_key_err = pthread_key_create(&async_key, ring_release);
+}
+
+static LogRing *get_ring(void)
+{
+    LogRing *ring = pthread_getspecific(async_key);
+    int new_ring = !ring;
+
+    if (ring && ring->buf)
+        return ring;
+
+    if (new_ring) {
+        ring = av_mallocz(sizeof(*ring));
+        if (!ring)
+            return NULL;
+    }
+
+    /* the buffer of a ring that outlived av_log_set_async(0) was freed
+     * there and is allocated again here */
+    pthread_mutex_lock(&async_lock);
+    ring->size = async_buffer_size;
+    ring->buf  = av_malloc(ring->size);
+    if (!ring->buf) {
+        pthread_mutex_unlock(&async_lock);
+        if (new_ring)
+            av_free(ring);
+        return NULL;
+    }
+    ring->print_prefix = 1;
+    if (new_ring) {
+        ring->next  = async_rings;
+        async_rings = ring;
+    }
+    pthread_mutex_unlock(&async_lock);
+
+    if (new_ring)
+        pthread_setspecific(async_key, ring);
+    return ring;
+}
+
+/* Returns 1 if the message was queued or dropped, 0 if the caller has to
+ * write it out itself. */
+static int log_async(void *avcl, int level, unsigned tint, const char *fmt,
+                     va_list vl)
+{
+    AVBPrint part[4];
+    LogRecord rec;
+    LogRing *ring;
+    size_t head, need;
+    int ret = 0;
+
+    atomic_fetch_add(&async_producers, 1);
+    if (!atomic_load(&async_enabled) || !(ring = get_ring()))
+        goto end;
+    ret = 1;
+
+    format_line(avcl, level, fmt, vl, part, &ring->print_prefix, rec.type);
+    rec.level        = level;
+    rec.tint         = tint;
+    rec.print_prefix = ring->print_prefix;
+    need = sizeof(rec);
+    for (int i = 0; i < 4; i++) {
+        rec.len[i] = strlen(part[i].str);
+        need += rec.len[i];
+    }
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (need > ring->size - (head - atomic_load_explicit(&ring->tail, memory_order_acquire))) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&async_dropped, 1, memory_order_relaxed);
+        goto finish;
+    }
+
+    rec.seq = atomic_fetch_add_explicit(&async_seq, 1, memory_order_relaxed);
+    ring_copy_in(ring, head, &rec, sizeof(rec));
+    head += sizeof(rec);
+    for (int i = 0; i < 4; i++) {
+        ring_copy_in(ring, head, part[i].str, rec.len[i]);
+        head += rec.len[i];
+    }
+    atomic_store(&ring->head, head);
+
+    if (atomic_load(&async_writer_idle)) {
+        pthread_mutex_lock(&async_lock);
+        pthread_cond_signal(&async_cond);
+        pthread_mutex_unlock(&async_lock);
+    }
+
+finish:
+    av_bprint_finalize(part + 3, NULL);
+end:
+    /* the last producer wakes up a thread disabling async logging */
+    if (atomic_fetch_sub(&async_producers, 1) == 1 && !atomic_load(&async_enabled)) {
+        pthread_mutex_lock(&async_lock);
+        pthread_cond_broadcast(&async_cond);
+        pthread_mutex_unlock(&async_lock);
+    }
+    return ret;
+}
+
+static int ring_pending(LogRing *ring, LogRecord *rec)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (atomic_load_explicit(&ring->head, memory_order_acquire) == tail)
+        return 0;
+    ring_copy_out(ring, tail, rec, sizeof(*rec));
+    return 1;
+}
+
+/* Find the ring holding the oldest message, freeing drained orphans on the
+ * way. Called with async_lock held. */
+static LogRing *next_ring(LogRecord *rec)
+{
+    LogRing **p = &async_rings, *best = NULL;
+    LogRecord cur;
+
+    while (*p) {
+        LogRing *ring = *p;
+
+        if (ring_pending(ring, &cur)) {
+            if (!best || (int)(cur.seq - rec->seq) < 0) {
+                best = ring;
+                *rec = cur;
+            }
+        } else if (ring->orphaned &&
+                   atomic_load(&ring->dropped) == ring->dropped_reported) {
+            *p = ring->next;
+            ring_free(ring);
+            continue;
+        }
+        p = &ring->next;
+    }
+    return best;
+}
+
+static void report_dropped(LogRing *ring)
+{
+    unsigned dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    static const int type[2] = { AV_CLASS_CATEGORY_NA + 16, AV_CLASS_CATEGORY_NA + 16 };
+    char msg[64], empty[] = "";
+    char *part[4] = { empty, empty, empty, msg };
+
+    if (dropped == ring->dropped_reported)
+        return;
+    snprintf(msg, sizeof(msg), "%s    %u log messages dropped\n",
+             async_line_open ? "\n" : "", dropped - ring->dropped_reported);
+    ring->dropped_reported = dropped;
+    log_output(AV_LOG_WARNING, 0, type, part, 1);
+    async_line_open = 0;
+}
+
+static void write_record(LogRing *ring, const LogRecord *rec,
+                         char **buf, unsigned *buf_size)
+{
+    size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed) + sizeof(*rec);
+    size_t len = 0;
+    char *part[4];
+
+    for (int i = 0; i < 4; i++)
+        len += rec->len[i] + 1;
+    av_fast_malloc(buf, buf_size, len);
+
+    ff_mutex_lock(&mutex);
+    report_dropped(ring);
+    if (*buf) {
+        char *p = *buf;
+        for (int i = 0; i < 4; i++) {
+            ring_copy_out(ring, pos, p, rec->len[i]);
+            p[rec->len[i]] = 0;
+            part[i] = p;
+            p += rec->len[i] + 1;
+            pos += rec->len[i];
+        }
+        log_output(rec->level, rec->tint, rec->type, part, rec->print_prefix);
+        async_line_open = !rec->print_prefix;
+    } else {
+        for (int i = 0; i < 4; i++)
+            pos += rec->len[i];
+    }
+    ff_mutex_unlock(&mutex);
+
+    atomic_store_explicit(&ring->tail, pos, memory_order_release);
+}
+
+static void *log_writer(void *arg)
+{
+    char *buf = NULL;
+    unsigned buf_size = 0;
+
+    pthread_mutex_lock(&async_lock);
+    for (;;) {
+        LogRecord rec;
+        LogRing *ring = next_ring(&rec);
+
+        if (ring) {
+            /* rings are only freed by this thread, so ring stays valid */
+            pthread_mutex_unlock(&async_lock);
+            write_record(ring, &rec, &buf, &buf_size);
+            pthread_mutex_lock(&async_lock);
+            continue;
+        }
+
+        ff_mutex_lock(&mutex);
+        for (ring = async_rings; ring; ring = ring->next)
+            report_dropped(ring);
+        ff_mutex_unlock(&mutex);
+
+        if (async_stop)
+            break;
+
+        atomic_store(&async_writer_idle, 1);
+        if (!next_ring(&rec))
+            pthread_cond_wait(&async_cond, &async_lock);
+        atomic_store(&async_writer_idle, 0);
+    }
+    pthread_mutex_unlock(&async_lock);
+
+    av_free(buf);
+    return NULL;
+}
+
+/* Called once the writer has drained everything and exited. Rings of
+ * threads that are gone and the one of the calling thread are freed, the
+ * other threads only keep the bare ring, which their exit frees. */
+static void free_rings(void)
+{
+    LogRing *self = pthread_getspecific(async_key), **p = &async_rings;
+
+    pthread_mutex_lock(&async_lock);
+    async_running = 0;
+    while (*p) {
+        LogRing *ring = *p;
+
+        if (ring->orphaned || ring == self) {
+            *p = ring->next;
+            ring_free(ring);
+            continue;
+        }
+        av_freep(&ring->buf);
+        atomic_store(&ring->head, 0);
+        atomic_store(&ring->tail, 0);
+        p = &ring->next;
+    }
+    pthread_mutex_unlock(&async_lock);
+
+    if (self)
+        pthread_setspecific(async_key, NULL);
+}
+
+int av_log_set_async(size_t buffer_size)
+{
+    int ret;
+
+    pthread_once(&async_once, async_init);
+    if (async_key_err)
+        return AVERROR(async_key_err);
+
+    if (!buffer_size) {
+        int running;
+
+        /* Let threads that are already past the enabled check finish
+         * queueing their message, then have the writer drain everything. */
+        atomic_store(&async_enabled, 0);
+
+        pthread_mutex_lock(&async_lock);
+        while (atomic_load(&async_producers))
+            pthread_cond_wait(&async_cond, &async_lock);
+        running    = async_running;
+        async_stop = 1;
+        pthread_cond_signal(&async_cond);
+        pthread_mutex_unlock(&async_lock);
+
+        if (running)
+            pthread_join(async_writer, NULL);
+        free_rings();
+        return 0;
+    }
+
+    if (buffer_size > SIZE_MAX / 2)
+        return AVERROR(EINVAL);
+    buffer_size = FFMAX(buffer_size, 4096);
+
+    pthread_mutex_lock(&async_lock);
+    async_buffer_size = 1;
+    while (async_buffer_size < buffer_size)
+        async_buffer_size <<= 1;
+    if (!async_running) {
+        async_stop = 0;
+        ret = pthread_create(&async_writer, NULL, log_writer, NULL);
+        if (ret) {
+            pthread_mutex_unlock(&async_lock);
+            return AVERROR(ret);
+        }
+        async_running = 1;
+    }
+    pthread_mutex_unlock(&async_lock);
+
+    atomic_store(&async_enabled, 1);
+    return 0;
+}
+
+uint64_t av_log_get_async_dropped(void)
+{
+    return atomic_load(&async_dropped);
+}
+#else
+int av_log_set_async(size_t buffer_size)
+{
+    return buffer_size ? AVERROR(ENOSYS) : 0;
+}
+
+uint64_t av_log_get_async_dropped(void)
+{
+    return 0;
+}
+#endif
+
+void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+{
+    static int print_prefix = 1;
+    AVBPrint part[4];
+    char *str[4];
+    int type[2];
+    unsigned tint = 0;
+
+    if (level >= 0) {
+        tint = level & 0xff00;
+        level &= 0xff;
+    }
+
+    if (level > av_log_level)
+        return;
+#if HAVE_PTHREADS
+    if (atomic_load_explicit(&async_enabled, memory_order_relaxed) &&
+        log_async(ptr, level, tint, fmt, vl))
+        return;
+#endif
+    ff_mutex_lock(&mutex);
+
+    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
+    for (int i = 0; i < 4; i++)
+        str[i] = part[i].str;
+    if (log_output(level, tint, type, str, print_prefix)) {
 #if CONFIG_VALGRIND_BACKTRACE
-    if (level <= BACKTRACE_LOGLEVEL)
-        VALGRIND_PRINTF_BACKTRACE("%s", "");
+        if (level <= BACKTRACE_LOGLEVEL)
+            VALGRIND_PRINTF_BACKTRACE("%s", "");
 #endif
-end:
+    }
     av_bprint_finalize(part+3, NULL);
     ff_mutex_unlock(&mutex);
 }
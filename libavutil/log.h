@@ -22,6 +22,8 @@
 #define AVUTIL_LOG_H
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "attributes.h"
 #include "version.h"
 
@@ -322,6 +324,31 @@ void av_log_set_callback(void (*callback)(void*, int, const char*, va_list));
 void av_log_default_callback(void *avcl, int level, const char *fmt,
                              va_list vl);
 
+/**
+ * Make av_log_default_callback() write from a background thread.
+ *
+ * Logging threads then only format their messages into a per-thread buffer
+ * and never wait for each other or for stderr. Messages from one thread are
+ * written in order. When the buffer of a thread is full, its messages are
+ * dropped and counted, and the number of dropped messages is logged once
+ * there is room again.
+ *
+ * @note Only the default callback is affected. Messages still queued are
+ *       lost if the process exits before this function is called with 0.
+ *
+ * @param buffer_size size in bytes of the buffer of each logging thread,
+ *                    or 0 to write out all queued messages, stop the
+ *                    background thread and go back to synchronous logging
+ * @return 0 on success, a negative AVERROR code on failure;
+ *         AVERROR(ENOSYS) if FFmpeg was built without pthreads
+ */
+int av_log_set_async(size_t buffer_size);
+
+/**
+ * @return the total number of messages dropped by asynchronous logging
+ */
+uint64_t av_log_get_async_dropped(void);
+
 /**
  * Return the context name
  *
@@ -23,6 +23,145 @@
 
 #include <string.h>
 
+#if HAVE_PTHREADS
+#define THREADS  4
+#define MESSAGES 2000
+
+typedef struct AsyncCheck {
+    int next[THREADS + 1];  ///< next expected message of each thread
+    int nb_lines;
+    int nb_notified_drops;
+    int end_seen;
+    int errors;
+} AsyncCheck;
+
+static void *log_thread(void *arg)
+{
+    int t = (intptr_t)arg;
+
+    for (int i = 0; i < MESSAGES; i++)
+        av_log(NULL, AV_LOG_INFO, "t%d %d\n", t, i);
+    return NULL;
+}
+
+/* A thread that outlives av_log_set_async(0): its ring buffer is freed there
+ * and reallocated by its next message. */
+static pthread_mutex_t step_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  step_cond = PTHREAD_COND_INITIALIZER;
+static int step;
+
+static void wait_step(int s)
+{
+    pthread_mutex_lock(&step_lock);
+    while (step < s)
+        pthread_cond_wait(&step_cond, &step_lock);
+    pthread_mutex_unlock(&step_lock);
+}
+
+static void set_step(int s)
+{
+    pthread_mutex_lock(&step_lock);
+    step = s;
+    pthread_cond_broadcast(&step_cond);
+    pthread_mutex_unlock(&step_lock);
+}
+
+static void *persistent_thread(void *arg)
+{
+    av_log(NULL, AV_LOG_INFO, "t%d 0\n", THREADS);
+    set_step(1);
+    wait_step(2);
+    av_log(NULL, AV_LOG_INFO, "t%d 1\n", THREADS);
+    return NULL;
+}
+
+static void parse_output(FILE *f, AsyncCheck *c)
+{
+    char line[256];
+    int t, i;
+    unsigned n;
+
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "t%d %d", &t, &i) == 2 && t >= 0 && t <= THREADS) {
+            /* messages of one thread must keep their order, the dropped
+             * ones leave gaps */
+            if (i < c->next[t] || c->end_seen)
+                c->errors++;
+            c->next[t] = i + 1;
+            c->nb_lines++;
+        } else if (sscanf(line, " %u log messages dropped", &n) == 1) {
+            c->nb_notified_drops += n;
+        } else if (!strcmp(line, "end\n")) {
+            c->end_seen = 1;
+        } else {
+            c->errors++;
+        }
+    }
+}
+
+/* Runs the logging threads with stderr redirected to a temporary file and
+ * checks the written lines. Returns the number of dropped messages. */
+static int check_async(size_t buffer_size, int total)
+{
+    pthread_t threads[THREADS], persistent;
+    uint64_t dropped = av_log_get_async_dropped();
+    AsyncCheck c = { 0 };
+    FILE *f = tmpfile();
+    int fd, ret;
+
+    if (!f)
+        return AVERROR(errno);
+    fflush(stderr);
+    fd = dup(2);
+    dup2(fileno(f), 2);
+
+    ret = av_log_set_async(buffer_size);
+    if (ret < 0)
+        goto end;
+    pthread_create(&persistent, NULL, persistent_thread, NULL);
+    for (int t = 0; t < THREADS; t++)
+        pthread_create(&threads[t], NULL, log_thread, (void *)(intptr_t)t);
+    for (int t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+    wait_step(1);
+
+    ret = av_log_set_async(0);
+    if (ret < 0)
+        goto end;
+    ret = av_log_set_async(buffer_size);
+    if (ret < 0)
+        goto end;
+    set_step(2);
+    pthread_join(persistent, NULL);
+    av_log(NULL, AV_LOG_INFO, "end\n");
+    ret = av_log_set_async(0);
+
+end:
+    fflush(stderr);
+    dup2(fd, 2);
+    close(fd);
+    step = 0;
+    if (ret < 0) {
+        fclose(f);
+        return ret;
+    }
+
+    parse_output(f, &c);
+    fclose(f);
+    dropped = av_log_get_async_dropped() - dropped;
+    /* all threads that logged are gone, so all rings must be freed */
+    if (c.errors || !c.end_seen || c.nb_lines + dropped != total ||
+        c.nb_notified_drops != dropped || async_rings) {
+        printf("async: %d errors, %d lines, %"PRIu64" dropped, %d reported%s\n",
+               c.errors, c.nb_lines, dropped, c.nb_notified_drops,
+               async_rings ? ", rings left" : "");
+        return AVERROR_BUG;
+    }
+    return dropped;
+}
+#endif
+
 static int call_log_format_line2(const char *fmt, char *buffer, int buffer_size, ...)
 {
     va_list args;
@@ -67,5 +206,23 @@ int main(int argc, char **argv)
             return 1;
         }
     }
+#if HAVE_PTHREADS
+    {
+        const int total = THREADS * MESSAGES + 2;
+        int ret;
+
+        use_color = 0;
+        /* large enough that nothing is dropped */
+        ret = check_async(1 << 20, total);
+        if (ret)
+            return 1;
+        printf("async: %d messages, none dropped\n", total);
+        /* the smallest buffer, the drops must be accounted for */
+        ret = check_async(4096, total);
+        if (ret < 0)
+            return 1;
+        printf("async: %d messages, drops accounted for\n", total);
+    }
+#endif
     return 0;
 }
@@ -0,0 +1,181 @@
+;******************************************************************************
+;* AES-NI optimized AES encryption/decryption
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; The round keys prepared by av_aes_init() are stored in the order they are
+; used: round_key[rounds] is applied first and round_key[0] last, for both
+; directions. The decryption keys already have InvMixColumns applied, which
+; is the layout aesdec expects. The keys are loaded unaligned, since AVAES
+; may be allocated by the caller.
+
+; %1 = enc/dec, %2 = number of blocks in m0..m3
+; roundsq holds rounds * 16, m5 is clobbered
+%macro AES_ROUNDS 2
+    movu          m5, [aq + roundsq]
+%assign %%i 0
+%rep %2
+    pxor          m %+ %%i, m5
+%assign %%i %%i+1
+%endrep
+    lea           kq, [roundsq - 16]
+%%loop:
+    movu          m5, [aq + kq]
+%assign %%i 0
+%rep %2
+    aes%1         m %+ %%i, m5
+%assign %%i %%i+1
+%endrep
+    sub           kq, 16
+    jg %%loop
+    movu          m5, [aq]
+%assign %%i 0
+%rep %2
+    aes%1last     m %+ %%i, m5
+%assign %%i %%i+1
+%endrep
+%endmacro
+
+%macro AES_LOAD4 0
+    movu          m0, [srcq +  0]
+    movu          m1, [srcq + 16]
+    movu          m2, [srcq + 32]
+    movu          m3, [srcq + 48]
+%endmacro
+
+%macro AES_STORE4 0
+    movu [dstq +  0], m0
+    movu [dstq + 16], m1
+    movu [dstq + 32], m2
+    movu [dstq + 48], m3
+%endmacro
+
+INIT_XMM aesni
+;-----------------------------------------------------------------------------
+; void ff_aes_encrypt_aesni(AVAES *a, uint8_t *dst, const uint8_t *src,
+;                           int count, uint8_t *iv, int rounds)
+;-----------------------------------------------------------------------------
+cglobal aes_encrypt, 6, 7, 6, a, dst, src, count, iv, rounds, k
+    shl       roundsd, 4
+    test        ivq, ivq
+    jz .ecb
+    ; CBC encryption is inherently serial, one block at a time
+    test     countd, countd
+    jle .end
+    movu          m4, [ivq]
+.cbc:
+    movu          m0, [srcq]
+    pxor          m0, m4
+    AES_ROUNDS   enc, 1
+    movu      [dstq], m0
+    mova          m4, m0
+    add         srcq, 16
+    add         dstq, 16
+    dec       countd
+    jg .cbc
+    movu       [ivq], m4
+    RET
+
+.ecb:
+    ; independent blocks are interleaved 4 at a time to hide the latency
+    sub       countd, 4
+    jl .ecb_tail
+.ecb4:
+    AES_LOAD4
+    AES_ROUNDS   enc, 4
+    AES_STORE4
+    add         srcq, 64
+    add         dstq, 64
+    sub       countd, 4
+    jge .ecb4
+.ecb_tail:
+    add       countd, 4
+    jle .end
+.ecb1:
+    movu          m0, [srcq]
+    AES_ROUNDS   enc, 1
+    movu      [dstq], m0
+    add         srcq, 16
+    add         dstq, 16
+    dec       countd
+    jg .ecb1
+.end:
+    RET
+
+; %1 = 1 for CBC (iv in m4), 0 for ECB
+%macro AES_DECRYPT_LOOP 1
+    sub       countd, 4
+    jl %%tail
+%%loop4:
+    AES_LOAD4
+    AES_ROUNDS   dec, 4
+%if %1
+    ; the ciphertext is re-read from src before anything is stored, so
+    ; in-place operation is fine
+    pxor          m0, m4
+    movu          m5, [srcq +  0]
+    pxor          m1, m5
+    movu          m5, [srcq + 16]
+    pxor          m2, m5
+    movu          m5, [srcq + 32]
+    pxor          m3, m5
+    movu          m4, [srcq + 48]
+%endif
+    AES_STORE4
+    add         srcq, 64
+    add         dstq, 64
+    sub       countd, 4
+    jge %%loop4
+%%tail:
+    add       countd, 4
+    jle %%end
+%%loop1:
+    movu          m0, [srcq]
+    AES_ROUNDS   dec, 1
+%if %1
+    pxor          m0, m4
+    movu          m4, [srcq]
+%endif
+    movu      [dstq], m0
+    add         srcq, 16
+    add         dstq, 16
+    dec       countd
+    jg %%loop1
+%%end:
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_aes_decrypt_aesni(AVAES *a, uint8_t *dst, const uint8_t *src,
+;                           int count, uint8_t *iv, int rounds)
+;-----------------------------------------------------------------------------
+cglobal aes_decrypt, 6, 7, 6, a, dst, src, count, iv, rounds, k
+    shl       roundsd, 4
+    test        ivq, ivq
+    jz .ecb
+    ; unlike encryption, CBC decryption can be pipelined
+    movu          m4, [ivq]
+    AES_DECRYPT_LOOP 1
+    movu       [ivq], m4
+    RET
+.ecb:
+    AES_DECRYPT_LOOP 0
+    RET
@@ -0,0 +1,92 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/aes.h"
+#include "libavutil/aes_internal.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_BLOCKS 37
+
+#define randomize_buffer(buf, size)     \
+    do {                                \
+        for (int j = 0; j < size; j++)  \
+            buf[j] = rnd();             \
+    } while (0)
+
+static void check_aes(int key_bits, int decrypt)
+{
+    static const int counts[] = { 1, 3, 4, 7, MAX_BLOCKS };
+    uint8_t key[32], iv[16], iv_ref[16], iv_new[16];
+    LOCAL_ALIGNED_16(uint8_t, src,     [MAX_BLOCKS * 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [MAX_BLOCKS * 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst_new, [MAX_BLOCKS * 16]);
+    AVAES a;
+
+    declare_func(void, AVAES *a, uint8_t *dst, const uint8_t *src,
+                 int count, uint8_t *iv, int rounds);
+
+    randomize_buffer(key, sizeof(key));
+    av_aes_init(&a, key, key_bits, decrypt);
+
+    if (check_func(a.crypt, "aes%d_%s", key_bits, decrypt ? "dec" : "enc")) {
+        randomize_buffer(src, MAX_BLOCKS * 16);
+        randomize_buffer(iv, sizeof(iv));
+
+        for (int i = 0; i < FF_ARRAY_ELEMS(counts); i++) {
+            int count = counts[i];
+
+            // ECB
+            call_ref(&a, dst_ref, src, count, NULL, a.rounds);
+            call_new(&a, dst_new, src, count, NULL, a.rounds);
+            if (memcmp(dst_ref, dst_new, count * 16))
+                fail();
+
+            // CBC, out of place and in place
+            memcpy(iv_ref, iv, sizeof(iv));
+            memcpy(iv_new, iv, sizeof(iv));
+            call_ref(&a, dst_ref, src, count, iv_ref, a.rounds);
+            call_new(&a, dst_new, src, count, iv_new, a.rounds);
+            if (memcmp(dst_ref, dst_new, count * 16) ||
+                memcmp(iv_ref, iv_new, sizeof(iv)))
+                fail();
+
+            memcpy(dst_new, src, count * 16);
+            memcpy(iv_new, iv, sizeof(iv));
+            call_new(&a, dst_new, dst_new, count, iv_new, a.rounds);
+            if (memcmp(dst_ref, dst_new, count * 16) ||
+                memcmp(iv_ref, iv_new, sizeof(iv)))
+                fail();
+        }
+
+        bench_new(&a, dst_new, src, MAX_BLOCKS, NULL, a.rounds);
+    }
+}
+
+void checkasm_check_aes(void)
+{
+    static const int key_bits[] = { 128, 192, 256 };
+
+    for (int decrypt = 0; decrypt <= 1; decrypt++) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(key_bits); i++)
+            check_aes(key_bits[i], decrypt);
+        report(decrypt ? "decrypt" : "encrypt");
+    }
+}
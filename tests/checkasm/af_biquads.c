@@ -0,0 +1,156 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "libavfilter/af_biquadsdsp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+#include "checkasm.h"
+
+#define LEN 256
+#define BUF_SIZE (LEN * BIQUADS_LANES)
+#define STATE_SIZE (4 * BIQUADS_LANES)
+
+static float randomf(float range)
+{
+    return (rnd() / (float)UINT32_MAX * 2.f - 1.f) * range;
+}
+
+static double randomd(double range)
+{
+    return (rnd() / (double)UINT32_MAX * 2. - 1.) * range;
+}
+
+/* A stable section: poles at radius r < 0.95 and angle t. */
+static void randomize_coeffs(float *coeffs)
+{
+    const float r = (rnd() % 95) / 100.f;
+    const float t = (rnd() % 314) / 100.f;
+
+    coeffs[0] = randomf(1.f);
+    coeffs[1] = randomf(2.f);
+    coeffs[2] = randomf(1.f);
+    coeffs[3] = 2.f * r * cosf(t);
+    coeffs[4] = -r * r;
+    coeffs[5] = rnd() % 101 / 100.f;
+    coeffs[6] = 1.f - coeffs[5];
+}
+
+static void check_filter(void (*func)(float *buf, const float *coeffs,
+                                      float *state, ptrdiff_t len),
+                         const char *name)
+{
+    LOCAL_ALIGNED_32(float, src,       [BUF_SIZE]);
+    LOCAL_ALIGNED_32(float, dst_ref,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(float, dst_new,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(float, state,     [STATE_SIZE]);
+    LOCAL_ALIGNED_32(float, state_ref, [STATE_SIZE]);
+    LOCAL_ALIGNED_32(float, state_new, [STATE_SIZE]);
+    float coeffs[7];
+
+    declare_func(void, float *buf, const float *coeffs, float *state,
+                 ptrdiff_t len);
+
+    if (check_func(func, "%s", name)) {
+        const int len = rnd() % LEN + 1;
+
+        for (int i = 0; i < BUF_SIZE; i++)
+            src[i] = randomf(1.f);
+        for (int i = 0; i < STATE_SIZE; i++)
+            state[i] = randomf(1.f);
+        randomize_coeffs(coeffs);
+
+        memcpy(dst_ref, src, sizeof(*src) * BUF_SIZE);
+        memcpy(dst_new, src, sizeof(*src) * BUF_SIZE);
+        memcpy(state_ref, state, sizeof(*state) * STATE_SIZE);
+        memcpy(state_new, state, sizeof(*state) * STATE_SIZE);
+
+        call_ref(dst_ref, coeffs, state_ref, len);
+        call_new(dst_new, coeffs, state_new, len);
+        if (!float_near_abs_eps_array(dst_ref, dst_new, 16 * FLT_EPSILON, BUF_SIZE) ||
+            !float_near_abs_eps_array(state_ref, state_new, 16 * FLT_EPSILON, STATE_SIZE))
+            fail();
+
+        /* Keep the buffer unchanged across the benchmark runs. */
+        coeffs[5] = 0.f;
+        coeffs[6] = 1.f;
+        memcpy(state_new, state, sizeof(*state) * STATE_SIZE);
+        bench_new(dst_new, coeffs, state_new, LEN);
+    }
+    report("%s", name);
+}
+
+static void check_filter_dbl(void (*func)(double *buf, const double *coeffs,
+                                          double *state, ptrdiff_t len),
+                             const char *name)
+{
+    LOCAL_ALIGNED_32(double, src,       [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, dst_ref,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, dst_new,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, state,     [STATE_SIZE]);
+    LOCAL_ALIGNED_32(double, state_ref, [STATE_SIZE]);
+    LOCAL_ALIGNED_32(double, state_new, [STATE_SIZE]);
+    float fcoeffs[7];
+    double coeffs[7];
+
+    declare_func(void, double *buf, const double *coeffs, double *state,
+                 ptrdiff_t len);
+
+    if (check_func(func, "%s", name)) {
+        const int len = rnd() % LEN + 1;
+
+        for (int i = 0; i < BUF_SIZE; i++)
+            src[i] = randomd(1.);
+        for (int i = 0; i < STATE_SIZE; i++)
+            state[i] = randomd(1.);
+        randomize_coeffs(fcoeffs);
+        for (int i = 0; i < 7; i++)
+            coeffs[i] = fcoeffs[i];
+
+        memcpy(dst_ref, src, sizeof(*src) * BUF_SIZE);
+        memcpy(dst_new, src, sizeof(*src) * BUF_SIZE);
+        memcpy(state_ref, state, sizeof(*state) * STATE_SIZE);
+        memcpy(state_new, state, sizeof(*state) * STATE_SIZE);
+
+        call_ref(dst_ref, coeffs, state_ref, len);
+        call_new(dst_new, coeffs, state_new, len);
+        if (!double_near_abs_eps_array(dst_ref, dst_new, 16 * DBL_EPSILON, BUF_SIZE) ||
+            !double_near_abs_eps_array(state_ref, state_new, 16 * DBL_EPSILON, STATE_SIZE))
+            fail();
+
+        /* Keep the buffer unchanged across the benchmark runs. */
+        coeffs[5] = 0.;
+        coeffs[6] = 1.;
+        memcpy(state_new, state, sizeof(*state) * STATE_SIZE);
+        bench_new(dst_new, coeffs, state_new, LEN);
+    }
+    report("%s", name);
+}
+
+void checkasm_check_biquads(void)
+{
+    BiquadsDSPContext dsp;
+
+    ff_biquads_init(&dsp);
+
+    check_filter(dsp.filter_di_flt,   "biquad_di_flt");
+    check_filter(dsp.filter_tdii_flt, "biquad_tdii_flt");
+    check_filter_dbl(dsp.filter_di_dbl, "biquad_di_dbl");
+}
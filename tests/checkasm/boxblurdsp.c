@@ -0,0 +1,121 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/boxblurdsp.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 64
+
+#define randomize_buffers(buf, size)     \
+    do {                                 \
+       int j;                            \
+       uint8_t *tmp_buf = (uint8_t *)buf;\
+       for (j = 0; j < size; j++)        \
+           tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+/* widths with and without a tail that the vector code cannot handle */
+static const int widths[] = { 5, 16, 45, WIDTH };
+
+static void check_vblur_row(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t,  srca,    [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  srcs,    [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_ref, [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_new, [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint32_t, sum_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint32_t, sum_new, [WIDTH]);
+    BoxBlurDSPContext dsp;
+
+    declare_func(void, uint32_t *sum, uint8_t *dst, const uint8_t *srca,
+                 const uint8_t *srcs, int inv, ptrdiff_t width);
+
+    ff_boxblurdsp_init(&dsp, depth);
+
+    if (check_func(dsp.vblur_row, "vblur_row%d", depth)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            const int length = 2 * (1 + rnd() % 100) + 1;
+            const int inv = ((1 << 16) + length / 2) / length;
+
+            randomize_buffers(srca, 2 * WIDTH);
+            randomize_buffers(srcs, 2 * WIDTH);
+            /* any value, the sums are allowed to wrap around */
+            randomize_buffers(sum_ref, WIDTH * sizeof(*sum_ref));
+            memcpy(sum_new, sum_ref, WIDTH * sizeof(*sum_ref));
+            memset(dst_ref, 0, 2 * WIDTH);
+            memset(dst_new, 0, 2 * WIDTH);
+
+            call_ref(sum_ref, dst_ref, srca, srcs, inv, widths[i]);
+            call_new(sum_new, dst_new, srca, srcs, inv, widths[i]);
+            if (memcmp(sum_ref, sum_new, WIDTH * sizeof(*sum_ref)) ||
+                memcmp(dst_ref, dst_new, 2 * WIDTH))
+                fail();
+        }
+        bench_new(sum_new, dst_new, srca, srcs, 13107, WIDTH);
+    }
+}
+
+static void check_update_col_sums(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, add,     [2 * WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, sub,     [2 * WIDTH]);
+    LOCAL_ALIGNED_32(int64_t, sum_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(int64_t, sum_new, [WIDTH]);
+    BoxBlurDSPContext dsp;
+
+    declare_func(void, void *col_sum, const uint8_t *add,
+                 const uint8_t *sub, ptrdiff_t width);
+
+    ff_boxblurdsp_init(&dsp, depth);
+
+    if (check_func(dsp.update_col_sums, "update_col_sums%d", depth)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            randomize_buffers(add, 2 * WIDTH);
+            randomize_buffers(sub, 2 * WIDTH);
+            /* keep the sums far enough from the limits of their type */
+            for (int x = 0; x < WIDTH; x++) {
+                if (depth > 8) {
+                    sum_ref[x] = (int64_t)(int32_t)rnd() << 8;
+                } else {
+                    ((int32_t *)sum_ref)[2 * x    ] = (int32_t)rnd() >> 4;
+                    ((int32_t *)sum_ref)[2 * x + 1] = (int32_t)rnd() >> 4;
+                }
+            }
+            memcpy(sum_new, sum_ref, WIDTH * sizeof(*sum_ref));
+
+            call_ref(sum_ref, add, sub, widths[i]);
+            call_new(sum_new, add, sub, widths[i]);
+            if (memcmp(sum_ref, sum_new, WIDTH * sizeof(*sum_ref)))
+                fail();
+        }
+        bench_new(sum_new, add, sub, WIDTH);
+    }
+}
+
+void checkasm_check_boxblurdsp(void)
+{
+    check_vblur_row(8);
+    check_vblur_row(16);
+    report("vblur_row");
+
+    check_update_col_sums(8);
+    check_update_col_sums(16);
+    report("update_col_sums");
+}
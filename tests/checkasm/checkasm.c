@@ -160,6 +160,9 @@ static const struct {
     #if CONFIG_V210_ENCODER
         { "v210enc", checkasm_check_v210enc },
     #endif
+    #if CONFIG_VC2_ENCODER
+        { "vc2enc_dwt", checkasm_check_vc2enc_dwt },
+    #endif
     #if CONFIG_VC1DSP
         { "vc1dsp", checkasm_check_vc1dsp },
     #endif
@@ -180,6 +183,25 @@ static const struct {
     #if CONFIG_AFIR_FILTER
         { "af_afir", checkasm_check_afir },
     #endif
+    #if CONFIG_EQUALIZER_FILTER
+        { "af_biquads", checkasm_check_biquads },
+    #endif
+    #if CONFIG_EBUR128_FILTER
+        { "f_ebur128", checkasm_check_ebur128 },
+    #endif
+    #if CONFIG_BOXBLURDSP
+        { "boxblurdsp", checkasm_check_boxblurdsp },
+    #endif
+        { "drawutils", checkasm_check_drawutils },
+    #if CONFIG_IVTCDSP
+        { "ivtcdsp", checkasm_check_ivtcdsp },
+    #endif
+    #if CONFIG_ROWSTATS
+        { "rowstats", checkasm_check_rowstats },
+    #endif
+    #if CONFIG_ATADENOISE_FILTER
+        { "vf_atadenoise", checkasm_check_vf_atadenoise },
+    #endif
     #if CONFIG_BLEND_FILTER
         { "vf_blend", checkasm_check_blend },
     #endif
@@ -198,15 +220,30 @@ static const struct {
     #if CONFIG_HFLIP_FILTER
         { "vf_hflip", checkasm_check_vf_hflip },
     #endif
+    #if CONFIG_HQDN3D_FILTER
+        { "vf_hqdn3d", checkasm_check_vf_hqdn3d },
+    #endif
     #if CONFIG_NLMEANS_FILTER
         { "vf_nlmeans", checkasm_check_nlmeans },
     #endif
+    #if CONFIG_PALETTEUSE_FILTER
+        { "vf_paletteuse", checkasm_check_vf_paletteuse },
+    #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
     #if CONFIG_SOBEL_FILTER
         { "vf_sobel", checkasm_check_vf_sobel },
     #endif
+    #if CONFIG_W3FDIF_FILTER
+        { "vf_w3fdif", checkasm_check_vf_w3fdif },
+    #endif
+    #if CONFIG_YADIF_FILTER
+        { "vf_yadif", checkasm_check_vf_yadif },
+    #endif
+    #if CONFIG_ZOOMPAN_FILTER
+        { "vf_zoompan", checkasm_check_vf_zoompan },
+    #endif
 #endif
 #if CONFIG_SWSCALE
     { "sw_gbrp", checkasm_check_sw_gbrp },
@@ -214,6 +251,7 @@ static const struct {
     { "sw_scale", checkasm_check_sw_scale },
 #endif
 #if CONFIG_AVUTIL
+        { "aes",       checkasm_check_aes },
         { "fixed_dsp", checkasm_check_fixed_dsp },
         { "float_dsp", checkasm_check_float_dsp },
         { "av_tx",     checkasm_check_av_tx },
@@ -0,0 +1,84 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/drawutils.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH  512
+#define STRIDE (2 * WIDTH + 32)
+
+#define randomize_buffers(buf, size)     \
+    do {                                 \
+       int j;                            \
+       uint8_t *tmp_buf = (uint8_t *)buf;\
+       for (j = 0; j < size; j++)        \
+           tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+/* widths with and without a tail that the vector code cannot handle */
+static const int widths[] = { 7, 16, 37, WIDTH };
+
+static void check_blend_row(int sub)
+{
+    LOCAL_ALIGNED_32(uint8_t, mask, [2 * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+    FFDrawContext draw;
+
+    declare_func(void, uint8_t *dst, const uint8_t *mask, ptrdiff_t mask_linesize,
+                 int w, unsigned src, unsigned alpha);
+
+    ff_draw_init(&draw, AV_PIX_FMT_YUV420P, 0);
+    randomize_buffers(mask, 2 * STRIDE);
+    /* fully transparent and opaque runs, as around and inside glyphs */
+    memset(mask + 40, 0x00, 24);
+    memset(mask + 80, 0xFF, 24);
+
+    if (check_func(draw.blend_row[sub], sub ? "blend_row_2x2" : "blend_row")) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            /* the mask alpha as computed by ff_blend_mask() */
+            const unsigned alpha = (0x10307 * (rnd() & 0xFF) + 0x3) >> 8;
+            const unsigned src = rnd() & 0xFF;
+
+            randomize_buffers(dst_ref, WIDTH);
+            memcpy(dst_new, dst_ref, WIDTH);
+            call_ref(dst_ref, mask, STRIDE, widths[i], src, alpha);
+            call_new(dst_new, mask, STRIDE, widths[i], src, alpha);
+            if (memcmp(dst_ref, dst_new, WIDTH))
+                fail();
+        }
+        /* an opaque color, the worst case for the products */
+        memcpy(dst_new, dst_ref, WIDTH);
+        call_ref(dst_ref, mask, STRIDE, WIDTH, 0xFF, 0x10203);
+        call_new(dst_new, mask, STRIDE, WIDTH, 0xFF, 0x10203);
+        if (memcmp(dst_ref, dst_new, WIDTH))
+            fail();
+        bench_new(dst_new, mask, STRIDE, WIDTH, 0x80, 0x8101);
+    }
+}
+
+void checkasm_check_drawutils(void)
+{
+    check_blend_row(0);
+    report("blend_row");
+
+    check_blend_row(1);
+    report("blend_row_2x2");
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "libavfilter/f_ebur128.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+#include "checkasm.h"
+
+#define LEN 256
+#define HISTORY (EBUR128_TP_TAPS - 1)
+#define BUF_SIZE ((HISTORY + LEN) * BIQUADS_LANES)
+
+static double randomd(double range)
+{
+    return (rnd() / (double)UINT32_MAX * 2. - 1.) * range;
+}
+
+void checkasm_check_ebur128(void)
+{
+    LOCAL_ALIGNED_32(double, buf,       [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, peaks,     [BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, peaks_ref, [BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, peaks_new, [BIQUADS_LANES]);
+    EBUR128DSPContext dsp;
+
+    declare_func(void, double *peaks, const double *buf, ptrdiff_t len);
+
+    ff_ebur128_dsp_init(&dsp);
+
+    if (check_func(dsp.true_peak, "true_peak")) {
+        const int len = rnd() % LEN + 1;
+
+        for (int i = 0; i < BUF_SIZE; i++)
+            buf[i] = randomd(1.);
+        /* some lanes start above anything the filter can reach */
+        for (int c = 0; c < BIQUADS_LANES; c++)
+            peaks[c] = rnd() & 1 ? 4. : randomd(0.5) + 0.5;
+
+        memcpy(peaks_ref, peaks, sizeof(*peaks) * BIQUADS_LANES);
+        memcpy(peaks_new, peaks, sizeof(*peaks) * BIQUADS_LANES);
+
+        call_ref(peaks_ref, buf + HISTORY * BIQUADS_LANES, len);
+        call_new(peaks_new, buf + HISTORY * BIQUADS_LANES, len);
+        if (!double_near_abs_eps_array(peaks_ref, peaks_new, 16 * DBL_EPSILON, BIQUADS_LANES))
+            fail();
+
+        bench_new(peaks_new, buf + HISTORY * BIQUADS_LANES, LEN);
+    }
+    report("true_peak");
+}
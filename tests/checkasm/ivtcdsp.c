@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/ivtcdsp.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH  512
+#define HEIGHT 16
+#define STRIDE (2 * WIDTH + 32)
+
+#define randomize_buffers(buf, size)     \
+    do {                                 \
+       int j;                            \
+       uint8_t *tmp_buf = (uint8_t *)buf;\
+       for (j = 0; j < size; j++)        \
+           tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+/* widths with and without a tail that the vector code cannot handle,
+ * including the decimate block widths */
+static const int widths[] = { 5, 8, 16, 24, 61, WIDTH };
+
+static void check_block_sad(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [STRIDE * HEIGHT]);
+    IVTCDSPContext dsp;
+
+    declare_func(uint64_t, const uint8_t *src1, ptrdiff_t stride1,
+                 const uint8_t *src2, ptrdiff_t stride2,
+                 ptrdiff_t width, ptrdiff_t height);
+
+    ff_ivtcdsp_init(&dsp, depth);
+    randomize_buffers(src1, STRIDE * HEIGHT);
+    randomize_buffers(src2, STRIDE * HEIGHT);
+
+    if (check_func(dsp.block_sad, "block_sad%d", depth)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            for (int h = 1; h <= HEIGHT; h += 7) {
+                /* unaligned blocks, as with the odd decimate block sizes */
+                const int off = (rnd() & 15) * (depth > 8 ? 2 : 1);
+                uint64_t ref = call_ref(src1 + off, STRIDE, src2, STRIDE - 16, widths[i], h);
+                uint64_t new = call_new(src1 + off, STRIDE, src2, STRIDE - 16, widths[i], h);
+                if (ref != new)
+                    fail();
+            }
+        }
+        bench_new(src1, STRIDE, src2, STRIDE, 16, 16);
+    }
+}
+
+static void check_comb_row(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [5 * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+    static const int threshs[] = { 0, 9, 100, 255 };
+    IVTCDSPContext dsp;
+
+    declare_func(void, uint8_t *dst, const uint8_t *prv2, const uint8_t *prv,
+                 const uint8_t *cur, const uint8_t *nxt, const uint8_t *nxt2,
+                 ptrdiff_t width, int thresh);
+
+    ff_ivtcdsp_init(&dsp, 8);
+    randomize_buffers(src, 5 * STRIDE);
+    /* fully combed columns: the filter reaches its extremes */
+    for (int y = 0; y < 5; y++) {
+        memset(src + y * STRIDE +  64, y & 1 ? 0x00 : 0xFF, 32);
+        memset(src + y * STRIDE + 128, y & 1 ? 0xFF : 0x00, 32);
+    }
+
+    if (check_func(dsp.comb_row, "comb_row")) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            for (int t = 0; t < FF_ARRAY_ELEMS(threshs); t++) {
+                memset(dst_ref, 0x55, WIDTH);
+                memset(dst_new, 0x55, WIDTH);
+                call_ref(dst_ref, src, src + STRIDE, src + 2 * STRIDE,
+                         src + 3 * STRIDE, src + 4 * STRIDE, widths[i], threshs[t]);
+                call_new(dst_new, src, src + STRIDE, src + 2 * STRIDE,
+                         src + 3 * STRIDE, src + 4 * STRIDE, widths[i], threshs[t]);
+                if (memcmp(dst_ref, dst_new, WIDTH))
+                    fail();
+            }
+        }
+        bench_new(dst_new, src, src + STRIDE, src + 2 * STRIDE,
+                  src + 3 * STRIDE, src + 4 * STRIDE, WIDTH, 9);
+    }
+}
+
+void checkasm_check_ivtcdsp(void)
+{
+    check_block_sad(8);
+    check_block_sad(16);
+    report("block_sad");
+
+    check_comb_row();
+    report("comb_row");
+}
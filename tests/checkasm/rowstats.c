@@ -0,0 +1,125 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/rowstats.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH  512
+#define HEIGHT 8
+#define STRIDE (2 * WIDTH + 32)
+
+#define randomize_buffers(buf, size)     \
+    do {                                 \
+       int j;                            \
+       uint8_t *tmp_buf = (uint8_t *)buf;\
+       for (j = 0; j < size; j++)        \
+           tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+/* widths with and without a tail that the vector code cannot handle */
+static const int widths[] = { 7, 64, 333, WIDTH };
+
+static void check_count_below(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [STRIDE * HEIGHT]);
+    static const int threshs[] = { 0, 32, 128, 255 };
+    RowStatsDSPContext dsp;
+
+    declare_func(uint64_t, const uint8_t *src, ptrdiff_t stride,
+                 ptrdiff_t width, ptrdiff_t height, int thresh);
+
+    ff_rowstats_init(&dsp, 8);
+    randomize_buffers(src, STRIDE * HEIGHT);
+
+    if (check_func(dsp.count_below, "count_below")) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            for (int t = 0; t < FF_ARRAY_ELEMS(threshs); t++) {
+                uint64_t ref = call_ref(src, STRIDE, widths[i], HEIGHT, threshs[t]);
+                uint64_t new = call_new(src, STRIDE, widths[i], HEIGHT, threshs[t]);
+                if (ref != new)
+                    fail();
+            }
+        }
+        bench_new(src, STRIDE, WIDTH, HEIGHT, 32);
+    }
+}
+
+static void check_row_sum(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [2 * WIDTH]);
+    RowStatsDSPContext dsp;
+
+    declare_func(uint64_t, const uint8_t *src, ptrdiff_t width);
+
+    ff_rowstats_init(&dsp, depth);
+    randomize_buffers(src, 2 * WIDTH);
+
+    if (check_func(dsp.row_sum, "row_sum%d", depth)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            if (call_ref(src, widths[i]) != call_new(src, widths[i]))
+                fail();
+        }
+        bench_new(src, WIDTH);
+    }
+}
+
+static void check_column_sum(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint32_t, sum_ref, [WIDTH + 8]);
+    LOCAL_ALIGNED_32(uint32_t, sum_new, [WIDTH + 8]);
+    RowStatsDSPContext dsp;
+
+    declare_func(void, uint32_t *sum, const uint8_t *src, ptrdiff_t stride,
+                 ptrdiff_t width, ptrdiff_t height);
+
+    ff_rowstats_init(&dsp, depth);
+    randomize_buffers(src, STRIDE * HEIGHT);
+
+    if (check_func(dsp.column_sum, "column_sum%d", depth)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            /* the functions accumulate, so start from non-zero sums */
+            randomize_buffers(sum_ref, (WIDTH + 8) * sizeof(*sum_ref));
+            for (int x = 0; x < WIDTH + 8; x++)
+                sum_ref[x] >>= 8;
+            memcpy(sum_new, sum_ref, (WIDTH + 8) * sizeof(*sum_ref));
+
+            call_ref(sum_ref, src, STRIDE, widths[i], HEIGHT);
+            call_new(sum_new, src, STRIDE, widths[i], HEIGHT);
+            if (memcmp(sum_ref, sum_new, (WIDTH + 8) * sizeof(*sum_ref)))
+                fail();
+        }
+        bench_new(sum_new, src, STRIDE, WIDTH, HEIGHT);
+    }
+}
+
+void checkasm_check_rowstats(void)
+{
+    check_count_below();
+    report("count_below");
+
+    check_row_sum(8);
+    check_row_sum(16);
+    report("row_sum");
+
+    check_column_sum(8);
+    check_column_sum(16);
+    report("column_sum");
+}
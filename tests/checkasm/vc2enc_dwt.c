@@ -0,0 +1,210 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/vc2enc_dwt.h"
+
+#include "checkasm.h"
+
+#define LEN 512
+
+/* Keeps 9 * (b + c) - a - d well inside the int32 range. */
+#define randomize_buffer(buf, len)                            \
+    do {                                                      \
+        for (int i = 0; i < len; i++)                         \
+            buf[i] = (int32_t)(rnd() & 0x3FFFF) - 0x20000;    \
+    } while (0)
+
+/* Covers the scalar tails; the callers below also offset the pointers by one
+ * element to exercise unaligned access. */
+static int random_len(void)
+{
+    return rnd() % 68;
+}
+
+static void check_buffers(const dwtcoef *ref, const dwtcoef *new, int len)
+{
+    if (memcmp(ref, new, len * sizeof(*ref)))
+        fail();
+}
+
+static void check_split_row(const VC2TransformDSPContext *c)
+{
+    LOCAL_ALIGNED_32(dwtcoef, src,     [2 * LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, lo_ref,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, lo_new,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, hi_ref,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, hi_new,  [LEN + 1]);
+    int n = random_len();
+
+    declare_func(void, dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n);
+
+    if (check_func(c->split_row, "split_row")) {
+        randomize_buffer(src, 2 * LEN + 1);
+        randomize_buffer(lo_ref, LEN + 1);
+        randomize_buffer(hi_ref, LEN + 1);
+        memcpy(lo_new, lo_ref, (LEN + 1) * sizeof(*lo_ref));
+        memcpy(hi_new, hi_ref, (LEN + 1) * sizeof(*hi_ref));
+
+        call_ref(lo_ref + 1, hi_ref + 1, src + 1, n);
+        call_new(lo_new + 1, hi_new + 1, src + 1, n);
+        check_buffers(lo_ref, lo_new, LEN + 1);
+        check_buffers(hi_ref, hi_new, LEN + 1);
+
+        bench_new(lo_new, hi_new, src, LEN);
+    }
+    report("split_row");
+}
+
+static void check_haar_row(const VC2TransformDSPContext *c)
+{
+    LOCAL_ALIGNED_32(dwtcoef, src,     [2 * LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, lo_ref,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, lo_new,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, hi_ref,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, hi_new,  [LEN + 1]);
+
+    declare_func(void, dwtcoef *lo, dwtcoef *hi, const dwtcoef *src, int n,
+                 int shift);
+
+    for (int shift = 0; shift < 2; shift++) {
+        int n = random_len();
+
+        if (check_func(c->haar_row, "haar_row_shift%d", shift)) {
+            randomize_buffer(src, 2 * LEN + 1);
+            randomize_buffer(lo_ref, LEN + 1);
+            randomize_buffer(hi_ref, LEN + 1);
+            memcpy(lo_new, lo_ref, (LEN + 1) * sizeof(*lo_ref));
+            memcpy(hi_new, hi_ref, (LEN + 1) * sizeof(*hi_ref));
+
+            call_ref(lo_ref + 1, hi_ref + 1, src + 1, n, shift);
+            call_new(lo_new + 1, hi_new + 1, src + 1, n, shift);
+            check_buffers(lo_ref, lo_new, LEN + 1);
+            check_buffers(hi_ref, hi_new, LEN + 1);
+
+            bench_new(lo_new, hi_new, src, LEN, shift);
+        }
+    }
+    report("haar_row");
+}
+
+static void check_haar_col(const VC2TransformDSPContext *c)
+{
+    LOCAL_ALIGNED_32(dwtcoef, lo_ref,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, lo_new,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, hi_ref,  [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, hi_new,  [LEN + 1]);
+    int n = random_len();
+
+    declare_func(void, dwtcoef *lo, dwtcoef *hi, int n);
+
+    if (check_func(c->haar_col, "haar_col")) {
+        randomize_buffer(lo_ref, LEN + 1);
+        randomize_buffer(hi_ref, LEN + 1);
+        memcpy(lo_new, lo_ref, (LEN + 1) * sizeof(*lo_ref));
+        memcpy(hi_new, hi_ref, (LEN + 1) * sizeof(*hi_ref));
+
+        call_ref(lo_ref + 1, hi_ref + 1, n);
+        call_new(lo_new + 1, hi_new + 1, n);
+        check_buffers(lo_ref, lo_new, LEN + 1);
+        check_buffers(hi_ref, hi_new, LEN + 1);
+
+        bench_new(lo_new, hi_new, LEN);
+    }
+    report("haar_col");
+}
+
+static void check_lifting(const VC2TransformDSPContext *c)
+{
+    LOCAL_ALIGNED_32(dwtcoef, src0,    [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, src1,    [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, src2,    [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, src3,    [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, dst_ref, [LEN + 1]);
+    LOCAL_ALIGNED_32(dwtcoef, dst_new, [LEN + 1]);
+    int n;
+
+    randomize_buffer(src0, LEN + 1);
+    randomize_buffer(src1, LEN + 1);
+    randomize_buffer(src2, LEN + 1);
+    randomize_buffer(src3, LEN + 1);
+
+    {
+        declare_func(void, dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,
+                     int n);
+
+        if (check_func(c->predict_53, "predict_53")) {
+            n = random_len();
+            randomize_buffer(dst_ref, LEN + 1);
+            memcpy(dst_new, dst_ref, (LEN + 1) * sizeof(*dst_ref));
+
+            call_ref(dst_ref + 1, src0 + 1, src1 + 1, n);
+            call_new(dst_new + 1, src0 + 1, src1 + 1, n);
+            check_buffers(dst_ref, dst_new, LEN + 1);
+
+            bench_new(dst_new, src0, src1, LEN);
+        }
+        report("predict_53");
+
+        if (check_func(c->update, "update")) {
+            n = random_len();
+            randomize_buffer(dst_ref, LEN + 1);
+            memcpy(dst_new, dst_ref, (LEN + 1) * sizeof(*dst_ref));
+
+            call_ref(dst_ref + 1, src0 + 1, src1 + 1, n);
+            call_new(dst_new + 1, src0 + 1, src1 + 1, n);
+            check_buffers(dst_ref, dst_new, LEN + 1);
+
+            bench_new(dst_new, src0, src1, LEN);
+        }
+        report("update");
+    }
+
+    {
+        declare_func(void, dwtcoef *dst, const dwtcoef *a, const dwtcoef *b,
+                     const dwtcoef *c, const dwtcoef *d, int n);
+
+        if (check_func(c->predict_97, "predict_97")) {
+            n = random_len();
+            randomize_buffer(dst_ref, LEN + 1);
+            memcpy(dst_new, dst_ref, (LEN + 1) * sizeof(*dst_ref));
+
+            call_ref(dst_ref + 1, src0 + 1, src1 + 1, src2 + 1, src3 + 1, n);
+            call_new(dst_new + 1, src0 + 1, src1 + 1, src2 + 1, src3 + 1, n);
+            check_buffers(dst_ref, dst_new, LEN + 1);
+
+            bench_new(dst_new, src0, src1, src2, src3, LEN);
+        }
+        report("predict_97");
+    }
+}
+
+void checkasm_check_vc2enc_dwt(void)
+{
+    VC2TransformDSPContext c;
+
+    ff_vc2enc_init_transform_dsp(&c);
+
+    check_split_row(&c);
+    check_haar_row(&c);
+    check_haar_col(&c);
+    check_lifting(&c);
+}
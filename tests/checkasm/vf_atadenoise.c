@@ -0,0 +1,81 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/atadenoise.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 125
+#define WIDTH_PADDED 128
+#define SIZE 9
+
+static void check_filter_row(int algorithm)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(uint8_t, frames,  [SIZE * WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH_PADDED]);
+    const float sigma[4] = { INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX };
+    /* thra and thrb for the default and the largest thresholds */
+    static const int thr[][2] = { { 4, 9 }, { 12, 40 }, { 75, 1279 } };
+    const uint8_t *srcf[SIZE];
+    ATADenoiseDSPContext dsp;
+
+    declare_func(void, const uint8_t *src, uint8_t *dst,
+                 const uint8_t **srcf, int w, int mid, int size,
+                 int thra, int thrb, const float *weights);
+
+    ff_atadenoise_init(&dsp, 8, algorithm, sigma);
+
+    if (check_func(dsp.filter_row[0], "atadenoise_filter_row8%s",
+                   algorithm == SERIAL ? "_serial" : "")) {
+        for (int t = 0; t < FF_ARRAY_ELEMS(thr); t++) {
+            /* frames close to the center one, so that the lanes stop
+             * accumulating after a varying number of frames */
+            for (int x = 0; x < WIDTH_PADDED; x++)
+                src[x] = rnd() & 0xFF;
+            for (int i = 0; i < SIZE; i++) {
+                for (int x = 0; x < WIDTH_PADDED; x++) {
+                    const int d = (int)(rnd() % (2 * thr[t][0] + 5)) - thr[t][0] - 2;
+                    frames[i * WIDTH_PADDED + x] = av_clip_uint8(src[x] + d);
+                }
+                srcf[i] = frames + i * WIDTH_PADDED;
+            }
+            srcf[SIZE / 2] = src;
+
+            memset(dst_ref, 0, WIDTH_PADDED);
+            memset(dst_new, 0, WIDTH_PADDED);
+            call_ref(src, dst_ref, srcf, WIDTH, SIZE / 2, SIZE, thr[t][0], thr[t][1], NULL);
+            call_new(src, dst_new, srcf, WIDTH, SIZE / 2, SIZE, thr[t][0], thr[t][1], NULL);
+            if (memcmp(dst_ref, dst_new, WIDTH))
+                fail();
+        }
+        bench_new(src, dst_new, srcf, WIDTH, SIZE / 2, SIZE, 4, 9, NULL);
+    }
+}
+
+void checkasm_check_vf_atadenoise(void)
+{
+    check_filter_row(PARALLEL);
+    report("filter_row8");
+
+    check_filter_row(SERIAL);
+    report("filter_row8_serial");
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vf_hqdn3d.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 125
+#define WIDTH_PADDED 128
+
+/* same tables as the filter builds for the given strength */
+static void init_coefs(int16_t *ct, double dist25, int lut_bits)
+{
+    const double gamma = log(0.25) / log(1.0 - FFMIN(dist25, 252.0) / 255.0 - 0.00001);
+
+    for (int i = -(256 << lut_bits); i < 256 << lut_bits; i++) {
+        double f = (i * (1 << (9 - lut_bits)) + (1 << (8 - lut_bits)) - 1) / 512.0;
+        double simil = FFMAX(0, 1.0 - fabs(f) / 255.0);
+        ct[(256 << lut_bits) + i] = lrint(pow(simil, gamma) * 256.0 * f);
+    }
+}
+
+static void check_row(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t,  src,           [WIDTH_PADDED * 2]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_ref,       [WIDTH_PADDED * 2]);
+    LOCAL_ALIGNED_32(uint8_t,  dst_new,       [WIDTH_PADDED * 2]);
+    LOCAL_ALIGNED_32(uint16_t, line_ant_ref,  [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(uint16_t, line_ant_new,  [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(uint16_t, frame_ant_ref, [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(uint16_t, frame_ant_new, [WIDTH_PADDED]);
+    const int lut_bits = depth == 16 ? 8 : 4;
+    const int bytes = (depth + 7) >> 3;
+    /* the default luma strengths and a strong one */
+    static const double strength[][2] = { { 4.0, 6.0 }, { 30.0, 45.0 } };
+    HQDN3DContext s = { 0 };
+    int16_t *spatial  = av_malloc((512 << lut_bits) * sizeof(*spatial));
+    int16_t *temporal = av_malloc((512 << lut_bits) * sizeof(*temporal));
+
+    declare_func(void, uint8_t *src, uint8_t *dst, uint16_t *line_ant,
+                 uint16_t *frame_ant, ptrdiff_t w, int16_t *spatial,
+                 int16_t *temporal);
+
+    if (!spatial || !temporal)
+        fail();
+
+    ff_hqdn3d_init(&s);
+
+    if (spatial && temporal && check_func(s.denoise_row[depth], "hqdn3d_row_%d", depth)) {
+        int16_t *spatial_lut  = spatial  + (256 << lut_bits);
+        int16_t *temporal_lut = temporal + (256 << lut_bits);
+
+        for (int t = 0; t < FF_ARRAY_ELEMS(strength); t++) {
+            init_coefs(spatial,  strength[t][0], lut_bits);
+            init_coefs(temporal, strength[t][1], lut_bits);
+
+            for (int x = 0; x < WIDTH_PADDED; x++) {
+                if (depth == 8)
+                    src[x] = rnd();
+                else
+                    AV_WN16A(src + 2 * x, rnd() & ((1 << depth) - 1));
+                line_ant_ref[x]  = rnd();
+                frame_ant_ref[x] = rnd();
+            }
+            memcpy(line_ant_new,  line_ant_ref,  sizeof(*line_ant_ref)  * WIDTH_PADDED);
+            memcpy(frame_ant_new, frame_ant_ref, sizeof(*frame_ant_ref) * WIDTH_PADDED);
+            memset(dst_ref, 0, WIDTH_PADDED * 2);
+            memset(dst_new, 0, WIDTH_PADDED * 2);
+
+            call_ref(src, dst_ref, line_ant_ref, frame_ant_ref, WIDTH, spatial_lut, temporal_lut);
+            call_new(src, dst_new, line_ant_new, frame_ant_new, WIDTH, spatial_lut, temporal_lut);
+            if (memcmp(dst_ref, dst_new, WIDTH * bytes) ||
+                memcmp(line_ant_ref,  line_ant_new,  WIDTH * sizeof(*line_ant_ref)) ||
+                memcmp(frame_ant_ref, frame_ant_new, WIDTH * sizeof(*frame_ant_ref)))
+                fail();
+        }
+        bench_new(src, dst_new, line_ant_new, frame_ant_new, WIDTH, spatial_lut, temporal_lut);
+    }
+
+    av_free(spatial);
+    av_free(temporal);
+}
+
+void checkasm_check_vf_hqdn3d(void)
+{
+    check_row(8);
+    check_row(9);
+    check_row(10);
+    check_row(16);
+    report("hqdn3d_row");
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/paletteuse.h"
+#include "libavutil/mem_internal.h"
+
+/* Lab values as ff_srgb_u8_to_oklab_int() gives them, plus the padding
+ * value used by the filter */
+static int32_t rnd_lab(int c)
+{
+    return c ? (int)(rnd() % 40000) - 20000 : rnd() % 65536;
+}
+
+static void check_nearest_color(void)
+{
+    LOCAL_ALIGNED_32(int32_t, pal, [3 * AVPALETTE_COUNT]);
+    static const int nb_colors_list[] = { 8, 16, 64, 248, AVPALETTE_COUNT };
+    PaletteUseDSPContext dsp;
+
+    declare_func(int, const int32_t *pal, int nb_colors, int L, int a, int b);
+
+    ff_paletteuse_init(&dsp);
+
+    if (check_func(dsp.nearest_color, "paletteuse_nearest_color")) {
+        for (int n = 0; n < FF_ARRAY_ELEMS(nb_colors_list); n++) {
+            const int nb_colors = nb_colors_list[n];
+
+            for (int t = 0; t < 32; t++) {
+                int target[3], ret_ref, ret_new;
+
+                for (int c = 0; c < 3; c++) {
+                    for (int i = 0; i < AVPALETTE_COUNT; i++)
+                        pal[c * AVPALETTE_COUNT + i] = rnd_lab(c);
+                    target[c] = rnd_lab(c);
+                }
+                switch (t & 3) {
+                case 1: /* the target is a palette color */
+                    for (int c = 0; c < 3; c++)
+                        target[c] = pal[c * AVPALETTE_COUNT + rnd() % nb_colors];
+                    break;
+                case 2: /* a duplicated palette color */
+                    for (int c = 0; c < 3; c++)
+                        pal[c * AVPALETTE_COUNT + nb_colors - 1] = pal[c * AVPALETTE_COUNT];
+                    break;
+                case 3: /* padding far away, all distances clipped */
+                    for (int c = 0; c < 3; c++)
+                        for (int i = nb_colors / 2; i < AVPALETTE_COUNT; i++)
+                            pal[c * AVPALETTE_COUNT + i] = 1 << 24;
+                    if (t & 4)
+                        for (int c = 0; c < 3; c++)
+                            target[c] = -(1 << 24);
+                    break;
+                }
+
+                ret_ref = call_ref(pal, nb_colors, target[0], target[1], target[2]);
+                ret_new = call_new(pal, nb_colors, target[0], target[1], target[2]);
+                if (ret_ref != ret_new) {
+                    fail();
+                    fprintf(stderr, "nb_colors %d: %d != %d\n", nb_colors, ret_ref, ret_new);
+                }
+            }
+        }
+        bench_new(pal, 32, 32768, 100, -100);
+    }
+}
+
+void checkasm_check_vf_paletteuse(void)
+{
+    check_nearest_color();
+    report("nearest_color");
+}
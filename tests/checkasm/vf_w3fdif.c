@@ -0,0 +1,140 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/w3fdif.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+
+static const int16_t coef_lf[2][4] = {{ 16384, 16384,     0,    0},
+                                      {  -852, 17236, 17236, -852}};
+static const int16_t coef_hf[2][5] = {{ -2048,  4096, -2048,     0,    0},
+                                      {  1016, -3801,  5570, -3801, 1016}};
+
+#define randomize_lines(buf, count) \
+    for (size_t i = 0; i < count; i++) \
+        buf[i] = rnd()
+
+/* The C functions advance the line pointers, so each call gets a fresh copy. */
+#define SET_LINES(dst, src, n) \
+    for (int i = 0; i < n; i++) \
+        dst[i] = src + i * WIDTH
+
+static void check_low(const char *name, int n,
+                      void (*func)(int32_t *, uint8_t **, const int16_t *, int),
+                      const int16_t *coef)
+{
+    LOCAL_ALIGNED_16(uint8_t, lines, [4 * WIDTH]);
+    LOCAL_ALIGNED_16(int32_t, work0, [WIDTH]);
+    LOCAL_ALIGNED_16(int32_t, work1, [WIDTH]);
+    uint8_t *cur0[4], *cur1[4];
+
+    declare_func(void, int32_t *work_line, uint8_t **in_lines_cur,
+                 const int16_t *coef, int linesize);
+
+    if (check_func(func, "%s", name)) {
+        randomize_lines(lines, 4 * WIDTH);
+        memset(work0, 0, WIDTH * sizeof(*work0));
+        memset(work1, 0, WIDTH * sizeof(*work1));
+        SET_LINES(cur0, lines, n);
+        SET_LINES(cur1, lines, n);
+
+        call_ref(work0, cur0, coef, WIDTH);
+        call_new(work1, cur1, coef, WIDTH);
+        if (memcmp(work0, work1, WIDTH * sizeof(*work0)))
+            fail();
+        SET_LINES(cur1, lines, n);
+        bench_new(work1, cur1, coef, WIDTH);
+    }
+}
+
+static void check_high(const char *name, int n,
+                       void (*func)(int32_t *, uint8_t **, uint8_t **, const int16_t *, int),
+                       const int16_t *coef)
+{
+    LOCAL_ALIGNED_16(uint8_t, lines, [10 * WIDTH]);
+    LOCAL_ALIGNED_16(int32_t, work0, [WIDTH]);
+    LOCAL_ALIGNED_16(int32_t, work1, [WIDTH]);
+    uint8_t *cur0[5], *cur1[5], *adj0[5], *adj1[5];
+
+    declare_func(void, int32_t *work_line, uint8_t **in_lines_cur,
+                 uint8_t **in_lines_adj, const int16_t *coef, int linesize);
+
+    if (check_func(func, "%s", name)) {
+        randomize_lines(lines, 10 * WIDTH);
+        for (int i = 0; i < WIDTH; i++)
+            work0[i] = work1[i] = (int32_t)(rnd() & 0xffffff) - 0x800000;
+        SET_LINES(cur0, lines, n);
+        SET_LINES(cur1, lines, n);
+        SET_LINES(adj0, lines + 5 * WIDTH, n);
+        SET_LINES(adj1, lines + 5 * WIDTH, n);
+
+        call_ref(work0, cur0, adj0, coef, WIDTH);
+        call_new(work1, cur1, adj1, coef, WIDTH);
+        if (memcmp(work0, work1, WIDTH * sizeof(*work0)))
+            fail();
+        SET_LINES(cur1, lines, n);
+        SET_LINES(adj1, lines + 5 * WIDTH, n);
+        bench_new(work1, cur1, adj1, coef, WIDTH);
+    }
+}
+
+static void check_scale(W3FDIFDSPContext *dsp)
+{
+    LOCAL_ALIGNED_16(int32_t, work, [WIDTH]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [WIDTH]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [WIDTH]);
+    const int max = 255 * 256 * 128;
+
+    declare_func(void, uint8_t *out_pixel, const int32_t *work_pixel,
+                 int linesize, int max);
+
+    if (check_func(dsp->filter_scale, "w3fdif_scale")) {
+        /* cover both clipping ends as well as the in-range values */
+        for (int i = 0; i < WIDTH; i++)
+            work[i] = (int32_t)(rnd() % (3 * max)) - max;
+        memset(dst0, 0, WIDTH);
+        memset(dst1, 0, WIDTH);
+
+        call_ref(dst0, work, WIDTH, max);
+        call_new(dst1, work, WIDTH, max);
+        if (memcmp(dst0, dst1, WIDTH))
+            fail();
+        bench_new(dst1, work, WIDTH, max);
+    }
+}
+
+void checkasm_check_vf_w3fdif(void)
+{
+    W3FDIFDSPContext dsp;
+
+    ff_w3fdif_init(&dsp, 8);
+
+    check_low("w3fdif_simple_low",  2, dsp.filter_simple_low,  coef_lf[0]);
+    check_low("w3fdif_complex_low", 4, dsp.filter_complex_low, coef_lf[1]);
+    report("low");
+
+    check_high("w3fdif_simple_high",  3, dsp.filter_simple_high,  coef_hf[0]);
+    check_high("w3fdif_complex_high", 5, dsp.filter_complex_high, coef_hf[1]);
+    report("high");
+
+    check_scale(&dsp);
+    report("scale");
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/yadif.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+
+#define WIDTH 256
+
+#define randomize_buffers(buf0, buf1, mask, count) \
+    for (size_t i = 0; i < count; i++) \
+        buf0[i] = buf1[i] = rnd() & mask
+
+/* filter_line() is called 3 pixels into the line and leaves the last
+ * pixels to filter_edges(); use a width that is a multiple of every SIMD
+ * step. Some versions store a few pixels past w, which filter_edges()
+ * overwrites, so the comparison stops after the w filtered pixels. */
+#define BODY(type, depth)                                                      \
+    do {                                                                       \
+        type prev0[5*WIDTH], prev1[5*WIDTH];                                   \
+        type next0[5*WIDTH], next1[5*WIDTH];                                   \
+        type cur0[5*WIDTH], cur1[5*WIDTH];                                     \
+        type dst0[WIDTH], dst1[WIDTH];                                         \
+        const int stride = WIDTH;                                              \
+        const int mask = (1<<depth)-1;                                         \
+        const int w = WIDTH - 16;                                              \
+                                                                               \
+        declare_func(void, void *dst, void *prev, void *cur, void *next,       \
+                     int w, int prefs, int mrefs, int parity, int mode);       \
+                                                                               \
+        for (int parity = 0; parity < 2; parity++) {                           \
+            for (int mode = 0; mode < 4; mode += 2) {                          \
+                randomize_buffers(prev0, prev1, mask, 5*WIDTH);                \
+                randomize_buffers(next0, next1, mask, 5*WIDTH);                \
+                randomize_buffers( cur0,  cur1, mask, 5*WIDTH);                \
+                memset(dst0, 0, sizeof(dst0));                                 \
+                memset(dst1, 0, sizeof(dst1));                                 \
+                                                                               \
+                call_ref(dst0 + 3, prev0 + 2*WIDTH + 3, cur0 + 2*WIDTH + 3,    \
+                         next0 + 2*WIDTH + 3, w, stride, -stride,              \
+                         parity, mode);                                        \
+                call_new(dst1 + 3, prev1 + 2*WIDTH + 3, cur1 + 2*WIDTH + 3,    \
+                         next1 + 2*WIDTH + 3, w, stride, -stride,              \
+                         parity, mode);                                        \
+                                                                               \
+                if (memcmp(dst0, dst1, (w + 3) * sizeof(*dst0))                \
+                        || memcmp(prev0, prev1, sizeof prev0)                  \
+                        || memcmp(next0, next1, sizeof next0)                  \
+                        || memcmp( cur0,  cur1, sizeof cur0))                  \
+                    fail();                                                    \
+            }                                                                  \
+        }                                                                      \
+        bench_new(dst1 + 3, prev1 + 2*WIDTH + 3, cur1 + 2*WIDTH + 3,           \
+                  next1 + 2*WIDTH + 3, w, stride, -stride, 0, 0);              \
+    } while (0)
+
+void checkasm_check_vf_yadif(void)
+{
+    YADIFContext s = { 0 };
+
+    s.csp = av_pix_fmt_desc_get(AV_PIX_FMT_YUV420P);
+    ff_yadif_init_filter_line(&s);
+    if (check_func(s.filter_line, "yadif8")) {
+        BODY(uint8_t, 8);
+        report("yadif8");
+    }
+
+    s.csp = av_pix_fmt_desc_get(AV_PIX_FMT_YUV420P10);
+    ff_yadif_init_filter_line(&s);
+    if (check_func(s.filter_line, "yadif10")) {
+        BODY(uint16_t, 10);
+        report("yadif10");
+    }
+
+    s.csp = av_pix_fmt_desc_get(AV_PIX_FMT_YUV420P16);
+    ff_yadif_init_filter_line(&s);
+    if (check_func(s.filter_line, "yadif16")) {
+        BODY(uint16_t, 16);
+        report("yadif16");
+    }
+}
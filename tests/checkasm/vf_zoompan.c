@@ -0,0 +1,134 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/zoompan.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 128
+#define MAX_TAPS 12
+
+/* widths with and without a tail that the vector code cannot handle */
+static const int widths[] = { 4, 13, 45, WIDTH };
+static const int taps_list[] = { 1, 3, 4, 7, 12 };
+
+/* Coefficients summing to 1 << ZOOMPAN_COEFF_BITS with negative lobes, like
+ * the bicubic kernel; zero padded up to stride. */
+static void fill_coeffs(int16_t *coeffs, int taps, int stride)
+{
+    int sum = 0;
+
+    for (int k = 0; k < taps; k++) {
+        coeffs[k] = (int)(rnd() % 1025) - 512;
+        sum += coeffs[k];
+    }
+    coeffs[rnd() % taps] += (1 << ZOOMPAN_COEFF_BITS) - sum;
+    for (int k = taps; k < stride; k++)
+        coeffs[k] = 0;
+}
+
+static void check_vfilter_row(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [MAX_TAPS * WIDTH]);
+    LOCAL_ALIGNED_32(int16_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(int16_t, dst_new, [WIDTH]);
+    int16_t coeffs[MAX_TAPS];
+    ZoompanDSPContext dsp;
+
+    declare_func(void, int16_t *dst, const uint8_t *src, ptrdiff_t linesize,
+                 const int16_t *coeffs, int taps, int width);
+
+    ff_zoompan_init(&dsp);
+
+    if (check_func(dsp.vfilter_row, "zoompan_vfilter_row")) {
+        for (int t = 0; t < FF_ARRAY_ELEMS(taps_list); t++) {
+            for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                const int taps = taps_list[t];
+
+                for (int j = 0; j < MAX_TAPS * WIDTH; j++)
+                    src[j] = rnd() & 0xFF;
+                fill_coeffs(coeffs, taps, FFALIGN(taps, 4));
+                memset(dst_ref, 0, WIDTH * sizeof(*dst_ref));
+                memset(dst_new, 0, WIDTH * sizeof(*dst_new));
+
+                call_ref(dst_ref, src, WIDTH, coeffs, taps, widths[i]);
+                call_new(dst_new, src, WIDTH, coeffs, taps, widths[i]);
+                if (memcmp(dst_ref, dst_new, WIDTH * sizeof(*dst_ref)))
+                    fail();
+            }
+        }
+        fill_coeffs(coeffs, 4, 4);
+        bench_new(dst_new, src, WIDTH, coeffs, 4, WIDTH);
+    }
+}
+
+static void check_hfilter_row(void)
+{
+    LOCAL_ALIGNED_32(int16_t, src,     [2 * WIDTH + MAX_TAPS]);
+    LOCAL_ALIGNED_32(int16_t, coeffs,  [WIDTH * MAX_TAPS]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+    int pos[WIDTH];
+    ZoompanDSPContext dsp;
+
+    declare_func(void, uint8_t *dst, const int16_t *src, const int *pos,
+                 const int16_t *coeffs, int taps, int width);
+
+    ff_zoompan_init(&dsp);
+
+    if (check_func(dsp.hfilter_row, "zoompan_hfilter_row")) {
+        for (int t = 0; t < FF_ARRAY_ELEMS(taps_list); t++) {
+            for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                const int taps = taps_list[t], stride = FFALIGN(taps, 4);
+
+                /* vertical pass output: 8 bit samples with 6 fractional
+                 * bits, plus some over- and undershoot */
+                for (int j = 0; j < 2 * WIDTH + MAX_TAPS; j++)
+                    src[j] = (int)(rnd() % (20480 + 4096)) - 4096;
+                /* increasing positions, both up- and downscaling */
+                pos[0] = rnd() % 4;
+                for (int x = 1; x < WIDTH; x++)
+                    pos[x] = FFMIN(pos[x - 1] + rnd() % 3, 2 * WIDTH + MAX_TAPS - stride);
+                for (int x = 0; x < WIDTH; x++)
+                    fill_coeffs(coeffs + x * stride, taps, stride);
+                memset(dst_ref, 0, WIDTH);
+                memset(dst_new, 0, WIDTH);
+
+                call_ref(dst_ref, src, pos, coeffs, stride, widths[i]);
+                call_new(dst_new, src, pos, coeffs, stride, widths[i]);
+                if (memcmp(dst_ref, dst_new, WIDTH))
+                    fail();
+            }
+        }
+        for (int x = 0; x < WIDTH; x++) {
+            pos[x] = x;
+            fill_coeffs(coeffs + x * 4, 4, 4);
+        }
+        bench_new(dst_new, src, pos, coeffs, 4, WIDTH);
+    }
+}
+
+void checkasm_check_vf_zoompan(void)
+{
+    check_vfilter_row();
+    report("vfilter_row");
+
+    check_hfilter_row();
+    report("hfilter_row");
+}
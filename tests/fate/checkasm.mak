@@ -1,11 +1,16 @@
 FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
+                fate-checkasm-aes                                       \
                 fate-checkasm-af_afir                                   \
+                fate-checkasm-af_biquads                                \
                 fate-checkasm-alacdsp                                   \
                 fate-checkasm-audiodsp                                  \
                 fate-checkasm-av_tx                                     \
                 fate-checkasm-blockdsp                                  \
+                fate-checkasm-boxblurdsp                                \
                 fate-checkasm-bswapdsp                                  \
+                fate-checkasm-drawutils                                 \
                 fate-checkasm-exrdsp                                    \
+                fate-checkasm-f_ebur128                                 \
                 fate-checkasm-fixed_dsp                                 \
                 fate-checkasm-flacdsp                                   \
                 fate-checkasm-float_dsp                                 \
@@ -22,6 +27,7 @@ FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
                 fate-checkasm-hevc_sao                                  \
                 fate-checkasm-huffyuvdsp                                \
                 fate-checkasm-idctdsp                                   \
+                fate-checkasm-ivtcdsp                                   \
                 fate-checkasm-jpeg2000dsp                               \
                 fate-checkasm-llviddsp                                  \
                 fate-checkasm-llviddspenc                               \
@@ -29,6 +35,7 @@ FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
                 fate-checkasm-motion                                    \
                 fate-checkasm-opusdsp                                   \
                 fate-checkasm-pixblockdsp                               \
+                fate-checkasm-rowstats                                  \
                 fate-checkasm-sbrdsp                                    \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-sw_gbrp                                   \
@@ -38,15 +45,22 @@ FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
                 fate-checkasm-v210dec                                   \
                 fate-checkasm-v210enc                                   \
                 fate-checkasm-vc1dsp                                    \
+                fate-checkasm-vc2enc_dwt                                \
+                fate-checkasm-vf_atadenoise                             \
                 fate-checkasm-vf_blend                                  \
                 fate-checkasm-vf_bwdif                                  \
                 fate-checkasm-vf_colorspace                             \
                 fate-checkasm-vf_eq                                     \
                 fate-checkasm-vf_gblur                                  \
                 fate-checkasm-vf_hflip                                  \
+                fate-checkasm-vf_hqdn3d                                 \
                 fate-checkasm-vf_nlmeans                                \
+                fate-checkasm-vf_paletteuse                             \
                 fate-checkasm-vf_threshold                              \
                 fate-checkasm-vf_sobel                                  \
+                fate-checkasm-vf_w3fdif                                 \
+                fate-checkasm-vf_yadif                                  \
+                fate-checkasm-vf_zoompan                                \
                 fate-checkasm-videodsp                                  \
                 fate-checkasm-vorbisdsp                                 \
                 fate-checkasm-vp8dsp                                    \
@@ -112,6 +112,48 @@ fate-unknown_layout-ac3: CMD = md5 -auto_conversion_filters \
   -guess_layout_max 0 -f s32le -ac 1 -ar 44100 -i $(TARGET_PATH)/$(AREF) \
   -f ac3 -flags +bitexact -c ac3_fixed
 
+# -max_queue_mem makes the threads wait for each other without changing the
+# output, and fails once the packets buffered before the muxer starts exceed it
+MAX_QUEUE_MEM_CMD = framecrc -f rawvideo -s 352x288 -pix_fmt yuv420p \
+  -i $(TARGET_PATH)/tests/data/vsynth1.yuv -f lavfi -i sine=d=2 \
+  -c:v rawvideo -c:a pcm_s16le
+
+FATE_MAX_QUEUE_MEM-$(call FILTERDEMDEC, SINE, RAWVIDEO, RAWVIDEO PCM_S16LE, \
+                         LAVFI_INDEV) += fate-ffmpeg-max_queue_mem-unlimited \
+                                         fate-ffmpeg-max_queue_mem
+FATE_MAX_QUEUE_MEM-$(call ALLYES, LAVFI_INDEV TESTSRC_FILTER SINE_FILTER \
+                         ATRIM_FILTER RAWVIDEO_DECODER PCM_S16LE_DECODER \
+                         RAWVIDEO_ENCODER PCM_S16LE_ENCODER NULL_MUXER \
+                         PIPE_PROTOCOL) += fate-ffmpeg-max_queue_mem-enospc
+fate-ffmpeg-max_queue_mem-unlimited fate-ffmpeg-max_queue_mem: tests/data/vsynth1.yuv
+fate-ffmpeg-max_queue_mem-unlimited: CMD = $(MAX_QUEUE_MEM_CMD)
+fate-ffmpeg-max_queue_mem: CMD = $(MAX_QUEUE_MEM_CMD) -max_queue_mem 512k
+fate-ffmpeg-max_queue_mem: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-max_queue_mem-unlimited
+# the video packets are buffered until the trimmed audio starts
+fate-ffmpeg-max_queue_mem-enospc: CMD = ffmpeg -xerror -max_queue_mem 256k \
+  -f lavfi -i "testsrc=s=352x288:d=5[out0];sine=d=5[out1]" -af atrim=start=3 \
+  -c:v rawvideo -c:a pcm_s16le -f null -; test $$? -eq 228
+FATE_FFMPEG-$(HAVE_THREADS) += $(FATE_MAX_QUEUE_MEM-yes)
+
+# -enc_chunks must produce the same packets as a serial encode; for AAC, the
+# chunks start from a fresh encoder, so only the timestamps are compared
+ENC_CHUNKS_MPEG4_CMD = framecrc -f rawvideo -s 352x288 -pix_fmt yuv420p \
+  -i $(TARGET_PATH)/tests/data/vsynth1.yuv -c:v mpeg4 -g 10 -qscale 10 -threads 1
+ENC_CHUNKS_AAC_CMD = framecrc -auto_conversion_filters -f lavfi -i sine=d=5 -c:a aac
+
+FATE_ENC_CHUNKS-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, MPEG4_ENCODER) += \
+  fate-ffmpeg-enc_chunks-mpeg4-serial fate-ffmpeg-enc_chunks-mpeg4
+FATE_ENC_CHUNKS-$(call FILTERDEMDEC, SINE ARESAMPLE, , PCM_S16LE, LAVFI_INDEV AAC_ENCODER) += \
+  fate-ffmpeg-enc_chunks-aac-serial fate-ffmpeg-enc_chunks-aac
+fate-ffmpeg-enc_chunks-mpeg4-serial fate-ffmpeg-enc_chunks-mpeg4: tests/data/vsynth1.yuv
+fate-ffmpeg-enc_chunks-mpeg4-serial: CMD = $(ENC_CHUNKS_MPEG4_CMD)
+fate-ffmpeg-enc_chunks-mpeg4: CMD = $(ENC_CHUNKS_MPEG4_CMD) -enc_chunks 2
+fate-ffmpeg-enc_chunks-mpeg4: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-enc_chunks-mpeg4-serial
+fate-ffmpeg-enc_chunks-aac-serial: CMD = $(ENC_CHUNKS_AAC_CMD) | cut -d, -f1-4
+fate-ffmpeg-enc_chunks-aac: CMD = $(ENC_CHUNKS_AAC_CMD) -enc_chunks 2 -enc_chunk_frames 50 | cut -d, -f1-4
+fate-ffmpeg-enc_chunks-aac: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-enc_chunks-aac-serial
+FATE_FFMPEG-$(HAVE_THREADS) += $(FATE_ENC_CHUNKS-yes)
+
 FATE_SAMPLES_FFMPEG-$(call FILTERDEMDEC, AMIX ARESAMPLE SINE, RAWVIDEO, \
                            PCM_S16LE RAWVIDEO, LAVFI_INDEV  \
                            MPEG4_ENCODER AC3_FIXED_ENCODER) \
@@ -34,6 +34,23 @@ fate-ffprobe_xsd: $(FFPROBE_TEST_FILE)
 fate-ffprobe_xsd: CMD = run $(FFPROBE_COMMAND) -noprivate -of xml=q=1:x=1 | \
 	xmllint --schema $(SRC_PATH)/doc/ffprobe.xsd -
 
+# probing with several threads must give the same result as the serial probe
+STREAM_INFO_TEST_FILE = tests/data/stream-info-test.ts
+STREAM_INFO_COMMAND = ffprobe$(PROGSSUF)$(EXESUF) -show_streams -show_format -bitexact $(TARGET_PATH)/$(STREAM_INFO_TEST_FILE) -print_filename $(STREAM_INFO_TEST_FILE)
+
+FATE_FFPROBE_STREAM_INFO += fate-ffprobe_stream_info
+fate-ffprobe_stream_info: CMD = run $(STREAM_INFO_COMMAND)
+
+FATE_FFPROBE_STREAM_INFO += fate-ffprobe_stream_info_threads
+fate-ffprobe_stream_info_threads: REF = $(SRC_PATH)/tests/ref/fate/ffprobe_stream_info
+fate-ffprobe_stream_info_threads: CMD = run $(STREAM_INFO_COMMAND) -stream_info_threads 4
+
+$(FATE_FFPROBE_STREAM_INFO): $(STREAM_INFO_TEST_FILE)
+FATE_FFPROBE-$(call ALLYES, AVDEVICE LAVFI_INDEV TESTSRC_FILTER SINE_FILTER SCALE_FILTER \
+                            MPEG2VIDEO_ENCODER MP2_ENCODER MPEGTS_MUXER         \
+                            MPEGTS_DEMUXER MPEG2VIDEO_DECODER MP2_DECODER       \
+                            FILE_PROTOCOL) += $(FATE_FFPROBE_STREAM_INFO)
+
 FATE_FFPROBE-$(HAVE_XMLLINT) += $(FATE_FFPROBE_SCHEMA-yes)
 FATE_FFPROBE += $(FATE_FFPROBE-yes)
 
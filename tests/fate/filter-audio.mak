@@ -99,6 +99,29 @@ fate-filter-asetrate: tests/data/asynth-44100-2.wav
 fate-filter-asetrate: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
 fate-filter-asetrate: CMD = framecrc -i $(SRC) -frames:a 20 -af asetrate=20000
 
+# stages=N must match N chained filters, on odd sized frames and, with the
+# float planar multichannel input, on the SIMD lane path as well
+FATE_FILTER_BIQUAD_STAGES += fate-filter-biquad-stages
+fate-filter-biquad-stages: CMD = framecrc -auto_conversion_filters -i $(SRC) -af asetnsamples=n=1001:p=0,lowpass=f=1000:stages=3
+
+FATE_FILTER_BIQUAD_STAGES += fate-filter-biquad-cascade
+fate-filter-biquad-cascade: REF = $(SRC_PATH)/tests/ref/fate/filter-biquad-stages
+fate-filter-biquad-cascade: CMD = framecrc -auto_conversion_filters -i $(SRC) -af asetnsamples=n=1001:p=0,lowpass=f=1000,lowpass=f=1000,lowpass=f=1000
+
+BIQUAD_FLTP_IN = asetnsamples=n=1001:p=0,pan=5.1|c0=c0|c1=c1|c2=0.5*c0+0.5*c1|c3=0.2*c0|c4=0.7*c0|c5=0.7*c1,aformat=fltp
+BIQUAD_FLTP_EQ = equalizer=f=800:t=q:w=1:g=6:a=tdii
+
+FATE_FILTER_BIQUAD_STAGES += fate-filter-biquad-stages-fltp
+fate-filter-biquad-stages-fltp: CMD = framecrc -auto_conversion_filters -i $(SRC) -af "$(BIQUAD_FLTP_IN),$(BIQUAD_FLTP_EQ):stages=2"
+
+FATE_FILTER_BIQUAD_STAGES += fate-filter-biquad-cascade-fltp
+fate-filter-biquad-cascade-fltp: REF = $(SRC_PATH)/tests/ref/fate/filter-biquad-stages-fltp
+fate-filter-biquad-cascade-fltp: CMD = framecrc -auto_conversion_filters -i $(SRC) -af "$(BIQUAD_FLTP_IN),$(BIQUAD_FLTP_EQ),$(BIQUAD_FLTP_EQ)"
+
+$(FATE_FILTER_BIQUAD_STAGES): tests/data/asynth-44100-2.wav
+$(FATE_FILTER_BIQUAD_STAGES): SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOWPASS EQUALIZER ASETNSAMPLES PAN AFORMAT, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_FILTER_BIQUAD_STAGES)
+
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, CHORUS, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-chorus
 fate-filter-chorus: tests/data/asynth-22050-1.wav
 fate-filter-chorus: SRC = $(TARGET_PATH)/tests/data/asynth-22050-1.wav
@@ -133,6 +156,20 @@ fate-filter-firequalizer: CMP = oneoff
 fate-filter-firequalizer: CMP_UNIT = s16
 fate-filter-firequalizer: SIZE_TOLERANCE = 1058400 - 1097208
 
+FATE_FILTER_LOUDNORM += fate-filter-loudnorm-lookahead
+fate-filter-loudnorm-lookahead: CMD = framecrc -i $(SRC) -af aresample,loudnorm=lookahead=1,aresample
+
+# linear normalization is ruled out, resampled to 192 kHz internally
+FATE_FILTER_LOUDNORM += fate-filter-loudnorm-lookahead-dynamic
+fate-filter-loudnorm-lookahead-dynamic: CMD = framecrc -i $(SRC) -af aresample,loudnorm=lookahead=1:lra=3,aresample
+
+FATE_FILTER_LOUDNORM += fate-filter-loudnorm-lookahead_max
+fate-filter-loudnorm-lookahead_max: CMD = framecrc -i $(SRC) -af aresample,loudnorm=lookahead=1:lookahead_max=4:i=-5,aresample
+
+$(FATE_FILTER_LOUDNORM): tests/data/asynth-44100-2.wav
+$(FATE_FILTER_LOUDNORM): SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOUDNORM ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_FILTER_LOUDNORM)
+
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, PAN, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-pan-mono1
 fate-filter-pan-mono1: tests/data/asynth-44100-2.wav
 fate-filter-pan-mono1: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
@@ -401,6 +438,10 @@ FATE_AFILTER-yes += fate-filter-formats
 fate-filter-formats: libavfilter/tests/formats$(EXESUF)
 fate-filter-formats: CMD = run libavfilter/tests/formats$(EXESUF)
 
+FATE_AFILTER-$(HAVE_THREADS) += fate-filter-buffersrc-threadsafe
+fate-filter-buffersrc-threadsafe: libavfilter/tests/buffersrc$(EXESUF)
+fate-filter-buffersrc-threadsafe: CMD = run libavfilter/tests/buffersrc$(EXESUF)
+
 FATE_SAMPLES_AVCONV += $(FATE_AFILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_AFILTER-yes)
 fate-afilter: $(FATE_AFILTER-yes) $(FATE_AFILTER_SAMPLES-yes)
@@ -76,6 +76,13 @@ FATE_FILTER_PALETTEUSE-$(call FILTERDEMDEC, PALETTEUSE SCALE, MATROSKA IMAGE2, H
 fate-filter-paletteuse: $(FATE_FILTER_PALETTEUSE-yes)
 FATE_FILTER_SAMPLES-yes += $(FATE_FILTER_PALETTEUSE-yes)
 
+# slice threaded histograms and wavefront error diffusion give the same output for any number of threads
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 NOISE SCALE FORMAT PALETTEGEN) += fate-filter-palettegen-threads
+fate-filter-palettegen-threads: CMD = framecrc -filter_complex_threads 4 -lavfi testsrc2=s=320x240:d=0.4,noise=alls=12:allf=t,scale,format=bgra,palettegen=stats_mode=diff,scale,format=bgra
+
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC TESTSRC2 NOISE SCALE FORMAT PALETTEUSE) += fate-filter-paletteuse-sierra3-threads
+fate-filter-paletteuse-sierra3-threads: CMD = framecrc -filter_complex_threads 4 -lavfi "testsrc2=s=320x240:d=0.4,noise=alls=12:allf=t,scale,format=bgra[v]\;testsrc=s=16x16:d=0.4,scale,format=bgra[p]\;[v][p]paletteuse=sierra3,scale,format=bgra"
+
 FATE_FILTER-$(call FILTERFRAMECRC, LIFE, LAVFI_INDEV) += fate-filter-lavd-life
 fate-filter-lavd-life: CMD = framecrc -f lavfi -i life=s=40x40:r=5:seed=42:mold=64:ratio=0.1:death_color=red:life_color=green -t 2
 
@@ -326,6 +333,12 @@ fate-filter-untile: CMD = framecrc -lavfi testsrc2=d=1:r=2,untile=2x2
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 UNTILE) += fate-filter-untile-yuv422p
 fate-filter-untile-yuv422p: CMD = framecrc -lavfi testsrc2=d=1:r=2,format=yuv422p,untile=2x2
 
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 ZOOMPAN) += fate-filter-zoompan-bicubic
+fate-filter-zoompan-bicubic: CMD = framecrc -lavfi "testsrc2=s=320x240:d=1:r=2,zoompan=z=min(zoom+0.1\,2):d=5:x=iw/2-iw/zoom/2:y=ih/2-ih/zoom/2:s=175x143:interp=bicubic"
+
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FORMAT ZOOMPAN) += fate-filter-zoompan-bicubic-yuv422p
+fate-filter-zoompan-bicubic-yuv422p: CMD = framecrc -lavfi testsrc2=s=320x240:d=1:r=2,format=yuv422p,zoompan=z=1.5-on/20:d=5:x=on*7.3:y=on*3.1:s=480x360:interp=bicubic
+
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp
 fate-filter-unsharp: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf unsharp=11:11:-1.5:11:11:-1.5
 
@@ -376,6 +389,11 @@ fate-filter-chromashift-wrap:  CMD = framecrc -lavfi testsrc2=r=5:d=1,chromashif
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FPS DECIMATE) += fate-filter-decimate
 fate-filter-decimate: CMD = framecrc -lavfi testsrc2=r=24:d=10,fps=60,decimate=5,decimate=4,decimate=3 -pix_fmt yuv420p
 
+# slice threaded block differences give the same decisions for any number of threads
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FPS DECIMATE) += fate-filter-decimate-threads
+fate-filter-decimate-threads: CMD = framecrc -filter_complex_threads 4 -lavfi testsrc2=r=24:d=10,fps=60,decimate=5,decimate=4,decimate=3 -pix_fmt yuv420p
+fate-filter-decimate-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-decimate
+
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FPS MPDECIMATE) += fate-filter-mpdecimate
 fate-filter-mpdecimate: CMD = framecrc -lavfi testsrc2=r=2:d=10,fps=3,mpdecimate -pix_fmt yuv420p
 
@@ -563,6 +581,12 @@ fate-filter-pixfmts-field: CMD = pixfmts "bottom"
 FATE_FILTER_PIXFMTS-$(call ALLYES, TELECINE_FILTER FIELDMATCH_FILTER) += fate-filter-pixfmts-fieldmatch
 fate-filter-pixfmts-fieldmatch: CMD = pixfmts "" "telecine," 25
 
+# slice threaded comb detection and field matching
+FATE_FILTER_PIXFMTS-$(call ALLYES, TELECINE_FILTER FIELDMATCH_FILTER) += fate-filter-pixfmts-fieldmatch_threads
+fate-filter-pixfmts-fieldmatch_threads: CMD = pixfmts "" "telecine," 25
+fate-filter-pixfmts-fieldmatch_threads: THREADS = 4
+fate-filter-pixfmts-fieldmatch_threads: REF = $(SRC_PATH)/tests/ref/fate/filter-pixfmts-fieldmatch
+
 FATE_FILTER_PIXFMTS-$(CONFIG_FIELDORDER_FILTER) += fate-filter-pixfmts-fieldorder
 fate-filter-pixfmts-fieldorder: CMD = pixfmts "tff" "setfield=bff,"
 
@@ -667,6 +691,8 @@ fate-filter-metadata-cropdetect2: CMD = run $(FILTER_METADATA_COMMAND) "sws_flag
 FREEZEDETECT_DEPS = LAVFI_INDEV MPTESTSRC_FILTER SCALE_FILTER FREEZEDETECT_FILTER
 FATE_METADATA_FILTER-$(call ALLYES, $(FREEZEDETECT_DEPS)) += fate-filter-metadata-freezedetect
 fate-filter-metadata-freezedetect: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;mptestsrc=r=25:d=10:m=51,freezedetect"
+FATE_METADATA_FILTER-$(call ALLYES, $(FREEZEDETECT_DEPS)) += fate-filter-metadata-freezedetect-row_step
+fate-filter-metadata-freezedetect-row_step: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;mptestsrc=r=25:d=10:m=51,freezedetect=row_step=4"
 
 SIGNALSTATS_DEPS = LAVFI_INDEV COLOR_FILTER SCALE_FILTER SIGNALSTATS_FILTER
 FATE_METADATA_FILTER-$(call ALLYES, $(SIGNALSTATS_DEPS)) += fate-filter-metadata-signalstats-yuv420p fate-filter-metadata-signalstats-yuv420p10
@@ -728,6 +754,21 @@ fate-filter-refcmp-ssim-rgb: CMD = refcmp_metadata ssim rgb24 0.015
 FATE_FILTER_REFCMP_METADATA-$(CONFIG_SSIM_FILTER) += fate-filter-refcmp-ssim-yuv
 fate-filter-refcmp-ssim-yuv: CMD = refcmp_metadata ssim yuv422p 0.015
 
+FATE_FILTER_REFCMP_METADATA-$(CONFIG_QUALITYMETRICS_FILTER) += fate-filter-refcmp-qualitymetrics-yuv
+fate-filter-refcmp-qualitymetrics-yuv: CMD = refcmp_metadata qualitymetrics yuv422p 0.0015
+
+FATE_FILTER_REFCMP_METADATA-$(CONFIG_QUALITYMETRICS_FILTER) += fate-filter-refcmp-qualitymetrics-yuv420p10
+fate-filter-refcmp-qualitymetrics-yuv420p10: CMD = refcmp_metadata qualitymetrics yuv420p10 0.0015
+
+# the values must be the ones of the psnr and ssim filters
+FATE_FILTER_REFCMP_METADATA-$(CONFIG_QUALITYMETRICS_FILTER) += fate-filter-refcmp-qualitymetrics-psnr-yuv
+fate-filter-refcmp-qualitymetrics-psnr-yuv: CMD = refcmp_metadata qualitymetrics=metrics=psnr yuv422p 0.0015
+fate-filter-refcmp-qualitymetrics-psnr-yuv: REF = $(SRC_PATH)/tests/ref/fate/filter-refcmp-psnr-yuv
+
+FATE_FILTER_REFCMP_METADATA-$(CONFIG_QUALITYMETRICS_FILTER) += fate-filter-refcmp-qualitymetrics-ssim-yuv
+fate-filter-refcmp-qualitymetrics-ssim-yuv: CMD = refcmp_metadata qualitymetrics=metrics=ssim yuv422p 0.015
+fate-filter-refcmp-qualitymetrics-ssim-yuv: REF = $(SRC_PATH)/tests/ref/fate/filter-refcmp-ssim-yuv
+
 FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER AVGBLUR_FILTER        \
                            METADATA_FILTER WRAPPED_AVFRAME_ENCODER NULL_MUXER \
                            PIPE_PROTOCOL) += $(FATE_FILTER_REFCMP_METADATA-yes)
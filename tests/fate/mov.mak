@@ -178,6 +178,14 @@ FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER PAN_FILTER) \
 fate-mov-mp4-pcm-float: tests/data/asynth-44100-1.wav
 fate-mov-mp4-pcm-float: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-af aresample,pan=FL+LFE+BR|c0=c0|c1=c0|c2=c0 -c:a pcm_f32le" "-map 0 -c copy -frames:a 0"
 
+# Test fragments mixing packets written by reference with smaller packets
+# copied into the fragment buffer, every other video frame is a duplicate
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4 MP2, MOV, RAWVIDEO_DEMUXER RAWVIDEO_DECODER \
+                        WAV_DEMUXER PCM_S16LE_DECODER SETPTS_FILTER FPS_FILTER) \
+                          += fate-mov-frag-ref
+fate-mov-frag-ref: tests/data/vsynth1.yuv tests/data/asynth-44100-2.wav
+fate-mov-frag-ref: CMD = transcode rawvideo $(TARGET_PATH)/tests/data/vsynth1.yuv mp4 "-map 0:v -map 1:a -vf setpts=2*PTS,fps=25 -c:v mpeg4 -qscale 4 -g 10 -c:a mp2 -t 4 -movflags frag_keyframe+empty_moov" "-c copy" "" "-i $(TARGET_PATH)/tests/data/asynth-44100-2.wav" "" "-s 352x288 -pix_fmt yuv420p"
+
 fate-mov-pcm-remux: tests/data/asynth-44100-1.wav
 fate-mov-pcm-remux: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -map 0 -c copy -fflags +bitexact -f mp4
 fate-mov-pcm-remux: CMP = oneline
@@ -52,4 +52,34 @@ FATE_SEGMENT-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER MATROSK
 
 FATE_SAMPLES_FFMPEG += $(FATE_SEGMENT-yes)
 
-fate-segment: $(FATE_SEGMENT-yes)
+SEGMENT_LAVFI_OPTS = -f lavfi -i "testsrc=s=32x32:r=25:d=4" \
+        -f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=4" \
+        -fflags +bitexact -flags +bitexact -c:v rawvideo -c:a pcm_s16le \
+        -f segment -segment_time 1 -segment_format mov -segment_list_type ffconcat
+
+tests/data/segment-lavfi-to-mov.ffconcat: TAG = GEN
+tests/data/segment-lavfi-to-mov.ffconcat: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin $(SEGMENT_LAVFI_OPTS) \
+        -segment_list $(TARGET_PATH)/$@ -y $(TARGET_PATH)/tests/data/segment-lavfi-to-mov-%03d.mov 2>/dev/null
+
+tests/data/segment-lavfi-to-mov-reuse.ffconcat: TAG = GEN
+tests/data/segment-lavfi-to-mov-reuse.ffconcat: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin $(SEGMENT_LAVFI_OPTS) -reuse_muxer 1 \
+        -segment_list $(TARGET_PATH)/$@ -y $(TARGET_PATH)/tests/data/segment-lavfi-to-mov-reuse-%03d.mov 2>/dev/null
+
+FATE_SEGMENT_LAVFI += fate-segment-lavfi-to-mov
+fate-segment-lavfi-to-mov: tests/data/segment-lavfi-to-mov.ffconcat
+fate-segment-lavfi-to-mov: CMD = framecrc -flags +bitexact -safe 0 -i $(TARGET_PATH)/tests/data/segment-lavfi-to-mov.ffconcat -c copy
+
+# reusing the segment muxer context must not change the output
+FATE_SEGMENT_LAVFI += fate-segment-lavfi-to-mov-reuse
+fate-segment-lavfi-to-mov-reuse: tests/data/segment-lavfi-to-mov-reuse.ffconcat
+fate-segment-lavfi-to-mov-reuse: CMD = framecrc -flags +bitexact -safe 0 -i $(TARGET_PATH)/tests/data/segment-lavfi-to-mov-reuse.ffconcat -c copy
+fate-segment-lavfi-to-mov-reuse: REF = $(SRC_PATH)/tests/ref/fate/segment-lavfi-to-mov
+
+FATE_SEGMENT_LAVFI-$(call ALLYES, LAVFI_INDEV TESTSRC_FILTER AEVALSRC_FILTER RAWVIDEO_ENCODER PCM_S16LE_ENCODER \
+                    MOV_MUXER SEGMENT_MUXER CONCAT_DEMUXER MOV_DEMUXER FRAMECRC_MUXER) += $(FATE_SEGMENT_LAVFI)
+
+FATE_FFMPEG += $(FATE_SEGMENT_LAVFI-yes)
+
+fate-segment: $(FATE_SEGMENT-yes) $(FATE_SEGMENT_LAVFI-yes)
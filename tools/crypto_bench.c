@@ -76,6 +76,7 @@ struct hash_impl {
 #include "libavutil/sha512.h"
 #include "libavutil/ripemd.h"
 #include "libavutil/aes.h"
+#include "libavutil/aes_ctr.h"
 #include "libavutil/blowfish.h"
 #include "libavutil/camellia.h"
 #include "libavutil/cast5.h"
@@ -120,6 +121,27 @@ static void run_lavu_aes128(uint8_t *output,
     av_aes_crypt(aes, output, input, size >> 4, NULL, 0);
 }
 
+static void run_lavu_aes128cbc(uint8_t *output,
+                               const uint8_t *input, unsigned size)
+{
+    static struct AVAES *aes;
+    uint8_t iv[16] = { 0 };
+    if (!aes && !(aes = av_aes_alloc()))
+        fatal_error("out of memory");
+    av_aes_init(aes, hardcoded_key, 128, 1);
+    av_aes_crypt(aes, output, input, size >> 4, iv, 1);
+}
+
+static void run_lavu_aes128ctr(uint8_t *output,
+                               const uint8_t *input, unsigned size)
+{
+    static struct AVAESCTR *aes;
+    if (!aes && !(aes = av_aes_ctr_alloc()))
+        fatal_error("out of memory");
+    av_aes_ctr_init(aes, hardcoded_key);
+    av_aes_ctr_crypt(aes, output, input, size);
+}
+
 static void run_lavu_blowfish(uint8_t *output,
                               const uint8_t *input, unsigned size)
 {
@@ -232,6 +254,16 @@ static void run_crypto_aes128(uint8_t *output,
         AES_encrypt(input + i, output + i, &aes);
 }
 
+static void run_crypto_aes128cbc(uint8_t *output,
+                                 const uint8_t *input, unsigned size)
+{
+    AES_KEY aes;
+    uint8_t iv[16] = { 0 };
+
+    AES_set_decrypt_key(hardcoded_key, 128, &aes);
+    AES_cbc_encrypt(input, output, size & ~15, &aes, iv, AES_DECRYPT);
+}
+
 static void run_crypto_blowfish(uint8_t *output,
                                 const uint8_t *input, unsigned size)
 {
@@ -328,6 +360,30 @@ DEFINE_GCRYPT_CYPHER_WRAPPER(blowfish, BLOWFISH,    ECB,    16)
 DEFINE_GCRYPT_CYPHER_WRAPPER(camellia, CAMELLIA128, ECB,    16)
 DEFINE_GCRYPT_CYPHER_WRAPPER(cast128,  CAST5,       ECB,    16)
 DEFINE_GCRYPT_CYPHER_WRAPPER(des,      DES,         ECB,    8)
+
+static void run_gcrypt_aes128cbc(uint8_t *output,
+                                 const uint8_t *input, unsigned size)
+{
+    static gcry_cipher_hd_t aes128cbc;
+    static const uint8_t iv[16] = { 0 };
+    if (!aes128cbc)
+        gcry_cipher_open(&aes128cbc, GCRY_CIPHER_AES128, GCRY_CIPHER_MODE_CBC, 0);
+    gcry_cipher_setkey(aes128cbc, hardcoded_key, 16);
+    gcry_cipher_setiv(aes128cbc, iv, 16);
+    gcry_cipher_decrypt(aes128cbc, output, size, input, size);
+}
+
+static void run_gcrypt_aes128ctr(uint8_t *output,
+                                 const uint8_t *input, unsigned size)
+{
+    static gcry_cipher_hd_t aes128ctr;
+    static const uint8_t ctr[16] = { 0 };
+    if (!aes128ctr)
+        gcry_cipher_open(&aes128ctr, GCRY_CIPHER_AES128, GCRY_CIPHER_MODE_CTR, 0);
+    gcry_cipher_setkey(aes128ctr, hardcoded_key, 16);
+    gcry_cipher_setctr(aes128ctr, ctr, 16);
+    gcry_cipher_encrypt(aes128ctr, output, size, input, size);
+}
 DEFINE_GCRYPT_CYPHER_WRAPPER(twofish,  TWOFISH128,  ECB,    16)
 DEFINE_GCRYPT_CYPHER_WRAPPER(rc4,      ARCFOUR,     STREAM, 16)
 
@@ -647,6 +703,12 @@ struct hash_impl implementations[] = {
     IMPL(tomcrypt, "RIPEMD-128", ripemd128, "9ab8bfba2ddccc5d99c9d4cdfb844a5f")
     IMPL_ALL("RIPEMD-160", ripemd160, "62a5321e4fc8784903bb43ab7752c75f8b25af00")
     IMPL_ALL("AES-128",    aes128,    "crc:ff6bc888")
+    /* CBC is benchmarked in the decryption direction, which can be pipelined */
+    IMPL(lavu,     "AES-128-CBC", aes128cbc, "crc:ae4a81eb")
+    IMPL(crypto,   "AES-128-CBC", aes128cbc, "crc:ae4a81eb")
+    IMPL(gcrypt,   "AES-128-CBC", aes128cbc, "crc:ae4a81eb")
+    IMPL(lavu,     "AES-128-CTR", aes128ctr, "crc:b9fd39aa")
+    IMPL(gcrypt,   "AES-128-CTR", aes128ctr, "crc:b9fd39aa")
     IMPL_ALL("CAMELLIA",   camellia,  "crc:7abb59a7")
     IMPL(lavu,     "CAST-128", cast128, "crc:456aa584")
     IMPL(crypto,   "CAST-128", cast128, "crc:456aa584")
@@ -0,0 +1,1186 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Run a catalog of self-contained decode, filter, encode, mux, probe, seek
+ * and submit workloads generated from lavfi sources and report their
+ * throughput, per-frame latency, peak memory and CPU time, optionally as JSON
+ * for comparing builds. The latency of an output is the time from the
+ * submission of the input it was made from to its output:
+ *
+ * make tools/workload_bench
+ * tools/workload_bench -j > before.json
+ *
+ * Workloads needing an external model (arnndn) only run when one is given
+ * with -m.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+#if HAVE_SYS_RESOURCE_H
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+#include "libavutil/avstring.h"
+#include "libavutil/avutil.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#include "libavcodec/avcodec.h"
+
+#include "libavformat/avformat.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+enum WorkloadType {
+    WORKLOAD_FILTER,
+    WORKLOAD_ENCODE,
+    WORKLOAD_DECODE,
+    WORKLOAD_MUX,
+    WORKLOAD_PROBE,
+    WORKLOAD_SEEK,
+    WORKLOAD_SUBMIT,
+};
+
+static const char *const type_names[] = {
+    [WORKLOAD_FILTER] = "filter",
+    [WORKLOAD_ENCODE] = "encode",
+    [WORKLOAD_DECODE] = "decode",
+    [WORKLOAD_MUX]    = "mux",
+    [WORKLOAD_PROBE]  = "probe",
+    [WORKLOAD_SEEK]   = "seek",
+    [WORKLOAD_SUBMIT] = "submit",
+};
+
+typedef struct Workload {
+    const char *name;
+    enum WorkloadType type;
+    const char *source;     ///< lavfi source generating the input
+    const char *filters;    ///< filter chain applied to the source, may be NULL
+    const char *codec;      ///< encoder (and decoder) for encode/decode/mux workloads
+    const char *format;     ///< muxer for mux, probe and seek workloads
+    const char *format_opts;
+    int nb_streams;         ///< copies of the stream muxed by mux and probe workloads, 1 if unset,
+                            ///< or threads submitting frames to a buffer source
+    int needs_model;        ///< filters contain a %s for the -m model file
+    int locked;             ///< submit through a mutex instead of the threadsafe buffer source
+    int loops;              ///< times the input is repeated in the file of seek workloads
+} Workload;
+
+static const Workload workloads[] = {
+    { "filter_scale_1080p_720p", WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=25", "scale=1280:720" },
+    { "filter_gblur_720p",       WORKLOAD_FILTER,
+      "testsrc2=s=1280x720:r=25", "gblur=sigma=4" },
+    { "filter_boxblur_avgblur_1080p", WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p,boxblur=20:2,avgblur=10" },
+    { "filter_yadif_1080i",      WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p,yadif" },
+    { "filter_ivtc_1080p",       WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=24000/1001",
+      "format=yuv420p,telecine,fieldmatch=combmatch=full,decimate" },
+    { "filter_zoompan_1080p",    WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=1",
+      "format=yuv420p,zoompan=z='min(zoom+0.0015,1.5)':d=125:"
+      "x='iw/2-(iw/zoom/2)':y='ih/2-(ih/zoom/2)':s=1920x1080" },
+    { "filter_zoompan_bicubic_1080p", WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=1",
+      "format=yuv420p,zoompan=z='min(zoom+0.0015,1.5)':d=125:"
+      "x='iw/2-(iw/zoom/2)':y='ih/2-(ih/zoom/2)':s=1920x1080:interp=bicubic" },
+    { "filter_aresample_48k_44k", WORKLOAD_FILTER,
+      "sine=f=440:r=48000:samples_per_frame=1024", "aresample=44100" },
+    { "filter_volume_ebur128",   WORKLOAD_FILTER,
+      "sine=f=440:r=48000:samples_per_frame=1024", "volume=0.5,ebur128" },
+    { "filter_ebur128_7.1_peak", WORKLOAD_FILTER,
+      "sine=f=440:r=48000:samples_per_frame=1024",
+      "aformat=channel_layouts=7.1,ebur128=peak=true+sample" },
+    { "filter_biquads_16ch",     WORKLOAD_FILTER,
+      "sine=f=440:r=48000:samples_per_frame=1024",
+      "aformat=fltp:channel_layouts=hexadecagonal,equalizer=f=1000:g=3,"
+      "lowpass=f=8000:stages=4,highpass=f=80:stages=2" },
+    { "filter_arnndn_7.1",       WORKLOAD_FILTER,
+      "sine=f=440:r=48000:samples_per_frame=480",
+      "aformat=channel_layouts=7.1,arnndn=m=%s", .needs_model = 1 },
+    { "filter_psnr_ssim_vmafmotion_1080p", WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=25",
+      "format=yuv420p,split[m][r];[r]boxblur,split[b0][b1];"
+      "[m][b0]psnr[p];[p][b1]ssim,vmafmotion" },
+    { "filter_qualitymetrics_1080p", WORKLOAD_FILTER,
+      "testsrc2=s=1920x1080:r=25",
+      "format=yuv420p,split[m][r];[r]boxblur[b];[m][b]qualitymetrics" },
+    { "filter_detect_2160p",     WORKLOAD_FILTER,
+      "testsrc2=s=3840x1600:r=25",
+      "pad=3840:2160:0:280,format=yuv420p,cropdetect,blackframe,freezedetect" },
+    { "encode_mpeg4_720p",       WORKLOAD_ENCODE,
+      "testsrc2=s=1280x720:r=25", "format=yuv420p", "mpeg4" },
+    { "encode_mpeg2video_1080p", WORKLOAD_ENCODE,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p", "mpeg2video" },
+    { "encode_ffv1_720p",        WORKLOAD_ENCODE,
+      "testsrc2=s=1280x720:r=25", "format=yuv420p", "ffv1" },
+    { "encode_vc2_1080p",        WORKLOAD_ENCODE,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p", "vc2" },
+    { "encode_vc2_2160p_10bit",  WORKLOAD_ENCODE,
+      "testsrc2=s=3840x2160:r=25", "format=yuv422p10le", "vc2" },
+    { "encode_aac_stereo",       WORKLOAD_ENCODE,
+      "sine=f=440:r=48000", "aformat=sample_fmts=fltp:channel_layouts=stereo", "aac" },
+    { "encode_flac_stereo",      WORKLOAD_ENCODE,
+      "sine=f=440:r=48000", "aformat=sample_fmts=s16:channel_layouts=stereo", "flac" },
+    { "decode_mpeg4_720p",       WORKLOAD_DECODE,
+      "testsrc2=s=1280x720:r=25", "format=yuv420p", "mpeg4" },
+    { "decode_mpeg2video_1080p", WORKLOAD_DECODE,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p", "mpeg2video" },
+    { "decode_ffv1_720p",        WORKLOAD_DECODE,
+      "testsrc2=s=1280x720:r=25", "format=yuv420p", "ffv1" },
+    { "decode_aac_stereo",       WORKLOAD_DECODE,
+      "sine=f=440:r=48000", "aformat=sample_fmts=fltp:channel_layouts=stereo", "aac" },
+    { "mux_mpegts_mpeg2video",   WORKLOAD_MUX,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p", "mpeg2video", "mpegts" },
+    { "mux_mp4_frag_mpeg2video", WORKLOAD_MUX,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p", "mpeg2video", "mp4",
+      "movflags=frag_keyframe+empty_moov" },
+    { "mux_matroska_ffv1",       WORKLOAD_MUX,
+      "testsrc2=s=1280x720:r=25", "format=yuv420p", "ffv1", "matroska" },
+    { "mux_nut_pcm_4streams",    WORKLOAD_MUX,
+      "sine=f=440:r=48000", "aformat=sample_fmts=s16:channel_layouts=mono",
+      "pcm_s16le", "nut", .nb_streams = 4 },
+    { "mux_nut_pcm_64streams",   WORKLOAD_MUX,
+      "sine=f=440:r=48000", "aformat=sample_fmts=s16:channel_layouts=mono",
+      "pcm_s16le", "nut", .nb_streams = 64 },
+    { "mux_nut_pcm_512streams",  WORKLOAD_MUX,
+      "sine=f=440:r=48000", "aformat=sample_fmts=s16:channel_layouts=mono",
+      "pcm_s16le", "nut", .nb_streams = 512 },
+    { "probe_mpegts_mpeg2video_16streams", WORKLOAD_PROBE,
+      "testsrc2=s=1920x1080:r=25", "format=yuv420p", "mpeg2video", "mpegts",
+      .nb_streams = 16 },
+    { "probe_mpegts_aac_64streams", WORKLOAD_PROBE,
+      "sine=f=440:r=48000", "aformat=sample_fmts=fltp:channel_layouts=stereo",
+      "aac", "mpegts", .nb_streams = 64 },
+    { "seek_mxf_mpeg2video_1000partitions", WORKLOAD_SEEK,
+      "testsrc2=s=16x16:r=25", "format=yuv420p", "mpeg2video", "mxf", .loops = 1000 },
+    { "submit_buffersrc_1producer", WORKLOAD_SUBMIT,
+      "testsrc2=s=320x240:r=25", "format=yuv420p", .nb_streams = 1 },
+    { "submit_buffersrc_4producers", WORKLOAD_SUBMIT,
+      "testsrc2=s=320x240:r=25", "format=yuv420p", .nb_streams = 4 },
+    { "submit_buffersrc_16producers", WORKLOAD_SUBMIT,
+      "testsrc2=s=320x240:r=25", "format=yuv420p", .nb_streams = 16 },
+    { "submit_locked_16producers", WORKLOAD_SUBMIT,
+      "testsrc2=s=320x240:r=25", "format=yuv420p", .nb_streams = 16, .locked = 1 },
+};
+
+#define MAX_THREADS 256
+
+typedef struct ThreadTime {
+    int     tid;
+    char    name[32];
+    int64_t cpu_ms;
+} ThreadTime;
+
+typedef struct Result {
+    int64_t frames;
+    double  duration;   ///< seconds of media output by filter workloads
+    int64_t bytes;
+    int64_t wall_us;
+    int64_t cpu_us;
+    int64_t peak_rss_kb;
+    int64_t latency_us[4]; ///< p50, p90, p99, max
+    ThreadTime threads[MAX_THREADS];
+    int nb_threads;
+} Result;
+
+typedef struct BenchContext {
+    const Workload *w;
+    const char *model;
+    int max_frames;
+    int threads;
+
+    AVFilterGraph   *graph;
+    AVFilterContext *sink;
+    AVCodecContext  *enc;
+    AVCodecContext  *dec;
+    AVFrame  *frame;
+    AVPacket *pkt;
+
+    AVPacket **packets;     ///< pre-encoded input of decode and mux workloads
+    int nb_packets;
+
+    uint8_t *muxed;         ///< pre-muxed input of probe and seek workloads
+    int muxed_size;
+    int muxed_pos;
+
+    int64_t *latency;       ///< time from the submission of each output's input to the output
+    int nb_latency;
+    unsigned latency_size;
+
+    int64_t *submitted;     ///< submission time of each input, in submission order
+    int submitted_size;
+    int nb_submitted;
+    int nb_matched;         ///< inputs matched to outputs in order by match_input()
+    Result *res;
+} BenchContext;
+
+static int64_t get_cpu_us(void)
+{
+#if HAVE_GETRUSAGE
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return (rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) * 1000000LL +
+            rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec;
+#else
+    return 0;
+#endif
+}
+
+static int64_t get_peak_rss_kb(void)
+{
+#if HAVE_GETRUSAGE && HAVE_STRUCT_RUSAGE_RU_MAXRSS
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return rusage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+/* Fill threads with the CPU time used by each thread of the process so
+ * far; only implemented on Linux. */
+static int get_thread_times(ThreadTime *threads)
+{
+    int nb_threads = 0;
+#if defined(__linux__)
+    long ticks = sysconf(_SC_CLK_TCK);
+    struct dirent *entry;
+    DIR *dir = opendir("/proc/self/task");
+
+    if (!dir)
+        return 0;
+    while ((entry = readdir(dir)) && nb_threads < MAX_THREADS) {
+        ThreadTime *t = &threads[nb_threads];
+        unsigned long utime, stime;
+        char path[300], buf[512], *p;
+        FILE *f;
+
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+        if (!(f = fopen(path, "r")))
+            continue;
+        p = fgets(buf, sizeof(buf), f);
+        fclose(f);
+        if (!p || !(p = strrchr(buf, ')')))
+            continue;
+        /* fields after the command name start at state, utime is the 14th */
+        if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                   &utime, &stime) != 2)
+            continue;
+
+        t->tid = atoi(entry->d_name);
+        av_strlcpy(t->name, strchr(buf, '(') + 1, FFMIN(sizeof(t->name), p - strchr(buf, '(')));
+        t->cpu_ms = (utime + stime) * 1000LL / ticks;
+        nb_threads++;
+    }
+    closedir(dir);
+#endif
+    return nb_threads;
+}
+
+/* Record the submission of an input; the returned slot is attached to
+ * it as opaque to find the time back at its output. */
+static int64_t *submit_input(BenchContext *bc)
+{
+    int64_t *t = &bc->submitted[FFMIN(bc->nb_submitted, bc->submitted_size - 1)];
+
+    bc->nb_submitted++;
+    *t = av_gettime_relative();
+    return t;
+}
+
+/* For codecs not passing opaque through, outputs are matched to inputs in
+ * order, and the flushed outputs to the last input. */
+static const int64_t *match_input(BenchContext *bc)
+{
+    if (!bc->nb_submitted)
+        return NULL;
+    return &bc->submitted[FFMIN3(bc->nb_matched++, bc->nb_submitted - 1, bc->submitted_size - 1)];
+}
+
+static int add_output(BenchContext *bc, int64_t bytes, const int64_t *submitted)
+{
+    int64_t now = av_gettime_relative();
+    int64_t *latency = av_fast_realloc(bc->latency, &bc->latency_size,
+                                       (bc->nb_latency + 1) * sizeof(*bc->latency));
+
+    if (!latency)
+        return AVERROR(ENOMEM);
+    bc->latency = latency;
+    if (submitted)
+        bc->latency[bc->nb_latency++] = now - *submitted;
+    bc->res->frames++;
+    bc->res->bytes += bytes;
+    return 0;
+}
+
+static int init_source(BenchContext *bc)
+{
+    const Workload *w = bc->w;
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    AVFilterInOut *outputs = NULL;
+    const char *filters = w->filters;
+    char desc[1024], model_filters[512];
+    int is_audio, ret;
+
+    bc->graph = avfilter_graph_alloc();
+    if (!bc->graph || !inputs) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if (bc->threads)
+        bc->graph->nb_threads = bc->threads;
+
+    is_audio = !strncmp(w->source, "sine", 4);
+    ret = avfilter_graph_create_filter(&bc->sink,
+                                       avfilter_get_by_name(is_audio ? "abuffersink" : "buffersink"),
+                                       "out", NULL, NULL, bc->graph);
+    if (ret < 0)
+        goto end;
+
+    if (w->needs_model) {
+        snprintf(model_filters, sizeof(model_filters), w->filters, bc->model);
+        filters = model_filters;
+    }
+    snprintf(desc, sizeof(desc), "%s%s%s[out]", w->source,
+             filters ? "," : "", filters ? filters : "");
+
+    inputs->name       = av_strdup("out");
+    inputs->filter_ctx = bc->sink;
+    inputs->pad_idx    = 0;
+    inputs->next       = NULL;
+    if (!inputs->name) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    if ((ret = avfilter_graph_parse_ptr(bc->graph, desc, &inputs, &outputs, NULL)) < 0 ||
+        (ret = avfilter_graph_config(bc->graph, NULL)) < 0)
+        goto end;
+
+end:
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    return ret;
+}
+
+static int init_encoder(BenchContext *bc)
+{
+    const AVCodec *codec = avcodec_find_encoder_by_name(bc->w->codec);
+    AVCodecContext *enc;
+    int ret;
+
+    if (!codec)
+        return AVERROR_ENCODER_NOT_FOUND;
+    enc = bc->enc = avcodec_alloc_context3(codec);
+    if (!enc)
+        return AVERROR(ENOMEM);
+
+    enc->time_base    = av_buffersink_get_time_base(bc->sink);
+    enc->thread_count = bc->threads;
+    enc->flags       |= AV_CODEC_FLAG_BITEXACT;
+    if (codec->type == AVMEDIA_TYPE_VIDEO) {
+        enc->width               = av_buffersink_get_w(bc->sink);
+        enc->height              = av_buffersink_get_h(bc->sink);
+        enc->pix_fmt             = av_buffersink_get_format(bc->sink);
+        enc->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(bc->sink);
+        enc->framerate           = av_buffersink_get_frame_rate(bc->sink);
+        enc->gop_size            = 25;
+    } else {
+        enc->sample_fmt  = av_buffersink_get_format(bc->sink);
+        enc->sample_rate = av_buffersink_get_sample_rate(bc->sink);
+        if ((ret = av_buffersink_get_ch_layout(bc->sink, &enc->ch_layout)) < 0)
+            return ret;
+    }
+    if (bc->w->type == WORKLOAD_ENCODE &&
+        (codec->capabilities & AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE))
+        enc->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+    /* the muxers need global headers for some codecs */
+    if (bc->w->type == WORKLOAD_MUX)
+        enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if ((ret = avcodec_open2(enc, codec, NULL)) < 0)
+        return ret;
+
+    if (codec->type == AVMEDIA_TYPE_AUDIO &&
+        !(codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+        av_buffersink_set_frame_size(bc->sink, enc->frame_size);
+
+    return 0;
+}
+
+static int init_decoder(BenchContext *bc)
+{
+    const AVCodec *codec = avcodec_find_decoder(bc->enc->codec_id);
+    AVCodecParameters *par;
+    AVCodecContext *dec;
+    int ret;
+
+    if (!codec)
+        return AVERROR_DECODER_NOT_FOUND;
+    dec = bc->dec = avcodec_alloc_context3(codec);
+    par = avcodec_parameters_alloc();
+    if (!dec || !par) {
+        avcodec_parameters_free(&par);
+        return AVERROR(ENOMEM);
+    }
+
+    ret = avcodec_parameters_from_context(par, bc->enc);
+    if (ret >= 0)
+        ret = avcodec_parameters_to_context(dec, par);
+    avcodec_parameters_free(&par);
+    if (ret < 0)
+        return ret;
+    dec->pkt_timebase = bc->enc->time_base;
+    dec->thread_count = bc->threads;
+    dec->flags       |= AV_CODEC_FLAG_COPY_OPAQUE;
+
+    return avcodec_open2(dec, codec, NULL);
+}
+
+/* Pull frames from the source graph; with measure set every frame counts
+ * as an output of the workload. */
+static int run_filter(BenchContext *bc, int (*process)(BenchContext *bc, AVFrame *frame),
+                      int measure)
+{
+    int ret = 0;
+
+    for (int i = 0; i < bc->max_frames; i++) {
+        int64_t submitted = av_gettime_relative();
+
+        ret = av_buffersink_get_frame(bc->sink, bc->frame);
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            return ret;
+        if (measure) {
+            AVRational tb = av_buffersink_get_time_base(bc->sink);
+
+            ret = add_output(bc, 0, &submitted);
+            if (bc->frame->nb_samples)
+                bc->res->duration += bc->frame->nb_samples / (double)bc->frame->sample_rate;
+            else if (bc->frame->duration > 0)
+                bc->res->duration += bc->frame->duration * av_q2d(tb);
+            else
+                bc->res->duration += av_q2d(av_inv_q(av_buffersink_get_frame_rate(bc->sink)));
+        }
+        if (ret >= 0 && process)
+            ret = process(bc, bc->frame);
+        av_frame_unref(bc->frame);
+        if (ret < 0)
+            return ret;
+    }
+    return process ? process(bc, NULL) : 0;
+}
+
+static int store_packet(BenchContext *bc, AVPacket *pkt)
+{
+    AVPacket **packets = av_realloc_array(bc->packets, bc->nb_packets + 1,
+                                          sizeof(*bc->packets));
+    if (!packets)
+        return AVERROR(ENOMEM);
+    bc->packets = packets;
+    if (!(packets[bc->nb_packets] = av_packet_clone(pkt)))
+        return AVERROR(ENOMEM);
+    bc->nb_packets++;
+    return 0;
+}
+
+static int encode_frame(BenchContext *bc, AVFrame *frame)
+{
+    int ret;
+
+    if (frame && bc->w->type == WORKLOAD_ENCODE)
+        frame->opaque = submit_input(bc);
+    ret = avcodec_send_frame(bc->enc, frame);
+
+    while (ret >= 0) {
+        ret = avcodec_receive_packet(bc->enc, bc->pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return 0;
+        if (ret < 0)
+            break;
+        if (bc->w->type == WORKLOAD_ENCODE)
+            ret = add_output(bc, bc->pkt->size,
+                             bc->enc->flags & AV_CODEC_FLAG_COPY_OPAQUE ?
+                             bc->pkt->opaque : match_input(bc));
+        else
+            ret = store_packet(bc, bc->pkt);
+        av_packet_unref(bc->pkt);
+    }
+    return ret;
+}
+
+static int run_decode(BenchContext *bc)
+{
+    int ret;
+
+    for (int i = 0; i <= bc->nb_packets; i++) {
+        if (i < bc->nb_packets)
+            bc->packets[i]->opaque = submit_input(bc);
+        ret = avcodec_send_packet(bc->dec, i < bc->nb_packets ? bc->packets[i] : NULL);
+        if (ret < 0)
+            return ret;
+        while ((ret = avcodec_receive_frame(bc->dec, bc->frame)) >= 0) {
+            ret = add_output(bc, 0, bc->frame->opaque);
+            av_frame_unref(bc->frame);
+            if (ret < 0)
+                return ret;
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            return ret;
+    }
+    return 0;
+}
+
+static int discard_write(void *opaque, uint8_t *buf, int size)
+{
+    BenchContext *bc = opaque;
+    bc->res->bytes += size;
+    return size;
+}
+
+static int read_muxed(void *opaque, uint8_t *buf, int size)
+{
+    BenchContext *bc = opaque;
+
+    size = FFMIN(size, bc->muxed_size - bc->muxed_pos);
+    if (!size)
+        return AVERROR_EOF;
+    memcpy(buf, bc->muxed + bc->muxed_pos, size);
+    bc->muxed_pos += size;
+    return size;
+}
+
+static int64_t seek_muxed(void *opaque, int64_t offset, int whence)
+{
+    BenchContext *bc = opaque;
+
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE: return bc->muxed_size;
+    case SEEK_SET:                             break;
+    case SEEK_CUR:    offset += bc->muxed_pos;  break;
+    case SEEK_END:    offset += bc->muxed_size; break;
+    default:          return AVERROR(EINVAL);
+    }
+    if (offset < 0 || offset > bc->muxed_size)
+        return AVERROR(EINVAL);
+    bc->muxed_pos = offset;
+    return offset;
+}
+
+/* Mux workloads discard their output, probe and seek workloads keep it as
+ * input. */
+static int run_mux(BenchContext *bc)
+{
+    AVFormatContext *oc = NULL;
+    AVDictionary *opts = NULL;
+    uint8_t *buf = NULL;
+    int nb_streams = FFMAX(bc->w->nb_streams, 1);
+    int keep = bc->w->type == WORKLOAD_PROBE || bc->w->type == WORKLOAD_SEEK;
+    int64_t span = 0;
+    int ret;
+
+    if ((ret = avformat_alloc_output_context2(&oc, NULL, bc->w->format, NULL)) < 0)
+        return ret;
+    oc->flags |= AVFMT_FLAG_BITEXACT;
+
+    if (keep) {
+        if ((ret = avio_open_dyn_buf(&oc->pb)) < 0)
+            goto end;
+    } else if (!(buf = av_malloc(32768)) ||
+               !(oc->pb = avio_alloc_context(buf, 32768, 1, bc, NULL, discard_write, NULL))) {
+        av_free(buf);
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    for (int i = 0; i < nb_streams; i++) {
+        AVStream *st = avformat_new_stream(oc, NULL);
+        if (!st) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        if ((ret = avcodec_parameters_from_context(st->codecpar, bc->enc)) < 0)
+            goto end;
+        st->time_base = bc->enc->time_base;
+    }
+
+    if (bc->w->format_opts &&
+        (ret = av_dict_parse_string(&opts, bc->w->format_opts, "=", ":", 0)) < 0)
+        goto end;
+    if ((ret = avformat_write_header(oc, &opts)) < 0)
+        goto end;
+
+    /* seek workloads repeat the input to make a longer file */
+    if (bc->nb_packets) {
+        const AVPacket *last = bc->packets[bc->nb_packets - 1];
+        span = last->dts + FFMAX(last->duration, 1) - bc->packets[0]->dts;
+    }
+
+    /* With several streams, the last one is written first, so that each
+     * packet sorts before the ones the interleaver already holds for the
+     * same instant, as with a late video stream in a multi-track file. */
+    for (int n = 0; n < bc->nb_packets * FFMAX(bc->w->loops, 1); n++) {
+        int i = n % bc->nb_packets;
+        int64_t offset = n / bc->nb_packets * span;
+
+        for (int j = nb_streams - 1; j >= 0; j--) {
+            AVStream *st = oc->streams[j];
+            int64_t submitted = av_gettime_relative();
+
+            if ((ret = av_packet_ref(bc->pkt, bc->packets[i])) < 0)
+                goto end;
+            bc->pkt->pts += offset;
+            bc->pkt->dts += offset;
+            av_packet_rescale_ts(bc->pkt, bc->enc->time_base, st->time_base);
+            bc->pkt->stream_index = j;
+            if ((ret = av_interleaved_write_frame(oc, bc->pkt)) < 0)
+                goto end;
+            if ((ret = add_output(bc, 0, &submitted)) < 0)
+                goto end;
+        }
+    }
+    ret = av_write_trailer(oc);
+
+end:
+    av_dict_free(&opts);
+    if (oc && oc->pb && keep) {
+        /* the padding is written at the current position, which muxers
+         * rewriting their header after the trailer left before the end */
+        uint8_t *data;
+        avio_seek(oc->pb, avio_get_dyn_buf(oc->pb, &data), SEEK_SET);
+        bc->muxed_size = avio_close_dyn_buf(oc->pb, &bc->muxed);
+        oc->pb = NULL;
+    } else if (oc && oc->pb) {
+        av_freep(&oc->pb->buffer);
+        avio_context_free(&oc->pb);
+    }
+    avformat_free_context(oc);
+    return ret;
+}
+
+static int open_muxed(BenchContext *bc, AVFormatContext **pic, int seekable)
+{
+    AVFormatContext *ic = avformat_alloc_context();
+    uint8_t *buf = av_malloc(32768);
+    AVIOContext *pb = NULL;
+    int ret;
+
+    if (!ic || !buf ||
+        !(pb = avio_alloc_context(buf, 32768, 0, bc, read_muxed, NULL,
+                                  seekable ? seek_muxed : NULL))) {
+        av_free(buf);
+        avformat_free_context(ic);
+        return AVERROR(ENOMEM);
+    }
+    ic->pb     = pb;
+    ic->flags |= AVFMT_FLAG_CUSTOM_IO;
+    ic->stream_info_threads = bc->threads;
+    bc->muxed_pos = 0;
+
+    if ((ret = avformat_open_input(&ic, NULL, av_find_input_format(bc->w->format), NULL)) < 0) {
+        av_freep(&pb->buffer);
+        avio_context_free(&pb);
+        return ret;
+    }
+    *pic = ic;
+    return 0;
+}
+
+static void close_muxed(AVFormatContext **pic)
+{
+    AVIOContext *pb = *pic ? (*pic)->pb : NULL;
+
+    avformat_close_input(pic);
+    if (pb)
+        av_freep(&pb->buffer);
+    avio_context_free(&pb);
+}
+
+/* Time opening the pre-muxed input up to the end of
+ * avformat_find_stream_info(), each stream counting as an output. */
+static int run_probe(BenchContext *bc)
+{
+    AVFormatContext *ic = NULL;
+    int64_t submitted = av_gettime_relative();
+    int ret;
+
+    if ((ret = open_muxed(bc, &ic, 0)) < 0)
+        return ret;
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0)
+        goto end;
+    bc->res->bytes = bc->muxed_pos;
+    for (unsigned i = 0; i < ic->nb_streams; i++)
+        if ((ret = add_output(bc, 0, &submitted)) < 0)
+            goto end;
+
+end:
+    close_muxed(&ic);
+    return ret;
+}
+
+/* Seek to max_frames pseudo-random positions of the pre-muxed input and
+ * read a packet after each seek, each seek counting as an output. */
+static int run_seek(BenchContext *bc)
+{
+    AVFormatContext *ic = NULL;
+    AVLFG lfg;
+    int ret;
+
+    if ((ret = open_muxed(bc, &ic, 1)) < 0)
+        return ret;
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0)
+        goto end;
+    if (ic->duration <= 0) {
+        ret = AVERROR_INVALIDDATA;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 0x5eec);
+    for (int i = 0; i < bc->max_frames; i++) {
+        int64_t ts = av_rescale(av_lfg_get(&lfg), ic->duration, UINT32_MAX);
+        int64_t submitted = av_gettime_relative();
+
+        if ((ret = av_seek_frame(ic, -1, ts, AVSEEK_FLAG_BACKWARD)) < 0 ||
+            (ret = av_read_frame(ic, bc->pkt)) < 0)
+            goto end;
+        bc->res->bytes += bc->pkt->size;
+        av_packet_unref(bc->pkt);
+        if ((ret = add_output(bc, 0, &submitted)) < 0)
+            goto end;
+    }
+
+end:
+    close_muxed(&ic);
+    return ret;
+}
+
+#if HAVE_THREADS
+typedef struct SubmitContext {
+    BenchContext *bc;
+    AVFilterContext *src;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int pending;            ///< frames were submitted since the last check
+    int nb_done;            ///< producers which are done submitting
+} SubmitContext;
+
+typedef struct Producer {
+    SubmitContext *sc;
+    int idx;
+    pthread_t thread;
+    int ret;
+} Producer;
+
+static void submit_wakeup(void *opaque)
+{
+    SubmitContext *sc = opaque;
+
+    pthread_mutex_lock(&sc->lock);
+    sc->pending = 1;
+    pthread_cond_signal(&sc->cond);
+    pthread_mutex_unlock(&sc->lock);
+}
+
+/* Each producer submits max_frames references to the source frame, in
+ * its own range of submission slots. */
+static void *submit_frames(void *arg)
+{
+    Producer *p = arg;
+    SubmitContext *sc = p->sc;
+    AVFrame *frame = av_frame_alloc();
+    int ret = frame ? 0 : AVERROR(ENOMEM);
+
+    for (int i = 0; ret >= 0 && i < sc->bc->max_frames; i++) {
+        if ((ret = av_frame_ref(frame, sc->bc->frame)) < 0)
+            break;
+        frame->pts    = i;
+        frame->opaque = &sc->bc->submitted[p->idx * sc->bc->max_frames + i];
+        *(int64_t *)frame->opaque = av_gettime_relative();
+        if (sc->bc->w->locked) {
+            pthread_mutex_lock(&sc->lock);
+            ret = av_buffersrc_add_frame(sc->src, frame);
+            sc->pending = 1;
+            pthread_cond_signal(&sc->cond);
+            pthread_mutex_unlock(&sc->lock);
+        } else {
+            ret = av_buffersrc_add_frame(sc->src, frame);
+        }
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+
+    pthread_mutex_lock(&sc->lock);
+    p->ret = ret;
+    sc->nb_done++;
+    pthread_cond_signal(&sc->cond);
+    pthread_mutex_unlock(&sc->lock);
+    return NULL;
+}
+
+/* Several threads feed a buffer source while this one drains its sink,
+ * either through the threadsafe mode of the buffer source or, for locked
+ * workloads, by serializing all the accesses to the graph with a mutex. */
+static int run_submit(BenchContext *bc)
+{
+    const Workload *w = bc->w;
+    SubmitContext sc = { .bc = bc };
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *sink;
+    AVFrame *frame = av_frame_alloc();
+    Producer *producers = NULL;
+    int nb_producers = FFMAX(w->nb_streams, 1), nb_started = 0;
+    char args[256];
+    int ret;
+
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=1/25:threadsafe=%d",
+             bc->frame->width, bc->frame->height, bc->frame->format, !w->locked);
+    if ((ret = avfilter_graph_create_filter(&sc.src, avfilter_get_by_name("buffer"),
+                                            "in", args, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"),
+                                            "out", NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_link(sc.src, 0, sink, 0)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+    if (!w->locked)
+        av_buffersrc_set_wakeup(sc.src, submit_wakeup, &sc);
+
+    if (!(producers = av_calloc(nb_producers, sizeof(*producers)))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    pthread_mutex_init(&sc.lock, NULL);
+    pthread_cond_init(&sc.cond, NULL);
+
+    pthread_mutex_lock(&sc.lock);
+    for (; nb_started < nb_producers; nb_started++) {
+        producers[nb_started].sc  = &sc;
+        producers[nb_started].idx = nb_started;
+        if ((ret = pthread_create(&producers[nb_started].thread, NULL,
+                                  submit_frames, &producers[nb_started]))) {
+            ret = AVERROR(ret);
+            break;
+        }
+    }
+    if (nb_started < nb_producers)
+        sc.nb_done += nb_producers - nb_started;
+
+    while (1) {
+        int finished;
+
+        while (!sc.pending && sc.nb_done < nb_producers)
+            pthread_cond_wait(&sc.cond, &sc.lock);
+        finished   = sc.nb_done == nb_producers;
+        sc.pending = 0;
+
+        if (!w->locked) {
+            pthread_mutex_unlock(&sc.lock);
+            ret = av_buffersrc_process_queue(sc.src, 0);
+        }
+        while (ret >= 0 && (ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+            ret = add_output(bc, 0, frame->opaque);
+            av_frame_unref(frame);
+        }
+        if (ret == AVERROR(EAGAIN))
+            ret = 0;
+        if (!w->locked)
+            pthread_mutex_lock(&sc.lock);
+        if (ret < 0 || finished)
+            break;
+    }
+    pthread_mutex_unlock(&sc.lock);
+
+    for (int i = 0; i < nb_started; i++) {
+        pthread_join(producers[i].thread, NULL);
+        if (ret >= 0 && producers[i].ret < 0)
+            ret = producers[i].ret;
+    }
+    if (ret >= 0 && bc->res->frames != (int64_t)nb_producers * bc->max_frames)
+        ret = AVERROR_BUG;
+    pthread_cond_destroy(&sc.cond);
+    pthread_mutex_destroy(&sc.lock);
+
+end:
+    av_free(producers);
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+#else
+static int run_submit(BenchContext *bc)
+{
+    return AVERROR(ENOSYS);
+}
+#endif
+
+static int cmp_int64(const void *a, const void *b)
+{
+    return FFDIFFSIGN(*(const int64_t *)a, *(const int64_t *)b);
+}
+
+static int run_workload(const Workload *w, const char *model, int max_frames, int threads,
+                        Result *res)
+{
+    BenchContext bc = { .w = w, .model = model, .max_frames = max_frames, .threads = threads,
+                        .res = res };
+    ThreadTime before[MAX_THREADS];
+    int nb_before;
+    int64_t start, cpu;
+    int ret;
+
+    memset(res, 0, sizeof(*res));
+
+    bc.submitted_size = FFMAX(max_frames, 1) * (w->type == WORKLOAD_SUBMIT ? FFMAX(w->nb_streams, 1) : 1);
+    bc.submitted = av_calloc(bc.submitted_size, sizeof(*bc.submitted));
+    bc.frame = av_frame_alloc();
+    bc.pkt   = av_packet_alloc();
+    if (!bc.submitted || !bc.frame || !bc.pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    if ((ret = init_source(&bc)) < 0)
+        goto end;
+    if (w->type != WORKLOAD_FILTER && w->type != WORKLOAD_SUBMIT &&
+        (ret = init_encoder(&bc)) < 0)
+        goto end;
+
+    /* decode, mux, probe and seek workloads only measure their last stage, so
+     * their input is prepared beforehand */
+    if (w->type != WORKLOAD_FILTER && w->type != WORKLOAD_ENCODE &&
+        w->type != WORKLOAD_SUBMIT) {
+        if ((ret = run_filter(&bc, encode_frame, 0)) < 0)
+            goto end;
+        if (w->type == WORKLOAD_DECODE && (ret = init_decoder(&bc)) < 0)
+            goto end;
+        if (w->type == WORKLOAD_PROBE || w->type == WORKLOAD_SEEK) {
+            ret = run_mux(&bc);
+            memset(res, 0, sizeof(*res));
+            bc.nb_latency = 0;
+            if (ret < 0)
+                goto end;
+        }
+    }
+    /* submit workloads send copies of the first source frame */
+    if (w->type == WORKLOAD_SUBMIT &&
+        (ret = av_buffersink_get_frame(bc.sink, bc.frame)) < 0)
+        goto end;
+
+    nb_before = get_thread_times(before);
+    cpu   = get_cpu_us();
+    start = av_gettime_relative();
+
+    switch (w->type) {
+    case WORKLOAD_FILTER: ret = run_filter(&bc, NULL, 1);         break;
+    case WORKLOAD_ENCODE: ret = run_filter(&bc, encode_frame, 0); break;
+    case WORKLOAD_DECODE: ret = run_decode(&bc);                  break;
+    case WORKLOAD_MUX:    ret = run_mux(&bc);                     break;
+    case WORKLOAD_PROBE:  ret = run_probe(&bc);                   break;
+    case WORKLOAD_SEEK:   ret = run_seek(&bc);                    break;
+    case WORKLOAD_SUBMIT: ret = run_submit(&bc);                  break;
+    }
+    if (ret < 0)
+        goto end;
+
+    res->wall_us     = av_gettime_relative() - start;
+    res->cpu_us      = get_cpu_us() - cpu;
+    res->peak_rss_kb = get_peak_rss_kb();
+
+    /* sample the threads before the codec contexts and their threads go away */
+    res->nb_threads = get_thread_times(res->threads);
+    for (int i = 0; i < res->nb_threads; i++)
+        for (int j = 0; j < nb_before; j++)
+            if (res->threads[i].tid == before[j].tid)
+                res->threads[i].cpu_ms -= before[j].cpu_ms;
+
+    if (bc.nb_latency) {
+        qsort(bc.latency, bc.nb_latency, sizeof(*bc.latency), cmp_int64);
+        res->latency_us[0] = bc.latency[bc.nb_latency * 50 / 100];
+        res->latency_us[1] = bc.latency[bc.nb_latency * 90 / 100];
+        res->latency_us[2] = bc.latency[bc.nb_latency * 99 / 100];
+        res->latency_us[3] = bc.latency[bc.nb_latency - 1];
+    }
+
+end:
+    for (int i = 0; i < bc.nb_packets; i++)
+        av_packet_free(&bc.packets[i]);
+    av_freep(&bc.packets);
+    av_freep(&bc.muxed);
+    av_freep(&bc.latency);
+    av_freep(&bc.submitted);
+    avcodec_free_context(&bc.enc);
+    avcodec_free_context(&bc.dec);
+    avfilter_graph_free(&bc.graph);
+    av_frame_free(&bc.frame);
+    av_packet_free(&bc.pkt);
+    return ret;
+}
+
+static void print_result(const Workload *w, const Result *res, int ret, int json, int first)
+{
+    double fps = res->wall_us ? res->frames * 1000000.0 / res->wall_us : 0;
+    double rtf = res->wall_us ? res->duration * 1000000.0 / res->wall_us : 0;
+
+    if (!json) {
+        if (ret < 0) {
+            printf("%-28s %-6s failed: %s\n", w->name, type_names[w->type], av_err2str(ret));
+            return;
+        }
+        printf("%-28s %-6s %6"PRId64" frames %9.2f fps %8.1fx rt  latency p50 %6"PRId64" p90 %6"PRId64
+               " p99 %6"PRId64" max %7"PRId64" us  cpu %6.2fs  rss %7"PRId64" kB\n",
+               w->name, type_names[w->type], res->frames, fps, rtf,
+               res->latency_us[0], res->latency_us[1], res->latency_us[2], res->latency_us[3],
+               res->cpu_us / 1000000.0, res->peak_rss_kb);
+        return;
+    }
+
+    printf("%s    {\n", first ? "" : ",\n");
+    printf("      \"name\": \"%s\",\n", w->name);
+    printf("      \"type\": \"%s\",\n", type_names[w->type]);
+    if (ret < 0) {
+        printf("      \"error\": \"%s\"\n    }", av_err2str(ret));
+        return;
+    }
+    printf("      \"frames\": %"PRId64",\n", res->frames);
+    printf("      \"bytes\": %"PRId64",\n", res->bytes);
+    printf("      \"wall_us\": %"PRId64",\n", res->wall_us);
+    printf("      \"fps\": %.3f,\n", fps);
+    printf("      \"realtime_factor\": %.3f,\n", rtf);
+    printf("      \"latency_us\": { \"p50\": %"PRId64", \"p90\": %"PRId64", \"p99\": %"PRId64", \"max\": %"PRId64" },\n",
+           res->latency_us[0], res->latency_us[1], res->latency_us[2], res->latency_us[3]);
+    printf("      \"cpu_us\": %"PRId64",\n", res->cpu_us);
+    printf("      \"peak_rss_kb\": %"PRId64",\n", res->peak_rss_kb);
+    printf("      \"threads\": [");
+    for (int i = 0; i < res->nb_threads; i++)
+        printf("%s\n        { \"tid\": %d, \"name\": \"%s\", \"cpu_ms\": %"PRId64" }",
+               i ? "," : "", res->threads[i].tid, res->threads[i].name, res->threads[i].cpu_ms);
+    printf("%s]\n    }", res->nb_threads ? "\n      " : "");
+}
+
+static int workload_selected(const Workload *w, int argc, char **argv)
+{
+    if (!argc)
+        return 1;
+    for (int i = 0; i < argc; i++)
+        if (strstr(w->name, argv[i]))
+            return 1;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int max_frames = 250, threads = 0, json = 0, list = 0;
+    int opt, first = 1, failed = 0;
+    const char *model = NULL;
+
+    while ((opt = getopt(argc, argv, "hljm:n:t:")) != -1) {
+        switch (opt) {
+        case 'm':
+            model = optarg;
+            break;
+        case 'l':
+            list = 1;
+            break;
+        case 'j':
+            json = 1;
+            break;
+        case 'n':
+            max_frames = strtol(optarg, NULL, 0);
+            break;
+        case 't':
+            threads = strtol(optarg, NULL, 0);
+            break;
+        case 'h':
+        default:
+            fprintf(stderr, "Usage: %s [-l] [-j] [-m model] [-n frames] [-t threads] [workload...]\n"
+                    "  -l          list the workloads\n"
+                    "  -j          print the results as JSON\n"
+                    "  -m model    rnnoise model file for the arnndn workloads\n"
+                    "  -n frames   number of source frames per workload, and of seeks of the\n"
+                    "              seek workloads (default 250)\n"
+                    "  -t threads  codec, filter and stream info threads, 0 for automatic (default)\n"
+                    "Workloads are selected by substring match on their name.\n",
+                    argv[0]);
+            exit(opt != 'h');
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    if (list) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(workloads); i++)
+            printf("%-28s %s\n", workloads[i].name, type_names[workloads[i].type]);
+        return 0;
+    }
+
+    av_log_set_level(AV_LOG_ERROR);
+
+    if (json)
+        printf("{\n  \"version\": \"%s\",\n  \"frames\": %d,\n  \"threads\": %d,\n  \"workloads\": [\n",
+               av_version_info(), max_frames, threads);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(workloads); i++) {
+        const Workload *w = &workloads[i];
+        Result res;
+        int ret;
+
+        if (!workload_selected(w, argc, argv) || (w->needs_model && !model))
+            continue;
+        ret = run_workload(w, model, max_frames, threads, &res);
+        print_result(w, &res, ret, json, first);
+        fflush(stdout);
+        failed |= ret < 0;
+        first = 0;
+    }
+
+    if (json)
+        printf("\n  ]\n}\n");
+
+    return failed;
+}